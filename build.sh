@@ -41,6 +41,9 @@ function find_libs() {
     if [[ ! -e "/usr/include/jansson.h" ]] ; then
         return 0
     fi
+    if [[ ! -e "/usr/include/zlib.h" ]] ; then
+        return 0
+    fi
     if [[ ! -e "/usr/bin/cmake" ]] ; then
         return 0
     fi
@@ -59,7 +62,7 @@ function find_libs() {
 find_libs
 if [[ $? -eq 0 ]] ; then
     apt update && apt install --yes libfcgi-dev libglib2.0-dev libcurl4-openssl-dev \
-        libjansson-dev cmake clang make libglib2.0-dev libsqlite3-dev git nginx ffmpeg
+        libjansson-dev zlib1g-dev cmake clang make libglib2.0-dev libsqlite3-dev git nginx ffmpeg
     cp -r ./data/system/default /etc/nginx/sites-enabled/
     cp ./data/system/plc.service /etc/systemd/system/
     systemctl enable plc
@@ -16,9 +16,11 @@
 #include <glib-2.0/glib.h>
 
 #include <utils/utils.h>
+#include <utils/seqlock.h>
 
 #define METEO_SENSOR_TRIES  5
 #define METEO_BAD_VAL       -127
+#define METEO_PERIOD_MS     10000
 
 typedef enum {
     METEO_SENSOR_DS18B20
@@ -34,8 +36,14 @@ typedef struct {
     MeteoSensorType type;
     MeteoDs18b20    ds18b20;
     bool            error;
+    SeqLock         lock;
 } MeteoSensor;
 
+typedef struct {
+    float   temp;
+    bool    error;
+} MeteoSensorState;
+
 /**
  * @brief Alloc mem for new sensor
  * 
@@ -76,4 +84,12 @@ MeteoSensor *MeteoSensorGet(const char *name);
  */
 void MeteoSensorAdd(MeteoSensor *sensor);
 
+/**
+ * @brief Get consistent copy of sensor state without locking
+ * 
+ * @param sensor Meteo sensor struct
+ * @param state Out sensor state
+ */
+void MeteoSensorStateGet(MeteoSensor *sensor, MeteoSensorState *state);
+
 #endif /* __METEO_CTRL_H__ */
@@ -23,6 +23,12 @@
 #define SECURITY_DETECTED_TIME_MAX_SEC  3
 #define SECURITY_SENSOR_TIME_MAX_SEC    60
 
+#define SECURITY_SENSORS_PERIOD_MS  1000
+#define SECURITY_KEYS_PERIOD_MS     1000
+#define SECURITY_KEY_DELAY_MS       5000
+
+#define SECURITY_VERSION_TIE_BITS   16
+
 typedef enum {
     SECURITY_SAVE_TYPE_STATUS,
     SECURITY_SAVE_TYPE_ALARM
@@ -151,6 +157,25 @@ bool SecurityAlarmGet();
  */
 bool SecurityStatusGet();
 
+/**
+ * @brief Get version of last local change of status or alarm
+ *
+ * @return Security state version
+ */
+uint64_t SecurityVersionGet();
+
+/**
+ * @brief Apply status and alarm of other unit if its version is newer
+ * than local one
+ *
+ * @param status Security status
+ * @param alarm Security alarm status
+ * @param version Version of status and alarm
+ *
+ * @return true/false as result of applying
+ */
+bool SecurityReconcile(bool status, bool alarm, uint64_t version);
+
 /**
  * @brief Add new iButton key for controller
  * 
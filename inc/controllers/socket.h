@@ -16,10 +16,14 @@
 #include <glib-2.0/glib.h>
 
 #include <utils/utils.h>
+#include <utils/seqlock.h>
 #include <core/gpio.h>
 
 #define SOCKET_DB_FILE  "socket.db"
 
+#define SOCKET_BUTTON_PERIOD_MS 200
+#define SOCKET_BUTTON_DELAY_MS  800
+
 typedef enum {
     SOCKET_PIN_BUTTON,
     SOCKET_PIN_RELAY,
@@ -36,6 +40,7 @@ typedef struct {
     GpioPin     *gpio[SOCKET_PIN_MAX];
     SocketGroup group;
     bool        status;
+    SeqLock     lock;
 } Socket;
 
 /**
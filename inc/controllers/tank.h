@@ -16,6 +16,7 @@
 #include <glib-2.0/glib.h>
 
 #include <utils/utils.h>
+#include <utils/seqlock.h>
 #include <core/gpio.h>
 
 #define TANK_LEVEL_PERCENT_DEFAULT  200
@@ -24,6 +25,10 @@
 
 #define TANK_DB_FILE    "tank.db"
 
+#define TANK_LEVELS_PERIOD_MS   1000
+#define TANK_BUTTON_PERIOD_MS   200
+#define TANK_BUTTON_DELAY_MS    800
+
 typedef enum {
     TANK_GPIO_VALVE,
     TANK_GPIO_PUMP,
@@ -45,6 +50,13 @@ typedef struct {
     bool            state;
 } TankLevel;
 
+typedef struct {
+    unsigned    level;
+    bool        status;
+    bool        pump;
+    bool        valve;
+} TankState;
+
 typedef struct {
     char        name[SHORT_STR_LEN];
     GpioPin     *gpio[TANK_GPIO_MAX];
@@ -53,6 +65,7 @@ typedef struct {
     bool        status;
     bool        pump;
     bool        valve;
+    SeqLock     lock;
 } Tank;
 
 /**
@@ -155,6 +168,14 @@ bool TankValveSet(Tank *tank, bool status);
  */
 bool TankStatusGet(Tank *tank);
 
+/**
+ * @brief Get consistent copy of tank state without locking
+ * 
+ * @param tank Tank object
+ * @param state Out tank state
+ */
+void TankStateGet(Tank *tank, TankState *state);
+
 /**
  * @brief Start all tanks controllers
  * 
@@ -16,11 +16,16 @@
 #include <glib-2.0/glib.h>
 
 #include <utils/utils.h>
+#include <utils/seqlock.h>
 #include <core/gpio.h>
 #include <plc/plc.h>
 
 #define WATERER_DB_FILE    "watering.db"
 
+#define WATERER_PERIOD_MS           1000
+#define WATERER_BUTTON_PERIOD_MS    200
+#define WATERER_BUTTON_DELAY_MS     800
+
 typedef enum {
     WATERER_GPIO_VALVE,
     WATERER_GPIO_STATUS_LED,
@@ -40,8 +45,14 @@ typedef struct {
     GList   *times;
     bool    status;
     bool    valve;
+    SeqLock lock;
 } Waterer;
 
+typedef struct {
+    bool    status;
+    bool    valve;
+} WatererState;
+
 /**
  * @brief Make new Waterer object
  * 
@@ -120,6 +131,14 @@ bool WatererStatusSet(Waterer *wtr, bool status, bool save);
  */
 bool WatererValveSet(Waterer *wtr, bool status);
 
+/**
+ * @brief Get consistent copy of Waterer state without locking
+ * 
+ * @param wtr Waterer controller
+ * @param state Out Waterer state
+ */
+void WatererStateGet(Waterer *wtr, WatererState *state);
+
 /**
  * @brief Start all Waterer controllers
  * 
@@ -0,0 +1,129 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __CHANNEL_H__
+#define __CHANNEL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CHANNEL_PING_MS         1000
+#define CHANNEL_DEAD_MS         3000
+#define CHANNEL_CONNECT_MS      1000
+#define CHANNEL_RETRY_MS        3000
+#define CHANNEL_FRAME_MAX       (1024 * 1024)
+#define CHANNEL_CALLS_MAX       8
+#define CHANNEL_PARKED_MAX      256
+
+/**
+ * Channel is persistent TCP connection between units which carries
+ * API requests as frames:
+ *
+ * len (4 bytes), id (4 bytes), type (1 byte), payload
+ *
+ * Request payload is method, path with query, zero byte and post data.
+ * Reply payload is response body. Requests are pipelined and matched
+ * with replies by id, idle connection is checked by ping frames.
+ *
+ * Server runs up to CHANNEL_CALLS_MAX requests of connection on job
+ * pool. State long-polls and routed requests are parked instead, up to
+ * CHANNEL_PARKED_MAX per connection, they do not take job workers while
+ * waiting.
+ */
+
+typedef struct _ChannelCall ChannelCall;
+
+/**
+ * @brief Async call handler, it runs on reactor thread and must not
+ * block
+ *
+ * @param result True if reply is received
+ * @param payload Zero terminated reply body owned by handler, NULL on
+ * failure
+ * @param len Reply body length
+ * @param data User data
+ */
+typedef void (*ChannelFunc)(bool result, char *payload, size_t len, void *data);
+
+/**
+ * @brief Set bind address and port of channel server, 0 port disables it
+ *
+ * @param ip Channel server bind IP address
+ * @param port Channel server port
+ */
+void ChannelServerSet(const char *ip, unsigned port);
+
+/**
+ * @brief Start channel server, requests are processed by web server
+ * handlers
+ *
+ * @return True/False as result of starting server
+ */
+bool ChannelServerStart();
+
+/**
+ * @brief Send request to unit without waiting for reply
+ *
+ * @param ip Unit IP
+ * @param port Unit channel port
+ * @param path Request path with query
+ * @param post Post data or NULL for GET request
+ *
+ * @return Call handle for ChannelCallWait or NULL on error
+ */
+ChannelCall *ChannelCallStart(const char *ip, unsigned port, const char *path, const char *post);
+
+/**
+ * @brief Wait for reply and release call
+ *
+ * @param call Call handle, NULL is failed call
+ * @param out Out buffer for reply body
+ * @param out_size Out buffer size
+ * @param out_len Out reply length or NULL
+ * @param timeout_ms Max waiting time
+ *
+ * @return True/False as result of call
+ */
+bool ChannelCallWait(ChannelCall *call, char *out, size_t out_size, size_t *out_len, unsigned timeout_ms);
+
+/**
+ * @brief Send request to unit and call handler with reply, so caller
+ * does not hold a thread while unit answers long-poll request
+ *
+ * @param ip Unit IP
+ * @param port Unit channel port
+ * @param path Request path with query
+ * @param post Post data or NULL for GET request
+ * @param timeout_ms Call is failed when it is not answered in time
+ * @param func Handler called once with reply or failure
+ * @param data User data for handler
+ *
+ * @return False if request was not sent, handler is not called then
+ */
+bool ChannelCallAsync(const char *ip, unsigned port, const char *path, const char *post,
+                      unsigned timeout_ms, ChannelFunc func, void *data);
+
+/**
+ * @brief Send request to unit and wait for reply
+ *
+ * @param ip Unit IP
+ * @param port Unit channel port
+ * @param path Request path with query
+ * @param post Post data or NULL for GET request
+ * @param out Out buffer for reply body
+ * @param out_size Out buffer size
+ * @param timeout_ms Max waiting time
+ *
+ * @return True/False as result of request
+ */
+bool ChannelRequest(const char *ip, unsigned port, const char *path, const char *post,
+                    char *out, size_t out_size, unsigned timeout_ms);
+
+#endif /* __CHANNEL_H__ */
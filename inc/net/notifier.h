@@ -47,4 +47,11 @@ bool NotifierTelegramSend(const char *msg);
  */
 bool NotifierSmsSend(const char *msg);
 
+/**
+ * @brief Subscribe to controller events and send notifies in background
+ * 
+ * @return true/false as result of starting notifier
+ */
+bool NotifierStart();
+
 #endif /* __NOTIFIER_H__ */
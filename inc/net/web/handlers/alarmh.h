@@ -0,0 +1,29 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __ALARM_HANDLER_H__
+#define __ALARM_HANDLER_H__
+
+#include <stdbool.h>
+
+#include <fcgiapp.h>
+#include <glib-2.0/glib.h>
+
+/**
+ * @brief Get alarms state and history, acknowledge alarms
+ *
+ * @param req FastCGI request
+ * @param params Request URI params
+ *
+ * @return true/false as result of processing request
+ */
+bool HandlerAlarmProcess(FCGX_Request *req, GList **params);
+
+#endif /* __ALARM_HANDLER_H__ */
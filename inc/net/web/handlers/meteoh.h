@@ -15,6 +15,7 @@
 
 #include <fcgiapp.h>
 #include <glib-2.0/glib.h>
+#include <jansson.h>
 
 /**
  * @brief Manage meteo controller
@@ -26,4 +27,13 @@
  */
 bool HandlerMeteoProcess(FCGX_Request *req, GList **params);
 
+/**
+ * @brief Put meteo sensors into json object
+ *
+ * @param root Json object to fill
+ *
+ * @return true/false as result of getting state
+ */
+bool HandlerMeteoStateGet(json_t *root);
+
 #endif /* __METEO_HANDLER_H__ */
@@ -15,6 +15,7 @@
 
 #include <fcgiapp.h>
 #include <glib-2.0/glib.h>
+#include <jansson.h>
 
 /**
  * @brief Manage security controller
@@ -26,4 +27,13 @@
  */
 bool HandlerSecurityProcess(FCGX_Request *req, GList **params);
 
+/**
+ * @brief Put security status, alarm and sensors into json object
+ *
+ * @param root Json object to fill
+ *
+ * @return true/false as result of getting state
+ */
+bool HandlerSecurityStateGet(json_t *root);
+
 #endif /* __SECURITY_HANDLER_H__ */
@@ -15,6 +15,7 @@
 
 #include <fcgiapp.h>
 #include <glib-2.0/glib.h>
+#include <jansson.h>
 
 /**
  * @brief Manage socket controller
@@ -26,4 +27,13 @@
  */
 bool HandlerSocketProcess(FCGX_Request *req, GList **params);
 
+/**
+ * @brief Put sockets into json object
+ *
+ * @param root Json object to fill
+ *
+ * @return true/false as result of getting state
+ */
+bool HandlerSocketStateGet(json_t *root);
+
 #endif /* __SOCKET_HANDLER_H__ */
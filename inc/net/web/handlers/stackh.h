@@ -0,0 +1,40 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __STACK_HANDLER_H__
+#define __STACK_HANDLER_H__
+
+#include <stdbool.h>
+
+#include <fcgiapp.h>
+#include <glib-2.0/glib.h>
+
+/**
+ * @brief Process stack requests of upper master
+ *
+ * @param req FastCGI request
+ * @param params Request URI params
+ *
+ * @return true/false as result of processing request
+ */
+bool HandlerStackProcess(FCGX_Request *req, GList **params);
+
+/**
+ * @brief Pass request of upper master to unit of this stack and send
+ * unit reply back
+ *
+ * @param req FastCGI request
+ * @param unit Stack unit ID from route param
+ *
+ * @return true/false as result of processing request
+ */
+bool HandlerStackRouteProcess(FCGX_Request *req, unsigned unit);
+
+#endif /* __STACK_HANDLER_H__ */
@@ -15,6 +15,7 @@
 
 #include <fcgiapp.h>
 #include <glib-2.0/glib.h>
+#include <jansson.h>
 
 /**
  * @brief Manage tank controller
@@ -26,4 +27,13 @@
  */
 bool HandlerTankProcess(FCGX_Request *req, GList **params);
 
+/**
+ * @brief Put tanks into json object
+ *
+ * @param root Json object to fill
+ *
+ * @return true/false as result of getting state
+ */
+bool HandlerTankStateGet(json_t *root);
+
 #endif /* __TANK_HANDLER_H__ */
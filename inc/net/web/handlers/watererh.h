@@ -15,6 +15,7 @@
 
 #include <fcgiapp.h>
 #include <glib-2.0/glib.h>
+#include <jansson.h>
 
 /**
  * @brief Manage waterer controller
@@ -26,4 +27,13 @@
  */
 bool HandlerWatererProcess(FCGX_Request *req, GList **params);
 
+/**
+ * @brief Put waterers into json object
+ *
+ * @param root Json object to fill
+ *
+ * @return true/false as result of getting state
+ */
+bool HandlerWatererStateGet(json_t *root);
+
 #endif /* __WATERER_HANDLER_H__ */
@@ -47,4 +47,15 @@ bool ResponseFailSend(FCGX_Request *req, const char *module, const char *error);
  */
 bool ResponseOkSend(FCGX_Request *req, json_t *root);
 
+/**
+ * @brief Send FastCGI OK response with binary body
+ *
+ * @param req Request struct
+ * @param data Body data
+ * @param len Body length
+ *
+ * @return Returns true/false as result of sending response
+ */
+bool ResponseBinarySend(FCGX_Request *req, const void *data, size_t len);
+
 #endif /* __RESPONSE_H__ */
@@ -13,11 +13,44 @@
 
 #include <stdbool.h>
 
+#include <utils/utils.h>
+
+#define WEB_CLIENT_POOL_SIZE    4
+#define WEB_CLIENT_TIMEOUT_MS   10000
+#define WEB_CLIENT_CONNECT_MS   1000
+
 typedef enum {
     WEB_REQ_GET,
     WEB_REQ_POST
 } WebRequestType;
 
+typedef struct {
+    WebRequestType  type;
+    char            url[STR_LEN];
+    const char      *post;
+    char            *out;
+    size_t          out_size;
+    size_t          out_len;
+    bool            result;
+} WebClientReq;
+
+/**
+ * @brief Async request handler, it runs on web client thread and must
+ * not block
+ *
+ * @param req Finished request
+ * @param data User data
+ */
+typedef void (*WebClientFunc)(WebClientReq *req, void *data);
+
+typedef struct {
+    unsigned        hosts;
+    unsigned long   requests;
+    unsigned long   hits;
+    unsigned long   misses;
+    unsigned long   connects;
+} WebClientStats;
+
 /**
  * @brief HTTP request
  * 
@@ -30,6 +63,32 @@ typedef enum {
  */
 bool WebClientRequest(WebRequestType type, const char *url, const char *post, char *out);
 
+/**
+ * @brief Run several HTTP requests in parallel, every request fails
+ * when it is not finished within deadline or not connected within
+ * WEB_CLIENT_CONNECT_MS
+ *
+ * @param reqs Requests array, out_size of zero means BUFFER_LEN_MAX
+ * @param count Requests count
+ * @param timeout_ms Deadline of every request
+ *
+ * @return True if all requests succeeded
+ */
+bool WebClientMultiRequest(WebClientReq *reqs, unsigned count, unsigned timeout_ms);
+
+/**
+ * @brief Run HTTP request on shared transfer loop, so any number of
+ * long-poll requests is served by one thread
+ *
+ * @param req Request, must be kept until handler is called
+ * @param timeout_ms Request deadline
+ * @param func Handler called when request is finished or failed
+ * @param data User data for handler
+ *
+ * @return False if request was not started, handler is not called then
+ */
+bool WebClientAsyncRequest(WebClientReq *req, unsigned timeout_ms, WebClientFunc func, void *data);
+
 /**
  * @brief HTTP telegram photo request
  * 
@@ -55,4 +114,12 @@ bool WebClientPhotoRequest(const char *url, unsigned chat_id, const char *file,
  */
 bool WebClientDocumentRequest(const char *url, unsigned chat_id, const char *file, char *out);
 
+/**
+ * @brief Get handles pool stats, connects counts new TCP connections
+ * made by requests
+ *
+ * @param stats Out stats
+ */
+void WebClientStatsGet(WebClientStats *stats);
+
 #endif /* __WEB_CLIENT_H__ */
@@ -13,7 +13,10 @@
 
 #include <stdbool.h>
 
+#include <fcgiapp.h>
+
 #define SERVER_API_VER  "v1"
+#define SERVER_WORKERS  4
 
 /**
  * @brief Set server credentials
@@ -23,6 +26,14 @@
  */
 void WebServerCredsSet(const char *host, unsigned port);
 
+/**
+ * @brief Process one request by API handlers. Used by FastCGI workers
+ * and by other transports which fill request streams and params.
+ *
+ * @param req Request with SCRIPT_NAME and REQUEST_URI params
+ */
+void WebServerRequestProcess(FCGX_Request *req);
+
 /**
  * @brief Starting FastCGI web server
  * 
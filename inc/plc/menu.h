@@ -22,6 +22,10 @@
 #include <controllers/tank.h>
 #include <controllers/socket.h>
 
+#define MENU_CLOCK_PERIOD_MS    1000
+#define MENU_BUTTON_PERIOD_MS   200
+#define MENU_BUTTON_DELAY_MS    800
+
 typedef enum {
     MENU_GPIO_UP,
     MENU_GPIO_MIDDLE,
@@ -12,14 +12,46 @@
 #define __PLC_H__
 
 #include <stdbool.h>
+#include <time.h>
 
 #include <core/gpio.h>
 
+#define PLC_ALARM_PERIOD_MS     500
+#define PLC_ALARM_FAST_MS       150
+#define PLC_ALARM_HISTORY_LEN   32
+#define PLC_STATS_PERIOD_MS     600000
+
 typedef enum {
-    PLC_ALARM_SECURITY  = 0x1,
-    PLC_ALARM_TANK      = 0x2
+    PLC_ALARM_SECURITY,
+    PLC_ALARM_TANK,
+    PLC_ALARM_MAX
 } PlcAlarmType;
 
+typedef enum {
+    PLC_ALARM_PRIO_LOW,
+    PLC_ALARM_PRIO_HIGH
+} PlcAlarmPriority;
+
+typedef enum {
+    PLC_ALARM_STATE_NORMAL,
+    PLC_ALARM_STATE_ACTIVE,
+    PLC_ALARM_STATE_ACKED,
+    PLC_ALARM_STATE_LATCHED
+} PlcAlarmState;
+
+typedef enum {
+    PLC_ALARM_ACTION_RAISED,
+    PLC_ALARM_ACTION_CLEARED,
+    PLC_ALARM_ACTION_ACKED
+} PlcAlarmAction;
+
+typedef struct {
+    PlcAlarmType    type;
+    PlcAlarmAction  action;
+    PlcAlarmState   state;
+    time_t          time;
+} PlcAlarmRecord;
+
 typedef enum {
     PLC_GPIO_ALARM_LED,
     PLC_GPIO_BUZZER,
@@ -56,11 +88,13 @@ typedef struct {
 void PlcTimeTypeSet(PlcTimeType type);
 
 /**
- * @brief Get current time
+ * @brief Get current time, cached until next second
  *
- * @param time Current time
+ * @param tm Current time
+ *
+ * @return True/False as result of getting time
  */
-bool PlcTimeGet(PlcTime *time);
+bool PlcTimeGet(PlcTime *tm);
 
 /**
  * @brief Set GPIO by type
@@ -71,15 +105,70 @@ bool PlcTimeGet(PlcTime *time);
 void PlcGpioSet(PlcGpioType type, GpioPin *gpio);
 
 /**
- * @brief Set alarm LED status
+ * @brief Raise or clear alarm condition. Unacknowledged alarms blink alarm
+ * LED, high priority ones faster, acknowledged active alarms keep it lit.
+ * Latching alarm stays latched after clearing until acknowledged.
  *
  * @param type Alarm Type
- * @param status Alarm status
+ * @param status Alarm condition status
  */
 void PlcAlarmSet(PlcAlarmType type, bool status);
 
 /**
- * @brief Set Buzzer sound
+ * @brief Acknowledge alarm
+ *
+ * @param type Alarm Type
+ *
+ * @return True if alarm was waiting for acknowledgement
+ */
+bool PlcAlarmAck(PlcAlarmType type);
+
+/**
+ * @brief Acknowledge all alarms
+ */
+void PlcAlarmAckAll();
+
+/**
+ * @brief Get current alarm state
+ *
+ * @param type Alarm Type
+ *
+ * @return Alarm state
+ */
+PlcAlarmState PlcAlarmStateGet(PlcAlarmType type);
+
+/**
+ * @brief Get alarm name
+ *
+ * @param type Alarm Type
+ *
+ * @return Alarm name
+ */
+const char *PlcAlarmNameGet(PlcAlarmType type);
+
+/**
+ * @brief Find alarm by name
+ *
+ * @param name Alarm name
+ * @param type Out alarm type
+ *
+ * @return true/false as result of finding alarm
+ */
+bool PlcAlarmTypeGet(const char *name, PlcAlarmType *type);
+
+/**
+ * @brief Get alarms history
+ *
+ * @param records Out records, newest first
+ * @param max Max records count
+ *
+ * @return Count of copied records
+ */
+unsigned PlcAlarmHistoryGet(PlcAlarmRecord *records, unsigned max);
+
+/**
+ * @brief Start or stop buzzer pattern, higher priority pattern pre-empts
+ * lower one which is resumed from the start when it is finished
  *
  * @param type Buzzer sound type
  * @param status Buzzer sttaus
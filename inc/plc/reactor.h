@@ -0,0 +1,94 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+#include <stdbool.h>
+
+#include <utils/periodic.h>
+
+#define REACTOR_THREADS     4
+
+/**
+ * @brief File descriptor ready handler
+ * 
+ * @param fd Readable file descriptor, handler must consume its data
+ * @param data User data
+ */
+typedef void (*ReactorFunc)(int fd, void *data);
+
+/**
+ * @brief Create epoll instance and start reactor threads
+ * 
+ * @return true/false as result of starting reactor
+ */
+bool ReactorStart();
+
+/**
+ * @brief Call handler every time when file descriptor becomes readable
+ * 
+ * @param fd File descriptor
+ * @param func Handler
+ * @param data User data for handler
+ * 
+ * @return true/false as result of adding descriptor
+ */
+bool ReactorFdAdd(int fd, ReactorFunc func, void *data);
+
+/**
+ * @brief Call blocking handler on job pool every time when file
+ * descriptor becomes readable, descriptor is not watched until
+ * handler returns
+ * 
+ * @param fd File descriptor
+ * @param func Handler
+ * @param data User data for handler
+ * 
+ * @return true/false as result of adding descriptor
+ */
+bool ReactorJobFdAdd(int fd, ReactorFunc func, void *data);
+
+/**
+ * @brief Stop watching file descriptor, must be called from its own
+ * handler, descriptor can be closed after that
+ * 
+ * @param fd File descriptor
+ * 
+ * @return true/false as result of removing descriptor
+ */
+bool ReactorFdRemove(int fd);
+
+/**
+ * @brief Run periodic task on reactor threads using timerfd
+ * 
+ * @param name Task name for logging
+ * @param period_ms Period in milliseconds
+ * @param func Task body
+ * @param data User data for task body
+ * 
+ * @return true/false as result of adding task
+ */
+bool ReactorTaskAdd(const char *name, unsigned period_ms, PeriodicFunc func, void *data);
+
+/**
+ * @brief Run blocking periodic task on job pool, timer is rearmed
+ * when task body returns
+ * 
+ * @param name Task name for logging
+ * @param period_ms Period in milliseconds
+ * @param func Task body
+ * @param data User data for task body
+ * 
+ * @return true/false as result of adding task
+ */
+bool ReactorJobTaskAdd(const char *name, unsigned period_ms, PeriodicFunc func, void *data);
+
+#endif /* __REACTOR_H__ */
@@ -0,0 +1,153 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __LOGIC_H__
+#define __LOGIC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glib-2.0/glib.h>
+
+#include <utils/utils.h>
+
+#define LOGIC_REGS_MAX          128
+#define LOGIC_CODE_MAX          512
+#define LOGIC_SLOTS_MAX         32
+#define LOGIC_PERIOD_MS_DEFAULT 100
+#define LOGIC_BENCH_SCANS       1000000
+
+typedef enum {
+    LOGIC_OP_END,
+    LOGIC_OP_LOADK,
+    LOGIC_OP_MOV,
+    LOGIC_OP_NOT,
+    LOGIC_OP_NEG,
+    LOGIC_OP_AND,
+    LOGIC_OP_OR,
+    LOGIC_OP_XOR,
+    LOGIC_OP_ADD,
+    LOGIC_OP_SUB,
+    LOGIC_OP_MUL,
+    LOGIC_OP_DIV,
+    LOGIC_OP_MOD,
+    LOGIC_OP_EQ,
+    LOGIC_OP_NE,
+    LOGIC_OP_LT,
+    LOGIC_OP_LE,
+    LOGIC_OP_GT,
+    LOGIC_OP_GE,
+    LOGIC_OP_SEL,
+    LOGIC_OP_TON,
+    LOGIC_OP_TOF,
+    LOGIC_OP_CTU,
+    LOGIC_OP_CTD,
+    LOGIC_OP_RTRIG,
+    LOGIC_OP_GPIO_GET,
+    LOGIC_OP_GPIO_SET,
+    LOGIC_OP_SOCKET_GET,
+    LOGIC_OP_SOCKET_SET,
+    LOGIC_OP_TANK_GET,
+    LOGIC_OP_METEO_GET
+} LogicOp;
+
+typedef enum {
+    LOGIC_IO_GPIO,
+    LOGIC_IO_SOCKET,
+    LOGIC_IO_TANK,
+    LOGIC_IO_METEO
+} LogicIoType;
+
+typedef struct {
+    uint8_t     op;
+    uint8_t     dst;
+    uint8_t     a;
+    uint8_t     b;
+    uint8_t     c;
+    uint8_t     slot;
+    int32_t     imm;
+} LogicInstr;
+
+typedef struct {
+    bool        in;
+    bool        q;
+    uint64_t    start;
+} LogicTimer;
+
+typedef struct {
+    bool        in;
+    int32_t     cv;
+} LogicCounter;
+
+typedef struct {
+    LogicIoType type;
+    void        *obj;
+    int32_t     last;
+} LogicIo;
+
+typedef struct {
+    char            name[SHORT_STR_LEN];
+    unsigned        period_ms;
+    LogicInstr      code[LOGIC_CODE_MAX];
+    unsigned        code_len;
+    int32_t         regs[LOGIC_REGS_MAX];
+    unsigned        vars_count;
+    LogicTimer      timers[LOGIC_SLOTS_MAX];
+    unsigned        timers_count;
+    LogicCounter    counters[LOGIC_SLOTS_MAX];
+    unsigned        counters_count;
+    LogicIo         io[LOGIC_SLOTS_MAX];
+    unsigned        io_count;
+    uint64_t        scans;
+} LogicProgram;
+
+/**
+ * @brief Compile program from ST-like statements, one assignment per
+ * statement, e.g. socket("Lamp") := TOF(gpio("IN1"), 60000) AND NOT day
+ *
+ * @param name Program name
+ * @param period_ms Scan cycle period
+ * @param lines Program statements
+ * @param count Statements count
+ *
+ * @return Compiled program or NULL on error
+ */
+LogicProgram *LogicProgramCompile(const char *name, unsigned period_ms, const char **lines, unsigned count);
+
+/**
+ * @brief Add compiled program to scan list
+ *
+ * @param prog Compiled program
+ */
+void LogicProgramAdd(LogicProgram *prog);
+
+/**
+ * @brief Run one scan cycle of program, never allocates memory
+ *
+ * @param prog Compiled program
+ * @param now_ms Scan time in milliseconds of monotonic clock
+ */
+void LogicProgramScan(LogicProgram *prog, uint64_t now_ms);
+
+/**
+ * @brief Start scan cycles of all added programs
+ *
+ * @return True/False as result of starting programs
+ */
+bool LogicStart();
+
+/**
+ * @brief Measure interpreter speed on built-in program and print it
+ *
+ * @return True/False as result of benchmark
+ */
+bool LogicBenchmark();
+
+#endif /* __LOGIC_H__ */
@@ -12,18 +12,51 @@
 #define __SCENARIO_H__
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include <glib-2.0/glib.h>
 
 #include <utils/utils.h>
+#include <utils/events.h>
+
+#define SCENARIO_ACTIONS_MAX    64
 
 typedef enum {
     SCENARIO_IN_HOME,
-    SCENARIO_OUT_HOME
+    SCENARIO_OUT_HOME,
+    SCENARIO_TYPE_MAX
 } ScenarioType;
 
 typedef enum {
-    SECURITY_CTRL_SOCKET
+    SCENARIO_CTRL_SOCKET,
+    SCENARIO_CTRL_SECURITY,
+    SCENARIO_CTRL_TANK,
+    SCENARIO_CTRL_WATERER,
+    SCENARIO_CTRL_METEO,
+    SCENARIO_CTRL_MAX
 } ScenarioCtrlType;
 
+typedef enum {
+    SCENARIO_FIELD_ANY,
+    SCENARIO_FIELD_STATUS,
+    SCENARIO_FIELD_ALARM,
+    SCENARIO_FIELD_LEVEL,
+    SCENARIO_FIELD_PUMP,
+    SCENARIO_FIELD_VALVE,
+    SCENARIO_FIELD_TEMP,
+    SCENARIO_FIELD_ERROR,
+    SCENARIO_FIELD_MAX
+} ScenarioField;
+
+typedef enum {
+    SCENARIO_CMP_EQ,
+    SCENARIO_CMP_NE,
+    SCENARIO_CMP_LT,
+    SCENARIO_CMP_LE,
+    SCENARIO_CMP_GT,
+    SCENARIO_CMP_GE
+} ScenarioCmp;
+
 typedef struct {
     char    name[SHORT_STR_LEN];
     bool    status;
@@ -36,18 +69,98 @@ typedef struct {
     ScenarioSocket      socket;
 } Scenario;
 
+typedef struct {
+    ScenarioField   field;
+    ScenarioCmp     cmp;
+    float           value;
+} ScenarioTest;
+
+typedef struct {
+    EventType       event;
+    char            name[SHORT_STR_LEN];
+    ScenarioTest    test;
+} ScenarioTrigger;
+
+typedef struct {
+    ScenarioCtrlType    ctrl;
+    char                name[SHORT_STR_LEN];
+    void                *obj;
+    ScenarioTest        test;
+} ScenarioCondition;
+
+typedef struct {
+    ScenarioCtrlType    ctrl;
+    ScenarioField       field;
+    unsigned            unit;
+    char                name[SHORT_STR_LEN];
+    bool                status;
+} ScenarioAction;
+
+typedef struct {
+    char            name[SHORT_STR_LEN];
+    ScenarioTrigger trigger;
+    GList           *conditions;
+    GList           *actions;
+    GList           *matched;
+} ScenarioRule;
+
+typedef struct {
+    unsigned    count;
+    unsigned    failed;
+    unsigned    requests;
+    bool        results[SCENARIO_ACTIONS_MAX];
+    uint64_t    latency_us;
+} ScenarioResult;
+
 /**
  * @brief Add new scenario to list
- * 
+ *
  * @param scenario Scenario with params
  */
 void ScenarioAdd(Scenario *scenario);
 
 /**
  * @brief Start all scenario by type
- * 
+ *
  * @param type Scenario type
  */
 bool ScenarioStart(ScenarioType type);
 
+/**
+ * @brief Run actions grouped by unit, one batch request per unit, all
+ * units are dispatched in parallel
+ *
+ * @param actions List of ScenarioAction, up to SCENARIO_ACTIONS_MAX
+ * @param result Out result of every action in list order and total latency
+ *
+ * @return True if all actions succeeded
+ */
+bool ScenarioActionsRun(GList *actions, ScenarioResult *result);
+
+/**
+ * @brief Make new empty rule
+ *
+ * @param name Rule name for logging
+ *
+ * @return Rule struct
+ */
+ScenarioRule *ScenarioRuleNew(const char *name);
+
+/**
+ * @brief Validate rule and put it into event index. Rule fires when its
+ * trigger test becomes true, or on every event for SCENARIO_FIELD_ANY.
+ *
+ * @param rule Rule with trigger, conditions and actions
+ *
+ * @return True/False as result of adding rule
+ */
+bool ScenarioRuleAdd(ScenarioRule *rule);
+
+/**
+ * @brief Subscribe to events used by rules triggers
+ *
+ * @return True/False as result of starting rules
+ */
+bool ScenarioRulesStart();
+
 #endif /* __SCENARIO_H__ */
@@ -0,0 +1,45 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __BREAKER_H__
+#define __BREAKER_H__
+
+#include <stdbool.h>
+
+#define BREAKER_FAILURES        3
+#define BREAKER_OPEN_MS         1000
+#define BREAKER_OPEN_MAX_MS     60000
+
+/**
+ * Every stack unit has circuit breaker. After BREAKER_FAILURES failed
+ * requests in a row breaker opens and requests to unit fail at once.
+ * When open time is over one probe request is let through: success
+ * closes breaker, failure opens it again for twice longer time up to
+ * BREAKER_OPEN_MAX_MS.
+ */
+
+/**
+ * @brief Check request to unit may be sent
+ *
+ * @param unit Stack unit ID
+ *
+ * @return True if request may be sent, False if unit is cut off
+ */
+bool BreakerAllow(unsigned unit);
+
+/**
+ * @brief Report result of request which was allowed
+ *
+ * @param unit Stack unit ID
+ * @param result Result of request
+ */
+void BreakerResult(unsigned unit, bool result);
+
+#endif /* __BREAKER_H__ */
@@ -0,0 +1,56 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __DISCOVERY_H__
+#define __DISCOVERY_H__
+
+#include <stdbool.h>
+
+#define DISCOVERY_GROUP         "239.255.77.1"
+#define DISCOVERY_PORT          9700
+#define DISCOVERY_PERIOD_MS     1000
+#define DISCOVERY_MISSED        3
+
+/**
+ * Every unit sends heartbeat to multicast group with its id, name,
+ * web port, channel port, API version and state version. Listening
+ * unit adds unknown units to stack and marks unit offline when
+ * DISCOVERY_MISSED heartbeats in a row are missed.
+ */
+
+/**
+ * @brief Set multicast group and heartbeat timing
+ *
+ * @param group Multicast group address
+ * @param port Multicast UDP port
+ * @param period_ms Heartbeat period
+ * @param missed Missed heartbeats count to mark unit offline
+ */
+void DiscoverySet(const char *group, unsigned port, unsigned period_ms, unsigned missed);
+
+/**
+ * @brief Set this unit params for heartbeats, units without it only
+ * listen
+ *
+ * @param id Unit ID in stack
+ * @param name Unit name
+ * @param port Unit web port
+ * @param channel Unit channel port or 0
+ */
+void DiscoveryUnitSet(unsigned id, const char *name, unsigned port, unsigned channel);
+
+/**
+ * @brief Start sending and receiving heartbeats
+ *
+ * @return True/False as result of starting discovery
+ */
+bool DiscoveryStart();
+
+#endif /* __DISCOVERY_H__ */
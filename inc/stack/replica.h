@@ -0,0 +1,73 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __REPLICA_H__
+#define __REPLICA_H__
+
+#include <stdbool.h>
+
+#include <stack/rpc.h>
+
+#define REPLICA_WAIT_MS     25000
+#define REPLICA_RETRY_MS    3000
+#define REPLICA_STALE_MS    30000
+
+/**
+ * Reads below are served from mirror only when it is fresh: unit is
+ * online, subscription replied within REPLICA_STALE_MS and there are
+ * no writes to unit which mirror may miss. Otherwise False is returned
+ * and caller asks unit directly.
+ */
+
+/**
+ * @brief Start mirroring state of all stack units. Every unit is
+ * subscribed by long-poll request, so mirror is updated right after
+ * changes on unit.
+ *
+ * @return True/False as result of starting replication
+ */
+bool ReplicaStart();
+
+/**
+ * @brief Start mirroring state of unit which joined after start
+ *
+ * @param unit Stack unit
+ *
+ * @return True/False as result of starting replication
+ */
+bool ReplicaUnitAdd(unsigned unit);
+
+/**
+ * @brief Get copy of mirrored unit state
+ *
+ * @param unit Stack unit
+ * @param state Out full state, must be released by RpcUnitStateFree
+ *
+ * @return False if unit state is not synced
+ */
+bool ReplicaStateGet(unsigned unit, RpcUnitState *state);
+
+/**
+ * @brief Mark unit mirror as outdated until next subscription reply,
+ * must be called after every write to unit
+ *
+ * @param unit Stack unit
+ */
+void ReplicaWriteNotify(unsigned unit);
+
+bool ReplicaSecurityStatusGet(unsigned unit, bool *status);
+bool ReplicaSecurityAlarmGet(unsigned unit, bool *alarm);
+bool ReplicaSecuritySensorsGet(unsigned unit, GList **sensors);
+bool ReplicaMeteoSensorsGet(unsigned unit, GList **sensors);
+bool ReplicaSocketsGet(unsigned unit, GList **sockets);
+bool ReplicaTanksGet(unsigned unit, GList **tanks);
+bool ReplicaWaterersGet(unsigned unit, GList **waterers);
+
+#endif /* __REPLICA_H__ */
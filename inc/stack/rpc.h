@@ -12,8 +12,11 @@
 #define __RPC_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <utils/utils.h>
+#include <stack/stack.h>
+#include <plc/plc.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -22,9 +25,85 @@
 /*********************************************************************/
 
 #define RPC_DEFAULT_UNIT    0
+#define RPC_TIMEOUT_MS      3000
+
+typedef struct {
+    unsigned    unit;
+    bool        online;
+} RpcUnitCheck;
 
 bool RpcUnitStatusCheck(unsigned unit);
 
+/**
+ * @brief Check units status in parallel
+ *
+ * @param checks Units to check, online field is set by result
+ * @param count Units count
+ * @param timeout_ms Deadline of every unit request
+ */
+void RpcUnitsStatusCheck(RpcUnitCheck *checks, unsigned count, unsigned timeout_ms);
+
+typedef struct {
+    unsigned    id;
+    char        name[SHORT_STR_LEN];
+    char        ip[SHORT_STR_LEN];
+    unsigned    port;
+    bool        active;
+    unsigned    path[STACK_PATH_MAX];
+    unsigned    hops;
+} RpcStackUnit;
+
+/**
+ * @brief Get units of unit stack with their paths from that unit,
+ * default unit gives units of this stack
+ *
+ * @param unit Stack unit ID
+ * @param units Out RpcStackUnit list
+ *
+ * @return True/False as result of request
+ */
+bool RpcStackUnitsGet(unsigned unit, GList **units);
+
+/**
+ * @brief Send request to unit of this stack and get raw reply, used
+ * by sub-master to pass requests of upper master
+ *
+ * @param unit Stack unit ID
+ * @param path Request path with query
+ * @param post Post data or NULL for GET request
+ * @param out Out buffer for reply body
+ * @param out_size Out buffer size
+ * @param out_len Out reply length
+ *
+ * @return True/False as result of request
+ */
+bool RpcRouteRequest(unsigned unit, const char *path, const char *post, char *out, size_t out_size, size_t *out_len);
+
+/**
+ * @brief Routed request handler, it runs on job pool
+ *
+ * @param result True/False as result of request
+ * @param out Reply body
+ * @param out_len Reply length
+ * @param data User data
+ */
+typedef void (*RpcRouteFunc)(bool result, const char *out, size_t out_len, void *data);
+
+/**
+ * @brief Send request to unit of this stack like RpcRouteRequest
+ * without holding a thread while unit answers, so routed long-poll
+ * does not take a worker of sub-master
+ *
+ * @param unit Stack unit ID
+ * @param path Request path with query
+ * @param post Post data or NULL for GET request
+ * @param func Handler called once with reply
+ * @param data User data for handler
+ *
+ * @return False if request was not started, handler is not called then
+ */
+bool RpcRouteAsync(unsigned unit, const char *path, const char *post, RpcRouteFunc func, void *data);
+
 /*********************************************************************/
 /*                                                                   */
 /*                         SECURITY FUNCTIONS                        */
@@ -43,12 +122,32 @@ typedef struct {
     bool                    detected;
 } RpcSecuritySensor;
 
+typedef struct {
+    unsigned    unit;
+    bool        status;
+    bool        alarm;
+    uint64_t    version;
+    bool        result;
+} RpcSecurityState;
+
 bool RpcSecurityStatusSet(unsigned unit, bool status);
 bool RpcSecurityStatusGet(unsigned unit, bool *status);
 bool RpcSecurityAlarmSet(unsigned unit, bool alarm);
 bool RpcSecurityAlarmGet(unsigned unit, bool *alarm);
 bool RpcSecuritySensorsGet(unsigned unit, GList **sensors);
 
+/**
+ * @brief Reconcile security state of several units in parallel. Every
+ * unit applies given status and alarm if their version is newer than
+ * its own and replies its resulting state, so version 0 only reads it.
+ *
+ * @param states Units with state to apply, replaced by units state,
+ * result is false for failed units
+ * @param count Units count
+ * @param timeout_ms Deadline of every unit request
+ */
+void RpcSecurityReconcile(RpcSecurityState *states, unsigned count, unsigned timeout_ms);
+
 /*********************************************************************/
 /*                                                                   */
 /*                           METEO FUNCTIONS                         */
@@ -151,4 +250,203 @@ bool RpcWatererPumpSet(unsigned unit, const char *name, bool status);
 bool RpcWatererValveSet(unsigned unit, const char *name, bool status);
 bool RpcWaterersGet(unsigned unit, GList **waterers);
 
+/*********************************************************************/
+/*                                                                   */
+/*                            BATCH FUNCTIONS                        */
+/*                                                                   */
+/*********************************************************************/
+
+#define RPC_BATCH_MAX   32
+
+typedef enum {
+    RPC_BATCH_SOCKET_STATUS,
+    RPC_BATCH_SECURITY_STATUS,
+    RPC_BATCH_SECURITY_ALARM,
+    RPC_BATCH_TANK_STATUS,
+    RPC_BATCH_TANK_PUMP,
+    RPC_BATCH_TANK_VALVE,
+    RPC_BATCH_WATERER_STATUS,
+    RPC_BATCH_WATERER_VALVE,
+    RPC_BATCH_CMD_MAX
+} RpcBatchCmd;
+
+typedef struct {
+    RpcBatchCmd cmd;
+    char        name[SHORT_STR_LEN];
+    bool        status;
+    bool        result;
+} RpcBatchAction;
+
+/**
+ * @brief Get batch command name used in requests
+ *
+ * @param cmd Batch command
+ *
+ * @return Command name or NULL
+ */
+const char *RpcBatchCmdName(RpcBatchCmd cmd);
+
+/**
+ * @brief Run set commands on unit by one request, result of every
+ * action is stored into its result field
+ *
+ * @param unit Stack unit
+ * @param actions Actions array, up to RPC_BATCH_MAX
+ * @param count Actions count
+ *
+ * @return True if all actions succeeded
+ */
+bool RpcBatchRun(unsigned unit, RpcBatchAction *actions, unsigned count);
+
+/*********************************************************************/
+/*                                                                   */
+/*                            ALARM FUNCTIONS                        */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    char            name[SHORT_STR_LEN];
+    PlcAlarmState   state;
+} RpcAlarm;
+
+typedef struct {
+    char            name[SHORT_STR_LEN];
+    PlcAlarmAction  action;
+    PlcAlarmState   state;
+    time_t          time;
+} RpcAlarmRecord;
+
+/**
+ * @brief Get state of every unit alarm
+ *
+ * @param unit Stack unit
+ * @param alarms Out list of RpcAlarm
+ *
+ * @return True/False as result of getting alarms
+ */
+bool RpcAlarmsGet(unsigned unit, GList **alarms);
+
+/**
+ * @brief Get unit alarms history
+ *
+ * @param unit Stack unit
+ * @param records Out list of RpcAlarmRecord, newest first
+ *
+ * @return True/False as result of getting history
+ */
+bool RpcAlarmHistoryGet(unsigned unit, GList **records);
+
+/**
+ * @brief Acknowledge unit alarm
+ *
+ * @param unit Stack unit
+ * @param name Alarm name or NULL for all alarms
+ * @param acked Out true if alarm was waiting for acknowledgement
+ *
+ * @return True/False as result of acknowledging
+ */
+bool RpcAlarmAck(unsigned unit, const char *name, bool *acked);
+
+/*********************************************************************/
+/*                                                                   */
+/*                            STATE FUNCTIONS                        */
+/*                                                                   */
+/*********************************************************************/
+
+#define RPC_STATE_BUF_LEN       65536
+#define RPC_STATE_BENCH_ROUNDS  10000
+#define RPC_BENCH_CALLS         1000
+#define RPC_BENCH_PARALLEL      4
+
+typedef struct {
+    uint64_t    version;
+    bool        delta;
+    bool        security_changed;
+    bool        security_status;
+    bool        security_alarm;
+    GList       *security_sensors;
+    GList       *meteo_sensors;
+    GList       *sockets;
+    GList       *tanks;
+    GList       *waterers;
+} RpcUnitState;
+
+/**
+ * @brief Get state of all unit controllers by one request
+ *
+ * @param unit Stack unit
+ * @param state Out state, must be released by RpcUnitStateFree
+ *
+ * @return True/False as result of getting state
+ */
+bool RpcUnitStateGet(unsigned unit, RpcUnitState *state);
+
+/**
+ * @brief Get unit objects changed after version. If delta is set, lists
+ * hold only changed objects, security status and alarm are valid only
+ * with security_changed and empty lists mean no changes, otherwise
+ * state is full because unit change log does not cover version.
+ * With wait_ms unit holds reply until anything is changed (long-poll).
+ *
+ * @param unit Stack unit
+ * @param since Last version known by caller
+ * @param wait_ms Max time to wait for changes, 0 to reply at once
+ * @param state Out state, must be released by RpcUnitStateFree
+ *
+ * @return True/False as result of getting changes
+ */
+bool RpcUnitChangesGet(unsigned unit, uint64_t since, unsigned wait_ms, RpcUnitState *state);
+
+/**
+ * @brief Async state handler, it runs on job pool
+ *
+ * @param result True/False as result of getting changes
+ * @param state Unit changes owned by handler, must be released by
+ * RpcUnitStateFree
+ * @param data User data
+ */
+typedef void (*RpcStateFunc)(bool result, RpcUnitState *state, void *data);
+
+/**
+ * @brief Subscribe to unit changes like RpcUnitChangesGet without
+ * holding a thread while unit waits for changes. Replies come by
+ * channel or by shared web client loop.
+ *
+ * @param unit Stack unit, local unit is not subscribed
+ * @param since Last version known by caller
+ * @param wait_ms Max time to wait for changes, 0 to reply at once
+ * @param func Handler called once with result
+ * @param data User data for handler
+ *
+ * @return False if request was not started, handler is not called then
+ */
+bool RpcUnitChangesAsync(unsigned unit, uint64_t since, unsigned wait_ms, RpcStateFunc func, void *data);
+
+/**
+ * @brief Free lists of unit state
+ *
+ * @param state Unit state
+ */
+void RpcUnitStateFree(RpcUnitState *state);
+
+/**
+ * @brief Measure binary and JSON state encoding on built-in unit state
+ * and print payload size and time per encode and decode
+ *
+ * @return True/False as result of benchmark
+ */
+bool RpcStateBenchmark();
+
+/**
+ * @brief Send state request of RpcUnitStateGet to unit over channel
+ * and over HTTP, RPC_BENCH_CALLS one by one for latency and by
+ * RPC_BENCH_PARALLEL at once for throughput, and print both. Reactor
+ * must be started for channel replies.
+ *
+ * @param unit Stack unit with channel
+ *
+ * @return True/False as result of benchmark
+ */
+bool RpcTransportBenchmark(unsigned unit);
+
 #endif /* __RPC_H__ */
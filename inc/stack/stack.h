@@ -15,13 +15,38 @@
 
 #include <stdbool.h>
 
+#define STACK_PERIOD_MS     3000
+#define STACK_TIMEOUT_MS    1000
+#define STACK_PATH_MAX      4
+
+/**
+ * Unit may be sub-master which has own stack. Master asks sub-master
+ * for its units once per period and reaches them through it, units
+ * of sub-master are checked and synced by sub-master. Unit path holds
+ * sub-masters IDs from this unit down to unit, requests go to path[0]
+ * with route param. Unit IDs are unique over all levels, ip:port
+ * pairs may repeat behind different sub-masters, requests are routed
+ * by unit ID.
+ *
+ * Units are added at runtime by discovery and sub-masters and are never
+ * freed. ID, name, submaster flag and path do not change after unit is
+ * added, other fields and units list are read and changed under
+ * StackLock or read by StackUnitCopy.
+ */
+
 typedef struct {
     unsigned    id;
     char        name[SHORT_STR_LEN];
     char        ip[SHORT_STR_LEN];
     unsigned    port;
+    unsigned    channel;
     bool        active;
     bool        error;
+    bool        announced;
+    uint64_t    version;
+    bool        submaster;
+    unsigned    path[STACK_PATH_MAX];
+    unsigned    hops;
 } StackUnit;
 
 /**
@@ -78,12 +103,32 @@ bool StackUnitNameCheck(const char *name);
 void StackActiveUnitsGet(GList **units);
 
 /**
- * @brief Get all stack units
+ * @brief Get all stack units, list is walked under StackLock only
  * 
  * @return Active units list
 */
 GList **StackUnitsGet();
 
+/**
+ * @brief Copy stack unit by ID
+ *
+ * @param id Stack unit ID
+ * @param unit Out unit copy
+ *
+ * @return True if unit exists
+ */
+bool StackUnitCopy(unsigned id, StackUnit *unit);
+
+/**
+ * @brief Lock stack units list and units fields, lock is recursive
+ */
+void StackLock();
+
+/**
+ * @brief Unlock stack units list and units fields
+ */
+void StackUnlock();
+
 /**
  * @brief Start stack units monitoring
  * 
@@ -0,0 +1,67 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __STATE_CODEC_H__
+#define __STATE_CODEC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <stack/rpc.h>
+
+#define STATE_CODEC_MAGIC   0xB5
+#define STATE_CODEC_VER     1
+#define STATE_CODEC_FORMAT  "bin"
+
+/**
+ * Binary unit state is used between units instead of JSON. Fields go
+ * in fixed order of Rpc* structs, integers are varints, names are
+ * length-prefixed, so there are no keys and no text numbers:
+ *
+ * magic, ver, flags, version,
+ * security sensors, meteo sensors, sockets, tanks, waterers
+ *
+ * Every list is items count followed by items.
+ */
+
+/**
+ * @brief Encode unit state
+ *
+ * @param state Unit state
+ * @param buf Out buffer
+ * @param size Out buffer size
+ *
+ * @return Encoded length or 0 if buffer is too small
+ */
+size_t StateEncode(const RpcUnitState *state, uint8_t *buf, size_t size);
+
+/**
+ * @brief Check that buffer holds binary unit state, not JSON reply
+ *
+ * @param buf Reply buffer
+ * @param len Reply length
+ *
+ * @return True if buffer is binary state
+ */
+bool StateEncodedCheck(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Decode unit state
+ *
+ * @param buf Encoded state
+ * @param len Encoded length
+ * @param state Out state, must be released by RpcUnitStateFree
+ *
+ * @return True/False as result of decoding
+ */
+bool StateDecode(const uint8_t *buf, size_t len, RpcUnitState *state);
+
+#endif /* __STATE_CODEC_H__ */
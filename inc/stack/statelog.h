@@ -0,0 +1,97 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+
+#ifndef __STATE_LOG_H__
+#define __STATE_LOG_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glib-2.0/glib.h>
+
+#include <utils/utils.h>
+
+#define STATE_LOG_LEN           256
+#define STATE_WAIT_MAX_MS       30000
+#define STATE_NOTIFY_TICK_MS    1000
+
+typedef enum {
+    STATE_SECTION_SECURITY,
+    STATE_SECTION_METEO,
+    STATE_SECTION_SOCKET,
+    STATE_SECTION_TANK,
+    STATE_SECTION_WATERER,
+    STATE_SECTION_MAX
+} StateSection;
+
+typedef struct {
+    uint64_t        version;
+    StateSection    section;
+    char            name[SHORT_STR_LEN];
+} StateChange;
+
+/**
+ * @brief State waiter handler, it runs on reactor thread and must not
+ * block
+ *
+ * @param data User data
+ */
+typedef void (*StateNotifyFunc)(void *data);
+
+/**
+ * @brief Start recording controllers changes from events
+ *
+ * @return True/False as result of starting log
+ */
+bool StateLogStart();
+
+/**
+ * @brief Get current state version, it grows on every change
+ *
+ * @return State version
+ */
+uint64_t StateVersionGet();
+
+/**
+ * @brief Block until state version differs from known one or timeout
+ *
+ * @param since Version known by reader
+ * @param timeout_ms Max waiting time
+ *
+ * @return True if version was changed
+ */
+bool StateChangesWait(uint64_t since, unsigned timeout_ms);
+
+/**
+ * @brief Call handler once when state version differs from known one
+ * or timeout passes, so waiting reader does not hold a thread. Timeout
+ * is checked every STATE_NOTIFY_TICK_MS.
+ *
+ * @param since Version known by reader
+ * @param timeout_ms Max waiting time
+ * @param func Handler, it is called at once if version is changed
+ * @param data User data for handler
+ *
+ * @return False if log is not started, handler is not called then
+ */
+bool StateChangesNotify(uint64_t since, unsigned timeout_ms, StateNotifyFunc func, void *data);
+
+/**
+ * @brief Get objects changed after version, one entry per object
+ *
+ * @param since Version known by reader
+ * @param changes Out list of StateChange, must be freed by reader
+ *
+ * @return False if log was trimmed after version and full state is needed
+ */
+bool StateChangesGet(uint64_t since, GList **changes);
+
+#endif /* __STATE_LOG_H__ */
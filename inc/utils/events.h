@@ -0,0 +1,139 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __EVENTS_H__
+#define __EVENTS_H__
+
+#include <stdbool.h>
+
+#include <utils/utils.h>
+
+#define EVENT_QUEUE_LEN         64
+#define EVENT_SUBSCRIBERS_MAX   16
+
+typedef enum {
+    EVENT_SOCKET_CHANGED,
+    EVENT_TANK_LEVEL_CHANGED,
+    EVENT_TANK_STATE_CHANGED,
+    EVENT_WATERER_CHANGED,
+    EVENT_SENSOR_DETECTED,
+    EVENT_SECURITY_CHANGED,
+    EVENT_METEO_CHANGED,
+    EVENT_TYPE_MAX
+} EventType;
+
+#define EVENT_MASK(type)    (1U << (type))
+#define EVENT_MASK_ALL      ((1U << EVENT_TYPE_MAX) - 1)
+
+typedef struct {
+    EventType   type;
+    char        name[SHORT_STR_LEN];
+    union {
+        struct {
+            bool    status;
+        } socket;
+        struct {
+            unsigned    level;
+            bool        notify;
+        } tank_level;
+        struct {
+            bool    status;
+            bool    pump;
+            bool    valve;
+        } tank_state;
+        struct {
+            bool    status;
+            bool    valve;
+            bool    notify;
+        } waterer;
+        struct {
+            bool    alarm;
+            bool    sms;
+            bool    telegram;
+        } sensor;
+        struct {
+            bool    status;
+            bool    alarm;
+        } security;
+        struct {
+            float   temp;
+            bool    error;
+        } meteo;
+    };
+} Event;
+
+typedef struct _EventSubscriber EventSubscriber;
+
+/**
+ * @brief Create subscriber with own event queue
+ * 
+ * @param name Subscriber name for logging
+ * @param mask Subscribed event types made by EVENT_MASK
+ * 
+ * @return Subscriber or NULL on error
+ */
+EventSubscriber *EventSubscribe(const char *name, unsigned mask);
+
+/**
+ * @brief Put event into queues of all interested subscribers
+ * 
+ * @param event Event to publish
+ * 
+ * @return False if some subscriber queue was full and event was dropped
+ */
+bool EventPublish(const Event *event);
+
+/**
+ * @brief Get next event without waiting
+ * 
+ * @param sub Subscriber
+ * @param event Out event
+ * 
+ * @return True if event was taken from queue
+ */
+bool EventPop(EventSubscriber *sub, Event *event);
+
+/**
+ * @brief Wait for next event
+ * 
+ * @param sub Subscriber
+ * @param event Out event
+ * @param timeout_ms Max waiting time in milliseconds
+ * 
+ * @return True if event was received, false on timeout
+ */
+bool EventWait(EventSubscriber *sub, Event *event, unsigned timeout_ms);
+
+/**
+ * @brief Get subscriber eventfd which becomes readable on new events
+ * 
+ * @param sub Subscriber
+ * 
+ * @return File descriptor
+ */
+int EventFdGet(EventSubscriber *sub);
+
+/**
+ * @brief Clear eventfd wakeup before draining queue by EventPop
+ * 
+ * @param sub Subscriber
+ */
+void EventReset(EventSubscriber *sub);
+
+/**
+ * @brief Get number of events dropped because subscriber queue was full
+ * 
+ * @param sub Subscriber
+ * 
+ * @return Dropped events count since subscribing
+ */
+unsigned long EventDroppedGet(EventSubscriber *sub);
+
+#endif /* __EVENTS_H__ */
@@ -0,0 +1,140 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JOBS_THREADS    4
+
+typedef enum {
+    JOB_PRIO_HIGH,
+    JOB_PRIO_NORMAL,
+    JOB_PRIO_LOW,
+    JOB_PRIO_MAX
+} JobPriority;
+
+typedef enum {
+    JOB_STATE_QUEUED,
+    JOB_STATE_RUNNING,
+    JOB_STATE_DONE,
+    JOB_STATE_CANCELLED
+} JobState;
+
+/**
+ * @brief Job body
+ * 
+ * @param data User data
+ * 
+ * @return Job result
+ */
+typedef bool (*JobFunc)(void *data);
+
+/**
+ * @brief Job data destructor for cancelled jobs
+ * 
+ * @param data User data
+ */
+typedef void (*JobFreeFunc)(void *data);
+
+typedef struct _Job Job;
+
+typedef struct {
+    unsigned        queued[JOB_PRIO_MAX];
+    unsigned        queued_max;
+    unsigned        running;
+    unsigned long   done;
+    unsigned long   cancelled;
+    unsigned long   stolen;
+    uint64_t        wait_avg_ns;
+    uint64_t        wait_max_ns;
+    uint64_t        run_avg_ns;
+    uint64_t        run_max_ns;
+} JobsStats;
+
+/**
+ * @brief Start fixed number of job workers
+ * 
+ * @return true/false as result of starting workers
+ */
+bool JobsStart();
+
+/**
+ * @brief Queue job and get handle for awaiting or cancelling
+ * 
+ * @param name Job name for logging
+ * @param prio Job priority
+ * @param func Job body
+ * @param free_func Called with data if job is cancelled before start,
+ * NULL if data is owned by caller
+ * @param data User data for job body, owned by job body
+ * 
+ * @return Job handle which must be released by JobRelease or NULL on error
+ */
+Job *JobSubmit(const char *name, JobPriority prio, JobFunc func, JobFreeFunc free_func, void *data);
+
+/**
+ * @brief Queue job without keeping handle
+ * 
+ * @param name Job name for logging
+ * @param prio Job priority
+ * @param func Job body
+ * @param data User data for job body, owned by job body
+ * 
+ * @return true/false as result of queueing job
+ */
+bool JobRun(const char *name, JobPriority prio, JobFunc func, void *data);
+
+/**
+ * @brief Wait for job completion
+ * 
+ * @param job Job handle
+ * @param result Out job body result, may be NULL
+ * 
+ * @return False if job was cancelled before start
+ */
+bool JobAwait(Job *job, bool *result);
+
+/**
+ * @brief Cancel job if it was not started yet, job data is passed to
+ * its free function
+ * 
+ * @param job Job handle
+ * 
+ * @return True if job will not run
+ */
+bool JobCancel(Job *job);
+
+/**
+ * @brief Get current job state
+ * 
+ * @param job Job handle
+ * 
+ * @return Job state
+ */
+JobState JobStateGet(Job *job);
+
+/**
+ * @brief Release job handle
+ * 
+ * @param job Job handle
+ */
+void JobRelease(Job *job);
+
+/**
+ * @brief Get queue depth and latency stats
+ * 
+ * @param stats Out stats
+ */
+void JobsStatsGet(JobsStats *stats);
+
+#endif /* __JOBS_H__ */
@@ -12,12 +12,32 @@
 #define __LOG_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include <utils/utils.h>
 
 #include <glib-2.0/glib.h>
 
+#define LOG_FILE_EXT            ".log"
+#define LOG_ARCHIVE_EXT         ".log.gz"
+#define LOG_INDEX_EXT           ".idx"
+#define LOG_TMP_EXT             ".tmp"
+
+#define LOG_ROTATE_SIZE_KB      1024
+#define LOG_ROTATE_DAYS         30
+#define LOG_ROTATE_QUOTA_KB     51200
+#define LOG_ARCHIVE_PERIOD_SEC  60
+
+/**
+ * Archive index record stored next to archive: compressed offset of full
+ * flush point where the first line of minute starts
+ */
+typedef struct {
+    uint32_t    minute;
+    uint64_t    offset;
+} LogIndexMark;
+
 typedef enum {
     LOG_TYPE_INFO,
     LOG_TYPE_WARN,
@@ -31,6 +51,29 @@ typedef enum {
  */
 void LogPathSet(const char *path);
 
+/**
+ * @brief Get log file folder
+ * 
+ * @return Log files destination folder
+ */
+const char *LogPathGet();
+
+/**
+ * @brief Set log files rotation limits
+ * 
+ * @param size_kb Max size of one log file before rotation
+ * @param days Max age of log archives
+ * @param quota_kb Max size of all log files in folder
+ */
+void LogRotateSet(unsigned size_kb, unsigned days, unsigned quota_kb);
+
+/**
+ * @brief Start background compression and pruning of closed log files
+ * 
+ * @return true/false as result of starting archiver
+ */
+bool LogArchiverStart();
+
 /**
  * @brief Logging message to console and file
  * 
@@ -0,0 +1,62 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __LOG_SEARCH_H__
+#define __LOG_SEARCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <utils/utils.h>
+#include <utils/log.h>
+#include <plc/plc.h>
+
+#define LOG_SEARCH_MINUTES      (24 * 60)
+#define LOG_SEARCH_LIMIT        1000
+
+typedef struct {
+    PlcTime     from;
+    PlcTime     to;
+    char        module[SHORT_STR_LEN];
+    bool        typed;
+    LogType     type;
+    unsigned    limit;
+} LogQuery;
+
+/**
+ * @brief Matched log line callback
+ * 
+ * @param line Log line without trailing new line
+ * @param len Log line length
+ * @param data User data
+ * 
+ * @return False to stop searching
+ */
+typedef bool (*LogSearchCb)(const char *line, size_t len, void *data);
+
+/**
+ * @brief Init log query with whole time range and no filters
+ * 
+ * @param query Log query
+ */
+void LogQueryInit(LogQuery *query);
+
+/**
+ * @brief Search log files by time range, module and level
+ * 
+ * @param query Search params
+ * @param cb Callback for every matched line
+ * @param data User data for callback
+ * 
+ * @return true/false as result of searching
+ */
+bool LogSearch(const LogQuery *query, LogSearchCb cb, void *data);
+
+#endif /* __LOG_SEARCH_H__ */
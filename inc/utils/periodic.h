@@ -0,0 +1,77 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __PERIODIC_H__
+#define __PERIODIC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <utils/utils.h>
+
+typedef struct _PeriodicTask PeriodicTask;
+
+/**
+ * @brief Periodic task body
+ * 
+ * @param task Running task
+ * @param data User data
+ */
+typedef void (*PeriodicFunc)(PeriodicTask *task, void *data);
+
+struct _PeriodicTask {
+    char            name[SHORT_STR_LEN];
+    unsigned        period_ms;
+    struct timespec deadline;
+    unsigned long   runs;
+    unsigned long   overruns;
+    uint64_t        late_max_ns;
+    bool            overrun;
+    PeriodicFunc    func;
+    void            *data;
+};
+
+/**
+ * @brief Init periodic task with first deadline from now
+ * 
+ * @param task Periodic task
+ * @param name Task name for logging
+ * @param period_ms Period in milliseconds
+ */
+void PeriodicInit(PeriodicTask *task, const char *name, unsigned period_ms);
+
+/**
+ * @brief Move task to next absolute deadline without sleeping
+ * 
+ * @param task Periodic task
+ * 
+ * @return False if deadline was missed and task was rescheduled from now
+ */
+bool PeriodicNext(PeriodicTask *task);
+
+/**
+ * @brief Sleep until next absolute deadline
+ * 
+ * @param task Periodic task
+ * 
+ * @return False if deadline was missed and task was rescheduled from now
+ */
+bool PeriodicWait(PeriodicTask *task);
+
+/**
+ * @brief Postpone next deadline keeping task phase
+ * 
+ * @param task Periodic task
+ * @param msec Additional delay in milliseconds
+ */
+void PeriodicDelay(PeriodicTask *task, unsigned msec);
+
+#endif /* __PERIODIC_H__ */
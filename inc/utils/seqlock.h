@@ -0,0 +1,68 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+/**
+ * Writers of one object are serialized by mutex, readers never lock
+ * and retry their copy if a writer was active meanwhile
+ */
+
+typedef struct {
+    atomic_uint seq;
+    mtx_t       mtx;
+} SeqLock;
+
+/**
+ * @brief Init seqlock
+ * 
+ * @param lock Seqlock
+ */
+void SeqLockInit(SeqLock *lock);
+
+/**
+ * @brief Start changing protected fields
+ * 
+ * @param lock Seqlock
+ */
+void SeqLockWriteBegin(SeqLock *lock);
+
+/**
+ * @brief Finish changing protected fields
+ * 
+ * @param lock Seqlock
+ */
+void SeqLockWriteEnd(SeqLock *lock);
+
+/**
+ * @brief Start reading protected fields
+ * 
+ * @param lock Seqlock
+ * 
+ * @return Sequence to pass to SeqLockReadRetry
+ */
+unsigned SeqLockReadBegin(SeqLock *lock);
+
+/**
+ * @brief Check that copied fields are consistent
+ * 
+ * @param lock Seqlock
+ * @param seq Sequence from SeqLockReadBegin
+ * 
+ * @return True if fields were changed during reading and copy must be repeated
+ */
+bool SeqLockReadRetry(SeqLock *lock, unsigned seq);
+
+#endif /* __SEQLOCK_H__ */
@@ -12,6 +12,8 @@
 #define __UTILS_H__
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
 #include <glib-2.0/glib.h>
 
@@ -22,6 +24,8 @@
 #define SHORT_STR_LEN       50
 #define BUFFER_LEN_MAX      4096
 
+#define UTILS_TIME_ZONE_FILE    "/etc/localtime"
+
 typedef struct {
     char    name[SHORT_STR_LEN];
     char    value[SHORT_STR_LEN];
@@ -37,6 +41,15 @@ typedef struct {
  */
 bool UtilsURIParse(const char *url, GList **params);
 
+/**
+ * @brief Copy request uri without one param
+ *
+ * @param uri Request uri
+ * @param name Param name
+ * @param out Out uri, STR_LEN size
+ */
+void UtilsURIParamDrop(const char *uri, const char *name, char *out);
+
 /**
  * @brief Wait thread some seconds
  *
@@ -52,10 +65,27 @@ void UtilsSecSleep(unsigned sec);
 void UtilsMsecSleep(unsigned msec);
 
 /**
- * @brief Get current Linux time
+ * @brief Convert Linux time to local time
+ * 
+ * @param sec Linux time in seconds
+ * @param tm Out local time with full year and month from 1
+ * 
+ * @return True/False as result of converting
+ */
+bool UtilsLinuxTimeGet(time_t sec, struct tm *tm);
+
+/**
+ * @brief Reload timezone and DST rules if system timezone was changed
+ * 
+ * @return True if timezone was reloaded
+ */
+bool UtilsTimeZoneUpdate();
+
+/**
+ * @brief Get monotonic clock for latency measurement
  * 
- * @return Linux time
+ * @return Monotonic time in nanoseconds
  */
-struct tm *UtilsLinuxTimeGet();
+uint64_t UtilsMonoNsGet();
 
 #endif /* __UTILS_H__ */
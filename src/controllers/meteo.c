@@ -14,6 +14,8 @@
 #include <utils/log.h>
 #include <net/notifier.h>
 #include <core/onewire.h>
+#include <plc/reactor.h>
+#include <utils/events.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -33,46 +35,66 @@ static struct _Meteo {
 /*                                                                   */
 /*********************************************************************/
 
-static int SensorsThread(void *data)
+static void SensorEventPublish(MeteoSensor *sensor, float temp, bool error)
+{
+    Event event = {
+        .type = EVENT_METEO_CHANGED,
+        .meteo.temp = temp,
+        .meteo.error = error
+    };
+
+    strncpy(event.name, sensor->name, SHORT_STR_LEN - 1);
+    EventPublish(&event);
+}
+
+static void SensorsTask(PeriodicTask *task, void *data)
 {
     bool    ret = false;
     float   temp = 0;
 
-    for (;;) {
-        for (GList *s = Meteo.sensors; s != NULL; s = s->next) {
-            MeteoSensor *sensor = (MeteoSensor *)s->data;
-
-            for (unsigned i = 0; i < METEO_SENSOR_TRIES; i++) {
-                switch (sensor->type) {
-                    case METEO_SENSOR_DS18B20:
-                        ret = OneWireTempRead(sensor->ds18b20.id, &temp);
-                        if (ret) {
-                            sensor->ds18b20.temp = temp;
-                        }
-                        break;
-                }
-
-                if (ret) {
+    for (GList *s = Meteo.sensors; s != NULL; s = s->next) {
+        MeteoSensor *sensor = (MeteoSensor *)s->data;
+        float       last_temp = sensor->ds18b20.temp;
+        bool        last_error = sensor->error;
+        float       new_temp = last_temp;
+        bool        new_error;
+
+        for (unsigned i = 0; i < METEO_SENSOR_TRIES; i++) {
+            switch (sensor->type) {
+                case METEO_SENSOR_DS18B20:
+                    ret = OneWireTempRead(sensor->ds18b20.id, &temp);
+                    if (ret) {
+                        new_temp = temp;
+                    }
                     break;
-                } else {
-                    UtilsSecSleep(2);
-                }
             }
 
-            if (!ret) {
-                if (!sensor->error) {
-                    sensor->error = true;
-                    sensor->ds18b20.temp = METEO_BAD_VAL;
-                    LogF(LOG_TYPE_ERROR, "METEO", "Failed to read temp sensor \"%s\"", sensor->name);
-                }
+            if (ret) {
+                break;
             } else {
-                if (sensor->error) {
-                    sensor->error = false;
-                    LogF(LOG_TYPE_ERROR, "METEO", "Successfully read temp sensor \"%s\"", sensor->name);
-                }
+                UtilsSecSleep(2);
             }
         }
-        UtilsSecSleep(10);
+
+        new_error = !ret;
+
+        if (new_error) {
+            new_temp = METEO_BAD_VAL;
+            if (!last_error) {
+                LogF(LOG_TYPE_ERROR, "METEO", "Failed to read temp sensor \"%s\"", sensor->name);
+            }
+        } else if (last_error) {
+            LogF(LOG_TYPE_ERROR, "METEO", "Successfully read temp sensor \"%s\"", sensor->name);
+        }
+
+        if (new_temp != last_temp || new_error != last_error) {
+            SeqLockWriteBegin(&sensor->lock);
+            sensor->ds18b20.temp = new_temp;
+            sensor->error = new_error;
+            SeqLockWriteEnd(&sensor->lock);
+
+            SensorEventPublish(sensor, new_temp, new_error);
+        }
     }
 }
 
@@ -90,20 +112,16 @@ MeteoSensor *MeteoSensorNew(const char *name, MeteoSensorType type)
     sensor->type = type;
     sensor->error = false;
     sensor->ds18b20.temp = 0;
+    SeqLockInit(&sensor->lock);
 
     return sensor;
 }
 
 bool MeteoControllerStart()
 {
-    thrd_t  sens_th;
-
     Log(LOG_TYPE_INFO, "METEO", "Starting Meteo controller");
 
-    if (thrd_create(&sens_th, &SensorsThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(sens_th) != thrd_success) {
+    if (!ReactorJobTaskAdd("meteo", METEO_PERIOD_MS, &SensorsTask, NULL)) {
         return false;
     }
 
@@ -130,3 +148,14 @@ void MeteoSensorAdd(MeteoSensor *sensor)
 {
     Meteo.sensors = g_list_append(Meteo.sensors, (void *)sensor);
 }
+
+void MeteoSensorStateGet(MeteoSensor *sensor, MeteoSensorState *state)
+{
+    unsigned seq;
+
+    do {
+        seq = SeqLockReadBegin(&sensor->lock);
+        state->temp = sensor->ds18b20.temp;
+        state->error = sensor->error;
+    } while (SeqLockReadRetry(&sensor->lock, seq));
+}
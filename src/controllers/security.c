@@ -9,17 +9,17 @@
 /*********************************************************************/
 
 #include <threads.h>
+#include <time.h>
 
 #include <controllers/security.h>
 #include <utils/log.h>
 #include <core/onewire.h>
-#include <net/notifier.h>
 #include <db/database.h>
 #include <controllers/socket.h>
-#include <stack/stack.h>
-#include <stack/rpc.h>
 #include <scenario/scenario.h>
 #include <plc/plc.h>
+#include <plc/reactor.h>
+#include <utils/events.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -31,17 +31,27 @@ static struct _Security {
     GList           *sensors;
     GList           *keys;
     GpioPin         *gpio[SECURITY_GPIO_MAX];
+    once_flag       sts_once;
     mtx_t           sts_mtx;
     bool            status;
     bool            alarm;
     bool            last_alarm;
     bool            sound[SECURITY_SOUND_MAX];
+    unsigned        timer;
+    bool            ow_error;
+    bool            started;
+    uint64_t        version;
 } Security = {
     .sensors = NULL,
+    .sts_once = ONCE_FLAG_INIT,
     .keys = NULL,
     .status = false,
     .alarm = false,
     .last_alarm = false,
+    .timer = 0,
+    .ow_error = false,
+    .started = false,
+    .version = 0
 };
 
 /*********************************************************************/
@@ -50,6 +60,42 @@ static struct _Security {
 /*                                                                   */
 /*********************************************************************/
 
+static void StateInit()
+{
+    mtx_init(&Security.sts_mtx, mtx_plain | mtx_recursive);
+}
+
+/**
+ * @brief Status, alarm and version are changed under one recursive
+ * lock, setters call each other and reconcile holds it across them
+ */
+static void StateLock()
+{
+    call_once(&Security.sts_once, &StateInit);
+    mtx_lock(&Security.sts_mtx);
+}
+
+static void StateUnlock()
+{
+    mtx_unlock(&Security.sts_mtx);
+}
+
+/**
+ * @brief Mark local change of status or alarm. Version is a logical
+ * counter in high bits, unit adopts versions it reconciles, so a change
+ * made after seeing other change is always newer regardless of clocks.
+ * Low bits are left for master to break ties of concurrent changes.
+ * States loaded from DB before start keep version 0.
+ */
+static void VersionBump()
+{
+    if (!Security.started) {
+        return;
+    }
+
+    Security.version = ((Security.version >> SECURITY_VERSION_TIE_BITS) + 1) << SECURITY_VERSION_TIE_BITS;
+}
+
 static bool StatusSave(SecurityStatusType type, bool status)
 {
     Database    db;
@@ -77,171 +123,156 @@ static bool StatusSave(SecurityStatusType type, bool status)
     return true;
 }
 
-static int SensorsThread(void *data)
+static void StateEventPublish()
+{
+    Event event = {
+        .type = EVENT_SECURITY_CHANGED,
+        .name = "security",
+        .security.status = Security.status,
+        .security.alarm = Security.alarm
+    };
+
+    EventPublish(&event);
+}
+
+static void SensorsTask(PeriodicTask *task, void *data)
 {
-    char        msg[STR_LEN];
-    unsigned    timer = 0;
     bool        state = false;
 
-    for (;;) {
-        timer++;
+    Security.timer++;
 
-        if (timer > SECURITY_SENSOR_TIME_MAX_SEC) {
-            timer = 0;
-        }
-
-        for (GList *s = Security.sensors; s != NULL; s = s->next) {
-            SecuritySensor *sensor = (SecuritySensor *)s->data;
+    if (Security.timer > SECURITY_SENSOR_TIME_MAX_SEC) {
+        Security.timer = 0;
+    }
 
-            if (sensor->detected) {
-                continue;
-            }
+    for (GList *s = Security.sensors; s != NULL; s = s->next) {
+        SecuritySensor *sensor = (SecuritySensor *)s->data;
 
-            switch (sensor->type) {
-                case SECURITY_SENSOR_MICRO_WAVE:
-                    if (!GpioPinRead(sensor->gpio, &state)) {
-                        LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
-                        break;
-                    }
+        if (sensor->detected) {
+            continue;
+        }
 
-                    if (!state) {
-                        sensor->counter++;
-                    }
+        switch (sensor->type) {
+            case SECURITY_SENSOR_MICRO_WAVE:
+                if (!GpioPinRead(sensor->gpio, &state)) {
+                    LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
                     break;
+                }
 
-                case SECURITY_SENSOR_PIR:
-                    if (!GpioPinRead(sensor->gpio, &state)) {
-                        LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
-                        break;
-                    }
+                if (!state) {
+                    sensor->counter++;
+                }
+                break;
 
-                    if (state) {
-                        sensor->counter++;
-                    }
+            case SECURITY_SENSOR_PIR:
+                if (!GpioPinRead(sensor->gpio, &state)) {
+                    LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
                     break;
+                }
 
-                case SECURITY_SENSOR_REED:
-                    if (!GpioPinRead(sensor->gpio, &state)) {
-                        LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
-                        break;
-                    }
+                if (state) {
+                    sensor->counter++;
+                }
+                break;
 
-                    if (!state) {
-                         sensor->detected = true;
-                    }
+            case SECURITY_SENSOR_REED:
+                if (!GpioPinRead(sensor->gpio, &state)) {
+                    LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to read GPIO \"%s\"", sensor->gpio->name);
                     break;
-            }
-
-            if (timer == SECURITY_SENSOR_TIME_MAX_SEC) {
-                if (sensor->counter >= SECURITY_DETECTED_TIME_MAX_SEC) {
-                    sensor->counter = 0;
-                    sensor->detected = true;
-                } else {
-                    sensor->counter = 0;
                 }
-            }
-
-            mtx_lock(&Security.sts_mtx);
-            if (sensor->detected && Security.status) {
-                LogF(LOG_TYPE_INFO, "SECURITY", "Security sensor \"%s\" detected!", sensor->name);
 
-                if (sensor->alarm && !Security.alarm) {
-                    SecurityAlarmSet(true, true);
+                if (!state) {
+                     sensor->detected = true;
                 }
+                break;
+        }
 
-                StackUnit *unit = StackUnitGet(RPC_DEFAULT_UNIT);
-                snprintf(msg, STR_LEN, "ОХРАНА:%s+Обнаружено+проникновение+%s", unit->name, sensor->name);
+        if (Security.timer == SECURITY_SENSOR_TIME_MAX_SEC) {
+            if (sensor->counter >= SECURITY_DETECTED_TIME_MAX_SEC) {
+                sensor->counter = 0;
+                sensor->detected = true;
+            } else {
+                sensor->counter = 0;
+            }
+        }
 
-                if (sensor->sms) {
-                    if (!NotifierSmsSend(msg)) {
-                        Log(LOG_TYPE_ERROR, "SECURITY", "Failed to send sms message");
-                    } else {
-                        Log(LOG_TYPE_INFO, "SECURITY", "Alarm sms was sended to phone");
-                    }
-                }
+        StateLock();
+        if (sensor->detected && Security.status) {
+            LogF(LOG_TYPE_INFO, "SECURITY", "Security sensor \"%s\" detected!", sensor->name);
 
-                if (sensor->telegram) {
-                    if (!NotifierTelegramSend(msg)) {
-                        Log(LOG_TYPE_ERROR, "SECURITY", "Failed to send telegram message");
-                    } else {
-                        Log(LOG_TYPE_INFO, "SECURITY", "Alarm message was sended to telegram");
-                    }
-                }
+            if (sensor->alarm && !Security.alarm) {
+                SecurityAlarmSet(true, true);
             }
-            mtx_unlock(&Security.sts_mtx);
-        }
 
-        UtilsSecSleep(1);
-    }
+            Event event = {
+                .type = EVENT_SENSOR_DETECTED,
+                .sensor.alarm = sensor->alarm,
+                .sensor.sms = sensor->sms,
+                .sensor.telegram = sensor->telegram
+            };
 
-    return 0;
+            strncpy(event.name, sensor->name, SHORT_STR_LEN - 1);
+            EventPublish(&event);
+        }
+        StateUnlock();
+    }
 }
 
-static int KeysThread(void *data)
+static void KeysTask(PeriodicTask *task, void *data)
 {
     GList   *cur_keys = NULL;
-    bool    ow_error = false;
 
-    for (;;) {
-        if (!OneWireKeysRead(&cur_keys)) {
-            if (!ow_error) {
-                ow_error = true;
-                Log(LOG_TYPE_ERROR, "SECURITY", "Failed to read iButton codes");
-            }
+    if (!OneWireKeysRead(&cur_keys)) {
+        if (!Security.ow_error) {
+            Security.ow_error = true;
+            Log(LOG_TYPE_ERROR, "SECURITY", "Failed to read iButton codes");
+        }
 
-            g_list_free(cur_keys);
-            cur_keys = NULL;
+        g_list_free(cur_keys);
+        cur_keys = NULL;
 
-            UtilsSecSleep(1);
-            continue;
-        } else {
-            if (ow_error) {
-                ow_error = false;
-                Log(LOG_TYPE_INFO, "SECURITY", "Successfully readed iButton codes");
-            }
+        return;
+    } else {
+        if (Security.ow_error) {
+            Security.ow_error = false;
+            Log(LOG_TYPE_INFO, "SECURITY", "Successfully readed iButton codes");
         }
+    }
 
-        if (cur_keys == NULL) {
-            UtilsSecSleep(1);
-            continue;
-        }
+    if (cur_keys == NULL) {
+        return;
+    }
 
-        for (GList *k = cur_keys; k != NULL; k = k->next) {
-            OneWireData *data = (OneWireData *)k->data;
+    for (GList *k = cur_keys; k != NULL; k = k->next) {
+        OneWireData *data = (OneWireData *)k->data;
 
-            if (SecurityKeyCheck(data->value)) {
-                if (!SecurityStatusSet(!SecurityStatusGet(), true)) {
-                    LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to switch security status by iButton");
-                }
+        if (SecurityKeyCheck(data->value)) {
+            if (!SecurityStatusSet(!SecurityStatusGet(), true)) {
+                LogF(LOG_TYPE_ERROR, "SECURITY", "Failed to switch security status by iButton");
+            }
 
-                if (SecurityStatusGet()) {
-                    if (!ScenarioStart(SCENARIO_OUT_HOME)) {
-                        Log(LOG_TYPE_ERROR, "SECURITY", "Failed to start scenario OUT_HOME");
-                    }
-                } else {
-                    if (!ScenarioStart(SCENARIO_IN_HOME)) {
-                        Log(LOG_TYPE_ERROR, "SECURITY", "Failed to start scenario IN_HOME");
-                    }
+            if (SecurityStatusGet()) {
+                if (!ScenarioStart(SCENARIO_OUT_HOME)) {
+                    Log(LOG_TYPE_ERROR, "SECURITY", "Failed to start scenario OUT_HOME");
                 }
-
-                LogF(LOG_TYPE_INFO, "SECURITY", "Detected valid key: \"%s\"", data->value);
-                UtilsSecSleep(5);
-
-                break;
             } else {
-                LogF(LOG_TYPE_ERROR, "SECURITY", "Invalid security key: \"%s\"", data->value);
+                if (!ScenarioStart(SCENARIO_IN_HOME)) {
+                    Log(LOG_TYPE_ERROR, "SECURITY", "Failed to start scenario IN_HOME");
+                }
             }
 
-            free(data);
-        }
+            LogF(LOG_TYPE_INFO, "SECURITY", "Detected valid key: \"%s\"", data->value);
+            PeriodicDelay(task, SECURITY_KEY_DELAY_MS);
 
-         g_list_free(cur_keys);
-        cur_keys = NULL;
+            break;
+        } else {
+            LogF(LOG_TYPE_ERROR, "SECURITY", "Invalid security key: \"%s\"", data->value);
+        }
 
-        UtilsSecSleep(1);
+        free(data);
     }
 
-    return 0;
+    g_list_free(cur_keys);
 }
 
 /*********************************************************************/
@@ -301,38 +332,38 @@ bool SecurityKeyCheck(const char *key)
 
 bool SecurityControllerStart()
 {
-    thrd_t  sens_th, keys_th;
-
     Log(LOG_TYPE_INFO, "SECURITY", "Starting Security controller");
 
-    if (thrd_create(&sens_th, &SensorsThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(sens_th != thrd_success)) {
+    if (!ReactorTaskAdd("security_sensors", SECURITY_SENSORS_PERIOD_MS, &SensorsTask, NULL)) {
         return false;
     }
-    if (thrd_create(&keys_th, &KeysThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(keys_th)) {
+    if (!ReactorJobTaskAdd("security_keys", SECURITY_KEYS_PERIOD_MS, &KeysTask, NULL)) {
         return false;
     }
 
+    Security.started = true;
+
     return true;
 }
 
 bool SecurityStatusSet(bool status, bool save)
 {
-    char    msg[STR_LEN];
+    StateLock();
 
     if (status != Security.status) {
-        mtx_lock(&Security.sts_mtx);
-
         Security.status = status;
+        VersionBump();
 
         if (!status) {
             LogF(LOG_TYPE_INFO, "SECURITY", "Security controller disabled");
             SecurityAlarmSet(false, true);
+
+            /**
+             * Alarm stays latched when it is only switched off remotely,
+             * disarming means user is aware of it and acknowledges it
+             */
+
+            PlcAlarmAck(PLC_ALARM_SECURITY);
         } else {
             LogF(LOG_TYPE_INFO, "SECURITY", "Security controller enabled");
         }
@@ -364,37 +395,24 @@ bool SecurityStatusSet(bool status, bool save)
         }
 
         /**
-         * Send notify
+         * Notify subscribers
          */
 
-        StackUnit *unit = StackUnitGet(RPC_DEFAULT_UNIT);
-
-        if (status) {
-            snprintf(msg, STR_LEN, "ОХРАНА:%s+сигнализация+включена", unit->name);
-        } else {
-            snprintf(msg, STR_LEN, "ОХРАНА:%s+сигнализация+отключена", unit->name);
-        }
-
-        if (!NotifierTelegramSend(msg)) {
-            Log(LOG_TYPE_ERROR, "SECURITY", "Failed to send status telegram message");
-        } else {
-            Log(LOG_TYPE_INFO, "SECURITY", "Status message was sended to telegram");
-        }
-
-        if (!NotifierSmsSend(msg)) {
-            Log(LOG_TYPE_ERROR, "SECURITY", "Failed to send security status sms message");
-        } else {
-            Log(LOG_TYPE_INFO, "SECURITY", "Status sms was sended to phone");
-        }
-
-        mtx_unlock(&Security.sts_mtx);
+        StateEventPublish();
     }
 
+    StateUnlock();
+
     return true;
 }
 
 bool SecurityAlarmSet(bool status, bool save)
 {
+    StateLock();
+
+    if (status != Security.alarm) {
+        VersionBump();
+    }
     Security.alarm = status;
 
     if (status) {
@@ -413,6 +431,10 @@ bool SecurityAlarmSet(bool status, bool save)
         LogF(LOG_TYPE_INFO, "SECURITY", "Security controller alarm disabled");
     }
 
+    StateEventPublish();
+
+    StateUnlock();
+
     if (save) {
         if (!StatusSave(SECURITY_SAVE_TYPE_ALARM, status)) {
             return false;
@@ -432,6 +454,48 @@ bool SecurityStatusGet()
     return Security.status;
 }
 
+uint64_t SecurityVersionGet()
+{
+    StateLock();
+    uint64_t version = Security.version;
+    StateUnlock();
+
+    return version;
+}
+
+bool SecurityReconcile(bool status, bool alarm, uint64_t version)
+{
+    bool result = true;
+
+    /**
+     * Compare, apply and version store are one step, so local change
+     * can not slip in between and be overwritten by older state
+     */
+
+    StateLock();
+
+    if (version > Security.version) {
+        result = SecurityStatusSet(status, true);
+
+        if (result && alarm != Security.alarm) {
+            result = SecurityAlarmSet(alarm, true);
+        }
+
+        /**
+         * Applied state keeps version of unit where it was changed, so it
+         * is not sent back as newer one
+         */
+
+        if (result) {
+            Security.version = version;
+        }
+    }
+
+    StateUnlock();
+
+    return result;
+}
+
 void SecuritySensorAdd(const SecuritySensor *sensor)
 {
     Security.sensors = g_list_append(Security.sensors, (void *)sensor);
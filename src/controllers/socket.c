@@ -11,6 +11,9 @@
 #include <controllers/socket.h>
 #include <utils/log.h>
 #include <db/database.h>
+#include <plc/reactor.h>
+#include <utils/events.h>
+#include <utils/jobs.h>
 
 #include <stdlib.h>
 #include <threads.h>
@@ -59,47 +62,42 @@ static bool StatusSave(const char *name, bool status)
     return true;
 }
 
-static int StatusSaveThread(void *data)
+static bool StatusSaveJob(void *data)
 {
     Socket *sock = (Socket *)data;
 
     mtx_lock(&Sockets.db_mtx);
 
-    if (!StatusSave(sock->name, sock->status)) {
+    if (!StatusSave(sock->name, SocketStatusGet(sock))) {
         mtx_unlock(&Sockets.db_mtx);
-        return -1;
+        return false;
     }
 
     mtx_unlock(&Sockets.db_mtx);
-    return 0;
+    return true;
 }
 
-static int SocketThread(void *data)
+static void SocketTask(PeriodicTask *task, void *data)
 {
     bool state = false;
+    bool pressed = false;
 
-     for (;;) {
-        bool pressed = false;
-
-        for (GList *s = Sockets.sockets; s != NULL; s = s->next) {
-            Socket *socket = (Socket *)s->data;
+    for (GList *s = Sockets.sockets; s != NULL; s = s->next) {
+        Socket *socket = (Socket *)s->data;
 
-            if (GpioPinRead(socket->gpio[SOCKET_PIN_BUTTON], &state)) {
-                if (state) {
-                    pressed = true;
-                    SocketStatusSet(socket, !SocketStatusGet(socket), true);
-                }
-            } else {
-                LogF(LOG_TYPE_ERROR, "SOCKET", "Failed to read GPIO \"%s\"", socket->gpio[SOCKET_PIN_BUTTON]->name);
+        if (GpioPinRead(socket->gpio[SOCKET_PIN_BUTTON], &state)) {
+            if (state) {
+                pressed = true;
+                SocketStatusSet(socket, !SocketStatusGet(socket), true);
             }
+        } else {
+            LogF(LOG_TYPE_ERROR, "SOCKET", "Failed to read GPIO \"%s\"", socket->gpio[SOCKET_PIN_BUTTON]->name);
         }
+    }
 
-        if (pressed) {
-            UtilsMsecSleep(800);
-        }
-
-        UtilsMsecSleep(200);
-     }
+    if (pressed) {
+        PeriodicDelay(task, SOCKET_BUTTON_DELAY_MS);
+    }
 }
 
 /*********************************************************************/
@@ -116,20 +114,17 @@ Socket *SocketNew(const char *name, GpioPin *button, GpioPin *relay, SocketGroup
     socket->gpio[SOCKET_PIN_BUTTON] = button;
     socket->gpio[SOCKET_PIN_RELAY] = relay;
     socket->group = group;
+    socket->status = false;
+    SeqLockInit(&socket->lock);
 
     return socket;
 }
 
 bool SocketControllerStart()
 {
-    thrd_t  sock_th;
-
     Log(LOG_TYPE_INFO, "SOCKET", "Starting Socket controller");
 
-    if (thrd_create(&sock_th, &SocketThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(sock_th) != thrd_success) {
+    if (!ReactorTaskAdd("socket_buttons", SOCKET_BUTTON_PERIOD_MS, &SocketTask, NULL)) {
         return false;
     }
 
@@ -159,12 +154,20 @@ Socket *SocketGet(const char *name)
 
 bool SocketStatusSet(Socket *sock, bool status, bool save)
 {
-    thrd_t  save_th;
+    Event   event = {
+        .type = EVENT_SOCKET_CHANGED,
+        .socket.status = status
+    };
 
+    SeqLockWriteBegin(&sock->lock);
     sock->status = status;
+    SeqLockWriteEnd(&sock->lock);
 
     GpioPinWrite(sock->gpio[SOCKET_PIN_RELAY], status);
 
+    strncpy(event.name, sock->name, SHORT_STR_LEN - 1);
+    EventPublish(&event);
+
     if (status) {
         LogF(LOG_TYPE_INFO, "SOCKET", "Socket \"%s\" on", sock->name);
     } else {
@@ -172,12 +175,8 @@ bool SocketStatusSet(Socket *sock, bool status, bool save)
     }
 
     if (save) {
-        if (thrd_create(&save_th, &StatusSaveThread, (void *)sock) != thrd_success) {
-            LogF(LOG_TYPE_INFO, "SOCKET", "Failed to create StatusSave thread for socket \"%s\"", sock->name);
-            return false;
-        }
-        if (thrd_detach(save_th) != thrd_success) {
-            LogF(LOG_TYPE_INFO, "SOCKET", "Failed to detach StatusSave thread for socket \"%s\"", sock->name);
+        if (!JobRun("socket_save", JOB_PRIO_LOW, &StatusSaveJob, (void *)sock)) {
+            LogF(LOG_TYPE_ERROR, "SOCKET", "Failed to queue status save for socket \"%s\"", sock->name);
             return false;
         }
     }
@@ -187,5 +186,13 @@ bool SocketStatusSet(Socket *sock, bool status, bool save)
 
 bool SocketStatusGet(Socket *sock)
 {
-    return sock->status;
+    unsigned    seq;
+    bool        status;
+
+    do {
+        seq = SeqLockReadBegin(&sock->lock);
+        status = sock->status;
+    } while (SeqLockReadRetry(&sock->lock, seq));
+
+    return status;
 }
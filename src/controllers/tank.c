@@ -10,12 +10,12 @@
 
 #include <controllers/tank.h>
 #include <utils/log.h>
-#include <net/notifier.h>
 #include <db/database.h>
 #include <plc/plc.h>
+#include <plc/reactor.h>
+#include <utils/events.h>
 
 #include <stdlib.h>
-#include <threads.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -25,7 +25,6 @@
 
 static struct _Tanks {
     GList   *tanks;
-    mtx_t   sts_mtx;
 } Tanks = {
     .tanks = NULL
 };
@@ -73,111 +72,142 @@ static bool NotifyLevelCheck(Tank *tank, unsigned num)
     return false;
 }
 
+static void LevelEventPublish(Tank *tank, bool notify)
+{
+    TankState   state;
+
+    TankStateGet(tank, &state);
+
+    Event event = {
+        .type = EVENT_TANK_LEVEL_CHANGED,
+        .tank_level.level = state.level,
+        .tank_level.notify = notify
+    };
+
+    strncpy(event.name, tank->name, SHORT_STR_LEN - 1);
+    EventPublish(&event);
+}
+
+static void StateEventPublish(Tank *tank)
+{
+    TankState   state;
+
+    TankStateGet(tank, &state);
+
+    Event event = {
+        .type = EVENT_TANK_STATE_CHANGED,
+        .tank_state.status = state.status,
+        .tank_state.pump = state.pump,
+        .tank_state.valve = state.valve
+    };
+
+    strncpy(event.name, tank->name, SHORT_STR_LEN - 1);
+    EventPublish(&event);
+}
+
+static void PumpValveUpdate(Tank *tank, bool pump, bool valve)
+{
+    SeqLockWriteBegin(&tank->lock);
+    tank->pump = pump;
+    tank->valve = valve;
+    SeqLockWriteEnd(&tank->lock);
+}
+
 static void TankLevelProcess(Tank *tank)
 {
+    bool pump;
+    bool valve;
+
     if (!tank->status) {
         return;
     }
 
     LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" water level %u%%", tank->name,  tank->level);
 
-    if (tank->level == TANK_LEVEL_PERCENT_MIN) {
+    pump = (tank->level != TANK_LEVEL_PERCENT_MIN);
+    valve = (tank->level != TANK_LEVEL_PERCENT_MAX);
+
+    if (!pump) {
         GpioPinWrite(tank->gpio[TANK_GPIO_PUMP], false);
-        tank->pump = false;
         PlcAlarmSet(PLC_ALARM_TANK, true);
         PlcBuzzerRun(PLC_BUZZER_TANK_EMPTY, true);
     } else {
         PlcAlarmSet(PLC_ALARM_TANK, false);
         GpioPinWrite(tank->gpio[TANK_GPIO_PUMP], true);
-        tank->pump = true;
     }
 
-    if (tank->level == TANK_LEVEL_PERCENT_MAX) {
-        GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], false);
-        tank->valve = false;
-    } else {
-        GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], true);
-        tank->valve = true;
-    }
-
-    LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" valve %s", tank->name, (tank->valve == true) ? "openned" : "closed");
-    LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" pump %s", tank->name, (tank->pump == true) ? "enabled" : "disabled");
+    GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], valve);
+    PumpValveUpdate(tank, pump, valve);
 
-    if (NotifyLevelCheck(tank, tank->level)) {
-        char    msg[STR_LEN];
+    LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" valve %s", tank->name, (valve == true) ? "openned" : "closed");
+    LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" pump %s", tank->name, (pump == true) ? "enabled" : "disabled");
 
-        snprintf(msg, STR_LEN, "БАК+\"%s\":+уровень+воды+%u%%", tank->name,  tank->level);
-
-        if (!NotifierTelegramSend(msg)) {
-            Log(LOG_TYPE_ERROR, "TANK", "Failed to send level notify");
-        }
-    }
+    StateEventPublish(tank);
+    LevelEventPublish(tank, NotifyLevelCheck(tank, tank->level));
 }
 
-static int TankLevelsThread(void *data)
+static void TankLevelsTask(PeriodicTask *task, void *data)
 {
     bool state;
 
-     for (;;) {
-        for (GList *t = Tanks.tanks; t != NULL; t = t->next) {
-            Tank *tank = (Tank *)t->data;
-            unsigned level_num = 0;
+    for (GList *t = Tanks.tanks; t != NULL; t = t->next) {
+        Tank *tank = (Tank *)t->data;
+        unsigned level_num = 0;
 
-            for (GList *l = tank->levels; l != NULL; l = l->next) {
-                TankLevel *level = (TankLevel *)l->data;
+        for (GList *l = tank->levels; l != NULL; l = l->next) {
+            TankLevel *level = (TankLevel *)l->data;
 
-                if (!GpioPinRead(level->gpio, &state)) {
-                    LogF(LOG_TYPE_ERROR, "TANK", "Failed to read GPIO \"%s\"", level->gpio->name);
-                    continue;
-                }
+            if (!GpioPinRead(level->gpio, &state)) {
+                LogF(LOG_TYPE_ERROR, "TANK", "Failed to read GPIO \"%s\"", level->gpio->name);
+                continue;
+            }
 
-                if (state) {
-                    if (level->percent > level_num) {
-                        level_num = level->percent;
-                    }
+            if (state) {
+                if (level->percent > level_num) {
+                    level_num = level->percent;
                 }
-
-                level->state = state;
             }
 
-            if (tank->level != level_num) {
-                tank->level = level_num;
+            level->state = state;
+        }
+
+        if (tank->level != level_num) {
+            SeqLockWriteBegin(&tank->lock);
+            tank->level = level_num;
+            SeqLockWriteEnd(&tank->lock);
 
+            if (tank->status) {
                 TankLevelProcess(tank);
+            } else {
+                LevelEventPublish(tank, false);
             }
         }
-        UtilsSecSleep(1);
     }
 }
 
-static int TankStatusThread(void *data)
+static void TankStatusTask(PeriodicTask *task, void *data)
 {
     bool state;
+    bool pressed = false;
 
-     for (;;) {
-        bool pressed = false;
-
-        for (GList *t = Tanks.tanks; t != NULL; t = t->next) {
-            Tank *tank = (Tank *)t->data;
+    for (GList *t = Tanks.tanks; t != NULL; t = t->next) {
+        Tank *tank = (Tank *)t->data;
 
-            if (!GpioPinRead(tank->gpio[TANK_GPIO_STATUS_BUTTON], &state)) {
-                LogF(LOG_TYPE_ERROR, "TANK", "Failed to read GPIO \"%s\"", tank->gpio[TANK_GPIO_STATUS_BUTTON]->name);
-            } else {
-                if (state) {
-                    pressed = true;
-                    if (!TankStatusSet(tank, !TankStatusGet(tank), true)) {
-                        LogF(LOG_TYPE_ERROR, "TANK", "Failed to switch tank \"%s\" status", tank->name);
-                    }
+        if (!GpioPinRead(tank->gpio[TANK_GPIO_STATUS_BUTTON], &state)) {
+            LogF(LOG_TYPE_ERROR, "TANK", "Failed to read GPIO \"%s\"", tank->gpio[TANK_GPIO_STATUS_BUTTON]->name);
+        } else {
+            if (state) {
+                pressed = true;
+                if (!TankStatusSet(tank, !TankStatusGet(tank), true)) {
+                    LogF(LOG_TYPE_ERROR, "TANK", "Failed to switch tank \"%s\" status", tank->name);
                 }
             }
         }
+    }
 
-        if (pressed) {
-            UtilsMsecSleep(800);
-        }
-
-        UtilsMsecSleep(200);
-     }
+    if (pressed) {
+        PeriodicDelay(task, TANK_BUTTON_DELAY_MS);
+    }
 }
 
 /*********************************************************************/
@@ -207,6 +237,7 @@ Tank *TankNew(const char *name)
     tank->status = false;
     tank->pump = false;
     tank->valve = false;
+    SeqLockInit(&tank->lock);
 
     return tank;
 }
@@ -233,30 +264,43 @@ void TankAdd(Tank *tank)
 
 bool TankStatusSet(Tank *tank, bool status, bool save)
 {
-    if (tank->status != status) {
-        mtx_lock(&Tanks.sts_mtx);
-
-        LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" water control %s", tank->name, (status == true) ? "enabled" : "disabled");
+    bool changed = false;
 
+    SeqLockWriteBegin(&tank->lock);
+    if (tank->status != status) {
         tank->status = status;
-        GpioPinWrite(tank->gpio[TANK_GPIO_STATUS_LED], status);
-
         if (!status) {
-            GpioPinWrite(tank->gpio[TANK_GPIO_PUMP], false);
-            GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], false);
             tank->valve = false;
             tank->pump = false;
-            PlcAlarmSet(PLC_ALARM_TANK, false);
         }
+        changed = true;
+    }
+    SeqLockWriteEnd(&tank->lock);
 
-        if (save) {
-            StatusSave(tank);
-        }
+    if (!changed) {
+        return true;
+    }
+
+    LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" water control %s", tank->name, (status == true) ? "enabled" : "disabled");
+
+    GpioPinWrite(tank->gpio[TANK_GPIO_STATUS_LED], status);
+
+    if (!status) {
+        GpioPinWrite(tank->gpio[TANK_GPIO_PUMP], false);
+        GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], false);
+        PlcAlarmSet(PLC_ALARM_TANK, false);
+    }
 
-        mtx_unlock(&Tanks.sts_mtx);
+    if (save) {
+        StatusSave(tank);
+    }
 
+    if (status) {
         TankLevelProcess(tank);
+    } else {
+        StateEventPublish(tank);
     }
+
     return true;
 }
 
@@ -273,7 +317,24 @@ Tank *TankGet(const char *name)
 
 bool TankStatusGet(Tank *tank)
 {
-    return tank->status;
+    TankState state;
+
+    TankStateGet(tank, &state);
+
+    return state.status;
+}
+
+void TankStateGet(Tank *tank, TankState *state)
+{
+    unsigned seq;
+
+    do {
+        seq = SeqLockReadBegin(&tank->lock);
+        state->level = tank->level;
+        state->status = tank->status;
+        state->pump = tank->pump;
+        state->valve = tank->valve;
+    } while (SeqLockReadRetry(&tank->lock, seq));
 }
 
 bool TankPumpSet(Tank *tank, bool status)
@@ -284,9 +345,13 @@ bool TankPumpSet(Tank *tank, bool status)
     }
 
     GpioPinWrite(tank->gpio[TANK_GPIO_PUMP], status);
+    SeqLockWriteBegin(&tank->lock);
     tank->pump = status;
+    SeqLockWriteEnd(&tank->lock);
     LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" pump %s", tank->name, (status == true) ? "enabled" : "disabled");
 
+    StateEventPublish(tank);
+
     return true;
 }
 
@@ -298,28 +363,24 @@ bool TankValveSet(Tank *tank, bool status)
     }
 
     GpioPinWrite(tank->gpio[TANK_GPIO_VALVE], status);
+    SeqLockWriteBegin(&tank->lock);
     tank->valve = status;
+    SeqLockWriteEnd(&tank->lock);
     LogF(LOG_TYPE_INFO, "TANK", "Tank \"%s\" valve %s", tank->name, (status == true) ? "openned" : "closed");
 
+    StateEventPublish(tank);
+
     return true;
 }
 
 bool TankControllerStart()
 {
-    thrd_t  lvl_th, sts_th;
-
     Log(LOG_TYPE_INFO, "TANK", "Starting Tank controller");
 
-    if (thrd_create(&lvl_th, &TankLevelsThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(lvl_th) != thrd_success) {
-        return false;
-    }
-    if (thrd_create(&sts_th, &TankStatusThread, NULL) != thrd_success) {
+    if (!ReactorTaskAdd("tank_levels", TANK_LEVELS_PERIOD_MS, &TankLevelsTask, NULL)) {
         return false;
     }
-    if (thrd_detach(sts_th) != thrd_success) {
+    if (!ReactorTaskAdd("tank_status", TANK_BUTTON_PERIOD_MS, &TankStatusTask, NULL)) {
         return false;
     }
 
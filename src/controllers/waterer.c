@@ -10,10 +10,9 @@
 
 #include <controllers/waterer.h>
 #include <utils/log.h>
-#include <net/notifier.h>
 #include <db/database.h>
-
-#include <threads.h>
+#include <plc/reactor.h>
+#include <utils/events.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -23,7 +22,6 @@
 
 static struct {
     GList   *waterers;
-    mtx_t   sts_mtx;
 } Watering = {
     .waterers = NULL
 };
@@ -60,73 +58,73 @@ static bool StatusSave(Waterer *wtr)
     return true;
 }
 
-static int WatererThread(void *data)
+static void StateEventPublish(Waterer *wtr, bool notify)
 {
-    PlcTime now;
+    WatererState    state;
+
+    WatererStateGet(wtr, &state);
 
-    for (;;) {
-        PlcTimeGet(&now);
+    Event event = {
+        .type = EVENT_WATERER_CHANGED,
+        .waterer.status = state.status,
+        .waterer.valve = state.valve,
+        .waterer.notify = notify
+    };
+
+    strncpy(event.name, wtr->name, SHORT_STR_LEN - 1);
+    EventPublish(&event);
+}
 
-        for (GList *w = Watering.waterers; w != NULL; w = w->next) {
-            Waterer *wtr = (Waterer *)w->data;
+static void WatererTask(PeriodicTask *task, void *data)
+{
+    PlcTime now;
 
-            for (GList *t = Watering.waterers; t != NULL; t = t->next) {
-                WateringTime *tm = (WateringTime *)t->data;
+    PlcTimeGet(&now);
 
-                if (tm->state != wtr->valve) {
-                    if (tm->time.dow == now.dow && tm->time.hour == now.hour && tm->time.min == now.min && wtr->status) {
-                        GpioPinWrite(wtr->gpio[WATERER_GPIO_VALVE], tm->state);
-                        wtr->valve = tm->state;
-                        LogF(LOG_TYPE_INFO, "WATERER", "Waterer \"%s\" valve %s", wtr->name, (tm->state == true) ? "openned" : "closed");
+    for (GList *w = Watering.waterers; w != NULL; w = w->next) {
+        Waterer *wtr = (Waterer *)w->data;
 
-                        if (tm->notify) {
-                            char    msg[STR_LEN];
+        for (GList *t = wtr->times; t != NULL; t = t->next) {
+            WateringTime *tm = (WateringTime *)t->data;
 
-                            snprintf(msg, STR_LEN, "ПОЛИВ+\"%s\":+кран+%s", wtr->name, (wtr->valve == true) ? "открыт" : "закрыт");
+            if (tm->state != wtr->valve) {
+                if (tm->time.dow == now.dow && tm->time.hour == now.hour && tm->time.min == now.min && wtr->status) {
+                    GpioPinWrite(wtr->gpio[WATERER_GPIO_VALVE], tm->state);
+                    SeqLockWriteBegin(&wtr->lock);
+                    wtr->valve = tm->state;
+                    SeqLockWriteEnd(&wtr->lock);
+                    LogF(LOG_TYPE_INFO, "WATERER", "Waterer \"%s\" valve %s", wtr->name, (tm->state == true) ? "openned" : "closed");
 
-                            if (!NotifierTelegramSend(msg)) {
-                                Log(LOG_TYPE_ERROR, "WATERER", "Failed to send watere notify");
-                            }
-                        }
-                    }
+                    StateEventPublish(wtr, tm->notify);
                 }
             }
         }
-
-        UtilsSecSleep(1);
     }
-    return 0;
 }
 
-static int ButtonsThread(void *data)
+static void ButtonsTask(PeriodicTask *task, void *data)
 {
     bool state;
-
-    for (;;) {
-        bool pressed = false;
-
-        for (GList *w = Watering.waterers; w != NULL; w = w->next) {
-            Waterer *wtr = (Waterer *)w->data;
-
-            if (!GpioPinRead(wtr->gpio[WATERER_GPIO_STATUS_BUTTON], &state)) {
-                LogF(LOG_TYPE_ERROR, "WATERER", "Failed to read GPIO \"%s\"", wtr->gpio[WATERER_GPIO_STATUS_BUTTON]->name);
-            } else {
-                if (state) {
-                    pressed = true;
-                    if (!WatererStatusSet(wtr, !wtr->status, true)) {
-                        LogF(LOG_TYPE_ERROR, "WATERER", "Failed to switch Waterer \"%s\" status", wtr->name);
-                    }
+    bool pressed = false;
+
+    for (GList *w = Watering.waterers; w != NULL; w = w->next) {
+        Waterer *wtr = (Waterer *)w->data;
+
+        if (!GpioPinRead(wtr->gpio[WATERER_GPIO_STATUS_BUTTON], &state)) {
+            LogF(LOG_TYPE_ERROR, "WATERER", "Failed to read GPIO \"%s\"", wtr->gpio[WATERER_GPIO_STATUS_BUTTON]->name);
+        } else {
+            if (state) {
+                pressed = true;
+                if (!WatererStatusSet(wtr, !wtr->status, true)) {
+                    LogF(LOG_TYPE_ERROR, "WATERER", "Failed to switch Waterer \"%s\" status", wtr->name);
                 }
             }
         }
+    }
 
-        if (pressed) {
-            UtilsMsecSleep(800);
-        }
-
-        UtilsMsecSleep(200);
+    if (pressed) {
+        PeriodicDelay(task, WATERER_BUTTON_DELAY_MS);
     }
-    return 0;
 }
 
 /*********************************************************************/
@@ -143,6 +141,7 @@ Waterer *WatererNew(const char *name)
     wtr->status = false;
     wtr->times = NULL;
     wtr->valve = false;
+    SeqLockInit(&wtr->lock);
 
     return wtr;
 }
@@ -191,25 +190,36 @@ void WatererGpioSet(Waterer *wtr, WatererGpioType type, GpioPin *gpio)
 
 bool WatererStatusSet(Waterer *wtr, bool status, bool save)
 {
-    if (wtr->status != status) {
-        mtx_lock(&Watering.sts_mtx);
-
-        LogF(LOG_TYPE_INFO, "WATERER", "Waterer \"%s\" status %s", wtr->name, (status == true) ? "enabled" : "disabled");
+    bool changed = false;
 
+    SeqLockWriteBegin(&wtr->lock);
+    if (wtr->status != status) {
         wtr->status = status;
-        GpioPinWrite(wtr->gpio[WATERER_GPIO_STATUS_LED], status);
-
         if (!status) {
-            GpioPinWrite(wtr->gpio[WATERER_GPIO_VALVE], false);
             wtr->valve = false;
         }
+        changed = true;
+    }
+    SeqLockWriteEnd(&wtr->lock);
 
-        if (save) {
-            StatusSave(wtr);
-        }
+    if (!changed) {
+        return true;
+    }
+
+    LogF(LOG_TYPE_INFO, "WATERER", "Waterer \"%s\" status %s", wtr->name, (status == true) ? "enabled" : "disabled");
+
+    GpioPinWrite(wtr->gpio[WATERER_GPIO_STATUS_LED], status);
+
+    if (!status) {
+        GpioPinWrite(wtr->gpio[WATERER_GPIO_VALVE], false);
+    }
 
-        mtx_unlock(&Watering.sts_mtx);
+    if (save) {
+        StatusSave(wtr);
     }
+
+    StateEventPublish(wtr, false);
+
     return true;
 }
 
@@ -221,35 +231,40 @@ bool WatererValveSet(Waterer *wtr, bool status)
     }
 
     GpioPinWrite(wtr->gpio[WATERER_GPIO_VALVE], status);
+    SeqLockWriteBegin(&wtr->lock);
     wtr->valve = status;
+    SeqLockWriteEnd(&wtr->lock);
     LogF(LOG_TYPE_INFO, "WATERER", "Waterer \"%s\" valve %s", wtr->name, (status == true) ? "openned" : "closed");
 
+    StateEventPublish(wtr, false);
+
     return true;
 }
 
-bool WatererControllerStart()
+void WatererStateGet(Waterer *wtr, WatererState *state)
 {
-    thrd_t  wtr_th, bth_th;
+    unsigned seq;
 
+    do {
+        seq = SeqLockReadBegin(&wtr->lock);
+        state->status = wtr->status;
+        state->valve = wtr->valve;
+    } while (SeqLockReadRetry(&wtr->lock, seq));
+}
+
+bool WatererControllerStart()
+{
     if (g_list_length(Watering.waterers) == 0) {
         return true;
     }
 
     Log(LOG_TYPE_INFO, "WATERER", "Starting Waterer controller");
 
-    if (thrd_create(&wtr_th, &WatererThread, NULL) != thrd_success) {
-        return false;
-    }
-
-    if (thrd_detach(wtr_th) != thrd_success) {
-        return false;
-    }
-
-    if (thrd_create(&bth_th, &ButtonsThread, NULL) != thrd_success) {
+    if (!ReactorTaskAdd("waterer", WATERER_PERIOD_MS, &WatererTask, NULL)) {
         return false;
     }
 
-    if (thrd_detach(bth_th) != thrd_success) {
+    if (!ReactorTaskAdd("waterer_buttons", WATERER_BUTTON_PERIOD_MS, &ButtonsTask, NULL)) {
         return false;
     }
 
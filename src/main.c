@@ -9,6 +9,7 @@
 /*********************************************************************/
 
 #include <string.h>
+#include <stdlib.h>
 
 #include <utils/configs/configs.h>
 #include <utils/utils.h>
@@ -18,6 +19,9 @@
 #include <db/database.h>
 #include <cam/camera.h>
 #include <plc/plc.h>
+#include <plc/reactor.h>
+#include <scenario/logic.h>
+#include <stack/rpc.h>
 
 int main(const int argc, const char **argv)
 {
@@ -26,11 +30,22 @@ int main(const int argc, const char **argv)
     char    db_path[STR_LEN] = "./data/db/";
     char    cam_path[STR_LEN] = "./data/cam/";
     bool    ftest_start = false;
+    bool    bench_start = false;
+    bool    bench_state_start = false;
+    bool    bench_rpc_start = false;
+    unsigned bench_rpc_unit = 0;
 
     if (argc > 1) {
         for (unsigned i = 1; i < argc; i++) {
             if (!strcmp(argv[i], "--ftest")) {
                 ftest_start = true;
+            } else if (!strcmp(argv[i], "--bench")) {
+                bench_start = true;
+            } else if (!strcmp(argv[i], "--bench-state")) {
+                bench_state_start = true;
+            } else if (!strcmp(argv[i], "--bench-rpc")) {
+                bench_rpc_start = true;
+                bench_rpc_unit = (unsigned)atoi(argv[i + 1]);
             } else if (!strcmp(argv[i], "--configs")) {
                 strncpy(cfg_path, argv[i + 1], STR_LEN);
             } else if (!strcmp(argv[i], "--db")) {
@@ -46,6 +61,9 @@ int main(const int argc, const char **argv)
                 printf("\t--log [:path]\t\tPath to Log directory\n");
                 printf("\t--cam [:path]\t\tPath to Camera photos directory\n");
                 printf("\t--ftest\t\t\tStart factory test\n");
+                printf("\t--bench\t\t\tMeasure logic engine speed\n");
+                printf("\t--bench-state\t\tCompare binary and JSON unit state encoding\n");
+                printf("\t--bench-rpc [:unit]\tCompare channel and HTTP requests to Stack unit\n");
                 return 0;
             }
         }
@@ -55,6 +73,14 @@ int main(const int argc, const char **argv)
     DatabasePathSet(db_path);
     CameraPathSet(cam_path);
 
+    if (bench_start) {
+        return LogicBenchmark() ? 0 : -1;
+    }
+
+    if (bench_state_start) {
+        return RpcStateBenchmark() ? 0 : -1;
+    }
+
     Log(LOG_TYPE_INFO, "MAIN", "Starting application");
 
     if (!GpioInit()) {
@@ -69,6 +95,18 @@ int main(const int argc, const char **argv)
 
     Log(LOG_TYPE_INFO, "MAIN", "Configs was readed");
 
+    if (bench_rpc_start) {
+        if (!ReactorStart()) {
+            Log(LOG_TYPE_ERROR, "MAIN", "Failed to start reactor");
+            return -1;
+        }
+        return RpcTransportBenchmark(bench_rpc_unit) ? 0 : -1;
+    }
+
+    if (!LogArchiverStart()) {
+        Log(LOG_TYPE_ERROR, "MAIN", "Failed to start Log archiver");
+    }
+
     if (ftest_start) {
         if (!FactoryTestStart()) {
             Log(LOG_TYPE_ERROR, "MAIN", "Failed to start Factory Test");
@@ -0,0 +1,1110 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <net/channel.h>
+#include <net/web/webserver.h>
+#include <plc/reactor.h>
+#include <stack/statelog.h>
+#include <stack/rpc.h>
+#include <utils/utils.h>
+#include <utils/jobs.h>
+#include <utils/log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+#define FRAME_HEADER_LEN    9
+#define STREAM_BUF_LEN      4096
+
+typedef enum {
+    FRAME_REQUEST,
+    FRAME_REPLY,
+    FRAME_PING,
+    FRAME_PONG
+} FrameType;
+
+typedef struct {
+    uint8_t     *data;
+    size_t      len;
+    size_t      size;
+} FrameBuf;
+
+typedef struct {
+    char        ip[SHORT_STR_LEN];
+    unsigned    port;
+    int         fd;
+    uint32_t    next_id;
+    uint64_t    last_rx_ns;
+    uint64_t    retry_ns;
+    GList       *calls;
+    mtx_t       wmtx;
+} ChannelConn;
+
+struct _ChannelCall {
+    uint32_t    id;
+    ChannelConn *conn;
+    bool        done;
+    bool        result;
+    char        *data;
+    size_t      len;
+    ChannelFunc func;
+    void        *func_data;
+    uint64_t    deadline_ns;
+};
+
+typedef struct {
+    ChannelConn *conn;
+    int         fd;
+    FrameBuf    buf;
+} ClientReader;
+
+typedef struct {
+    int                 fd;
+    mtx_t               wmtx;
+    atomic_uint         refs;
+    atomic_uint         calls;
+    atomic_uint         parked;
+    _Atomic uint64_t    last_rx_ns;
+    FrameBuf            buf;
+} ServerConn;
+
+/**
+ * @brief Complete frame handler, payload is zero terminated and owned
+ * by handler
+ *
+ * @return False to close connection
+ */
+typedef bool (*FrameFunc)(void *data, FrameType type, uint32_t id, char *payload, size_t len);
+
+typedef struct {
+    ServerConn  *conn;
+    uint32_t    id;
+    char        *payload;
+    size_t      len;
+    bool        parked;
+} ServerCall;
+
+typedef struct {
+    FCGX_Stream     stream;
+    unsigned char   *buf;
+    size_t          size;
+} MemStream;
+
+static struct {
+    once_flag   once;
+    mtx_t       mtx;
+    cnd_t       done;
+    GList       *conns;
+    GList       *servers;
+    char        server_ip[SHORT_STR_LEN];
+    unsigned    server_port;
+} Channel = {
+    .once = ONCE_FLAG_INIT,
+    .conns = NULL,
+    .servers = NULL,
+    .server_ip = {0},
+    .server_port = 0
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void ChannelTask(PeriodicTask *task, void *data);
+
+static void ChannelInit()
+{
+    mtx_init(&Channel.mtx, mtx_plain);
+    cnd_init(&Channel.done);
+
+    if (!ReactorTaskAdd("channel", CHANNEL_PING_MS, &ChannelTask, NULL)) {
+        Log(LOG_TYPE_ERROR, "CHANNEL", "Failed to start channel pings");
+    }
+}
+
+static bool FullWrite(int fd, const void *data, size_t len)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+
+    while (len > 0) {
+        ssize_t n = send(fd, ptr, len, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        /**
+         * Sockets are nonblocking for reactor, full socket buffer is
+         * waited for as long as live peer may be silent
+         */
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+
+            if (poll(&pfd, 1, CHANNEL_DEAD_MS) != 1) {
+                return false;
+            }
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Write frame, caller must hold write lock of connection
+ */
+static bool FrameWrite(int fd, FrameType type, uint32_t id, const void *head, size_t head_len,
+                       const void *data, size_t data_len)
+{
+    uint8_t     hdr[FRAME_HEADER_LEN];
+    uint32_t    len = head_len + data_len;
+
+    for (unsigned i = 0; i < 4; i++) {
+        hdr[i] = (uint8_t)(len >> (24 - i * 8));
+        hdr[4 + i] = (uint8_t)(id >> (24 - i * 8));
+    }
+    hdr[8] = (uint8_t)type;
+
+    if (!FullWrite(fd, hdr, FRAME_HEADER_LEN)) {
+        return false;
+    }
+    if (head_len > 0 && !FullWrite(fd, head, head_len)) {
+        return false;
+    }
+    if (data_len > 0 && !FullWrite(fd, data, data_len)) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Send ping or pong without waiting, caller must hold write lock
+ * of connection. Connection which can not take header at once is dead.
+ */
+static bool SignalSend(int fd, FrameType type, uint32_t id)
+{
+    uint8_t hdr[FRAME_HEADER_LEN] = { 0 };
+
+    for (unsigned i = 0; i < 4; i++) {
+        hdr[4 + i] = (uint8_t)(id >> (24 - i * 8));
+    }
+    hdr[8] = (uint8_t)type;
+
+    return send(fd, hdr, FRAME_HEADER_LEN, MSG_NOSIGNAL | MSG_DONTWAIT) == FRAME_HEADER_LEN;
+}
+
+/**
+ * @brief Read available data of nonblocking socket and pass every
+ * complete frame to handler
+ *
+ * @return False if connection is closed, failed or frame is invalid
+ */
+static bool FramesRead(int fd, FrameBuf *buf, FrameFunc func, void *data)
+{
+    for (;;) {
+        if (buf->size - buf->len < STREAM_BUF_LEN) {
+            buf->size = buf->len + STREAM_BUF_LEN;
+            buf->data = (uint8_t *)realloc(buf->data, buf->size);
+        }
+
+        ssize_t n = recv(fd, buf->data + buf->len, buf->size - buf->len, 0);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        if (n <= 0) {
+            return false;
+        }
+
+        buf->len += n;
+
+        while (buf->len >= FRAME_HEADER_LEN) {
+            uint32_t    size = 0;
+            uint32_t    id = 0;
+
+            for (unsigned i = 0; i < 4; i++) {
+                size = (size << 8) | buf->data[i];
+                id = (id << 8) | buf->data[4 + i];
+            }
+
+            if (size > CHANNEL_FRAME_MAX) {
+                return false;
+            }
+            if (buf->len < FRAME_HEADER_LEN + size) {
+                break;
+            }
+
+            FrameType   type = buf->data[8];
+            char        *payload = (char *)malloc(size + 1);
+
+            memcpy(payload, buf->data + FRAME_HEADER_LEN, size);
+            payload[size] = '\0';
+
+            buf->len -= FRAME_HEADER_LEN + size;
+            memmove(buf->data, buf->data + FRAME_HEADER_LEN + size, buf->len);
+
+            if (!func(data, type, id, payload, size)) {
+                return false;
+            }
+        }
+    }
+}
+
+static void SocketSetup(int fd)
+{
+    int one = 1;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static int Connect(const char *ip, unsigned port)
+{
+    struct sockaddr_in  addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    struct pollfd       pfd;
+    int                 err = 0;
+    socklen_t           err_len = sizeof(err);
+
+    if (inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+
+    if (poll(&pfd, 1, CHANNEL_CONNECT_MS) != 1 ||
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0 || err != 0) {
+        close(fd);
+        return -1;
+    }
+
+    SocketSetup(fd);
+
+    return fd;
+}
+
+static ChannelConn *ConnGet(const char *ip, unsigned port)
+{
+    for (GList *c = Channel.conns; c != NULL; c = c->next) {
+        ChannelConn *conn = (ChannelConn *)c->data;
+
+        if (conn->port == port && !strcmp(conn->ip, ip)) {
+            return conn;
+        }
+    }
+
+    ChannelConn *conn = (ChannelConn *)calloc(1, sizeof(ChannelConn));
+
+    strncpy(conn->ip, ip, SHORT_STR_LEN - 1);
+    conn->port = port;
+    conn->fd = -1;
+    mtx_init(&conn->wmtx, mtx_plain);
+    Channel.conns = g_list_append(Channel.conns, (void *)conn);
+
+    return conn;
+}
+
+static ChannelCall *CallGet(ChannelConn *conn, uint32_t id)
+{
+    for (GList *c = conn->calls; c != NULL; c = c->next) {
+        ChannelCall *call = (ChannelCall *)c->data;
+
+        if (call->id == id) {
+            return call;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Call handlers of finished async calls, channel lock must not
+ * be held, so handlers may start new calls
+ */
+static void AsyncCallsFinish(GList *calls)
+{
+    for (GList *c = calls; c != NULL; c = c->next) {
+        ChannelCall *call = (ChannelCall *)c->data;
+
+        call->func(call->result, call->data, call->len, call->func_data);
+        free(call);
+    }
+
+    g_list_free(calls);
+}
+
+static bool ClientFrameProcess(void *data, FrameType type, uint32_t id, char *payload, size_t len)
+{
+    ChannelConn *conn = ((ClientReader *)data)->conn;
+    GList       *finished = NULL;
+
+    mtx_lock(&Channel.mtx);
+
+    conn->last_rx_ns = UtilsMonoNsGet();
+
+    ChannelCall *call = (type == FRAME_REPLY) ? CallGet(conn, id) : NULL;
+    if (call != NULL) {
+        conn->calls = g_list_remove(conn->calls, call);
+        call->data = payload;
+        call->len = len;
+        call->result = true;
+        call->done = true;
+        if (call->func != NULL) {
+            finished = g_list_append(finished, (void *)call);
+        } else {
+            cnd_broadcast(&Channel.done);
+        }
+    } else {
+        free(payload);
+    }
+
+    mtx_unlock(&Channel.mtx);
+
+    AsyncCallsFinish(finished);
+
+    return true;
+}
+
+/**
+ * @brief Client connection reader, matches replies with calls. Closed
+ * connection is removed from reactor and all its calls are failed.
+ */
+static void ClientConnProcess(int fd, void *data)
+{
+    ClientReader    *reader = (ClientReader *)data;
+    ChannelConn     *conn = reader->conn;
+
+    if (FramesRead(fd, &reader->buf, &ClientFrameProcess, reader)) {
+        return;
+    }
+
+    ReactorFdRemove(fd);
+
+    GList *finished = NULL;
+
+    mtx_lock(&Channel.mtx);
+
+    if (conn->fd == fd) {
+        conn->fd = -1;
+    }
+
+    for (GList *c = conn->calls; c != NULL; c = c->next) {
+        ChannelCall *call = (ChannelCall *)c->data;
+
+        call->result = false;
+        call->done = true;
+        if (call->func != NULL) {
+            finished = g_list_append(finished, (void *)call);
+        }
+    }
+    g_list_free(conn->calls);
+    conn->calls = NULL;
+    cnd_broadcast(&Channel.done);
+
+    mtx_unlock(&Channel.mtx);
+
+    AsyncCallsFinish(finished);
+
+    mtx_lock(&conn->wmtx);
+    close(fd);
+    mtx_unlock(&conn->wmtx);
+
+    free(reader->buf.data);
+    free(reader);
+}
+
+/**
+ * @brief Get connected socket, caller must hold write lock of connection
+ */
+static int ConnFdGet(ChannelConn *conn)
+{
+    mtx_lock(&Channel.mtx);
+    int fd = conn->fd;
+    mtx_unlock(&Channel.mtx);
+
+    if (fd >= 0) {
+        return fd;
+    }
+
+    /**
+     * Dead unit is not dialed on every call, so callers fail fast
+     * instead of waiting for connect timeout
+     */
+
+    if (UtilsMonoNsGet() < conn->retry_ns) {
+        return -1;
+    }
+
+    fd = Connect(conn->ip, conn->port);
+    if (fd < 0) {
+        conn->retry_ns = UtilsMonoNsGet() + (uint64_t)CHANNEL_RETRY_MS * 1000000;
+        return -1;
+    }
+
+    ClientReader *reader = (ClientReader *)calloc(1, sizeof(ClientReader));
+
+    reader->conn = conn;
+    reader->fd = fd;
+
+    mtx_lock(&Channel.mtx);
+    conn->fd = fd;
+    conn->last_rx_ns = UtilsMonoNsGet();
+    mtx_unlock(&Channel.mtx);
+
+    if (!ReactorFdAdd(fd, &ClientConnProcess, (void *)reader)) {
+        mtx_lock(&Channel.mtx);
+        conn->fd = -1;
+        mtx_unlock(&Channel.mtx);
+        close(fd);
+        free(reader);
+        return -1;
+    }
+
+    LogF(LOG_TYPE_INFO, "CHANNEL", "Connected to unit %s:%u", conn->ip, conn->port);
+    return fd;
+}
+
+static void MemStreamGrow(FCGX_Stream *stream, int close)
+{
+    MemStream   *ms = (MemStream *)stream->data;
+    size_t      used = stream->wrNext - ms->buf;
+
+    ms->size *= 2;
+    ms->buf = (unsigned char *)realloc(ms->buf, ms->size);
+    stream->wrNext = ms->buf + used;
+    stream->stop = ms->buf + ms->size;
+}
+
+static void MemStreamEnd(FCGX_Stream *stream)
+{
+    stream->isClosed = 1;
+}
+
+static void ServerConnRelease(ServerConn *conn)
+{
+    if (atomic_fetch_sub(&conn->refs, 1) == 1) {
+        close(conn->fd);
+        mtx_destroy(&conn->wmtx);
+        free(conn->buf.data);
+        free(conn);
+    }
+}
+
+/**
+ * @brief Send reply body of call and release it
+ */
+static void ServerCallReply(ServerCall *call, const void *body, size_t len)
+{
+    ServerConn *conn = call->conn;
+
+    mtx_lock(&conn->wmtx);
+    if (!FrameWrite(conn->fd, FRAME_REPLY, call->id, NULL, 0, body, len)) {
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    mtx_unlock(&conn->wmtx);
+
+    atomic_fetch_sub(call->parked ? &conn->parked : &conn->calls, 1);
+    free(call->payload);
+    free(call);
+    ServerConnRelease(conn);
+}
+
+static void ServerCallFail(ServerCall *call, const char *error)
+{
+    char body[STR_LEN];
+
+    snprintf(body, STR_LEN, "{\"result\":false,\"error\":\"%s\"}", error);
+    ServerCallReply(call, body, strlen(body));
+}
+
+/**
+ * @brief Run one request by web server handlers with memory streams
+ * instead of FastCGI ones and send reply body back. Parked long-poll
+ * is run without wait param, its waiting is already over.
+ */
+static bool ServerCallJob(void *data)
+{
+    ServerCall  *call = (ServerCall *)data;
+    char        *path = call->payload + 1;
+    size_t      path_len = strlen(path);
+    char        *post = path + path_len + 1;
+    size_t      post_len = call->len - path_len - 2;
+    char        script[STR_LEN];
+    char        uri[STR_LEN];
+    char        env[4][EXT_STR_LEN];
+    char        *envp[5];
+    MemStream   in = { 0 };
+    MemStream   out = { 0 };
+
+    if (call->parked) {
+        UtilsURIParamDrop(path, "wait", uri);
+    }
+
+    snprintf(script, STR_LEN, "%.*s", (int)strcspn(path, "?"), path);
+    snprintf(env[0], EXT_STR_LEN, "REQUEST_METHOD=%s", (call->payload[0] == 'P') ? "POST" : "GET");
+    snprintf(env[1], EXT_STR_LEN, "SCRIPT_NAME=%s", script);
+    snprintf(env[2], EXT_STR_LEN, "REQUEST_URI=%s", call->parked ? uri : path);
+    snprintf(env[3], EXT_STR_LEN, "CONTENT_LENGTH=%zu", post_len);
+    for (unsigned i = 0; i < 4; i++) {
+        envp[i] = env[i];
+    }
+    envp[4] = NULL;
+
+    in.stream.rdNext = (unsigned char *)post;
+    in.stream.stop = (unsigned char *)post + post_len;
+    in.stream.stopUnget = in.stream.rdNext;
+    in.stream.wrNext = in.stream.stop;
+    in.stream.isReader = 1;
+    in.stream.fillBuffProc = &MemStreamEnd;
+    in.stream.data = &in;
+
+    out.size = STREAM_BUF_LEN;
+    out.buf = (unsigned char *)malloc(out.size);
+    out.stream.wrNext = out.buf;
+    out.stream.rdNext = out.buf;
+    out.stream.stop = out.buf + out.size;
+    out.stream.emptyBuffProc = &MemStreamGrow;
+    out.stream.data = &out;
+
+    FCGX_Request req = {
+        .in = &in.stream,
+        .out = &out.stream,
+        .err = &out.stream,
+        .envp = envp
+    };
+
+    WebServerRequestProcess(&req);
+
+    /**
+     * Handlers write CGI headers before body, only body is sent
+     */
+
+    size_t      len = out.stream.wrNext - out.buf;
+    const char  *body = g_strstr_len((const char *)out.buf, len, "\r\n\r\n");
+    size_t      skip = (body != NULL) ? (size_t)(body - (const char *)out.buf) + 4 : 0;
+
+    ServerCallReply(call, out.buf + skip, len - skip);
+    free(out.buf);
+
+    return true;
+}
+
+static void ServerCallWake(void *data)
+{
+    ServerCall *call = (ServerCall *)data;
+
+    if (!JobRun("channel", JOB_PRIO_NORMAL, &ServerCallJob, (void *)call)) {
+        ServerCallFail(call, "Channel is busy");
+    }
+}
+
+static void ServerRouteDone(bool result, const char *out, size_t out_len, void *data)
+{
+    ServerCall *call = (ServerCall *)data;
+
+    if (!result) {
+        ServerCallFail(call, "Failed to route request");
+        return;
+    }
+
+    ServerCallReply(call, out, out_len);
+}
+
+static const char *ParamGet(GList *params, const char *name)
+{
+    for (GList *p = params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, name)) {
+            return param->value;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Keep call which may wait long without job worker. State
+ * long-poll is run when state is changed or its wait is over, routed
+ * request is passed to unit and its reply is sent when it comes.
+ *
+ * @return False if call is not parkable and must be run on job pool
+ */
+static bool ServerCallPark(ServerCall *call)
+{
+    char        *path = call->payload + 1;
+    GList       *params = NULL;
+    bool        state = !strncmp(path, "/api/" SERVER_API_VER "/state?", strlen("/api/" SERVER_API_VER "/state?"));
+
+    UtilsURIParse(path, &params);
+
+    const char  *route = ParamGet(params, "route");
+    const char  *cmd = ParamGet(params, "cmd");
+    const char  *since = ParamGet(params, "since");
+    const char  *wait = ParamGet(params, "wait");
+    unsigned    route_id = (route != NULL) ? strtoul(route, NULL, 10) : 0;
+    uint64_t    since_version = (since != NULL) ? strtoull(since, NULL, 10) : 0;
+    unsigned    wait_ms = (wait != NULL) ? strtoul(wait, NULL, 10) : 0;
+    bool        poll = (state && cmd != NULL && !strcmp(cmd, "changes_get") && since != NULL && wait_ms > 0);
+
+    g_list_free_full(params, &free);
+
+    if (route_id == 0 && !poll) {
+        return false;
+    }
+
+    call->parked = true;
+    atomic_fetch_add(&call->conn->refs, 1);
+    atomic_fetch_add(&call->conn->parked, 1);
+
+    if (route_id != 0) {
+        char routed[STR_LEN];
+        char *post = (call->payload[0] == 'P') ? path + strlen(path) + 1 : NULL;
+
+        UtilsURIParamDrop(path, "route", routed);
+
+        if (!RpcRouteAsync(route_id, routed, post, &ServerRouteDone, (void *)call)) {
+            LogF(LOG_TYPE_ERROR, "CHANNEL", "Failed to route request to Unit %u", route_id);
+            ServerCallFail(call, "Failed to route request");
+        }
+        return true;
+    }
+
+    if (wait_ms > STATE_WAIT_MAX_MS) {
+        wait_ms = STATE_WAIT_MAX_MS;
+    }
+
+    if (!StateChangesNotify(since_version, wait_ms, &ServerCallWake, (void *)call)) {
+        ServerCallWake((void *)call);
+    }
+
+    return true;
+}
+
+static bool ServerFrameProcess(void *data, FrameType type, uint32_t id, char *payload, size_t len)
+{
+    ServerConn *conn = (ServerConn *)data;
+
+    conn->last_rx_ns = UtilsMonoNsGet();
+
+    /**
+     * Reply being written answers ping as well, so pong is skipped
+     * instead of waiting for it on reactor
+     */
+
+    if (type == FRAME_PING) {
+        bool sent = true;
+
+        free(payload);
+
+        if (mtx_trylock(&conn->wmtx) == thrd_success) {
+            sent = SignalSend(conn->fd, FRAME_PONG, id);
+            mtx_unlock(&conn->wmtx);
+        }
+
+        return sent;
+    }
+
+    if (type != FRAME_REQUEST || len < 2 || memchr(payload + 1, '\0', len - 1) == NULL) {
+        free(payload);
+        return false;
+    }
+
+    if (atomic_load(&conn->calls) >= CHANNEL_CALLS_MAX || atomic_load(&conn->parked) >= CHANNEL_PARKED_MAX) {
+        const char *busy = "{\"result\":false,\"error\":\"Channel is busy\"}";
+
+        free(payload);
+        mtx_lock(&conn->wmtx);
+        bool sent = FrameWrite(conn->fd, FRAME_REPLY, id, NULL, 0, busy, strlen(busy));
+        mtx_unlock(&conn->wmtx);
+
+        return sent;
+    }
+
+    ServerCall *call = (ServerCall *)malloc(sizeof(ServerCall));
+
+    call->conn = conn;
+    call->id = id;
+    call->payload = payload;
+    call->len = len;
+    call->parked = false;
+
+    /**
+     * Long-polls and routed requests wait without worker, so the pool
+     * stays usable whatever number of subscriptions is open
+     */
+
+    if (ServerCallPark(call)) {
+        return true;
+    }
+
+    atomic_fetch_add(&conn->refs, 1);
+    atomic_fetch_add(&conn->calls, 1);
+
+    /**
+     * Requests run in parallel on job pool, so slow request does not
+     * hold up other requests of same connection
+     */
+
+    if (!JobRun("channel", JOB_PRIO_NORMAL, &ServerCallJob, (void *)call)) {
+        atomic_fetch_sub(&conn->calls, 1);
+        atomic_fetch_sub(&conn->refs, 1);
+        free(payload);
+        free(call);
+        return false;
+    }
+
+    return true;
+}
+
+static void ServerConnProcess(int fd, void *data)
+{
+    ServerConn *conn = (ServerConn *)data;
+
+    if (FramesRead(fd, &conn->buf, &ServerFrameProcess, conn)) {
+        return;
+    }
+
+    ReactorFdRemove(fd);
+
+    mtx_lock(&Channel.mtx);
+    Channel.servers = g_list_remove(Channel.servers, conn);
+    mtx_unlock(&Channel.mtx);
+
+    /**
+     * Running requests keep connection, their replies just fail
+     */
+
+    shutdown(fd, SHUT_RDWR);
+    ServerConnRelease(conn);
+}
+
+static void ServerAccept(int fd, void *data)
+{
+    for (;;) {
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Log(LOG_TYPE_ERROR, "CHANNEL", "Failed to accept connection");
+            }
+            return;
+        }
+
+        SocketSetup(client);
+
+        ServerConn *conn = (ServerConn *)calloc(1, sizeof(ServerConn));
+
+        conn->fd = client;
+        mtx_init(&conn->wmtx, mtx_plain);
+        atomic_init(&conn->refs, 1);
+        atomic_init(&conn->calls, 0);
+        conn->last_rx_ns = UtilsMonoNsGet();
+
+        mtx_lock(&Channel.mtx);
+        Channel.servers = g_list_append(Channel.servers, (void *)conn);
+        mtx_unlock(&Channel.mtx);
+
+        if (!ReactorFdAdd(client, &ServerConnProcess, (void *)conn)) {
+            mtx_lock(&Channel.mtx);
+            Channel.servers = g_list_remove(Channel.servers, conn);
+            mtx_unlock(&Channel.mtx);
+            ServerConnRelease(conn);
+        }
+    }
+}
+
+/**
+ * @brief Ping idle client connections and shut down connections without
+ * any frame for CHANNEL_DEAD_MS, their readers close them. Async calls
+ * are failed after their deadline.
+ */
+static void ChannelTask(PeriodicTask *task, void *data)
+{
+    uint64_t    now = UtilsMonoNsGet();
+    GList       *finished = NULL;
+
+    mtx_lock(&Channel.mtx);
+
+    for (GList *c = Channel.conns; c != NULL; c = c->next) {
+        ChannelConn *conn = (ChannelConn *)c->data;
+        uint64_t    idle_ms = (now - conn->last_rx_ns) / 1000000;
+
+        for (GList *l = conn->calls; l != NULL;) {
+            ChannelCall *call = (ChannelCall *)l->data;
+            GList       *next = l->next;
+
+            if (call->func != NULL && now >= call->deadline_ns) {
+                conn->calls = g_list_delete_link(conn->calls, l);
+                finished = g_list_append(finished, (void *)call);
+            }
+            l = next;
+        }
+
+        if (conn->fd < 0) {
+            continue;
+        }
+
+        if (idle_ms > CHANNEL_DEAD_MS) {
+            LogF(LOG_TYPE_ERROR, "CHANNEL", "Unit %s:%u does not answer", conn->ip, conn->port);
+            shutdown(conn->fd, SHUT_RDWR);
+        } else if (idle_ms >= CHANNEL_PING_MS / 2 && mtx_trylock(&conn->wmtx) == thrd_success) {
+            if (!SignalSend(conn->fd, FRAME_PING, 0)) {
+                shutdown(conn->fd, SHUT_RDWR);
+            }
+            mtx_unlock(&conn->wmtx);
+        }
+    }
+
+    /**
+     * Server readers update receive time without channel lock, so it is
+     * read before clock to keep idle time from wrapping
+     */
+
+    for (GList *c = Channel.servers; c != NULL; c = c->next) {
+        ServerConn  *conn = (ServerConn *)c->data;
+        uint64_t    last_rx_ns = atomic_load(&conn->last_rx_ns);
+
+        if ((UtilsMonoNsGet() - last_rx_ns) / 1000000 > CHANNEL_DEAD_MS) {
+            shutdown(conn->fd, SHUT_RDWR);
+        }
+    }
+
+    mtx_unlock(&Channel.mtx);
+
+    AsyncCallsFinish(finished);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+void ChannelServerSet(const char *ip, unsigned port)
+{
+    strncpy(Channel.server_ip, ip, SHORT_STR_LEN - 1);
+    Channel.server_port = port;
+}
+
+bool ChannelServerStart()
+{
+    struct sockaddr_in  addr = { .sin_family = AF_INET };
+    int                 one = 1;
+
+    if (Channel.server_port == 0) {
+        return true;
+    }
+
+    call_once(&Channel.once, &ChannelInit);
+
+    addr.sin_port = htons(Channel.server_port);
+    if (inet_pton(AF_INET, Channel.server_ip, &addr.sin_addr) != 1) {
+        LogF(LOG_TYPE_ERROR, "CHANNEL", "Invalid channel server ip \"%s\"", Channel.server_ip);
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return false;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    if (!ReactorFdAdd(fd, &ServerAccept, NULL)) {
+        close(fd);
+        return false;
+    }
+
+    LogF(LOG_TYPE_INFO, "CHANNEL", "Channel server is listening on %s:%u", Channel.server_ip, Channel.server_port);
+    return true;
+}
+
+/**
+ * @brief Send request, async call is owned by channel after that
+ */
+static ChannelCall *CallStart(const char *ip, unsigned port, const char *path, const char *post,
+                              ChannelFunc func, void *func_data, unsigned timeout_ms)
+{
+    const char  *method = (post != NULL) ? "P" : "G";
+    size_t      path_len = strlen(path) + 1;
+
+    call_once(&Channel.once, &ChannelInit);
+
+    mtx_lock(&Channel.mtx);
+    ChannelConn *conn = ConnGet(ip, port);
+    mtx_unlock(&Channel.mtx);
+
+    mtx_lock(&conn->wmtx);
+
+    int fd = ConnFdGet(conn);
+    if (fd < 0) {
+        mtx_unlock(&conn->wmtx);
+        return NULL;
+    }
+
+    ChannelCall *call = (ChannelCall *)calloc(1, sizeof(ChannelCall));
+
+    call->conn = conn;
+    call->func = func;
+    call->func_data = func_data;
+    call->deadline_ns = UtilsMonoNsGet() + (uint64_t)timeout_ms * 1000000;
+
+    /**
+     * Reader fails calls of dead connection once, so call is not
+     * registered if connection has already failed
+     */
+
+    mtx_lock(&Channel.mtx);
+    if (conn->fd != fd) {
+        mtx_unlock(&Channel.mtx);
+        mtx_unlock(&conn->wmtx);
+        free(call);
+        return NULL;
+    }
+    call->id = ++conn->next_id;
+    uint32_t id = call->id;
+    conn->calls = g_list_append(conn->calls, (void *)call);
+    mtx_unlock(&Channel.mtx);
+
+    /**
+     * Path is sent with method prefix and zero byte in one piece
+     */
+
+    char *head = (char *)malloc(path_len + 1);
+
+    head[0] = method[0];
+    memcpy(head + 1, path, path_len);
+
+    if (!FrameWrite(fd, FRAME_REQUEST, id, head, path_len + 1,
+                    post, (post != NULL) ? strlen(post) : 0)) {
+        shutdown(fd, SHUT_RDWR);
+    }
+
+    free(head);
+    mtx_unlock(&conn->wmtx);
+
+    return call;
+}
+
+ChannelCall *ChannelCallStart(const char *ip, unsigned port, const char *path, const char *post)
+{
+    return CallStart(ip, port, path, post, NULL, NULL, 0);
+}
+
+bool ChannelCallAsync(const char *ip, unsigned port, const char *path, const char *post,
+                      unsigned timeout_ms, ChannelFunc func, void *data)
+{
+    return (CallStart(ip, port, path, post, func, data, timeout_ms) != NULL);
+}
+
+bool ChannelCallWait(ChannelCall *call, char *out, size_t out_size, size_t *out_len, unsigned timeout_ms)
+{
+    struct timespec deadline;
+    bool            ret = false;
+
+    if (call == NULL) {
+        return false;
+    }
+
+    timespec_get(&deadline, TIME_UTC);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    mtx_lock(&Channel.mtx);
+
+    while (!call->done) {
+        if (cnd_timedwait(&Channel.done, &Channel.mtx, &deadline) != thrd_success) {
+            break;
+        }
+    }
+
+    if (!call->done) {
+        call->conn->calls = g_list_remove(call->conn->calls, call);
+    }
+
+    mtx_unlock(&Channel.mtx);
+
+    if (call->done && call->result && call->len < out_size) {
+        memcpy(out, call->data, call->len);
+        out[call->len] = '\0';
+        if (out_len != NULL) {
+            *out_len = call->len;
+        }
+        ret = true;
+    }
+
+    free(call->data);
+    free(call);
+
+    return ret;
+}
+
+bool ChannelRequest(const char *ip, unsigned port, const char *path, const char *post,
+                    char *out, size_t out_size, unsigned timeout_ms)
+{
+    return ChannelCallWait(ChannelCallStart(ip, port, path, post), out, out_size, NULL, timeout_ms);
+}
@@ -13,7 +13,12 @@
 
 #include <net/notifier.h>
 #include <utils/utils.h>
+#include <utils/log.h>
+#include <utils/events.h>
 #include <net/web/webclient.h>
+#include <stack/stack.h>
+#include <stack/rpc.h>
+#include <plc/reactor.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -37,6 +42,114 @@ static struct {
     .phone = {0}
 };
 
+static struct {
+    EventSubscriber *sub;
+    bool            security;
+} Notifier = {
+    .sub = NULL,
+    .security = false
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void EventProcess(const Event *event)
+{
+    char        msg[STR_LEN];
+    StackUnit   *unit;
+
+    switch (event->type) {
+        case EVENT_TANK_LEVEL_CHANGED:
+            if (!event->tank_level.notify) {
+                break;
+            }
+
+            snprintf(msg, STR_LEN, "БАК+\"%s\":+уровень+воды+%u%%", event->name, event->tank_level.level);
+
+            if (!NotifierTelegramSend(msg)) {
+                Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send level notify");
+            }
+            break;
+
+        case EVENT_WATERER_CHANGED:
+            if (!event->waterer.notify) {
+                break;
+            }
+
+            snprintf(msg, STR_LEN, "ПОЛИВ+\"%s\":+кран+%s", event->name, (event->waterer.valve == true) ? "открыт" : "закрыт");
+
+            if (!NotifierTelegramSend(msg)) {
+                Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send watere notify");
+            }
+            break;
+
+        case EVENT_SENSOR_DETECTED:
+            unit = StackUnitGet(RPC_DEFAULT_UNIT);
+            snprintf(msg, STR_LEN, "ОХРАНА:%s+Обнаружено+проникновение+%s", unit->name, event->name);
+
+            if (event->sensor.sms) {
+                if (!NotifierSmsSend(msg)) {
+                    Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send sms message");
+                } else {
+                    Log(LOG_TYPE_INFO, "NOTIFIER", "Alarm sms was sended to phone");
+                }
+            }
+
+            if (event->sensor.telegram) {
+                if (!NotifierTelegramSend(msg)) {
+                    Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send telegram message");
+                } else {
+                    Log(LOG_TYPE_INFO, "NOTIFIER", "Alarm message was sended to telegram");
+                }
+            }
+            break;
+
+        case EVENT_SECURITY_CHANGED:
+            if (event->security.status == Notifier.security) {
+                break;
+            }
+            Notifier.security = event->security.status;
+
+            unit = StackUnitGet(RPC_DEFAULT_UNIT);
+
+            if (event->security.status) {
+                snprintf(msg, STR_LEN, "ОХРАНА:%s+сигнализация+включена", unit->name);
+            } else {
+                snprintf(msg, STR_LEN, "ОХРАНА:%s+сигнализация+отключена", unit->name);
+            }
+
+            if (!NotifierTelegramSend(msg)) {
+                Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send status telegram message");
+            } else {
+                Log(LOG_TYPE_INFO, "NOTIFIER", "Status message was sended to telegram");
+            }
+
+            if (!NotifierSmsSend(msg)) {
+                Log(LOG_TYPE_ERROR, "NOTIFIER", "Failed to send security status sms message");
+            } else {
+                Log(LOG_TYPE_INFO, "NOTIFIER", "Status sms was sended to phone");
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void EventsProcess(int fd, void *data)
+{
+    Event   event;
+
+    EventReset(Notifier.sub);
+
+    while (EventPop(Notifier.sub, &event)) {
+        EventProcess(&event);
+    }
+}
+
 /*********************************************************************/
 /*                                                                   */
 /*                          PUBLIC FUNCTIONS                         */
@@ -76,3 +189,16 @@ bool NotifierSmsSend(const char *msg)
 
     return WebClientRequest(WEB_REQ_GET, url, NULL, buf);
 }
+
+bool NotifierStart()
+{
+    Notifier.sub = EventSubscribe("notifier", EVENT_MASK(EVENT_TANK_LEVEL_CHANGED) |
+                                              EVENT_MASK(EVENT_WATERER_CHANGED) |
+                                              EVENT_MASK(EVENT_SENSOR_DETECTED) |
+                                              EVENT_MASK(EVENT_SECURITY_CHANGED));
+    if (Notifier.sub == NULL) {
+        return false;
+    }
+
+    return ReactorJobFdAdd(EventFdGet(Notifier.sub), &EventsProcess, NULL);
+}
@@ -14,6 +14,54 @@
 #include <net/tgbot/tgresp.h>
 #include <stack/rpc.h>
 #include <utils/log.h>
+#include <utils/jobs.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    char        token[STR_LEN];
+    unsigned    from;
+    char        cam[SHORT_STR_LEN];
+    char        file_name[SHORT_STR_LEN];
+    char        file_full_name[STR_LEN];
+} TgCamPhoto;
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool PhotoJob(void *data)
+{
+    TgCamPhoto  *photo = (TgCamPhoto *)data;
+    const char  *error = NULL;
+
+    if (RpcCameraPhotoSave(RPC_DEFAULT_UNIT, photo->cam, photo->file_name)) {
+        if (!TgDocumentRespSend(photo->token, photo->from, photo->file_full_name)) {
+            error = "<b>Ошибка отправки фото</b>";
+            LogF(LOG_TYPE_ERROR, "TGCAM", "Failed to send cam photo for user %d", photo->from);
+        }
+    } else {
+        error = "<b>Ошибка получения фото</b>";
+        LogF(LOG_TYPE_ERROR, "TGCAM", "Failed to save photo for user %d", photo->from);
+    }
+
+    if (error != NULL) {
+        json_t *buttons = json_array();
+
+        TgRespButtonAdd(buttons, "Назад");
+        TgRespSend(photo->token, photo->from, error, buttons);
+    }
+
+    free(photo);
+
+    return error == NULL;
+}
 
 /*********************************************************************/
 /*                                                                   */
@@ -26,8 +74,6 @@ void TgCamProcess(const char *token, unsigned from, const char *message)
     json_t      *buttons = json_array();
     GList       *cams = NULL;
     GString     *text = g_string_new("<b>КАМЕРЫ</b>\n\n");
-    char        file_name[SHORT_STR_LEN];
-    char        file_full_name[SHORT_STR_LEN];
     char        cam_path[STR_LEN];
 
     if (RpcCamerasGet(RPC_DEFAULT_UNIT, &cams)) {
@@ -38,18 +84,24 @@ void TgCamProcess(const char *token, unsigned from, const char *message)
 
             if (!strcmp(message, cam->name)) {
                 if (RpcCameraPathGet(RPC_DEFAULT_UNIT, cam_path)) {
+                    TgCamPhoto *photo = (TgCamPhoto *)malloc(sizeof(TgCamPhoto));
+
+                    /**
+                     * Snapshot takes seconds, so do not block bot updates
+                     */
 
-                    snprintf(file_name, SHORT_STR_LEN, "%s.jpg", cam->name);
-                    snprintf(file_full_name, SHORT_STR_LEN, "%s%s.jpg", cam_path, cam->name);
+                    strncpy(photo->token, token, STR_LEN - 1);
+                    photo->token[STR_LEN - 1] = '\0';
+                    photo->from = from;
+                    strncpy(photo->cam, cam->name, SHORT_STR_LEN - 1);
+                    photo->cam[SHORT_STR_LEN - 1] = '\0';
+                    snprintf(photo->file_name, SHORT_STR_LEN, "%s.jpg", cam->name);
+                    snprintf(photo->file_full_name, STR_LEN, "%s%s.jpg", cam_path, cam->name);
 
-                    if (RpcCameraPhotoSave(RPC_DEFAULT_UNIT, cam->name, file_name)) {
-                        if (!TgDocumentRespSend(token, from, file_full_name)) {
-                            text = g_string_append(text, "<b>Ошибка отправки фото</b>");
-                            LogF(LOG_TYPE_ERROR, "TGCAM", "Failed to send cam photo for user %d", from);
-                        }
-                    } else {
+                    if (!JobRun("tg_photo", JOB_PRIO_NORMAL, &PhotoJob, (void *)photo)) {
+                        free(photo);
                         text = g_string_append(text, "<b>Ошибка получения фото</b>");
-                        LogF(LOG_TYPE_ERROR, "TGCAM", "Failed to save photo for user %d", from);
+                        LogF(LOG_TYPE_ERROR, "TGCAM", "Failed to queue photo for user %d", from);
                     }
                 } else {
                     text = g_string_append(text, "<b>Ошибка получения папки с фото</b>");
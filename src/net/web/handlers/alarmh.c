@@ -0,0 +1,139 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib-2.0/glib.h>
+#include <jansson.h>
+#include <fcgiapp.h>
+
+#include <net/web/handlers/alarmh.h>
+#include <net/web/response.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+#include <stack/rpc.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool HandlerStateGet(FCGX_Request *req, GList **params)
+{
+    json_t  *root = json_object();
+    GList   *alarms = NULL;
+
+    if (!RpcAlarmsGet(RPC_DEFAULT_UNIT, &alarms)) {
+        json_decref(root);
+        return ResponseFailSend(req, "ALARMH", "Failed to get alarms");
+    }
+
+    json_t *jalarms = json_array();
+
+    for (GList *a = alarms; a != NULL; a = a->next) {
+        RpcAlarm *alarm = (RpcAlarm *)a->data;
+
+        json_t *jalarm = json_object();
+        json_object_set_new(jalarm, "name", json_string(alarm->name));
+        json_object_set_new(jalarm, "state", json_integer(alarm->state));
+        json_array_append_new(jalarms, jalarm);
+
+        free(alarm);
+    }
+
+    json_object_set_new(root, "alarms", jalarms);
+    g_list_free(alarms);
+
+    return ResponseOkSend(req, root);
+}
+
+static bool HandlerHistoryGet(FCGX_Request *req, GList **params)
+{
+    json_t  *root = json_object();
+    GList   *records = NULL;
+
+    if (!RpcAlarmHistoryGet(RPC_DEFAULT_UNIT, &records)) {
+        json_decref(root);
+        return ResponseFailSend(req, "ALARMH", "Failed to get alarms history");
+    }
+
+    json_t *jrecords = json_array();
+
+    for (GList *r = records; r != NULL; r = r->next) {
+        RpcAlarmRecord *record = (RpcAlarmRecord *)r->data;
+
+        json_t *jrecord = json_object();
+        json_object_set_new(jrecord, "name", json_string(record->name));
+        json_object_set_new(jrecord, "action", json_integer(record->action));
+        json_object_set_new(jrecord, "state", json_integer(record->state));
+        json_object_set_new(jrecord, "time", json_integer(record->time));
+        json_array_append_new(jrecords, jrecord);
+
+        free(record);
+    }
+
+    json_object_set_new(root, "history", jrecords);
+    g_list_free(records);
+
+    return ResponseOkSend(req, root);
+}
+
+static bool HandlerAck(FCGX_Request *req, GList **params)
+{
+    json_t      *root = json_object();
+    const char  *name = NULL;
+    bool        acked = false;
+
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "name")) {
+            name = param->value;
+        }
+    }
+
+    if (!RpcAlarmAck(RPC_DEFAULT_UNIT, name, &acked)) {
+        json_decref(root);
+        return ResponseFailSend(req, "ALARMH", "Failed to acknowledge alarm");
+    }
+
+    json_object_set_new(root, "acked", json_boolean(acked));
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerAlarmProcess(FCGX_Request *req, GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "cmd")) {
+            if (!strcmp(param->value, "state_get")) {
+                return HandlerStateGet(req, params);
+            } else if (!strcmp(param->value, "history_get")) {
+                return HandlerHistoryGet(req, params);
+            } else if (!strcmp(param->value, "ack")) {
+                return HandlerAck(req, params);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,131 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib-2.0/glib.h>
+#include <jansson.h>
+#include <fcgiapp.h>
+
+#include <net/web/handlers/batchh.h>
+#include <net/web/response.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+#include <stack/rpc.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool BatchCmdFind(const char *name, RpcBatchCmd *cmd)
+{
+    if (name == NULL) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < RPC_BATCH_CMD_MAX; i++) {
+        if (!strcmp(RpcBatchCmdName(i), name)) {
+            *cmd = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool HandlerRun(FCGX_Request *req, GList **params)
+{
+    RpcBatchAction  actions[RPC_BATCH_MAX];
+    char            body[BUFFER_LEN_MAX];
+    json_error_t    error;
+    size_t          index;
+    json_t          *value;
+
+    const char *length = FCGX_GetParam("CONTENT_LENGTH", req->envp);
+    int len = (length != NULL) ? atoi(length) : 0;
+
+    if (len <= 0 || len >= BUFFER_LEN_MAX) {
+        return ResponseFailSend(req, "BATCHH", "Invalid batch body length");
+    }
+
+    if (FCGX_GetStr(body, len, req->in) != len) {
+        return ResponseFailSend(req, "BATCHH", "Failed to read batch body");
+    }
+    body[len] = '\0';
+
+    json_t *jreq = json_loads(body, 0, &error);
+    if (jreq == NULL) {
+        return ResponseFailSend(req, "BATCHH", "Invalid batch body");
+    }
+
+    json_t *jactions = json_object_get(jreq, "actions");
+    unsigned count = json_array_size(jactions);
+
+    if (count == 0 || count > RPC_BATCH_MAX) {
+        json_decref(jreq);
+        return ResponseFailSend(req, "BATCHH", "Invalid batch actions count");
+    }
+
+    json_array_foreach(jactions, index, value) {
+        RpcBatchAction  *action = &actions[index];
+        const char      *name = json_string_value(json_object_get(value, "name"));
+
+        if (!BatchCmdFind(json_string_value(json_object_get(value, "cmd")), &action->cmd)) {
+            json_decref(jreq);
+            return ResponseFailSend(req, "BATCHH", "Invalid batch command");
+        }
+
+        memset(action->name, 0x0, SHORT_STR_LEN);
+        if (name != NULL) {
+            strncpy(action->name, name, SHORT_STR_LEN - 1);
+        }
+        action->status = json_is_true(json_object_get(value, "status"));
+    }
+    json_decref(jreq);
+
+    RpcBatchRun(RPC_DEFAULT_UNIT, actions, count);
+
+    json_t *root = json_object();
+    json_t *jresults = json_array();
+
+    for (unsigned i = 0; i < count; i++) {
+        json_array_append_new(jresults, json_boolean(actions[i].result));
+    }
+    json_object_set_new(root, "results", jresults);
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerBatchProcess(FCGX_Request *req, GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "cmd")) {
+            if (!strcmp(param->value, "run")) {
+                return HandlerRun(req, params);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
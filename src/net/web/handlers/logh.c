@@ -0,0 +1,167 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib-2.0/glib.h>
+#include <jansson.h>
+#include <fcgiapp.h>
+
+#include <net/web/handlers/logh.h>
+#include <net/web/response.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+#include <utils/logsearch.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    FCGX_Request    *req;
+    unsigned        count;
+} LogStream;
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool TimeParse(const char *value, PlcTime *tm, bool end)
+{
+    int ret = sscanf(value, "%u.%u.%u-%u:%u:%u", &tm->year, &tm->month, &tm->day, &tm->hour, &tm->min, &tm->sec);
+
+    if (ret < 3) {
+        return false;
+    }
+
+    if (ret < 4) {
+        tm->hour = end ? 23 : 0;
+    }
+    if (ret < 5) {
+        tm->min = end ? 59 : 0;
+    }
+    if (ret < 6) {
+        tm->sec = end ? 59 : 0;
+    }
+
+    return true;
+}
+
+static bool LineSend(const char *line, size_t len, void *data)
+{
+    LogStream *stream = (LogStream *)data;
+
+    json_t *jline = json_stringn(line, len);
+    if (jline == NULL) {
+        return true;
+    }
+
+    char *out = json_dumps(jline, JSON_ENCODE_ANY);
+    if (out != NULL) {
+        if (stream->count > 0) {
+            FCGX_PutS(",", stream->req->out);
+        }
+        FCGX_PutS(out, stream->req->out);
+        stream->count++;
+        free(out);
+    }
+
+    json_decref(jline);
+    return true;
+}
+
+static bool HandlerSearch(FCGX_Request *req, GList **params)
+{
+    LogQuery    query;
+    LogStream   stream = {
+        .req = req,
+        .count = 0
+    };
+    char        tail[SHORT_STR_LEN];
+
+    LogQueryInit(&query);
+
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "from")) {
+            if (!TimeParse(param->value, &query.from, false)) {
+                return ResponseFailSend(req, "LOGH", "Log search invalid from time");
+            }
+        } else if (!strcmp(param->name, "to")) {
+            if (!TimeParse(param->value, &query.to, true)) {
+                return ResponseFailSend(req, "LOGH", "Log search invalid to time");
+            }
+        } else if (!strcmp(param->name, "module")) {
+            strncpy(query.module, param->value, SHORT_STR_LEN - 1);
+        } else if (!strcmp(param->name, "level")) {
+            query.typed = true;
+            if (!strcmp(param->value, "info")) {
+                query.type = LOG_TYPE_INFO;
+            } else if (!strcmp(param->value, "warn")) {
+                query.type = LOG_TYPE_WARN;
+            } else if (!strcmp(param->value, "error")) {
+                query.type = LOG_TYPE_ERROR;
+            } else {
+                return ResponseFailSend(req, "LOGH", "Log search invalid level");
+            }
+        } else if (!strcmp(param->name, "limit")) {
+            query.limit = strtoul(param->value, NULL, 10);
+        }
+    }
+
+    /**
+     * Lines are streamed to client while files are scanned
+     */
+
+    FCGX_PutS("Content-type: application/json\r\n", req->out);
+    FCGX_PutS("HTTP/1.0 200 OK\r\n", req->out);
+    FCGX_PutS("\r\n", req->out);
+    FCGX_PutS("{\"lines\": [", req->out);
+
+    bool ret = LogSearch(&query, &LineSend, (void *)&stream);
+
+    snprintf(tail, SHORT_STR_LEN, "], \"count\": %u, \"result\": %s}", stream.count, (ret == true) ? "true" : "false");
+    FCGX_PutS(tail, req->out);
+
+    if (!ret) {
+        Log(LOG_TYPE_ERROR, "LOGH", "Failed to search log files");
+    }
+
+    return ret;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerLogProcess(FCGX_Request *req, GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "cmd")) {
+            if (!strcmp(param->value, "search")) {
+                return HandlerSearch(req, params);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
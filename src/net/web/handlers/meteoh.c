@@ -28,11 +28,28 @@
 
 static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
 {
-    json_t  *root = json_object();
+    json_t *root = json_object();
+
+    if (!HandlerMeteoStateGet(root)) {
+        json_decref(root);
+        return ResponseFailSend(req, "METEOH", "Failed to get meteo sensors");
+    }
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerMeteoStateGet(json_t *root)
+{
     GList   *sensors = NULL;
 
     if (!RpcMeteoSensorsGet(RPC_DEFAULT_UNIT, &sensors)) {
-        return ResponseFailSend(req, "METEOH", "Failed to get meteo sensors");
+        return false;
     }
 
     json_t *jsensors = json_array();
@@ -59,15 +76,9 @@ static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
     json_object_set_new(root, "sensors", jsensors);
     g_list_free(sensors);
 
-    return ResponseOkSend(req, root);
+    return true;
 }
 
-/*********************************************************************/
-/*                                                                   */
-/*                          PUBLIC FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
-
 bool HandlerMeteoProcess(FCGX_Request *req, GList **params)
 {
     for (GList *p = *params; p != NULL; p = p->next) {
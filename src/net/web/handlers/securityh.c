@@ -9,6 +9,7 @@
 /*********************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <glib-2.0/glib.h>
 #include <jansson.h>
@@ -116,13 +117,57 @@ static bool HandlerAlarmGet(FCGX_Request *req, GList **params)
     return ResponseOkSend(req, root);
 }
 
-static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
+static bool HandlerReconcile(FCGX_Request *req, GList **params)
 {
-    json_t  *root = json_object();
-    GList   *sensors = NULL;
+    json_t              *root = json_object();
+    RpcSecurityState    state = { .unit = RPC_DEFAULT_UNIT };
+    RpcSecurityState    before = { .unit = RPC_DEFAULT_UNIT };
+    bool                found = false;
+
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "status")) {
+            state.status = !strcmp(param->value, "true");
+        } else if (!strcmp(param->name, "alarm")) {
+            state.alarm = !strcmp(param->value, "true");
+        } else if (!strcmp(param->name, "version")) {
+            state.version = strtoull(param->value, NULL, 10);
+            found = true;
+        }
+    }
+
+    if (!found) {
+        json_decref(root);
+        return ResponseFailSend(req, "SECURITYH", "Security command ivalid");
+    }
+
+    /**
+     * Version 0 only reads state, so unit tells whether it applied
+     * master state and its mirror must be refreshed
+     */
+
+    RpcSecurityReconcile(&before, 1, 0);
+    RpcSecurityReconcile(&state, 1, 0);
+    if (!state.result) {
+        json_decref(root);
+        return ResponseFailSend(req, "SECURITYH", "Failed to reconcile security state");
+    }
+
+    json_object_set_new(root, "status", json_boolean(state.status));
+    json_object_set_new(root, "alarm", json_boolean(state.alarm));
+    json_object_set_new(root, "version", json_integer(state.version));
+    json_object_set_new(root, "applied", json_boolean(state.version != before.version));
+
+    return ResponseOkSend(req, root);
+}
+
+static bool SensorsAdd(json_t *root)
+{
+    GList *sensors = NULL;
 
     if (!RpcSecuritySensorsGet(RPC_DEFAULT_UNIT, &sensors)) {
-        return ResponseFailSend(req, "SECURITYH", "Failed to get security sensors");
+        return false;
     }
 
     json_t *jsensors = json_array();
@@ -142,6 +187,18 @@ static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
     json_object_set_new(root, "sensors", jsensors);
     g_list_free(sensors);
 
+    return true;
+}
+
+static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
+{
+    json_t *root = json_object();
+
+    if (!SensorsAdd(root)) {
+        json_decref(root);
+        return ResponseFailSend(req, "SECURITYH", "Failed to get security sensors");
+    }
+
     return ResponseOkSend(req, root);
 }
 
@@ -151,6 +208,21 @@ static bool HandlerSensorsGet(FCGX_Request *req, GList **params)
 /*                                                                   */
 /*********************************************************************/
 
+bool HandlerSecurityStateGet(json_t *root)
+{
+    bool    status = false;
+    bool    alarm = false;
+
+    if (!RpcSecurityStatusGet(RPC_DEFAULT_UNIT, &status) || !RpcSecurityAlarmGet(RPC_DEFAULT_UNIT, &alarm)) {
+        return false;
+    }
+
+    json_object_set_new(root, "status", json_boolean(status));
+    json_object_set_new(root, "alarm", json_boolean(alarm));
+
+    return SensorsAdd(root);
+}
+
 bool HandlerSecurityProcess(FCGX_Request *req, GList **params)
 {
     for (GList *p = *params; p != NULL; p = p->next) {
@@ -167,6 +239,8 @@ bool HandlerSecurityProcess(FCGX_Request *req, GList **params)
                 return HandlerAlarmGet(req, params);
             } else if (!strcmp(param->value, "alarm_set")) {
                 return HandlerAlarmSet(req, params);
+            } else if (!strcmp(param->value, "reconcile")) {
+                return HandlerReconcile(req, params);
             } else {
                 return false;
             }
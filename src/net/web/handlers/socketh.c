@@ -63,11 +63,28 @@ static bool HandlerStatusSet(FCGX_Request *req, GList **params)
 
 static bool HandlerSocketsGet(FCGX_Request *req, GList **params)
 {
-    json_t  *root = json_object();
+    json_t *root = json_object();
+
+    if (!HandlerSocketStateGet(root)) {
+        json_decref(root);
+        return ResponseFailSend(req, "SOCKETH", "Failed to get sockets");
+    }
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerSocketStateGet(json_t *root)
+{
     GList   *sockets = NULL;
 
     if (!RpcSocketsGet(RPC_DEFAULT_UNIT, &sockets)) {
-        return ResponseFailSend(req, "SOCKETH", "Failed to get meteo sockets");
+        return false;
     }
 
     json_t *jsockets = json_array();
@@ -96,15 +113,9 @@ static bool HandlerSocketsGet(FCGX_Request *req, GList **params)
     json_object_set_new(root, "sockets", jsockets);
     g_list_free(sockets);
 
-    return ResponseOkSend(req, root);
+    return true;
 }
 
-/*********************************************************************/
-/*                                                                   */
-/*                          PUBLIC FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
-
 bool HandlerSocketProcess(FCGX_Request *req, GList **params)
 {
     for (GList *p = *params; p != NULL; p = p->next) {
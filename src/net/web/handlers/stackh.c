@@ -0,0 +1,135 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-2.0/glib.h>
+#include <jansson.h>
+#include <fcgiapp.h>
+
+#include <net/web/handlers/stackh.h>
+#include <net/web/response.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+#include <stack/rpc.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool HandlerUnitsGet(FCGX_Request *req, GList **params)
+{
+    json_t  *root = json_object();
+    json_t  *junits = json_array();
+    GList   *units = NULL;
+
+    if (!RpcStackUnitsGet(RPC_DEFAULT_UNIT, &units)) {
+        json_decref(junits);
+        json_decref(root);
+        return ResponseFailSend(req, "STACKH", "Failed to get stack units");
+    }
+
+    for (GList *u = units; u != NULL; u = u->next) {
+        RpcStackUnit    *unit = (RpcStackUnit *)u->data;
+        json_t          *junit = json_object();
+        json_t          *jpath = json_array();
+
+        for (unsigned i = 0; i < unit->hops; i++) {
+            json_array_append_new(jpath, json_integer(unit->path[i]));
+        }
+
+        json_object_set_new(junit, "id", json_integer(unit->id));
+        json_object_set_new(junit, "name", json_string(unit->name));
+        json_object_set_new(junit, "ip", json_string(unit->ip));
+        json_object_set_new(junit, "port", json_integer(unit->port));
+        json_object_set_new(junit, "active", json_boolean(unit->active));
+        json_object_set_new(junit, "path", jpath);
+        json_array_append_new(junits, junit);
+    }
+
+    json_object_set_new(root, "units", junits);
+    g_list_free_full(units, &free);
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerStackRouteProcess(FCGX_Request *req, unsigned unit)
+{
+    char    path[STR_LEN];
+    char    *body = NULL;
+    size_t  out_len = 0;
+
+    const char *uri = FCGX_GetParam("REQUEST_URI", req->envp);
+    const char *method = FCGX_GetParam("REQUEST_METHOD", req->envp);
+
+    UtilsURIParamDrop(uri, "route", path);
+
+    if (method != NULL && !strcmp(method, "POST")) {
+        const char *length = FCGX_GetParam("CONTENT_LENGTH", req->envp);
+        int len = (length != NULL) ? atoi(length) : 0;
+
+        if (len <= 0 || len >= RPC_STATE_BUF_LEN) {
+            return ResponseFailSend(req, "STACKH", "Invalid routed body length");
+        }
+
+        body = (char *)malloc(len + 1);
+        if (FCGX_GetStr(body, len, req->in) != len) {
+            free(body);
+            return ResponseFailSend(req, "STACKH", "Failed to read routed body");
+        }
+        body[len] = '\0';
+    }
+
+    char *out = (char *)malloc(RPC_STATE_BUF_LEN);
+    bool ret = RpcRouteRequest(unit, path, body, out, RPC_STATE_BUF_LEN, &out_len);
+
+    free(body);
+
+    /**
+     * Reply may be binary state, so it is sent back as is
+     */
+
+    if (ret) {
+        ret = ResponseBinarySend(req, out, out_len);
+    } else {
+        LogF(LOG_TYPE_ERROR, "STACKH", "Failed to route request to Unit %u", unit);
+        ret = ResponseFailSend(req, "STACKH", "Failed to route request");
+    }
+
+    free(out);
+    return ret;
+}
+
+bool HandlerStackProcess(FCGX_Request *req, GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "cmd")) {
+            if (!strcmp(param->value, "units_get")) {
+                return HandlerUnitsGet(req, params);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,333 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <glib-2.0/glib.h>
+#include <jansson.h>
+#include <fcgiapp.h>
+
+#include <net/web/handlers/stateh.h>
+#include <net/web/handlers/securityh.h>
+#include <net/web/handlers/meteoh.h>
+#include <net/web/handlers/socketh.h>
+#include <net/web/handlers/tankh.h>
+#include <net/web/handlers/watererh.h>
+#include <net/web/response.h>
+#include <net/web/webserver.h>
+#include <stack/statelog.h>
+#include <stack/statecodec.h>
+#include <stack/rpc.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+static atomic_uint Waiters = 0;
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    const char  *name;
+    const char  *list;
+    bool        (*func)(json_t *root);
+} StateSectionDef;
+
+static const StateSectionDef Sections[STATE_SECTION_MAX] = {
+    [STATE_SECTION_SECURITY] = { "security", "sensors", &HandlerSecurityStateGet },
+    [STATE_SECTION_METEO] = { "meteo", "sensors", &HandlerMeteoStateGet },
+    [STATE_SECTION_SOCKET] = { "socket", "sockets", &HandlerSocketStateGet },
+    [STATE_SECTION_TANK] = { "tank", "tanks", &HandlerTankStateGet },
+    [STATE_SECTION_WATERER] = { "waterer", "waterers", &HandlerWatererStateGet }
+};
+
+static bool ChangedCheck(GList *changes, StateSection section, const char *name)
+{
+    for (GList *c = changes; c != NULL; c = c->next) {
+        StateChange *change = (StateChange *)c->data;
+
+        if (change->section == section && (name == NULL || !strcmp(change->name, name))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool SectionAdd(json_t *root, StateSection section)
+{
+    json_t *jsection = json_object();
+
+    if (!Sections[section].func(jsection)) {
+        json_decref(jsection);
+        return false;
+    }
+
+    json_object_set_new(root, Sections[section].name, jsection);
+    return true;
+}
+
+static bool SectionChangesAdd(json_t *root, StateSection section, GList *changes)
+{
+    if (!ChangedCheck(changes, section, NULL)) {
+        return true;
+    }
+
+    if (!SectionAdd(root, section)) {
+        return false;
+    }
+
+    /**
+     * Section is built as usual and objects which were not changed
+     * are removed from its list
+     */
+
+    json_t *jlist = json_object_get(json_object_get(root, Sections[section].name), Sections[section].list);
+
+    for (size_t i = json_array_size(jlist); i-- > 0;) {
+        const char *name = json_string_value(json_object_get(json_array_get(jlist, i), "name"));
+
+        if (name == NULL || !ChangedCheck(changes, section, name)) {
+            json_array_remove(jlist, i);
+        }
+    }
+
+    return true;
+}
+
+static bool BinaryCheck(GList *params)
+{
+    for (GList *p = params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "fmt")) {
+            return !strcmp(param->value, STATE_CODEC_FORMAT);
+        }
+    }
+
+    return false;
+}
+
+static void WatererFree(void *data)
+{
+    RpcWaterer *waterer = (RpcWaterer *)data;
+
+    g_list_free_full(waterer->times, &free);
+    free(waterer);
+}
+
+static void ListFilter(GList **list, GList *changes, StateSection section, void (*free_func)(void *))
+{
+    GList *l = *list;
+
+    while (l != NULL) {
+        GList *next = l->next;
+
+        /**
+         * All RPC objects start with name field
+         */
+
+        if (!ChangedCheck(changes, section, (const char *)l->data)) {
+            free_func(l->data);
+            *list = g_list_delete_link(*list, l);
+        }
+        l = next;
+    }
+}
+
+/**
+ * @brief Send state in binary form, for delta only objects from
+ * changes are kept
+ */
+static bool BinarySend(FCGX_Request *req, uint64_t version, bool delta, GList *changes)
+{
+    RpcUnitState state = { 0 };
+
+    if ((!delta || changes != NULL) && !RpcUnitStateGet(RPC_DEFAULT_UNIT, &state)) {
+        return ResponseFailSend(req, "STATEH", "Failed to get controllers state");
+    }
+
+    state.version = version;
+
+    if (delta) {
+        state.delta = true;
+        state.security_changed = ChangedCheck(changes, STATE_SECTION_SECURITY, NULL);
+        ListFilter(&state.security_sensors, changes, STATE_SECTION_SECURITY, &free);
+        ListFilter(&state.meteo_sensors, changes, STATE_SECTION_METEO, &free);
+        ListFilter(&state.sockets, changes, STATE_SECTION_SOCKET, &free);
+        ListFilter(&state.tanks, changes, STATE_SECTION_TANK, &free);
+        ListFilter(&state.waterers, changes, STATE_SECTION_WATERER, &WatererFree);
+    }
+
+    uint8_t *buf = (uint8_t *)malloc(RPC_STATE_BUF_LEN);
+    size_t  len = StateEncode(&state, buf, RPC_STATE_BUF_LEN);
+
+    RpcUnitStateFree(&state);
+
+    if (len == 0) {
+        free(buf);
+        return ResponseFailSend(req, "STATEH", "Failed to encode controllers state");
+    }
+
+    bool ret = ResponseBinarySend(req, buf, len);
+    free(buf);
+
+    return ret;
+}
+
+static bool HandlerStateGet(FCGX_Request *req, GList **params)
+{
+    json_t      *root = NULL;
+    uint64_t    version = StateVersionGet();
+
+    if (BinaryCheck(*params)) {
+        return BinarySend(req, version, false, NULL);
+    }
+
+    root = json_object();
+
+    for (unsigned s = 0; s < STATE_SECTION_MAX; s++) {
+        if (!SectionAdd(root, s)) {
+            json_decref(root);
+            return ResponseFailSend(req, "STATEH", "Failed to get controllers state");
+        }
+    }
+
+    json_object_set_new(root, "version", json_integer(version));
+
+    return ResponseOkSend(req, root);
+}
+
+static bool HandlerChangesGet(FCGX_Request *req, GList **params)
+{
+    json_t      *root = json_object();
+    GList       *changes = NULL;
+    uint64_t    since = 0;
+    unsigned    wait = 0;
+    bool        found = false;
+
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "since")) {
+            since = strtoull(param->value, NULL, 10);
+            found = true;
+        } else if (!strcmp(param->name, "wait")) {
+            wait = strtoul(param->value, NULL, 10);
+        }
+    }
+
+    if (!found) {
+        json_decref(root);
+        return ResponseFailSend(req, "STATEH", "State command invalid");
+    }
+
+    /**
+     * Long-poll: reply is held until something is changed. One web
+     * server worker is always kept free for usual requests, extra
+     * subscribers get immediate reply and just poll again. Channel
+     * parks its long-polls itself and runs them here without wait.
+     */
+
+    if (wait > 0) {
+        if (wait > STATE_WAIT_MAX_MS) {
+            wait = STATE_WAIT_MAX_MS;
+        }
+
+        if (atomic_fetch_add(&Waiters, 1) < SERVER_WORKERS - 1) {
+            StateChangesWait(since, wait);
+        }
+        atomic_fetch_sub(&Waiters, 1);
+    }
+
+    /**
+     * Version is taken before reading controllers, so change made
+     * in between is sent again next time instead of being lost
+     */
+
+    uint64_t version = StateVersionGet();
+
+    if (BinaryCheck(*params)) {
+        json_decref(root);
+
+        if (since == version) {
+            return BinarySend(req, version, true, NULL);
+        }
+
+        if (!StateChangesGet(since, &changes)) {
+            return HandlerStateGet(req, params);
+        }
+
+        bool ret = BinarySend(req, version, true, changes);
+        g_list_free_full(changes, &free);
+
+        return ret;
+    }
+
+    if (since == version) {
+        json_object_set_new(root, "version", json_integer(version));
+        return ResponseOkSend(req, root);
+    }
+
+    if (!StateChangesGet(since, &changes)) {
+        json_decref(root);
+        return HandlerStateGet(req, params);
+    }
+
+    for (unsigned s = 0; s < STATE_SECTION_MAX; s++) {
+        if (!SectionChangesAdd(root, s, changes)) {
+            g_list_free_full(changes, &free);
+            json_decref(root);
+            return ResponseFailSend(req, "STATEH", "Failed to get controllers changes");
+        }
+    }
+
+    g_list_free_full(changes, &free);
+    json_object_set_new(root, "version", json_integer(version));
+    json_object_set_new(root, "delta", json_boolean(true));
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerStateProcess(FCGX_Request *req, GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "cmd")) {
+            if (!strcmp(param->value, "state_get")) {
+                return HandlerStateGet(req, params);
+            } else if (!strcmp(param->value, "changes_get")) {
+                return HandlerChangesGet(req, params);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
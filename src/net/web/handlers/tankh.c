@@ -133,11 +133,28 @@ static bool HandlerValveSet(FCGX_Request *req, GList **params)
 
 static bool HandlerTanksGet(FCGX_Request *req, GList **params)
 {
-    json_t  *root = json_object();
+    json_t *root = json_object();
+
+    if (!HandlerTankStateGet(root)) {
+        json_decref(root);
+        return ResponseFailSend(req, "TANKH", "Failed to get tanks");
+    }
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerTankStateGet(json_t *root)
+{
     GList   *tanks = NULL;
 
     if (!RpcTanksGet(RPC_DEFAULT_UNIT, &tanks)) {
-        return ResponseFailSend(req, "TANKH", "Failed to get meteo tanks");
+        return false;
     }
 
     json_t *jtanks = json_array();
@@ -159,15 +176,9 @@ static bool HandlerTanksGet(FCGX_Request *req, GList **params)
     json_object_set_new(root, "tanks", jtanks);
     g_list_free(tanks);
 
-    return ResponseOkSend(req, root);
+    return true;
 }
 
-/*********************************************************************/
-/*                                                                   */
-/*                          PUBLIC FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
-
 bool HandlerTankProcess(FCGX_Request *req, GList **params)
 {
     for (GList *p = *params; p != NULL; p = p->next) {
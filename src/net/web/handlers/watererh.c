@@ -98,11 +98,28 @@ static bool HandlerValveSet(FCGX_Request *req, GList **params)
 
 static bool HandlerWaterersGet(FCGX_Request *req, GList **params)
 {
-    json_t  *root = json_object();
+    json_t *root = json_object();
+
+    if (!HandlerWatererStateGet(root)) {
+        json_decref(root);
+        return ResponseFailSend(req, "WATERERH", "Failed to get waterers");
+    }
+
+    return ResponseOkSend(req, root);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool HandlerWatererStateGet(json_t *root)
+{
     GList   *waterers = NULL;
 
     if (!RpcWaterersGet(RPC_DEFAULT_UNIT, &waterers)) {
-        return ResponseFailSend(req, "WATERERH", "Failed to get meteo waterers");
+        return false;
     }
 
     json_t *jwaterers = json_array();
@@ -115,7 +132,7 @@ static bool HandlerWaterersGet(FCGX_Request *req, GList **params)
         json_object_set_new(jwaterer, "status", json_boolean(waterer->status));
         json_object_set_new(jwaterer, "valve", json_boolean(waterer->valve));
 
-        json_t *jtimes = json_object();
+        json_t *jtimes = json_array();
         for (GList *t = waterer->times; t != NULL; t = t->next) {
             RpcWatererTime *tm = (RpcWatererTime *)t->data;
 
@@ -139,15 +156,9 @@ static bool HandlerWaterersGet(FCGX_Request *req, GList **params)
     json_object_set_new(root, "waterers", jwaterers);
     g_list_free(waterers);
 
-    return ResponseOkSend(req, root);
+    return true;
 }
 
-/*********************************************************************/
-/*                                                                   */
-/*                          PUBLIC FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
-
 bool HandlerWatererProcess(FCGX_Request *req, GList **params)
 {
     for (GList *p = *params; p != NULL; p = p->next) {
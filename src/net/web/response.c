@@ -24,7 +24,7 @@ bool ResponseFailSend(FCGX_Request *req, const char *module, const char *error)
     json_object_set_new(root, "result", json_boolean(false));
     FCGX_PutS("\r\n", req->out);
 
-    char *out = json_dumps(root, JSON_INDENT(4));
+    char *out = json_dumps(root, JSON_COMPACT);
     FCGX_PutS(out, req->out);
 
     free(out);
@@ -42,7 +42,7 @@ bool ResponseOkSend(FCGX_Request *req, json_t *root)
     json_object_set_new(root, "result", json_boolean(true));
     FCGX_PutS("\r\n", req->out);
 
-    char *out = json_dumps(root, JSON_INDENT(4));
+    char *out = json_dumps(root, JSON_COMPACT);
     FCGX_PutS(out, req->out);
 
     free(out);
@@ -50,3 +50,12 @@ bool ResponseOkSend(FCGX_Request *req, json_t *root)
 
     return true;
 }
+
+bool ResponseBinarySend(FCGX_Request *req, const void *data, size_t len)
+{
+    FCGX_PutS("Content-type: application/octet-stream\r\n", req->out);
+    FCGX_PutS("HTTP/1.0 200 OK\r\n", req->out);
+    FCGX_PutS("\r\n", req->out);
+
+    return (FCGX_PutStr((const char *)data, len, req->out) == (int)len);
+}
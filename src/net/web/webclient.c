@@ -12,8 +12,52 @@
 #include <utils/utils.h>
 
 #include <curl/curl.h>
+#include <glib-2.0/glib.h>
 
 #include <string.h>
+#include <stdlib.h>
+#include <threads.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    char        host[STR_LEN];
+    CURL        *idle[WEB_CLIENT_POOL_SIZE];
+    unsigned    idle_count;
+} WebClientHost;
+
+typedef struct {
+    WebClientReq    *req;
+    CURL            *curl;
+    WebClientFunc   func;
+    void            *data;
+} WebClientAsync;
+
+static struct {
+    once_flag       once;
+    once_flag       async_once;
+    bool            ready;
+    mtx_t           mtx;
+    mtx_t           share_mtx[CURL_LOCK_DATA_LAST];
+    CURLSH          *share;
+    CURLM           *multi;
+    GList           *queued;
+    GList           *hosts;
+    WebClientStats  stats;
+} WebClient = {
+    .once = ONCE_FLAG_INIT,
+    .async_once = ONCE_FLAG_INIT,
+    .ready = false,
+    .share = NULL,
+    .multi = NULL,
+    .queued = NULL,
+    .hosts = NULL,
+    .stats = {0}
+};
 
 /*********************************************************************/
 /*                                                                   */
@@ -32,6 +76,267 @@ static size_t WebOutputWrite(char *ptr, size_t size, size_t nmemb, void *data)
     return size * nmemb;
 }
 
+static size_t WebReqWrite(char *ptr, size_t size, size_t nmemb, void *data)
+{
+    WebClientReq    *req = (WebClientReq *)data;
+    size_t          len = size * nmemb;
+
+    if (req->out_len + len >= req->out_size) {
+        return 0;
+    }
+
+    memcpy(req->out + req->out_len, ptr, len);
+    req->out_len += len;
+    req->out[req->out_len] = '\0';
+
+    return len;
+}
+
+static void ShareLock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    mtx_lock(&WebClient.share_mtx[data]);
+}
+
+static void ShareUnlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+    mtx_unlock(&WebClient.share_mtx[data]);
+}
+
+static void PoolInit()
+{
+    mtx_init(&WebClient.mtx, mtx_plain);
+    for (unsigned i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        mtx_init(&WebClient.share_mtx[i], mtx_plain);
+    }
+
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+        return;
+    }
+
+    /**
+     * DNS, TLS sessions and live connections are shared between all
+     * pooled handles, so handle of any host may reuse them
+     */
+
+    WebClient.share = curl_share_init();
+    if (WebClient.share != NULL) {
+        curl_share_setopt(WebClient.share, CURLSHOPT_LOCKFUNC, &ShareLock);
+        curl_share_setopt(WebClient.share, CURLSHOPT_UNLOCKFUNC, &ShareUnlock);
+        curl_share_setopt(WebClient.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(WebClient.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(WebClient.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    WebClient.ready = true;
+}
+
+static void HostKeyGet(const char *url, char *host)
+{
+    const char  *start = strstr(url, "://");
+    size_t      len;
+
+    start = (start != NULL) ? start + 3 : url;
+    len = strcspn(start, "/?");
+    len = (size_t)(start - url) + len;
+
+    if (len >= STR_LEN) {
+        len = STR_LEN - 1;
+    }
+
+    memcpy(host, url, len);
+    host[len] = '\0';
+}
+
+static WebClientHost *HostGet(const char *host)
+{
+    for (GList *h = WebClient.hosts; h != NULL; h = h->next) {
+        WebClientHost *item = (WebClientHost *)h->data;
+
+        if (!strcmp(item->host, host)) {
+            return item;
+        }
+    }
+
+    WebClientHost *item = (WebClientHost *)calloc(1, sizeof(WebClientHost));
+
+    strncpy(item->host, host, STR_LEN - 1);
+    WebClient.hosts = g_list_append(WebClient.hosts, (void *)item);
+    WebClient.stats.hosts++;
+
+    return item;
+}
+
+static CURL *HandleAcquire(const char *url)
+{
+    char    host[STR_LEN];
+    CURL    *curl = NULL;
+
+    call_once(&WebClient.once, &PoolInit);
+    if (!WebClient.ready) {
+        return NULL;
+    }
+
+    HostKeyGet(url, host);
+
+    mtx_lock(&WebClient.mtx);
+    WebClientHost *item = HostGet(host);
+    if (item->idle_count > 0) {
+        curl = item->idle[--item->idle_count];
+        WebClient.stats.hits++;
+    } else {
+        WebClient.stats.misses++;
+    }
+    mtx_unlock(&WebClient.mtx);
+
+    if (curl == NULL) {
+        curl = curl_easy_init();
+        if (curl == NULL) {
+            return NULL;
+        }
+    } else {
+        curl_easy_reset(curl);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, WebClient.share);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+
+    return curl;
+}
+
+static void HandleRelease(CURL *curl, const char *url)
+{
+    char    host[STR_LEN];
+    long    connects = 0;
+
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    HostKeyGet(url, host);
+
+    mtx_lock(&WebClient.mtx);
+    WebClient.stats.connects += connects;
+    WebClient.stats.requests++;
+
+    WebClientHost *item = HostGet(host);
+    if (item->idle_count < WEB_CLIENT_POOL_SIZE) {
+        item->idle[item->idle_count++] = curl;
+        curl = NULL;
+    }
+    mtx_unlock(&WebClient.mtx);
+
+    if (curl != NULL) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+/**
+ * @brief Prepare pooled handle for request with deadline
+ */
+static CURL *ReqHandleGet(WebClientReq *req, unsigned timeout_ms)
+{
+    req->result = false;
+    req->out_len = 0;
+    req->out[0] = '\0';
+    if (req->out_size == 0) {
+        req->out_size = BUFFER_LEN_MAX;
+    }
+
+    if (req->type == WEB_REQ_POST && req->post == NULL) {
+        return NULL;
+    }
+
+    CURL *curl = HandleAcquire(req->url);
+    if (curl == NULL) {
+        return NULL;
+    }
+
+    if (req->type == WEB_REQ_POST) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req->post);
+    }
+
+    /**
+     * Stack units are in local network, so dead unit fails on short
+     * connect deadline instead of holding whole batch
+     */
+
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)WEB_CLIENT_CONNECT_MS);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &WebReqWrite);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)req);
+
+    return curl;
+}
+
+/**
+ * @brief Single transfer loop for all async requests, new requests
+ * are added by the loop itself because multi handle is not thread safe
+ */
+static int AsyncThread(void *data)
+{
+    CURLMsg *msg;
+    int     running = 0;
+    int     left = 0;
+
+    for (;;) {
+        mtx_lock(&WebClient.mtx);
+        GList *queued = WebClient.queued;
+        WebClient.queued = NULL;
+        mtx_unlock(&WebClient.mtx);
+
+        for (GList *q = queued; q != NULL; q = q->next) {
+            curl_multi_add_handle(WebClient.multi, ((WebClientAsync *)q->data)->curl);
+        }
+        g_list_free(queued);
+
+        curl_multi_perform(WebClient.multi, &running);
+
+        while ((msg = curl_multi_info_read(WebClient.multi, &left)) != NULL) {
+            WebClientAsync  *async = NULL;
+            CURL            *curl = msg->easy_handle;
+            CURLcode        result = msg->data.result;
+
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&async);
+            curl_multi_remove_handle(WebClient.multi, curl);
+            HandleRelease(curl, async->req->url);
+
+            async->req->result = (result == CURLE_OK);
+            async->func(async->req, async->data);
+            free(async);
+        }
+
+        curl_multi_poll(WebClient.multi, NULL, 0, WEB_CLIENT_TIMEOUT_MS, NULL);
+    }
+
+    return 0;
+}
+
+static void AsyncInit()
+{
+    thrd_t th;
+
+    call_once(&WebClient.once, &PoolInit);
+    if (!WebClient.ready) {
+        return;
+    }
+
+    CURLM *multi = curl_multi_init();
+    if (multi == NULL) {
+        return;
+    }
+
+    WebClient.multi = multi;
+    if (thrd_create(&th, &AsyncThread, NULL) != thrd_success) {
+        WebClient.multi = NULL;
+        curl_multi_cleanup(multi);
+        return;
+    }
+    thrd_detach(th);
+}
+
 /*********************************************************************/
 /*                                                                   */
 /*                          PUBLIC FUNCTIONS                         */
@@ -43,24 +348,24 @@ bool WebClientRequest(WebRequestType type, const char *url, const char *post, ch
     CURL    *curl_handle;
     int     ret = CURLE_OK;
 
-    curl_handle = curl_easy_init();
+    if (type == WEB_REQ_POST && post == NULL) {
+        return false;
+    }
+
+    curl_handle = HandleAcquire(url);
     if (!curl_handle) {
         return false;
     }
 
-    curl_easy_setopt(curl_handle, CURLOPT_URL, url);
     if (type == WEB_REQ_POST) {
-        if (post == NULL) {
-            curl_easy_cleanup(curl_handle);
-            return false;
-        }
         curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, post);
     }
 
+    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT_MS, (long)WEB_CLIENT_TIMEOUT_MS);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, &WebOutputWrite);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, out);
     ret = curl_easy_perform(curl_handle);
-    curl_easy_cleanup(curl_handle);
+    HandleRelease(curl_handle, url);
 
     if (ret != CURLE_OK) {
         return false;
@@ -69,6 +374,105 @@ bool WebClientRequest(WebRequestType type, const char *url, const char *post, ch
     return true;
 }
 
+bool WebClientMultiRequest(WebClientReq *reqs, unsigned count, unsigned timeout_ms)
+{
+    CURLMsg     *msg;
+    int         running = 0;
+    int         left = 0;
+    bool        ret = true;
+
+    CURLM *multi = curl_multi_init();
+    if (multi == NULL) {
+        for (unsigned i = 0; i < count; i++) {
+            reqs[i].result = false;
+            reqs[i].out_len = 0;
+        }
+        return false;
+    }
+
+    CURL **handles = (CURL **)calloc(count, sizeof(CURL *));
+
+    for (unsigned i = 0; i < count; i++) {
+        handles[i] = ReqHandleGet(&reqs[i], timeout_ms);
+        if (handles[i] == NULL) {
+            continue;
+        }
+
+        curl_easy_setopt(handles[i], CURLOPT_PRIVATE, (void *)&reqs[i]);
+        curl_multi_add_handle(multi, handles[i]);
+    }
+
+    /**
+     * Every handle has own deadline, so the loop ends when the slowest
+     * request is done or timed out
+     */
+
+    do {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) {
+            break;
+        }
+
+        if (running > 0 && curl_multi_poll(multi, NULL, 0, timeout_ms, NULL) != CURLM_OK) {
+            break;
+        }
+    } while (running > 0);
+
+    while ((msg = curl_multi_info_read(multi, &left)) != NULL) {
+        WebClientReq *req = NULL;
+
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&req);
+        if (req != NULL) {
+            req->result = (msg->data.result == CURLE_OK);
+        }
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        if (handles[i] != NULL) {
+            curl_multi_remove_handle(multi, handles[i]);
+            HandleRelease(handles[i], reqs[i].url);
+        }
+        ret = ret && reqs[i].result;
+    }
+
+    free(handles);
+    curl_multi_cleanup(multi);
+
+    return ret;
+}
+
+bool WebClientAsyncRequest(WebClientReq *req, unsigned timeout_ms, WebClientFunc func, void *data)
+{
+    call_once(&WebClient.async_once, &AsyncInit);
+    if (WebClient.multi == NULL) {
+        return false;
+    }
+
+    CURL *curl = ReqHandleGet(req, timeout_ms);
+    if (curl == NULL) {
+        return false;
+    }
+
+    WebClientAsync *async = (WebClientAsync *)malloc(sizeof(WebClientAsync));
+
+    async->req = req;
+    async->curl = curl;
+    async->func = func;
+    async->data = data;
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)async);
+
+    mtx_lock(&WebClient.mtx);
+    WebClient.queued = g_list_append(WebClient.queued, (void *)async);
+    mtx_unlock(&WebClient.mtx);
+
+    curl_multi_wakeup(WebClient.multi);
+
+    return true;
+}
+
 bool WebClientPhotoRequest(const char *url, unsigned chat_id, const char *file, const char *caption, char *out)
 {
     CURL                *curl;
@@ -80,13 +484,11 @@ bool WebClientPhotoRequest(const char *url, unsigned chat_id, const char *file,
 
     snprintf(id_str, STR_LEN, "%u", chat_id);
 
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
+    curl = HandleAcquire(url);
     if (curl)
     {
         curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
         curl_easy_setopt(curl, CURLOPT_POST, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url);
         curl_easy_setopt(curl, CURLOPT_DEFAULT_PROTOCOL, "https");
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &WebOutputWrite);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, out);
@@ -111,8 +513,8 @@ bool WebClientPhotoRequest(const char *url, unsigned chat_id, const char *file,
         ret = curl_easy_perform(curl);
         curl_mime_free(mime);
         curl_slist_free_all(headers);
+        HandleRelease(curl, url);
     }
-    curl_easy_cleanup(curl);
 
     if (ret != CURLE_OK) {
         return false;
@@ -130,9 +532,7 @@ bool WebClientDocumentRequest(const char *url, unsigned chat_id, const char *fil
     struct curl_slist*  headerlist = NULL;
     static const char   buf[] = "Expect:";
 
-    curl_global_init(CURL_GLOBAL_ALL);
-
-    curl = curl_easy_init();
+    curl = HandleAcquire(url);
     if (curl) {
         form = curl_mime_init(curl);
         field = curl_mime_addpart(form);
@@ -141,12 +541,11 @@ bool WebClientDocumentRequest(const char *url, unsigned chat_id, const char *fil
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &WebOutputWrite);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, out);
         headerlist = curl_slist_append(headerlist, buf);
-        curl_easy_setopt(curl, CURLOPT_URL, url);
         curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
         ret = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
         curl_mime_free(form);
         curl_slist_free_all(headerlist);
+        HandleRelease(curl, url);
     }
 
     if (ret != CURLE_OK) {
@@ -155,3 +554,12 @@ bool WebClientDocumentRequest(const char *url, unsigned chat_id, const char *fil
 
     return true;
 }
+
+void WebClientStatsGet(WebClientStats *stats)
+{
+    call_once(&WebClient.once, &PoolInit);
+
+    mtx_lock(&WebClient.mtx);
+    *stats = WebClient.stats;
+    mtx_unlock(&WebClient.mtx);
+}
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 
 #include <fcgi_config.h>
 #include <fcgiapp.h>
@@ -24,6 +25,11 @@
 #include <net/web/handlers/indexh.h>
 #include <net/web/handlers/tankh.h>
 #include <net/web/handlers/watererh.h>
+#include <net/web/handlers/logh.h>
+#include <net/web/handlers/batchh.h>
+#include <net/web/handlers/stateh.h>
+#include <net/web/handlers/stackh.h>
+#include <net/web/handlers/alarmh.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -47,8 +53,7 @@ static struct {
 
 static bool Process(int socketId)
 {
-    FCGX_Request    req;
-    GList           *params = NULL;
+    FCGX_Request req;
 
     if (FCGX_InitRequest(&req, socketId, 0) != 0) {
         Log(LOG_TYPE_ERROR, "SERVER", "Failed to init web request");
@@ -61,67 +66,123 @@ static bool Process(int socketId)
             continue;
         }
 
-        const char *query = FCGX_GetParam("SCRIPT_NAME", req.envp);
-        char *url = FCGX_GetParam("REQUEST_URI", req.envp);
-
-        if (!strcmp(query, "/")) {
-            if (!HandlerIndexProcess(&req, NULL)) {
-                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Index handler");
-            }
-            FCGX_Finish_r(&req);
-            continue;
-        } 
-
-        if (UtilsURIParse(url, &params)) {
-            if (!strcmp(query, "/api/" SERVER_API_VER "/security")) {
-                if (!HandlerSecurityProcess(&req, &params)) {
-                    Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Security controller get handler");
-                }
-            } else if (!strcmp(query, "/api/" SERVER_API_VER "/meteo")) {
-                if (!HandlerMeteoProcess(&req, &params)) {
-                    Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Meteo controller get handler");
-                }
-            } else if (!strcmp(query, "/api/" SERVER_API_VER "/socket")) {
-                if (!HandlerSocketProcess(&req, &params)) {
-                    Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Socket controller get handler");
-                }
-            } else if (!strcmp(query, "/api/" SERVER_API_VER "/tank")) {
-                if (!HandlerTankProcess(&req, &params)) {
-                    Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Tank controller get handler");
-                }
-            } else if (!strcmp(query, "/api/" SERVER_API_VER "/waterer")) {
-                if (!HandlerWatererProcess(&req, &params)) {
-                    Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Waterer controller get handler");
-                }
-            } else {
-                FCGX_PutS("Content-type: text/html\r\n", req.out);
-                FCGX_PutS("\r\n", req.out);
-                FCGX_PutS("<html><h1>404 NOT FOUND</h1></html>\r\n", req.out);
-            }
-        } else {
-            Log(LOG_TYPE_ERROR, "SERVER", "Incorrect request");
-        }
-
-        if (params != NULL) {
-            for (GList *p = params; p != NULL; p = p->next) {
-                UtilsReqParam *param = (UtilsReqParam *)p->data;
-                free(param);
-            }
-            g_list_free(params);
-            params = NULL;
-        }
+        WebServerRequestProcess(&req);
 
         FCGX_Finish_r(&req);
     }
     return true;
 }
 
+/**
+ * @brief Get unit ID from route param of request of upper master
+ *
+ * @return Unit ID or 0 if request is for this unit
+ */
+static unsigned RouteGet(GList **params)
+{
+    for (GList *p = *params; p != NULL; p = p->next) {
+        UtilsReqParam *param = (UtilsReqParam *)p->data;
+
+        if (!strcmp(param->name, "route")) {
+            return strtoul(param->value, NULL, 10);
+        }
+    }
+
+    return 0;
+}
+
+static int ProcessThread(void *data)
+{
+    Process(*(int *)data);
+    return 0;
+}
+
 /*********************************************************************/
 /*                                                                   */
 /*                          PUBLIC FUNCTIONS                         */
 /*                                                                   */
 /*********************************************************************/
 
+void WebServerRequestProcess(FCGX_Request *req)
+{
+    GList *params = NULL;
+
+    const char *query = FCGX_GetParam("SCRIPT_NAME", req->envp);
+    char *url = FCGX_GetParam("REQUEST_URI", req->envp);
+
+    if (!strcmp(query, "/")) {
+        if (!HandlerIndexProcess(req, NULL)) {
+            Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Index handler");
+        }
+        return;
+    } 
+
+    if (UtilsURIParse(url, &params)) {
+        unsigned route = RouteGet(&params);
+
+        if (route != 0) {
+            if (!HandlerStackRouteProcess(req, route)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Stack route handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/security")) {
+            if (!HandlerSecurityProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Security controller get handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/meteo")) {
+            if (!HandlerMeteoProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Meteo controller get handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/socket")) {
+            if (!HandlerSocketProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Socket controller get handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/tank")) {
+            if (!HandlerTankProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Tank controller get handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/waterer")) {
+            if (!HandlerWatererProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Waterer controller get handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/log")) {
+            if (!HandlerLogProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Log search handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/batch")) {
+            if (!HandlerBatchProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Batch handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/state")) {
+            if (!HandlerStateProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process State handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/stack")) {
+            if (!HandlerStackProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Stack handler");
+            }
+        } else if (!strcmp(query, "/api/" SERVER_API_VER "/alarm")) {
+            if (!HandlerAlarmProcess(req, &params)) {
+                Log(LOG_TYPE_ERROR, "SERVER", "Failed to process Alarm handler");
+            }
+        } else {
+            FCGX_PutS("Content-type: text/html\r\n", req->out);
+            FCGX_PutS("\r\n", req->out);
+            FCGX_PutS("<html><h1>404 NOT FOUND</h1></html>\r\n", req->out);
+        }
+    } else {
+        Log(LOG_TYPE_ERROR, "SERVER", "Incorrect request");
+    }
+
+    if (params != NULL) {
+        for (GList *p = params; p != NULL; p = p->next) {
+            UtilsReqParam *param = (UtilsReqParam *)p->data;
+            free(param);
+        }
+        g_list_free(params);
+        params = NULL;
+    }
+}
+
 void WebServerCredsSet(const char *host, unsigned port)
 {
     strncpy(Server.ip, host, STR_LEN);
@@ -130,8 +191,9 @@ void WebServerCredsSet(const char *host, unsigned port)
 
 bool WebServerStart()
 {
-    int     socketId = 0;
-    char    full_path[EXT_STR_LEN];
+    static int  socketId = 0;
+    char        full_path[EXT_STR_LEN];
+    thrd_t      th;
 
     snprintf(full_path, EXT_STR_LEN, "%s:%d", Server.ip, Server.port);
 
@@ -141,6 +203,19 @@ bool WebServerStart()
         return false;
     }
 
+    /**
+     * Several workers accept on one socket, so long-polling state
+     * subscriber does not block other requests
+     */
+
+    for (unsigned i = 1; i < SERVER_WORKERS; i++) {
+        if (thrd_create(&th, &ProcessThread, (void *)&socketId) != thrd_success) {
+            Log(LOG_TYPE_ERROR, "SERVER", "Failed to start web server worker");
+            return false;
+        }
+        thrd_detach(th);
+    }
+
     Process(socketId);
 
     return true;
@@ -13,6 +13,8 @@
 #include <utils/log.h>
 #include <stack/rpc.h>
 #include <plc/plc.h>
+#include <utils/events.h>
+#include <plc/reactor.h>
 
 #include <threads.h>
 
@@ -26,14 +28,16 @@ static struct _Menu {
     unsigned    level;
     GpioPin     *gpio[MENU_GPIO_MAX];
     GList       *levels;
-    LCD         *lcd;
-    mtx_t       upd_mtx;
-    bool        pressed;
+    LCD             *lcd;
+    mtx_t           upd_mtx;
+    EventSubscriber *sub;
+    unsigned        minute;
 } Menu = {
     .level = 0,
     .levels = NULL,
     .lcd = NULL,
-    .pressed = false
+    .sub = NULL,
+    .minute = 0
 };
 
 /*********************************************************************/
@@ -47,10 +51,12 @@ static void MenuDataPrint(MenuValue *value)
     char    val[SHORT_STR_LEN];
 
     if (value->ctrl == MENU_CTRL_METEO) {
-        int     temp = 0;
+        int                 temp = 0;
+        MeteoSensorState    state;
 
         if (value->meteo.sensor->type == METEO_SENSOR_DS18B20) {
-            temp = (int)value->meteo.sensor->ds18b20.temp;
+            MeteoSensorStateGet(value->meteo.sensor, &state);
+            temp = (int)state.temp;
         }
 
         if (temp == METEO_BAD_VAL) {
@@ -91,8 +97,12 @@ static void MenuDataPrint(MenuValue *value)
             snprintf(val, SHORT_STR_LEN, "ERR");
         }
     } else if (value->ctrl == MENU_CTRL_TANK) {
+        TankState state;
+
+        TankStateGet(value->tank.tank, &state);
+
         if (value->tank.param == MENU_TANK_LEVEL) {
-            unsigned lvl = value->tank.tank->level;
+            unsigned lvl = state.level;
             if (lvl < 10) {
                 snprintf(val, SHORT_STR_LEN, "%s:  %u%%", value->alias, lvl);
             } else if (lvl >= 10 && lvl < 100) {
@@ -101,95 +111,119 @@ static void MenuDataPrint(MenuValue *value)
                 snprintf(val, SHORT_STR_LEN, "%s:%u%%", value->alias, lvl);
             }
         } else if (value->tank.param == MENU_TANK_PUMP) {
-            bool status = value->tank.tank->pump;
+            bool status = state.pump;
             snprintf(val, SHORT_STR_LEN, "%s:%s", value->alias, (status == true) ? "O" : "X");
         } else if (value->tank.param == MENU_TANK_VALVE) {
-            bool status = value->tank.tank->valve;
+            bool status = state.valve;
             snprintf(val, SHORT_STR_LEN, "%s:%s", value->alias, (status == true) ? "O" : "X");
         }
     } else if (value->ctrl == MENU_CTRL_SOCKET) {
-        bool status = value->socket.sock->status;
+        bool status = SocketStatusGet(value->socket.sock);
         snprintf(val, SHORT_STR_LEN, "%s:%s", value->alias, (status == true) ? "O" : "X");
     } else if (value->ctrl == MENU_CTRL_LIGHT) {
-        bool status = value->light.sock->status;
+        bool status = SocketStatusGet(value->light.sock);
         snprintf(val, SHORT_STR_LEN, "%s:%s", value->alias, (status == true) ? "O" : "X");
     }
 
     LcdPrint(Menu.lcd, val);
 }
 
-static int DisplayThread(void *data)
+static void DisplayUpdate()
 {
     unsigned cur_lvl = 0;
-    unsigned counter = 0;
-
-    for (;;) {
-        if (counter == 50 || Menu.pressed) {
-            Menu.pressed = false;
-            counter = 0;
-            cur_lvl = 0;
-
-            for (GList *l = Menu.levels; l != NULL; l = l->next) {
-                MenuLevel *level = (MenuLevel *)l->data;
-                if (cur_lvl == Menu.level) {
-                    LcdClear(Menu.lcd);
-
-                    if (strcmp(level->name, "main")) {
-                        LcdPosSet(Menu.lcd, 0, 0);
-                        LcdPrint(Menu.lcd, level->name);
-                    }
-
-                    for (GList *v = level->values; v != NULL; v = v->next) {
-                        MenuValue *value = (MenuValue *)v->data;
-                        LcdPosSet(Menu.lcd, value->row, value->col);
-                        MenuDataPrint(value);
-                    }
-                }
-                cur_lvl++;
+
+    mtx_lock(&Menu.upd_mtx);
+
+    for (GList *l = Menu.levels; l != NULL; l = l->next) {
+        MenuLevel *level = (MenuLevel *)l->data;
+        if (cur_lvl == Menu.level) {
+            LcdClear(Menu.lcd);
+
+            if (strcmp(level->name, "main")) {
+                LcdPosSet(Menu.lcd, 0, 0);
+                LcdPrint(Menu.lcd, level->name);
+            }
+
+            for (GList *v = level->values; v != NULL; v = v->next) {
+                MenuValue *value = (MenuValue *)v->data;
+                LcdPosSet(Menu.lcd, value->row, value->col);
+                MenuDataPrint(value);
             }
         }
-        counter++;
-        UtilsMsecSleep(100);
+        cur_lvl++;
+    }
+
+    mtx_unlock(&Menu.upd_mtx);
+}
+
+static void DisplayEventsProcess(int fd, void *data)
+{
+    Event   event;
+    bool    update = false;
+
+    EventReset(Menu.sub);
+
+    while (EventPop(Menu.sub, &event)) {
+        update = true;
+    }
+
+    if (update) {
+        DisplayUpdate();
     }
-    return 0;
 }
 
-static int ButtonsThread(void *data)
+static void ClockTask(PeriodicTask *task, void *data)
+{
+    PlcTime time;
+
+    if (PlcTimeGet(&time) && time.min != Menu.minute) {
+        Menu.minute = time.min;
+        DisplayUpdate();
+    }
+}
+
+static void ButtonsTask(PeriodicTask *task, void *data)
 {
     bool state;
 
-    for (;;) {
-        if (!GpioPinRead(Menu.gpio[MENU_GPIO_UP], &state)) {
-            LogF(LOG_TYPE_ERROR, "MENU", "Failed to read GPIO \"%s\"", Menu.gpio[MENU_GPIO_UP]->name);
-        } else { 
-            if (!state) {
-                if (Menu.level < (g_list_length(Menu.levels) - 1)) {
-                    Menu.level++;
-                } else {
-                    Menu.level = 0;
-                }
-                Menu.pressed = true;
-                UtilsMsecSleep(800);
+    if (!GpioPinRead(Menu.gpio[MENU_GPIO_UP], &state)) {
+        LogF(LOG_TYPE_ERROR, "MENU", "Failed to read GPIO \"%s\"", Menu.gpio[MENU_GPIO_UP]->name);
+    } else { 
+        if (!state) {
+            if (Menu.level < (g_list_length(Menu.levels) - 1)) {
+                Menu.level++;
+            } else {
+                Menu.level = 0;
             }
+            DisplayUpdate();
+            PeriodicDelay(task, MENU_BUTTON_DELAY_MS);
+            return;
         }
+    }
 
-        if (!GpioPinRead(Menu.gpio[MENU_GPIO_DOWN], &state)) {
-            LogF(LOG_TYPE_ERROR, "MENU", "Failed to read GPIO \"%s\"", Menu.gpio[MENU_GPIO_UP]->name);
-        } else {
-            if (!state) {
-                if (Menu.level > 0) {
-                    Menu.level--;
-                } else {
-                    Menu.level = g_list_length(Menu.levels) - 1;
-                }
-                Menu.pressed = true;
-                UtilsMsecSleep(800);
-            }
+    if (!GpioPinRead(Menu.gpio[MENU_GPIO_MIDDLE], &state)) {
+        LogF(LOG_TYPE_ERROR, "MENU", "Failed to read GPIO \"%s\"", Menu.gpio[MENU_GPIO_MIDDLE]->name);
+    } else {
+        if (!state) {
+            PlcAlarmAckAll();
+            PeriodicDelay(task, MENU_BUTTON_DELAY_MS);
+            return;
         }
+    }
 
-        UtilsMsecSleep(200);
+    if (!GpioPinRead(Menu.gpio[MENU_GPIO_DOWN], &state)) {
+        LogF(LOG_TYPE_ERROR, "MENU", "Failed to read GPIO \"%s\"", Menu.gpio[MENU_GPIO_UP]->name);
+    } else {
+        if (!state) {
+            if (Menu.level > 0) {
+                Menu.level--;
+            } else {
+                Menu.level = g_list_length(Menu.levels) - 1;
+            }
+            DisplayUpdate();
+            PeriodicDelay(task, MENU_BUTTON_DELAY_MS);
+        }
     }
-    return 0;
 }
 
 /*********************************************************************/
@@ -242,12 +276,27 @@ void MenuValueAdd(MenuLevel *level, MenuValue *value)
 
 bool MenuStart()
 {
-    thrd_t  btn_th, lcd_th;
+    mtx_init(&Menu.upd_mtx, mtx_plain);
+
+    Menu.sub = EventSubscribe("menu", EVENT_MASK(EVENT_SOCKET_CHANGED) |
+                                      EVENT_MASK(EVENT_TANK_LEVEL_CHANGED) |
+                                      EVENT_MASK(EVENT_TANK_STATE_CHANGED) |
+                                      EVENT_MASK(EVENT_METEO_CHANGED));
+    if (Menu.sub == NULL) {
+        return false;
+    }
 
-    thrd_create(&btn_th, &ButtonsThread, NULL);
-    thrd_detach(btn_th);
-    thrd_create(&lcd_th, &DisplayThread, NULL);
-    thrd_detach(lcd_th);
+    DisplayUpdate();
+
+    if (!ReactorFdAdd(EventFdGet(Menu.sub), &DisplayEventsProcess, NULL)) {
+        return false;
+    }
+    if (!ReactorTaskAdd("menu_clock", MENU_CLOCK_PERIOD_MS, &ClockTask, NULL)) {
+        return false;
+    }
+    if (!ReactorTaskAdd("menu_buttons", MENU_BUTTON_PERIOD_MS, &ButtonsTask, NULL)) {
+        return false;
+    }
 
     return true;
 }
@@ -12,13 +12,25 @@
 #include <utils/utils.h>
 #include <utils/log.h>
 #include <net/web/webserver.h>
+#include <net/web/webclient.h>
 #include <net/tgbot/tgbot.h>
+#include <net/notifier.h>
+#include <net/channel.h>
 #include <controllers/controllers.h>
 #include <stack/stack.h>
+#include <stack/statelog.h>
+#include <stack/discovery.h>
 #include <db/dbloader.h>
 #include <plc/menu.h>
+#include <plc/reactor.h>
+#include <utils/jobs.h>
+#include <scenario/logic.h>
+#include <scenario/scenario.h>
 
+#include <string.h>
 #include <threads.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -26,16 +38,105 @@
 /*                                                                   */
 /*********************************************************************/
 
+typedef struct {
+    const unsigned  *steps;
+    unsigned        steps_count;
+    unsigned        repeat;
+    unsigned        prio;
+} PlcPattern;
+
+typedef struct {
+    PlcGpioType         gpio;
+    const PlcPattern    *patterns;
+    unsigned            patterns_count;
+    unsigned            active;
+    int                 current;
+    unsigned            step;
+    unsigned            played;
+    uint64_t            deadline;
+    bool                level;
+    bool                output;
+} PlcChannel;
+
+/**
+ * Steps are on/off durations in milliseconds starting with "on",
+ * zero repeat means that pattern is played until stopped
+ */
+
+static const unsigned StepsEnter[] = { 300, 0 };
+static const unsigned StepsExit[] = { 100, 100 };
+static const unsigned StepsLoop[] = { PLC_ALARM_PERIOD_MS, PLC_ALARM_PERIOD_MS };
+static const unsigned StepsTankEmpty[] = { 1000, 2000 };
+
+static const PlcPattern BuzzerPatterns[] = {
+    [PLC_BUZZER_SECURITY_ENTER] = { StepsEnter, 2, 1, 3 },
+    [PLC_BUZZER_SECURITY_EXIT] = { StepsExit, 2, 2, 3 },
+    [PLC_BUZZER_LOOP] = { StepsLoop, 2, 0, 2 },
+    [PLC_BUZZER_TANK_EMPTY] = { StepsTankEmpty, 2, 4, 1 }
+};
+
+static const unsigned StepsFast[] = { PLC_ALARM_FAST_MS, PLC_ALARM_FAST_MS };
+static const unsigned StepsSteady[] = { 1000, 0 };
+
+typedef enum {
+    ALARM_LED_ACKED,
+    ALARM_LED_LOW,
+    ALARM_LED_HIGH
+} AlarmLedPattern;
+
+static const PlcPattern AlarmPatterns[] = {
+    [ALARM_LED_ACKED] = { StepsSteady, 2, 0, 1 },
+    [ALARM_LED_LOW] = { StepsLoop, 2, 0, 2 },
+    [ALARM_LED_HIGH] = { StepsFast, 2, 0, 3 }
+};
+
+static const struct {
+    const char          *name;
+    PlcAlarmPriority    prio;
+    bool                latching;
+} AlarmDefs[PLC_ALARM_MAX] = {
+    [PLC_ALARM_SECURITY] = { "security", PLC_ALARM_PRIO_HIGH, true },
+    [PLC_ALARM_TANK] = { "tank", PLC_ALARM_PRIO_LOW, false }
+};
+
 static struct _Plc {
     GpioPin     *gpio[PLC_GPIO_MAX];
-    unsigned    alarms;
-    bool        buzzer;
+    PlcAlarmState   alarms[PLC_ALARM_MAX];
+    PlcAlarmRecord  history[PLC_ALARM_HISTORY_LEN];
+    unsigned        history_head;
+    unsigned        history_count;
     PlcTimeType time_type;
+    PlcTime     time;
+    time_t      time_sec;
+    mtx_t       time_mtx;
+    once_flag   time_once;
+    PlcChannel  buzzer;
+    PlcChannel  alarm;
+    int         seq_fd;
+    mtx_t       seq_mtx;
+    once_flag   seq_once;
 } Plc = {
     .gpio = {0},
-    .alarms = 0x0,
-    .buzzer = false,
-    .time_type = PLC_TIME_LINUX
+    .alarms = {0},
+    .history_head = 0,
+    .history_count = 0,
+    .time_type = PLC_TIME_LINUX,
+    .time_sec = 0,
+    .time_once = ONCE_FLAG_INIT,
+    .buzzer = {
+        .gpio = PLC_GPIO_BUZZER,
+        .patterns = BuzzerPatterns,
+        .patterns_count = sizeof(BuzzerPatterns) / sizeof(BuzzerPatterns[0]),
+        .current = -1
+    },
+    .alarm = {
+        .gpio = PLC_GPIO_ALARM_LED,
+        .patterns = AlarmPatterns,
+        .patterns_count = sizeof(AlarmPatterns) / sizeof(AlarmPatterns[0]),
+        .current = -1
+    },
+    .seq_fd = -1,
+    .seq_once = ONCE_FLAG_INIT
 };
 
 /*********************************************************************/
@@ -44,69 +145,245 @@ static struct _Plc {
 /*                                                                   */
 /*********************************************************************/
 
-static int AlarmThread(void *data)
+static void TimeInit()
 {
-    bool    last = true;
+    mtx_init(&Plc.time_mtx, mtx_plain);
+}
 
-    for (;;) {
-        if (Plc.alarms != 0x0) {
-            if (last) {
-                last = false;
-                GpioPinWrite(Plc.gpio[PLC_GPIO_ALARM_LED], true);
-            } else {
-                last = true;
-                GpioPinWrite(Plc.gpio[PLC_GPIO_ALARM_LED], false);
-            }
+static void ChannelOutput(PlcChannel *ch)
+{
+    /**
+     * Pin is written once per update, so zero length steps
+     * between patterns do not produce glitches
+     */
+
+    if (ch->output != ch->level) {
+        ch->output = ch->level;
+        GpioPinWrite(Plc.gpio[ch->gpio], ch->level);
+    }
+}
+
+static int ChannelTopGet(PlcChannel *ch)
+{
+    int top = -1;
+
+    for (unsigned i = 0; i < ch->patterns_count; i++) {
+        if ((ch->active & (1 << i)) == 0) {
+            continue;
+        }
+        if (top < 0 || ch->patterns[i].prio > ch->patterns[top].prio) {
+            top = i;
         }
+    }
 
-        if (Plc.buzzer) {
-            if (last) {
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], true);
-            } else {
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], false);
+    return top;
+}
+
+static void ChannelUpdate(PlcChannel *ch, uint64_t now)
+{
+    int top = ChannelTopGet(ch);
+
+    if (top != ch->current) {
+        ch->current = top;
+
+        if (top < 0) {
+            ch->deadline = 0;
+            ch->level = false;
+            return;
+        }
+
+        /**
+         * Pre-empted or new pattern is always played from the start
+         */
+
+        ch->step = 0;
+        ch->played = 0;
+        ch->deadline = now + (uint64_t)ch->patterns[top].steps[0] * 1000000ULL;
+        ch->level = true;
+    }
+
+    if (top < 0) {
+        return;
+    }
+
+    const PlcPattern *pattern = &ch->patterns[top];
+
+    /**
+     * Do not replay missed steps after long stall
+     */
+
+    if (now > ch->deadline + 1000000000ULL) {
+        ch->deadline = now;
+    }
+
+    while (ch->deadline <= now) {
+        if (++ch->step == pattern->steps_count) {
+            ch->step = 0;
+            ch->played++;
+
+            if (pattern->repeat != 0 && ch->played >= pattern->repeat) {
+                ch->active &= ~(1 << top);
+                ChannelUpdate(ch, now);
+                return;
             }
         }
 
-        UtilsMsecSleep(500);
+        ch->deadline += (uint64_t)pattern->steps[ch->step] * 1000000ULL;
+        ch->level = ((ch->step % 2) == 0);
     }
-    return 0;
 }
 
-static int BuzzerThread(void *data)
+static void SequencerArm()
 {
-    PlcBuzzerType *type = (PlcBuzzerType *)data;
+    uint64_t            deadline = Plc.buzzer.deadline;
+    struct itimerspec   its = {0};
 
-    switch (*type) {
-        case PLC_BUZZER_LOOP:
-            break;
+    if (deadline == 0 || (Plc.alarm.deadline != 0 && Plc.alarm.deadline < deadline)) {
+        deadline = Plc.alarm.deadline;
+    }
 
-        case PLC_BUZZER_SECURITY_ENTER:
-            GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], true);
-            UtilsMsecSleep(300);
-            GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], false);
-            break;
+    /**
+     * Zero deadline disarms timer
+     */
 
-        case PLC_BUZZER_SECURITY_EXIT:
-            for (unsigned i = 0; i < 2; i++) {
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], true);
-                UtilsMsecSleep(100);
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], false);
-                UtilsMsecSleep(100);
-            }
+    its.it_value.tv_sec = deadline / 1000000000ULL;
+    its.it_value.tv_nsec = deadline % 1000000000ULL;
+
+    if (timerfd_settime(Plc.seq_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to arm sequencer timer");
+    }
+}
+
+static void SequencerUpdate()
+{
+    uint64_t now = UtilsMonoNsGet();
+
+    ChannelUpdate(&Plc.buzzer, now);
+    ChannelUpdate(&Plc.alarm, now);
+    ChannelOutput(&Plc.buzzer);
+    ChannelOutput(&Plc.alarm);
+
+    if (Plc.seq_fd >= 0) {
+        SequencerArm();
+    }
+}
+
+static void SequencerProcess(int fd, void *data)
+{
+    uint64_t expired;
+
+    if (read(fd, &expired, sizeof(expired)) != sizeof(expired)) {
+        return;
+    }
+
+    mtx_lock(&Plc.seq_mtx);
+    SequencerUpdate();
+    mtx_unlock(&Plc.seq_mtx);
+}
+
+static void AlarmRecordAdd(PlcAlarmType type, PlcAlarmAction action)
+{
+    PlcAlarmRecord *rec = &Plc.history[Plc.history_head];
+
+    rec->type = type;
+    rec->action = action;
+    rec->state = Plc.alarms[type];
+    rec->time = time(NULL);
+
+    Plc.history_head = (Plc.history_head + 1) % PLC_ALARM_HISTORY_LEN;
+    if (Plc.history_count < PLC_ALARM_HISTORY_LEN) {
+        Plc.history_count++;
+    }
+}
+
+static void AlarmLedUpdate()
+{
+    unsigned active = 0x0;
+
+    for (unsigned i = 0; i < PLC_ALARM_MAX; i++) {
+        switch (Plc.alarms[i]) {
+            case PLC_ALARM_STATE_ACTIVE:
+            case PLC_ALARM_STATE_LATCHED:
+                if (AlarmDefs[i].prio == PLC_ALARM_PRIO_HIGH) {
+                    active |= (1 << ALARM_LED_HIGH);
+                } else {
+                    active |= (1 << ALARM_LED_LOW);
+                }
+                break;
+
+            case PLC_ALARM_STATE_ACKED:
+                active |= (1 << ALARM_LED_ACKED);
+                break;
+
+            case PLC_ALARM_STATE_NORMAL:
+                break;
+        }
+    }
+
+    Plc.alarm.active = active;
+    SequencerUpdate();
+}
+
+static bool AlarmAck(PlcAlarmType type)
+{
+    switch (Plc.alarms[type]) {
+        case PLC_ALARM_STATE_ACTIVE:
+            Plc.alarms[type] = PLC_ALARM_STATE_ACKED;
             break;
 
-        case PLC_BUZZER_TANK_EMPTY:
-            for (unsigned i = 0; i < 4; i++) {
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], true);
-                UtilsSecSleep(1);
-                GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], false);
-                UtilsSecSleep(2);
-            }
+        case PLC_ALARM_STATE_LATCHED:
+            Plc.alarms[type] = PLC_ALARM_STATE_NORMAL;
             break;
+
+        default:
+            return false;
+    }
+
+    AlarmRecordAdd(type, PLC_ALARM_ACTION_ACKED);
+    return true;
+}
+
+static void SequencerInit()
+{
+    mtx_init(&Plc.seq_mtx, mtx_plain);
+}
+
+static bool SequencerStart()
+{
+    Plc.seq_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (Plc.seq_fd < 0) {
+        return false;
     }
 
-    free(type);
-    return 0;
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+    SequencerUpdate();
+    mtx_unlock(&Plc.seq_mtx);
+
+    return ReactorFdAdd(Plc.seq_fd, &SequencerProcess, NULL);
+}
+
+/**
+ * @brief Log shared pools usage, low hit rate means that pool is too
+ * small for number of parallel requests
+ */
+static void StatsTask(PeriodicTask *task, void *data)
+{
+    WebClientStats  web;
+    JobsStats       jobs;
+
+    WebClientStatsGet(&web);
+    JobsStatsGet(&jobs);
+
+    LogF(LOG_TYPE_INFO, "PLC", "Web client: %u hosts, %lu requests, %lu hits, %lu misses, %lu connects",
+         web.hosts, web.requests, web.hits, web.misses, web.connects);
+    LogF(LOG_TYPE_INFO, "PLC", "Jobs: %u queued max, %lu done, %lu cancelled, %lu stolen, "
+         "wait avg/max %lu/%lu us, run avg/max %lu/%lu us",
+         jobs.queued_max, jobs.done, jobs.cancelled, jobs.stolen,
+         (unsigned long)(jobs.wait_avg_ns / 1000), (unsigned long)(jobs.wait_max_ns / 1000),
+         (unsigned long)(jobs.run_avg_ns / 1000), (unsigned long)(jobs.run_max_ns / 1000));
 }
 
 /*********************************************************************/
@@ -120,22 +397,49 @@ void PlcTimeTypeSet(PlcTimeType type)
     Plc.time_type = type;
 }
 
-bool PlcTimeGet(PlcTime *time)
+bool PlcTimeGet(PlcTime *tm)
 {
-    if (Plc.time_type == PLC_TIME_LINUX) {
-        struct tm *t = UtilsLinuxTimeGet();
+    if (Plc.time_type != PLC_TIME_LINUX) {
+        return false;
+    }
 
-        time->sec = t->tm_sec;
-        time->min = t->tm_min;
-        time->hour = t->tm_hour;
-        time->day = t->tm_mday;
-        time->dow = t->tm_wday;
-        time->month = t->tm_mon;
-        time->year = t->tm_year;
+    call_once(&Plc.time_once, &TimeInit);
 
-        return true;
+    time_t sec = time(NULL);
+
+    mtx_lock(&Plc.time_mtx);
+
+    if (sec != Plc.time_sec) {
+        struct tm t;
+
+        /**
+         * Timezone file is checked once a minute
+         */
+
+        if (sec / 60 != Plc.time_sec / 60) {
+            UtilsTimeZoneUpdate();
+        }
+
+        if (!UtilsLinuxTimeGet(sec, &t)) {
+            mtx_unlock(&Plc.time_mtx);
+            return false;
+        }
+
+        Plc.time.sec = t.tm_sec;
+        Plc.time.min = t.tm_min;
+        Plc.time.hour = t.tm_hour;
+        Plc.time.day = t.tm_mday;
+        Plc.time.dow = t.tm_wday;
+        Plc.time.month = t.tm_mon;
+        Plc.time.year = t.tm_year;
+        Plc.time_sec = sec;
     }
-    return false;
+
+    *tm = Plc.time;
+
+    mtx_unlock(&Plc.time_mtx);
+
+    return true;
 }
 
 void PlcGpioSet(PlcGpioType type, GpioPin *gpio)
@@ -145,44 +449,191 @@ void PlcGpioSet(PlcGpioType type, GpioPin *gpio)
 
 void PlcAlarmSet(PlcAlarmType type, bool status)
 {
+    bool changed = false;
+
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+
     if (status) {
-        Plc.alarms |= (1 << type);
+        if (Plc.alarms[type] == PLC_ALARM_STATE_NORMAL || Plc.alarms[type] == PLC_ALARM_STATE_LATCHED) {
+            Plc.alarms[type] = PLC_ALARM_STATE_ACTIVE;
+            AlarmRecordAdd(type, PLC_ALARM_ACTION_RAISED);
+            changed = true;
+        }
     } else {
-        Plc.alarms &= ~(1 << type);
+        if (Plc.alarms[type] == PLC_ALARM_STATE_ACTIVE) {
+            if (AlarmDefs[type].latching) {
+                Plc.alarms[type] = PLC_ALARM_STATE_LATCHED;
+            } else {
+                Plc.alarms[type] = PLC_ALARM_STATE_NORMAL;
+            }
+            AlarmRecordAdd(type, PLC_ALARM_ACTION_CLEARED);
+            changed = true;
+        } else if (Plc.alarms[type] == PLC_ALARM_STATE_ACKED) {
+            Plc.alarms[type] = PLC_ALARM_STATE_NORMAL;
+            AlarmRecordAdd(type, PLC_ALARM_ACTION_CLEARED);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        AlarmLedUpdate();
+    }
+
+    mtx_unlock(&Plc.seq_mtx);
+
+    if (changed) {
+        LogF(LOG_TYPE_INFO, "PLC", "Alarm \"%s\" %s", AlarmDefs[type].name, (status == true) ? "raised" : "cleared");
+    }
+}
+
+bool PlcAlarmAck(PlcAlarmType type)
+{
+    bool acked;
+
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+
+    acked = AlarmAck(type);
+    if (acked) {
+        AlarmLedUpdate();
+    }
+
+    mtx_unlock(&Plc.seq_mtx);
+
+    if (acked) {
+        LogF(LOG_TYPE_INFO, "PLC", "Alarm \"%s\" acknowledged", AlarmDefs[type].name);
+    }
+
+    return acked;
+}
+
+void PlcAlarmAckAll()
+{
+    for (unsigned i = 0; i < PLC_ALARM_MAX; i++) {
+        PlcAlarmAck(i);
     }
+}
+
+PlcAlarmState PlcAlarmStateGet(PlcAlarmType type)
+{
+    PlcAlarmState state;
+
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+    state = Plc.alarms[type];
+    mtx_unlock(&Plc.seq_mtx);
+
+    return state;
+}
+
+const char *PlcAlarmNameGet(PlcAlarmType type)
+{
+    return AlarmDefs[type].name;
+}
+
+bool PlcAlarmTypeGet(const char *name, PlcAlarmType *type)
+{
+    for (unsigned i = 0; i < PLC_ALARM_MAX; i++) {
+        if (!strcmp(AlarmDefs[i].name, name)) {
+            *type = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned PlcAlarmHistoryGet(PlcAlarmRecord *records, unsigned max)
+{
+    unsigned count;
+
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+
+    count = (Plc.history_count < max) ? Plc.history_count : max;
 
-    if (Plc.alarms == 0x0) {
-        UtilsSecSleep(1);
-        GpioPinWrite(Plc.gpio[PLC_GPIO_ALARM_LED], false);
+    for (unsigned i = 0; i < count; i++) {
+        unsigned pos = (Plc.history_head + PLC_ALARM_HISTORY_LEN - 1 - i) % PLC_ALARM_HISTORY_LEN;
+        records[i] = Plc.history[pos];
     }
+
+    mtx_unlock(&Plc.seq_mtx);
+
+    return count;
 }
 
 void PlcBuzzerRun(PlcBuzzerType type, bool status)
 {
-    thrd_t  bz_th;
+    call_once(&Plc.seq_once, &SequencerInit);
 
-    if (type == PLC_BUZZER_LOOP) {
-        Plc.buzzer = status;
-        if (!status) {
-            UtilsSecSleep(1);
-            GpioPinWrite(Plc.gpio[PLC_GPIO_BUZZER], false);
+    mtx_lock(&Plc.seq_mtx);
+
+    if (status) {
+        Plc.buzzer.active |= (1 << type);
+
+        /**
+         * Repeated request restarts pattern which is playing now
+         */
+
+        if (Plc.buzzer.current == (int)type) {
+            Plc.buzzer.current = -1;
         }
     } else {
-        PlcBuzzerType *t = (PlcBuzzerType *)malloc(sizeof(PlcBuzzerType));
-        *t = type;
-        thrd_create(&bz_th, &BuzzerThread, (void *)t);
-        thrd_detach(bz_th);
+        Plc.buzzer.active &= ~(1 << type);
     }
+
+    SequencerUpdate();
+
+    mtx_unlock(&Plc.seq_mtx);
 }
 
-bool PlcStart()
+void PlcBuzzerStop()
 {
-    thrd_t  alrm_th;
+    call_once(&Plc.seq_once, &SequencerInit);
+
+    mtx_lock(&Plc.seq_mtx);
+
+    Plc.buzzer.active = 0x0;
+    SequencerUpdate();
+
+    mtx_unlock(&Plc.seq_mtx);
+}
 
+bool PlcStart()
+{
     Log(LOG_TYPE_INFO, "PLC", "Starting Plc");
 
-    thrd_create(&alrm_th, &AlarmThread, NULL);
-    thrd_detach(alrm_th);
+    if (!ReactorStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start reactor");
+        return -1;
+    }
+
+    if (!JobsStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start job pool");
+        return -1;
+    }
+
+    if (!SequencerStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start buzzer sequencer");
+        return -1;
+    }
+
+    if (!ReactorTaskAdd("plc_stats", PLC_STATS_PERIOD_MS, &StatsTask, NULL)) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start stats task");
+        return -1;
+    }
+
+    Log(LOG_TYPE_INFO, "PLC", "Starting Notifier");
+
+    if (!NotifierStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start Notifier");
+        return -1;
+    }
 
     Log(LOG_TYPE_INFO, "PLC", "Loading database states");
 
@@ -198,6 +649,27 @@ bool PlcStart()
         return -1;
     }
 
+    Log(LOG_TYPE_INFO, "PLC", "Starting logic programs");
+
+    if (!LogicStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start logic programs");
+        return -1;
+    }
+
+    Log(LOG_TYPE_INFO, "PLC", "Starting scenario rules");
+
+    if (!ScenarioRulesStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start scenario rules");
+        return -1;
+    }
+
+    Log(LOG_TYPE_INFO, "PLC", "Starting state change log");
+
+    if (!StateLogStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start state change log");
+        return -1;
+    }
+
     Log(LOG_TYPE_INFO, "PLC", "Starting Stack monitoring");
 
     if (!StackStart()) {
@@ -205,6 +677,13 @@ bool PlcStart()
         return -1;
     }
 
+    Log(LOG_TYPE_INFO, "PLC", "Starting Stack discovery");
+
+    if (!DiscoveryStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start stack discovery");
+        return -1;
+    }
+
     Log(LOG_TYPE_INFO, "PLC", "Starting Telegram bot");
 
     if (!TgBotStart()) {
@@ -219,6 +698,13 @@ bool PlcStart()
         return -1;
     }
 
+    Log(LOG_TYPE_INFO, "PLC", "Starting Channel server");
+
+    if (!ChannelServerStart()) {
+        Log(LOG_TYPE_ERROR, "PLC", "Failed to start channel server");
+        return -1;
+    }
+
     Log(LOG_TYPE_INFO, "PLC", "Starting Web Server");
 
     if (!WebServerStart()) {
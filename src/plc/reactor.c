@@ -0,0 +1,292 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <threads.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include <plc/reactor.h>
+#include <utils/jobs.h>
+#include <utils/log.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef enum {
+    REACTOR_SOURCE_FD,
+    REACTOR_SOURCE_TASK
+} ReactorSourceType;
+
+typedef struct {
+    ReactorSourceType   type;
+    bool                job;
+    bool                removed;
+    int                 fd;
+    ReactorFunc         func;
+    void                *data;
+    PeriodicTask        task;
+} ReactorSource;
+
+static struct {
+    int     epfd;
+} Reactor = {
+    .epfd = -1
+};
+
+static thread_local ReactorSource *ReactorCurrent = NULL;
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static bool SourceArm(ReactorSource *src, int op)
+{
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLONESHOT,
+        .data.ptr = src
+    };
+
+    /**
+     * One shot mode guarantees that a source is never
+     * processed by two reactor threads at the same time
+     */
+
+    return epoll_ctl(Reactor.epfd, op, src->fd, &ev) == 0;
+}
+
+static bool TimerArm(ReactorSource *src)
+{
+    struct itimerspec its = {
+        .it_interval = {0},
+        .it_value = src->task.deadline
+    };
+
+    return timerfd_settime(src->fd, TFD_TIMER_ABSTIME, &its, NULL) == 0;
+}
+
+static void SourceRun(ReactorSource *src)
+{
+    uint64_t    expired;
+
+    switch (src->type) {
+        case REACTOR_SOURCE_FD:
+            ReactorCurrent = src;
+            src->func(src->fd, src->data);
+            ReactorCurrent = NULL;
+
+            if (src->removed) {
+                free(src);
+                return;
+            }
+            break;
+
+        case REACTOR_SOURCE_TASK:
+            if (read(src->fd, &expired, sizeof(expired)) != sizeof(expired)) {
+                break;
+            }
+
+            src->task.func(&src->task, src->task.data);
+            PeriodicNext(&src->task);
+
+            if (!TimerArm(src)) {
+                LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to arm timer for task \"%s\"", src->task.name);
+                return;
+            }
+            break;
+    }
+
+    if (!SourceArm(src, EPOLL_CTL_MOD)) {
+        LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to rearm descriptor %d", src->fd);
+    }
+}
+
+static bool SourceJob(void *data)
+{
+    SourceRun((ReactorSource *)data);
+    return true;
+}
+
+static void SourceProcess(ReactorSource *src)
+{
+    /**
+     * Blocking bodies run on job pool, source stays disarmed until
+     * the body returns, so it is still never processed twice at once
+     */
+
+    if (src->job) {
+        const char *name = (src->type == REACTOR_SOURCE_TASK) ? src->task.name : "reactor_fd";
+
+        if (JobRun(name, JOB_PRIO_NORMAL, &SourceJob, (void *)src)) {
+            return;
+        }
+
+        LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to queue job \"%s\", running it on reactor", name);
+    }
+
+    SourceRun(src);
+}
+
+static bool FdSourceAdd(int fd, ReactorFunc func, void *data, bool job)
+{
+    ReactorSource *src = (ReactorSource *)malloc(sizeof(ReactorSource));
+
+    if (src == NULL) {
+        return false;
+    }
+
+    src->type = REACTOR_SOURCE_FD;
+    src->job = job;
+    src->removed = false;
+    src->fd = fd;
+    src->func = func;
+    src->data = data;
+
+    if (!SourceArm(src, EPOLL_CTL_ADD)) {
+        free(src);
+        LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to add descriptor %d", fd);
+        return false;
+    }
+
+    return true;
+}
+
+static bool TaskSourceAdd(const char *name, unsigned period_ms, PeriodicFunc func, void *data, bool job)
+{
+    ReactorSource *src = (ReactorSource *)malloc(sizeof(ReactorSource));
+
+    if (src == NULL) {
+        return false;
+    }
+
+    src->type = REACTOR_SOURCE_TASK;
+    src->job = job;
+    src->removed = false;
+    src->func = NULL;
+    src->data = NULL;
+
+    PeriodicInit(&src->task, name, period_ms);
+    src->task.func = func;
+    src->task.data = data;
+
+    src->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (src->fd < 0) {
+        free(src);
+        LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to create timer for task \"%s\"", name);
+        return false;
+    }
+
+    /**
+     * First run is immediate like the first pass of a loop
+     */
+
+    if (!TimerArm(src) || !SourceArm(src, EPOLL_CTL_ADD)) {
+        close(src->fd);
+        free(src);
+        LogF(LOG_TYPE_ERROR, "REACTOR", "Failed to add task \"%s\"", name);
+        return false;
+    }
+
+    return true;
+}
+
+static int ReactorThread(void *data)
+{
+    struct epoll_event ev;
+
+    for (;;) {
+        int n = epoll_wait(Reactor.epfd, &ev, 1, -1);
+
+        if (n < 0) {
+            if (errno != EINTR) {
+                Log(LOG_TYPE_ERROR, "REACTOR", "Failed to wait for events");
+                UtilsSecSleep(1);
+            }
+            continue;
+        }
+
+        if (n == 1) {
+            SourceProcess((ReactorSource *)ev.data.ptr);
+        }
+    }
+
+    return 0;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool ReactorStart()
+{
+    thrd_t  th;
+
+    Reactor.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (Reactor.epfd < 0) {
+        Log(LOG_TYPE_ERROR, "REACTOR", "Failed to create epoll instance");
+        return false;
+    }
+
+    for (unsigned i = 0; i < REACTOR_THREADS; i++) {
+        if (thrd_create(&th, &ReactorThread, NULL) != thrd_success) {
+            return false;
+        }
+        if (thrd_detach(th) != thrd_success) {
+            return false;
+        }
+    }
+
+    LogF(LOG_TYPE_INFO, "REACTOR", "Reactor started with %u threads", REACTOR_THREADS);
+
+    return true;
+}
+
+bool ReactorFdAdd(int fd, ReactorFunc func, void *data)
+{
+    return FdSourceAdd(fd, func, data, false);
+}
+
+bool ReactorJobFdAdd(int fd, ReactorFunc func, void *data)
+{
+    return FdSourceAdd(fd, func, data, true);
+}
+
+bool ReactorFdRemove(int fd)
+{
+    ReactorSource *src = ReactorCurrent;
+
+    if (src == NULL || src->fd != fd) {
+        return false;
+    }
+
+    src->removed = true;
+
+    return epoll_ctl(Reactor.epfd, EPOLL_CTL_DEL, fd, NULL) == 0;
+}
+
+bool ReactorTaskAdd(const char *name, unsigned period_ms, PeriodicFunc func, void *data)
+{
+    return TaskSourceAdd(name, period_ms, func, data, false);
+}
+
+bool ReactorJobTaskAdd(const char *name, unsigned period_ms, PeriodicFunc func, void *data)
+{
+    return TaskSourceAdd(name, period_ms, func, data, true);
+}
@@ -0,0 +1,917 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <scenario/logic.h>
+#include <utils/log.h>
+#include <core/gpio.h>
+#include <controllers/socket.h>
+#include <controllers/tank.h>
+#include <controllers/meteo.h>
+#include <plc/reactor.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef enum {
+    TOK_END,
+    TOK_NUM,
+    TOK_STR,
+    TOK_IDENT,
+    TOK_ASSIGN,
+    TOK_LPAREN,
+    TOK_RPAREN,
+    TOK_COMMA,
+    TOK_PLUS,
+    TOK_MINUS,
+    TOK_MUL,
+    TOK_DIV,
+    TOK_EQ,
+    TOK_NE,
+    TOK_LT,
+    TOK_LE,
+    TOK_GT,
+    TOK_GE,
+    TOK_ERROR
+} LogicToken;
+
+typedef struct {
+    LogicProgram    *prog;
+    const char      *pos;
+    LogicToken      tok;
+    char            text[SHORT_STR_LEN];
+    int32_t         num;
+    char            vars[LOGIC_REGS_MAX][SHORT_STR_LEN];
+    unsigned        temp;
+    bool            error;
+} LogicParser;
+
+static struct {
+    GList   *programs;
+} Logic = {
+    .programs = NULL
+};
+
+static const char *BenchLines[] = {
+    "x := x + 1",
+    "reset := x >= 1000",
+    "x := SEL(reset, 0, x)",
+    "pulse := TON(x MOD 10 < 5, 0)",
+    "edge := R_TRIG(pulse)",
+    "cnt := CTU(edge, reset, 50)",
+    "out := (x > 100 AND x < 900) OR NOT cnt XOR pulse",
+    "y := (x * 3 - 7) / 2"
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void TokenNext(LogicParser *p)
+{
+    while (isspace((unsigned char)*p->pos)) {
+        p->pos++;
+    }
+
+    const char *s = p->pos;
+
+    if (*s == '\0') {
+        p->tok = TOK_END;
+        return;
+    }
+
+    if (isdigit((unsigned char)*s)) {
+        char *end;
+
+        p->num = (int32_t)strtol(s, &end, 10);
+        p->pos = end;
+        p->tok = TOK_NUM;
+        return;
+    }
+
+    if (isalpha((unsigned char)*s) || *s == '_') {
+        unsigned len = 0;
+
+        while (isalnum((unsigned char)*p->pos) || *p->pos == '_') {
+            if (len < SHORT_STR_LEN - 1) {
+                p->text[len++] = *p->pos;
+            }
+            p->pos++;
+        }
+        p->text[len] = '\0';
+        p->tok = TOK_IDENT;
+        return;
+    }
+
+    if (*s == '"') {
+        unsigned len = 0;
+
+        p->pos++;
+        while (*p->pos != '"' && *p->pos != '\0') {
+            if (len < SHORT_STR_LEN - 1) {
+                p->text[len++] = *p->pos;
+            }
+            p->pos++;
+        }
+        p->text[len] = '\0';
+
+        if (*p->pos != '"') {
+            p->tok = TOK_ERROR;
+            return;
+        }
+        p->pos++;
+        p->tok = TOK_STR;
+        return;
+    }
+
+    p->pos++;
+
+    switch (*s) {
+        case '(': p->tok = TOK_LPAREN; return;
+        case ')': p->tok = TOK_RPAREN; return;
+        case ',': p->tok = TOK_COMMA; return;
+        case '+': p->tok = TOK_PLUS; return;
+        case '-': p->tok = TOK_MINUS; return;
+        case '*': p->tok = TOK_MUL; return;
+        case '/': p->tok = TOK_DIV; return;
+        case '=': p->tok = TOK_EQ; return;
+
+        case ':':
+            if (*p->pos == '=') {
+                p->pos++;
+                p->tok = TOK_ASSIGN;
+                return;
+            }
+            break;
+
+        case '<':
+            if (*p->pos == '=') {
+                p->pos++;
+                p->tok = TOK_LE;
+            } else if (*p->pos == '>') {
+                p->pos++;
+                p->tok = TOK_NE;
+            } else {
+                p->tok = TOK_LT;
+            }
+            return;
+
+        case '>':
+            if (*p->pos == '=') {
+                p->pos++;
+                p->tok = TOK_GE;
+            } else {
+                p->tok = TOK_GT;
+            }
+            return;
+    }
+
+    p->tok = TOK_ERROR;
+}
+
+static bool KeywordIs(LogicParser *p, const char *word)
+{
+    return p->tok == TOK_IDENT && !strcmp(p->text, word);
+}
+
+static bool Expect(LogicParser *p, LogicToken tok)
+{
+    if (p->tok != tok) {
+        p->error = true;
+        return false;
+    }
+    TokenNext(p);
+    return true;
+}
+
+static int TempAlloc(LogicParser *p)
+{
+    /**
+     * Temporaries grow down from the top of register file,
+     * variables grow up from the bottom
+     */
+
+    if (p->temp <= p->prog->vars_count) {
+        p->error = true;
+        return -1;
+    }
+    return p->temp--;
+}
+
+static int VarGet(LogicParser *p, const char *name)
+{
+    LogicProgram *prog = p->prog;
+
+    for (unsigned i = 0; i < prog->vars_count; i++) {
+        if (!strcmp(p->vars[i], name)) {
+            return i;
+        }
+    }
+
+    if (prog->vars_count >= p->temp) {
+        p->error = true;
+        return -1;
+    }
+
+    strncpy(p->vars[prog->vars_count], name, SHORT_STR_LEN - 1);
+    return prog->vars_count++;
+}
+
+static int Emit(LogicParser *p, LogicOp op, int dst, int a, int b, int c, int slot, int32_t imm)
+{
+    LogicProgram *prog = p->prog;
+
+    if (p->error || dst < 0 || a < 0 || b < 0 || c < 0 || slot < 0 || prog->code_len >= LOGIC_CODE_MAX - 1) {
+        p->error = true;
+        return -1;
+    }
+
+    LogicInstr *instr = &prog->code[prog->code_len++];
+
+    instr->op = op;
+    instr->dst = dst;
+    instr->a = a;
+    instr->b = b;
+    instr->c = c;
+    instr->slot = slot;
+    instr->imm = imm;
+
+    return dst;
+}
+
+static int IoSlotGet(LogicParser *p, LogicIoType type, void *obj)
+{
+    LogicProgram *prog = p->prog;
+
+    if (obj == NULL) {
+        LogF(LOG_TYPE_ERROR, "LOGIC", "Program \"%s\" unknown I/O \"%s\"", prog->name, p->text);
+        p->error = true;
+        return -1;
+    }
+
+    for (unsigned i = 0; i < prog->io_count; i++) {
+        if (prog->io[i].type == type && prog->io[i].obj == obj) {
+            return i;
+        }
+    }
+
+    if (prog->io_count >= LOGIC_SLOTS_MAX) {
+        p->error = true;
+        return -1;
+    }
+
+    prog->io[prog->io_count].type = type;
+    prog->io[prog->io_count].obj = obj;
+    prog->io[prog->io_count].last = -1;
+
+    return prog->io_count++;
+}
+
+static int IoParse(LogicParser *p, LogicIoType type)
+{
+    void *obj = NULL;
+
+    if (!Expect(p, TOK_LPAREN) || p->tok != TOK_STR) {
+        p->error = true;
+        return -1;
+    }
+
+    switch (type) {
+        case LOGIC_IO_GPIO:
+            obj = GpioPinGet(p->text);
+            break;
+
+        case LOGIC_IO_SOCKET:
+            obj = SocketGet(p->text);
+            break;
+
+        case LOGIC_IO_TANK:
+            obj = TankGet(p->text);
+            break;
+
+        case LOGIC_IO_METEO:
+            obj = MeteoSensorGet(p->text);
+            break;
+    }
+
+    int slot = IoSlotGet(p, type, obj);
+
+    TokenNext(p);
+    Expect(p, TOK_RPAREN);
+
+    return slot;
+}
+
+static int ExprParse(LogicParser *p);
+
+static int32_t PresetParse(LogicParser *p)
+{
+    int32_t val = p->num;
+
+    if (!Expect(p, TOK_NUM)) {
+        return 0;
+    }
+    return val;
+}
+
+static int SlotAlloc(LogicParser *p, unsigned *count)
+{
+    if (*count >= LOGIC_SLOTS_MAX) {
+        p->error = true;
+        return -1;
+    }
+    return (*count)++;
+}
+
+static int CallParse(LogicParser *p, const char *name)
+{
+    LogicProgram    *prog = p->prog;
+    int             a = 0;
+    int             b = 0;
+    int             c = 0;
+    int32_t         pt;
+
+    if (!strcmp(name, "gpio")) {
+        int slot = IoParse(p, LOGIC_IO_GPIO);
+        return Emit(p, LOGIC_OP_GPIO_GET, TempAlloc(p), 0, 0, 0, slot, 0);
+    }
+    if (!strcmp(name, "socket")) {
+        int slot = IoParse(p, LOGIC_IO_SOCKET);
+        return Emit(p, LOGIC_OP_SOCKET_GET, TempAlloc(p), 0, 0, 0, slot, 0);
+    }
+    if (!strcmp(name, "tank")) {
+        int slot = IoParse(p, LOGIC_IO_TANK);
+        return Emit(p, LOGIC_OP_TANK_GET, TempAlloc(p), 0, 0, 0, slot, 0);
+    }
+    if (!strcmp(name, "meteo")) {
+        int slot = IoParse(p, LOGIC_IO_METEO);
+        return Emit(p, LOGIC_OP_METEO_GET, TempAlloc(p), 0, 0, 0, slot, 0);
+    }
+
+    Expect(p, TOK_LPAREN);
+
+    if (!strcmp(name, "TON") || !strcmp(name, "TOF")) {
+        a = ExprParse(p);
+        Expect(p, TOK_COMMA);
+        pt = PresetParse(p);
+        Expect(p, TOK_RPAREN);
+        return Emit(p, (name[2] == 'N') ? LOGIC_OP_TON : LOGIC_OP_TOF, TempAlloc(p), a, 0, 0,
+                    SlotAlloc(p, &prog->timers_count), pt);
+    }
+    if (!strcmp(name, "CTU") || !strcmp(name, "CTD")) {
+        a = ExprParse(p);
+        Expect(p, TOK_COMMA);
+        b = ExprParse(p);
+        Expect(p, TOK_COMMA);
+        pt = PresetParse(p);
+        Expect(p, TOK_RPAREN);
+        return Emit(p, (name[2] == 'U') ? LOGIC_OP_CTU : LOGIC_OP_CTD, TempAlloc(p), a, b, 0,
+                    SlotAlloc(p, &prog->counters_count), pt);
+    }
+    if (!strcmp(name, "R_TRIG")) {
+        a = ExprParse(p);
+        Expect(p, TOK_RPAREN);
+        return Emit(p, LOGIC_OP_RTRIG, TempAlloc(p), a, 0, 0, SlotAlloc(p, &prog->counters_count), 0);
+    }
+    if (!strcmp(name, "SEL")) {
+        a = ExprParse(p);
+        Expect(p, TOK_COMMA);
+        b = ExprParse(p);
+        Expect(p, TOK_COMMA);
+        c = ExprParse(p);
+        Expect(p, TOK_RPAREN);
+        return Emit(p, LOGIC_OP_SEL, TempAlloc(p), a, b, c, 0, 0);
+    }
+
+    LogF(LOG_TYPE_ERROR, "LOGIC", "Program \"%s\" unknown function \"%s\"", prog->name, name);
+    p->error = true;
+    return -1;
+}
+
+static int PrimaryParse(LogicParser *p)
+{
+    char name[SHORT_STR_LEN];
+
+    switch (p->tok) {
+        case TOK_NUM: {
+            int32_t val = p->num;
+            TokenNext(p);
+            return Emit(p, LOGIC_OP_LOADK, TempAlloc(p), 0, 0, 0, 0, val);
+        }
+
+        case TOK_LPAREN: {
+            TokenNext(p);
+            int r = ExprParse(p);
+            Expect(p, TOK_RPAREN);
+            return r;
+        }
+
+        case TOK_IDENT:
+            if (KeywordIs(p, "TRUE") || KeywordIs(p, "FALSE")) {
+                int32_t val = KeywordIs(p, "TRUE");
+                TokenNext(p);
+                return Emit(p, LOGIC_OP_LOADK, TempAlloc(p), 0, 0, 0, 0, val);
+            }
+
+            strncpy(name, p->text, SHORT_STR_LEN);
+            TokenNext(p);
+
+            if (p->tok == TOK_LPAREN) {
+                return CallParse(p, name);
+            }
+            return VarGet(p, name);
+
+        default:
+            p->error = true;
+            return -1;
+    }
+}
+
+static int UnaryParse(LogicParser *p)
+{
+    if (KeywordIs(p, "NOT")) {
+        TokenNext(p);
+        int a = UnaryParse(p);
+        return Emit(p, LOGIC_OP_NOT, TempAlloc(p), a, 0, 0, 0, 0);
+    }
+    if (p->tok == TOK_MINUS) {
+        TokenNext(p);
+        int a = UnaryParse(p);
+        return Emit(p, LOGIC_OP_NEG, TempAlloc(p), a, 0, 0, 0, 0);
+    }
+    return PrimaryParse(p);
+}
+
+static int MulParse(LogicParser *p)
+{
+    int a = UnaryParse(p);
+
+    for (;;) {
+        LogicOp op;
+
+        if (p->tok == TOK_MUL) {
+            op = LOGIC_OP_MUL;
+        } else if (p->tok == TOK_DIV) {
+            op = LOGIC_OP_DIV;
+        } else if (KeywordIs(p, "MOD")) {
+            op = LOGIC_OP_MOD;
+        } else {
+            return a;
+        }
+
+        TokenNext(p);
+        int b = UnaryParse(p);
+        a = Emit(p, op, TempAlloc(p), a, b, 0, 0, 0);
+    }
+}
+
+static int AddParse(LogicParser *p)
+{
+    int a = MulParse(p);
+
+    while (p->tok == TOK_PLUS || p->tok == TOK_MINUS) {
+        LogicOp op = (p->tok == TOK_PLUS) ? LOGIC_OP_ADD : LOGIC_OP_SUB;
+
+        TokenNext(p);
+        int b = MulParse(p);
+        a = Emit(p, op, TempAlloc(p), a, b, 0, 0, 0);
+    }
+    return a;
+}
+
+static int CmpParse(LogicParser *p)
+{
+    int     a = AddParse(p);
+    LogicOp op;
+
+    switch (p->tok) {
+        case TOK_EQ: op = LOGIC_OP_EQ; break;
+        case TOK_NE: op = LOGIC_OP_NE; break;
+        case TOK_LT: op = LOGIC_OP_LT; break;
+        case TOK_LE: op = LOGIC_OP_LE; break;
+        case TOK_GT: op = LOGIC_OP_GT; break;
+        case TOK_GE: op = LOGIC_OP_GE; break;
+        default: return a;
+    }
+
+    TokenNext(p);
+    int b = AddParse(p);
+    return Emit(p, op, TempAlloc(p), a, b, 0, 0, 0);
+}
+
+static int AndParse(LogicParser *p)
+{
+    int a = CmpParse(p);
+
+    while (KeywordIs(p, "AND")) {
+        TokenNext(p);
+        int b = CmpParse(p);
+        a = Emit(p, LOGIC_OP_AND, TempAlloc(p), a, b, 0, 0, 0);
+    }
+    return a;
+}
+
+static int XorParse(LogicParser *p)
+{
+    int a = AndParse(p);
+
+    while (KeywordIs(p, "XOR")) {
+        TokenNext(p);
+        int b = AndParse(p);
+        a = Emit(p, LOGIC_OP_XOR, TempAlloc(p), a, b, 0, 0, 0);
+    }
+    return a;
+}
+
+static int ExprParse(LogicParser *p)
+{
+    int a = XorParse(p);
+
+    while (KeywordIs(p, "OR")) {
+        TokenNext(p);
+        int b = XorParse(p);
+        a = Emit(p, LOGIC_OP_OR, TempAlloc(p), a, b, 0, 0, 0);
+    }
+    return a;
+}
+
+static bool StatementParse(LogicParser *p)
+{
+    LogicProgram    *prog = p->prog;
+    char            name[SHORT_STR_LEN];
+    int             out_slot = -1;
+    LogicOp         out_op = LOGIC_OP_END;
+    int             dst = -1;
+
+    p->temp = LOGIC_REGS_MAX - 1;
+    TokenNext(p);
+
+    if (p->tok != TOK_IDENT) {
+        return false;
+    }
+
+    strncpy(name, p->text, SHORT_STR_LEN);
+    TokenNext(p);
+
+    if (p->tok == TOK_LPAREN) {
+        if (!strcmp(name, "gpio")) {
+            out_slot = IoParse(p, LOGIC_IO_GPIO);
+            out_op = LOGIC_OP_GPIO_SET;
+        } else if (!strcmp(name, "socket")) {
+            out_slot = IoParse(p, LOGIC_IO_SOCKET);
+            out_op = LOGIC_OP_SOCKET_SET;
+        } else {
+            return false;
+        }
+    } else {
+        dst = VarGet(p, name);
+    }
+
+    if (!Expect(p, TOK_ASSIGN)) {
+        return false;
+    }
+
+    unsigned    start = prog->code_len;
+    int         r = ExprParse(p);
+
+    if (p->error || p->tok != TOK_END) {
+        return false;
+    }
+
+    if (out_op != LOGIC_OP_END) {
+        return Emit(p, out_op, 0, r, 0, 0, out_slot, 0) >= 0;
+    }
+
+    /**
+     * Store result directly to variable when it was produced
+     * by the last instruction of this statement
+     */
+
+    if (r > (int)p->temp && prog->code_len > start && prog->code[prog->code_len - 1].dst == r) {
+        prog->code[prog->code_len - 1].dst = dst;
+        return true;
+    }
+
+    return Emit(p, LOGIC_OP_MOV, dst, r, 0, 0, 0, 0) >= 0;
+}
+
+static void ProgramTask(PeriodicTask *task, void *data)
+{
+    LogicProgramScan((LogicProgram *)data, UtilsMonoNsGet() / 1000000ULL);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PUBLIC  FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+LogicProgram *LogicProgramCompile(const char *name, unsigned period_ms, const char **lines, unsigned count)
+{
+    LogicProgram    *prog = (LogicProgram *)calloc(1, sizeof(LogicProgram));
+    LogicParser     *p = (LogicParser *)calloc(1, sizeof(LogicParser));
+
+    strncpy(prog->name, name, SHORT_STR_LEN - 1);
+    prog->period_ms = (period_ms != 0) ? period_ms : LOGIC_PERIOD_MS_DEFAULT;
+    p->prog = prog;
+
+    for (unsigned i = 0; i < count; i++) {
+        p->pos = lines[i];
+
+        if (!StatementParse(p)) {
+            LogF(LOG_TYPE_ERROR, "LOGIC", "Program \"%s\" syntax error in statement %u: %s", name, i + 1, lines[i]);
+            free(p);
+            free(prog);
+            return NULL;
+        }
+    }
+
+    prog->code[prog->code_len].op = LOGIC_OP_END;
+    free(p);
+
+    LogF(LOG_TYPE_INFO, "LOGIC", "Program \"%s\" compiled to %u instructions", name, prog->code_len);
+
+    return prog;
+}
+
+void LogicProgramAdd(LogicProgram *prog)
+{
+    Logic.programs = g_list_append(Logic.programs, (void *)prog);
+}
+
+void LogicProgramScan(LogicProgram *prog, uint64_t now_ms)
+{
+    int32_t *r = prog->regs;
+
+    for (const LogicInstr *i = prog->code;; i++) {
+        switch (i->op) {
+            case LOGIC_OP_END:
+                prog->scans++;
+                return;
+
+            case LOGIC_OP_LOADK:
+                r[i->dst] = i->imm;
+                break;
+
+            case LOGIC_OP_MOV:
+                r[i->dst] = r[i->a];
+                break;
+
+            case LOGIC_OP_NOT:
+                r[i->dst] = (r[i->a] == 0);
+                break;
+
+            case LOGIC_OP_NEG:
+                r[i->dst] = (int32_t)(-(int64_t)r[i->a]);
+                break;
+
+            case LOGIC_OP_AND:
+                r[i->dst] = (r[i->a] != 0 && r[i->b] != 0);
+                break;
+
+            case LOGIC_OP_OR:
+                r[i->dst] = (r[i->a] != 0 || r[i->b] != 0);
+                break;
+
+            case LOGIC_OP_XOR:
+                r[i->dst] = ((r[i->a] != 0) != (r[i->b] != 0));
+                break;
+
+            /**
+             * Arithmetic is done in 64 bits to avoid signed overflow
+             */
+
+            case LOGIC_OP_ADD:
+                r[i->dst] = (int32_t)((int64_t)r[i->a] + r[i->b]);
+                break;
+
+            case LOGIC_OP_SUB:
+                r[i->dst] = (int32_t)((int64_t)r[i->a] - r[i->b]);
+                break;
+
+            case LOGIC_OP_MUL:
+                r[i->dst] = (int32_t)((int64_t)r[i->a] * r[i->b]);
+                break;
+
+            case LOGIC_OP_DIV:
+                r[i->dst] = (r[i->b] != 0) ? (int32_t)((int64_t)r[i->a] / r[i->b]) : 0;
+                break;
+
+            case LOGIC_OP_MOD:
+                r[i->dst] = (r[i->b] != 0) ? (int32_t)((int64_t)r[i->a] % r[i->b]) : 0;
+                break;
+
+            case LOGIC_OP_EQ:
+                r[i->dst] = (r[i->a] == r[i->b]);
+                break;
+
+            case LOGIC_OP_NE:
+                r[i->dst] = (r[i->a] != r[i->b]);
+                break;
+
+            case LOGIC_OP_LT:
+                r[i->dst] = (r[i->a] < r[i->b]);
+                break;
+
+            case LOGIC_OP_LE:
+                r[i->dst] = (r[i->a] <= r[i->b]);
+                break;
+
+            case LOGIC_OP_GT:
+                r[i->dst] = (r[i->a] > r[i->b]);
+                break;
+
+            case LOGIC_OP_GE:
+                r[i->dst] = (r[i->a] >= r[i->b]);
+                break;
+
+            case LOGIC_OP_SEL:
+                r[i->dst] = (r[i->a] != 0) ? r[i->b] : r[i->c];
+                break;
+
+            case LOGIC_OP_TON: {
+                LogicTimer  *t = &prog->timers[i->slot];
+                bool        in = (r[i->a] != 0);
+
+                if (in && !t->in) {
+                    t->start = now_ms;
+                }
+                t->q = in && (now_ms - t->start >= (uint64_t)i->imm);
+                t->in = in;
+                r[i->dst] = t->q;
+                break;
+            }
+
+            case LOGIC_OP_TOF: {
+                LogicTimer  *t = &prog->timers[i->slot];
+                bool        in = (r[i->a] != 0);
+
+                if (in) {
+                    t->q = true;
+                } else {
+                    if (t->in) {
+                        t->start = now_ms;
+                    }
+                    if (t->q && now_ms - t->start >= (uint64_t)i->imm) {
+                        t->q = false;
+                    }
+                }
+                t->in = in;
+                r[i->dst] = t->q;
+                break;
+            }
+
+            case LOGIC_OP_CTU: {
+                LogicCounter    *cnt = &prog->counters[i->slot];
+                bool            in = (r[i->a] != 0);
+
+                if (r[i->b] != 0) {
+                    cnt->cv = 0;
+                } else if (in && !cnt->in && cnt->cv < INT32_MAX) {
+                    cnt->cv++;
+                }
+                cnt->in = in;
+                r[i->dst] = (cnt->cv >= i->imm);
+                break;
+            }
+
+            case LOGIC_OP_CTD: {
+                LogicCounter    *cnt = &prog->counters[i->slot];
+                bool            in = (r[i->a] != 0);
+
+                if (r[i->b] != 0) {
+                    cnt->cv = i->imm;
+                } else if (in && !cnt->in && cnt->cv > INT32_MIN) {
+                    cnt->cv--;
+                }
+                cnt->in = in;
+                r[i->dst] = (cnt->cv <= 0);
+                break;
+            }
+
+            case LOGIC_OP_RTRIG: {
+                LogicCounter    *cnt = &prog->counters[i->slot];
+                bool            in = (r[i->a] != 0);
+
+                r[i->dst] = (in && !cnt->in);
+                cnt->in = in;
+                break;
+            }
+
+            case LOGIC_OP_GPIO_GET: {
+                bool state;
+
+                if (GpioPinRead((GpioPin *)prog->io[i->slot].obj, &state)) {
+                    r[i->dst] = state;
+                }
+                break;
+            }
+
+            /**
+             * Outputs are written on change only, so manual switching
+             * is kept until program result changes again
+             */
+
+            case LOGIC_OP_GPIO_SET: {
+                LogicIo *io = &prog->io[i->slot];
+                int32_t val = (r[i->a] != 0);
+
+                if (io->last != val) {
+                    io->last = val;
+                    GpioPinWrite((GpioPin *)io->obj, val);
+                }
+                break;
+            }
+
+            case LOGIC_OP_SOCKET_GET:
+                r[i->dst] = SocketStatusGet((Socket *)prog->io[i->slot].obj);
+                break;
+
+            case LOGIC_OP_SOCKET_SET: {
+                LogicIo *io = &prog->io[i->slot];
+                int32_t val = (r[i->a] != 0);
+
+                if (io->last != val) {
+                    io->last = val;
+                    SocketStatusSet((Socket *)io->obj, val, true);
+                }
+                break;
+            }
+
+            case LOGIC_OP_TANK_GET: {
+                TankState state;
+
+                TankStateGet((Tank *)prog->io[i->slot].obj, &state);
+                r[i->dst] = state.level;
+                break;
+            }
+
+            /**
+             * Temperature is passed in tenths of degree
+             */
+
+            case LOGIC_OP_METEO_GET: {
+                MeteoSensorState state;
+
+                MeteoSensorStateGet((MeteoSensor *)prog->io[i->slot].obj, &state);
+                r[i->dst] = (int32_t)(state.temp * 10.0f);
+                break;
+            }
+        }
+    }
+}
+
+bool LogicStart()
+{
+    for (GList *l = Logic.programs; l != NULL; l = l->next) {
+        LogicProgram *prog = (LogicProgram *)l->data;
+
+        if (!ReactorTaskAdd(prog->name, prog->period_ms, &ProgramTask, (void *)prog)) {
+            LogF(LOG_TYPE_ERROR, "LOGIC", "Failed to start program \"%s\"", prog->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LogicBenchmark()
+{
+    LogicProgram *prog = LogicProgramCompile("bench", 0, BenchLines, sizeof(BenchLines) / sizeof(BenchLines[0]));
+
+    if (prog == NULL) {
+        return false;
+    }
+
+    uint64_t start = UtilsMonoNsGet();
+
+    for (unsigned i = 0; i < LOGIC_BENCH_SCANS; i++) {
+        LogicProgramScan(prog, i);
+    }
+
+    uint64_t    ns = UtilsMonoNsGet() - start;
+    uint64_t    instrs = (uint64_t)LOGIC_BENCH_SCANS * (prog->code_len + 1);
+
+    LogPrintF(LOG_TYPE_INFO, "LOGIC", "%u scans of %u instructions in %llu us",
+              LOGIC_BENCH_SCANS, prog->code_len + 1, (unsigned long long)(ns / 1000));
+    LogPrintF(LOG_TYPE_INFO, "LOGIC", "%.1f instructions per microsecond, %.3f us per scan",
+              (double)instrs * 1000.0 / (double)ns, (double)ns / 1000.0 / LOGIC_BENCH_SCANS);
+
+    free(prog);
+    return true;
+}
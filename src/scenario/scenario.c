@@ -10,7 +10,47 @@
 
 #include <scenario/scenario.h>
 #include <utils/log.h>
+#include <utils/jobs.h>
 #include <stack/rpc.h>
+#include <plc/reactor.h>
+#include <controllers/socket.h>
+#include <controllers/security.h>
+#include <controllers/tank.h>
+#include <controllers/waterer.h>
+#include <controllers/meteo.h>
+
+#include <stdlib.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    char    name[SHORT_STR_LEN];
+    GList   *rules;
+} ScenarioGroup;
+
+typedef struct {
+    unsigned        unit;
+    RpcBatchAction  actions[RPC_BATCH_MAX];
+    unsigned        index[RPC_BATCH_MAX];
+    unsigned        count;
+    Job             *job;
+} ScenarioBatch;
+
+static struct {
+    GList           *manual[SCENARIO_TYPE_MAX];
+    GList           *index[EVENT_TYPE_MAX];
+    unsigned        mask;
+    EventSubscriber *sub;
+} Scenarios = {
+    .manual = {NULL},
+    .index = {NULL},
+    .mask = 0x0,
+    .sub = NULL
+};
 
 /*********************************************************************/
 /*                                                                   */
@@ -18,7 +58,357 @@
 /*                                                                   */
 /*********************************************************************/
 
-GList *scenarios = NULL;
+static bool TestCheck(const ScenarioTest *test, float value)
+{
+    switch (test->cmp) {
+        case SCENARIO_CMP_EQ:
+            return value == test->value;
+
+        case SCENARIO_CMP_NE:
+            return value != test->value;
+
+        case SCENARIO_CMP_LT:
+            return value < test->value;
+
+        case SCENARIO_CMP_LE:
+            return value <= test->value;
+
+        case SCENARIO_CMP_GT:
+            return value > test->value;
+
+        case SCENARIO_CMP_GE:
+            return value >= test->value;
+    }
+    return false;
+}
+
+static bool EventValueGet(const Event *event, ScenarioField field, float *value)
+{
+    switch (event->type) {
+        case EVENT_SOCKET_CHANGED:
+            if (field == SCENARIO_FIELD_STATUS) {
+                *value = event->socket.status;
+                return true;
+            }
+            break;
+
+        case EVENT_TANK_LEVEL_CHANGED:
+            if (field == SCENARIO_FIELD_LEVEL) {
+                *value = event->tank_level.level;
+                return true;
+            }
+            break;
+
+        case EVENT_TANK_STATE_CHANGED:
+            if (field == SCENARIO_FIELD_STATUS) {
+                *value = event->tank_state.status;
+                return true;
+            } else if (field == SCENARIO_FIELD_PUMP) {
+                *value = event->tank_state.pump;
+                return true;
+            } else if (field == SCENARIO_FIELD_VALVE) {
+                *value = event->tank_state.valve;
+                return true;
+            }
+            break;
+
+        case EVENT_WATERER_CHANGED:
+            if (field == SCENARIO_FIELD_STATUS) {
+                *value = event->waterer.status;
+                return true;
+            } else if (field == SCENARIO_FIELD_VALVE) {
+                *value = event->waterer.valve;
+                return true;
+            }
+            break;
+
+        case EVENT_SECURITY_CHANGED:
+            if (field == SCENARIO_FIELD_STATUS) {
+                *value = event->security.status;
+                return true;
+            } else if (field == SCENARIO_FIELD_ALARM) {
+                *value = event->security.alarm;
+                return true;
+            }
+            break;
+
+        case EVENT_METEO_CHANGED:
+            if (field == SCENARIO_FIELD_TEMP) {
+                *value = event->meteo.temp;
+                return true;
+            } else if (field == SCENARIO_FIELD_ERROR) {
+                *value = event->meteo.error;
+                return true;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return false;
+}
+
+static bool ConditionValueGet(const ScenarioCondition *cond, float *value)
+{
+    switch (cond->ctrl) {
+        case SCENARIO_CTRL_SOCKET:
+            if (cond->test.field == SCENARIO_FIELD_STATUS) {
+                *value = SocketStatusGet((Socket *)cond->obj);
+                return true;
+            }
+            break;
+
+        case SCENARIO_CTRL_SECURITY:
+            if (cond->test.field == SCENARIO_FIELD_STATUS) {
+                *value = SecurityStatusGet();
+                return true;
+            } else if (cond->test.field == SCENARIO_FIELD_ALARM) {
+                *value = SecurityAlarmGet();
+                return true;
+            }
+            break;
+
+        case SCENARIO_CTRL_TANK: {
+            TankState state;
+
+            TankStateGet((Tank *)cond->obj, &state);
+
+            switch (cond->test.field) {
+                case SCENARIO_FIELD_STATUS: *value = state.status; return true;
+                case SCENARIO_FIELD_LEVEL: *value = state.level; return true;
+                case SCENARIO_FIELD_PUMP: *value = state.pump; return true;
+                case SCENARIO_FIELD_VALVE: *value = state.valve; return true;
+                default: break;
+            }
+            break;
+        }
+
+        case SCENARIO_CTRL_WATERER: {
+            WatererState state;
+
+            WatererStateGet((Waterer *)cond->obj, &state);
+
+            switch (cond->test.field) {
+                case SCENARIO_FIELD_STATUS: *value = state.status; return true;
+                case SCENARIO_FIELD_VALVE: *value = state.valve; return true;
+                default: break;
+            }
+            break;
+        }
+
+        case SCENARIO_CTRL_METEO: {
+            MeteoSensorState state;
+
+            MeteoSensorStateGet((MeteoSensor *)cond->obj, &state);
+
+            switch (cond->test.field) {
+                case SCENARIO_FIELD_TEMP: *value = state.temp; return true;
+                case SCENARIO_FIELD_ERROR: *value = state.error; return true;
+                default: break;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return false;
+}
+
+static void *ConditionObjGet(const ScenarioCondition *cond)
+{
+    switch (cond->ctrl) {
+        case SCENARIO_CTRL_SOCKET:
+            return SocketGet(cond->name);
+
+        case SCENARIO_CTRL_TANK:
+            return TankGet(cond->name);
+
+        case SCENARIO_CTRL_WATERER:
+            return WatererGet(cond->name);
+
+        case SCENARIO_CTRL_METEO:
+            return MeteoSensorGet(cond->name);
+
+        default:
+            return NULL;
+    }
+}
+
+static bool ActionCmdGet(const ScenarioAction *action, RpcBatchCmd *cmd)
+{
+    switch (action->ctrl) {
+        case SCENARIO_CTRL_SOCKET:
+            *cmd = RPC_BATCH_SOCKET_STATUS;
+            return action->field == SCENARIO_FIELD_STATUS;
+
+        case SCENARIO_CTRL_SECURITY:
+            if (action->field == SCENARIO_FIELD_ALARM) {
+                *cmd = RPC_BATCH_SECURITY_ALARM;
+                return true;
+            }
+            *cmd = RPC_BATCH_SECURITY_STATUS;
+            return action->field == SCENARIO_FIELD_STATUS;
+
+        case SCENARIO_CTRL_TANK:
+            if (action->field == SCENARIO_FIELD_PUMP) {
+                *cmd = RPC_BATCH_TANK_PUMP;
+                return true;
+            } else if (action->field == SCENARIO_FIELD_VALVE) {
+                *cmd = RPC_BATCH_TANK_VALVE;
+                return true;
+            }
+            *cmd = RPC_BATCH_TANK_STATUS;
+            return action->field == SCENARIO_FIELD_STATUS;
+
+        case SCENARIO_CTRL_WATERER:
+            if (action->field == SCENARIO_FIELD_VALVE) {
+                *cmd = RPC_BATCH_WATERER_VALVE;
+                return true;
+            }
+            *cmd = RPC_BATCH_WATERER_STATUS;
+            return action->field == SCENARIO_FIELD_STATUS;
+
+        default:
+            return false;
+    }
+}
+
+static ScenarioBatch *BatchGet(ScenarioBatch *batches, unsigned *count, unsigned unit)
+{
+    for (unsigned i = 0; i < *count; i++) {
+        if (batches[i].unit == unit && batches[i].count < RPC_BATCH_MAX) {
+            return &batches[i];
+        }
+    }
+
+    ScenarioBatch *batch = &batches[(*count)++];
+
+    batch->unit = unit;
+    return batch;
+}
+
+static bool BatchJob(void *data)
+{
+    ScenarioBatch *batch = (ScenarioBatch *)data;
+
+    return RpcBatchRun(batch->unit, batch->actions, batch->count);
+}
+
+static bool RuleJob(void *data)
+{
+    ScenarioRule    *rule = (ScenarioRule *)data;
+    ScenarioResult  result;
+    bool            ret = ScenarioActionsRun(rule->actions, &result);
+
+    LogF((ret) ? LOG_TYPE_INFO : LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" done: %u/%u actions in %u requests, %llu us",
+         rule->name, result.count - result.failed, result.count, result.requests, (unsigned long long)result.latency_us);
+
+    return ret;
+}
+
+/**
+ * @brief Remember whether trigger test matched last event of source, empty
+ * trigger name matches every source, so edge is kept per source name
+ *
+ * @return Previous match of source
+ */
+static bool RuleMatchedSwap(ScenarioRule *rule, const char *source, bool matched)
+{
+    GList *item = g_list_find_custom(rule->matched, source, (GCompareFunc)&strcmp);
+
+    if (matched && item == NULL) {
+        char *name = (char *)calloc(1, SHORT_STR_LEN);
+
+        strncpy(name, source, SHORT_STR_LEN - 1);
+        rule->matched = g_list_append(rule->matched, (void *)name);
+    } else if (!matched && item != NULL) {
+        free(item->data);
+        rule->matched = g_list_delete_link(rule->matched, item);
+    }
+
+    return (item != NULL);
+}
+
+static void RuleCheck(ScenarioRule *rule, const Event *event)
+{
+    float   value;
+    bool    fire;
+
+    if (rule->trigger.test.field == SCENARIO_FIELD_ANY) {
+        fire = true;
+    } else {
+        if (!EventValueGet(event, rule->trigger.test.field, &value)) {
+            return;
+        }
+
+        /**
+         * Rule fires when trigger test becomes true, so repeated
+         * events on the same side of threshold are ignored
+         */
+
+        bool matched = TestCheck(&rule->trigger.test, value);
+
+        fire = !RuleMatchedSwap(rule, event->name, matched) && matched;
+    }
+
+    if (!fire) {
+        return;
+    }
+
+    for (GList *c = rule->conditions; c != NULL; c = c->next) {
+        ScenarioCondition *cond = (ScenarioCondition *)c->data;
+
+        if (!ConditionValueGet(cond, &value) || !TestCheck(&cond->test, value)) {
+            return;
+        }
+    }
+
+    LogF(LOG_TYPE_INFO, "SCENARIO", "Rule \"%s\" triggered by \"%s\"", rule->name, event->name);
+
+    if (!JobRun("scenario", JOB_PRIO_NORMAL, &RuleJob, (void *)rule)) {
+        LogF(LOG_TYPE_ERROR, "SCENARIO", "Failed to queue rule \"%s\"", rule->name);
+    }
+}
+
+static void EventsProcess(int fd, void *data)
+{
+    Event event;
+
+    EventReset(Scenarios.sub);
+
+    while (EventPop(Scenarios.sub, &event)) {
+        for (GList *g = Scenarios.index[event.type]; g != NULL; g = g->next) {
+            ScenarioGroup *group = (ScenarioGroup *)g->data;
+
+            if (group->name[0] != '\0' && strcmp(group->name, event.name)) {
+                continue;
+            }
+
+            for (GList *r = group->rules; r != NULL; r = r->next) {
+                RuleCheck((ScenarioRule *)r->data, &event);
+            }
+        }
+    }
+}
+
+static ScenarioGroup *GroupGet(EventType type, const char *name)
+{
+    for (GList *g = Scenarios.index[type]; g != NULL; g = g->next) {
+        ScenarioGroup *group = (ScenarioGroup *)g->data;
+
+        if (!strcmp(group->name, name)) {
+            return group;
+        }
+    }
+
+    ScenarioGroup *group = (ScenarioGroup *)calloc(1, sizeof(ScenarioGroup));
+
+    strncpy(group->name, name, SHORT_STR_LEN - 1);
+    Scenarios.index[type] = g_list_append(Scenarios.index[type], (void *)group);
+
+    return group;
+}
 
 /*********************************************************************/
 /*                                                                   */
@@ -28,22 +418,187 @@ GList *scenarios = NULL;
 
 void ScenarioAdd(Scenario *scenario)
 {
-    scenarios = g_list_append(scenarios, (void *)scenario);
+    ScenarioAction *action = (ScenarioAction *)calloc(1, sizeof(ScenarioAction));
+
+    action->ctrl = scenario->ctrl;
+    action->field = SCENARIO_FIELD_STATUS;
+    action->unit = scenario->unit;
+    action->status = scenario->socket.status;
+    strncpy(action->name, scenario->socket.name, SHORT_STR_LEN - 1);
+
+    Scenarios.manual[scenario->type] = g_list_append(Scenarios.manual[scenario->type], (void *)action);
+    free(scenario);
 }
 
 bool ScenarioStart(ScenarioType type)
 {
-    for (GList *s = scenarios; s != NULL; s = s->next) {
-        Scenario *scenario = (Scenario *)s->data;
+    ScenarioResult  result;
+    bool            ret = ScenarioActionsRun(Scenarios.manual[type], &result);
+
+    LogF(LOG_TYPE_INFO, "SCENARIO", "Scenario done: %u/%u actions in %u requests, %llu us",
+         result.count - result.failed, result.count, result.requests, (unsigned long long)result.latency_us);
+
+    return ret;
+}
+
+bool ScenarioActionsRun(GList *actions, ScenarioResult *result)
+{
+    unsigned        batches_count = 0;
+    unsigned        i = 0;
+    uint64_t        start = UtilsMonoNsGet();
+
+    memset(result, 0x0, sizeof(ScenarioResult));
+    result->count = g_list_length(actions);
+
+    if (result->count == 0) {
+        return true;
+    }
+
+    if (result->count > SCENARIO_ACTIONS_MAX) {
+        LogF(LOG_TYPE_ERROR, "SCENARIO", "Too many actions: %u", result->count);
+        result->failed = result->count;
+        return false;
+    }
+
+    ScenarioBatch *batches = (ScenarioBatch *)calloc(result->count, sizeof(ScenarioBatch));
+
+    for (GList *a = actions; a != NULL; a = a->next, i++) {
+        ScenarioAction  *action = (ScenarioAction *)a->data;
+        RpcBatchCmd     cmd;
+
+        if (!ActionCmdGet(action, &cmd)) {
+            continue;
+        }
 
-        if (scenario->type == type) {
-            if (scenario->ctrl == SECURITY_CTRL_SOCKET) {
-                if (!RpcSocketStatusSet(scenario->unit, scenario->socket.name, scenario->socket.status)) {
-                    LogF(LOG_TYPE_ERROR, "SCENARIO", "Failed to switch socket \"%s\" status for unit \"%u\"", scenario->socket.name, scenario->unit);
-                }
+        ScenarioBatch   *batch = BatchGet(batches, &batches_count, action->unit);
+        RpcBatchAction  *act = &batch->actions[batch->count];
+
+        act->cmd = cmd;
+        act->status = action->status;
+        strncpy(act->name, action->name, SHORT_STR_LEN - 1);
+        batch->index[batch->count++] = i;
+    }
+
+    for (unsigned b = 0; b < batches_count; b++) {
+        batches[b].job = JobSubmit("scenario", JOB_PRIO_HIGH, &BatchJob, NULL, (void *)&batches[b]);
+    }
+
+    /**
+     * Caller may be a job worker itself, so batches not yet taken by
+     * workers are cancelled and run here. Walk from the tail which
+     * workers reach last.
+     */
+
+    for (unsigned b = batches_count; b-- > 0;) {
+        ScenarioBatch *batch = &batches[b];
+
+        if (batch->job == NULL || JobCancel(batch->job)) {
+            BatchJob((void *)batch);
+        } else {
+            JobAwait(batch->job, NULL);
+        }
+
+        if (batch->job != NULL) {
+            JobRelease(batch->job);
+        }
+
+        for (unsigned k = 0; k < batch->count; k++) {
+            result->results[batch->index[k]] = batch->actions[k].result;
+        }
+    }
+
+    i = 0;
+    for (GList *a = actions; a != NULL; a = a->next, i++) {
+        ScenarioAction *action = (ScenarioAction *)a->data;
+
+        if (!result->results[i]) {
+            LogF(LOG_TYPE_ERROR, "SCENARIO", "Failed to set \"%s\" status for unit \"%u\"", action->name, action->unit);
+            result->failed++;
+        }
+    }
+
+    result->requests = batches_count;
+    result->latency_us = (UtilsMonoNsGet() - start) / 1000;
+    free(batches);
+
+    return result->failed == 0;
+}
+
+ScenarioRule *ScenarioRuleNew(const char *name)
+{
+    ScenarioRule *rule = (ScenarioRule *)calloc(1, sizeof(ScenarioRule));
+
+    strncpy(rule->name, name, SHORT_STR_LEN - 1);
+    rule->trigger.test.field = SCENARIO_FIELD_ANY;
+
+    return rule;
+}
+
+bool ScenarioRuleAdd(ScenarioRule *rule)
+{
+    Event   event = { .type = rule->trigger.event };
+    float   value;
+
+    if (rule->trigger.event >= EVENT_TYPE_MAX) {
+        LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" has invalid trigger event", rule->name);
+        return false;
+    }
+
+    if (rule->trigger.test.field != SCENARIO_FIELD_ANY && !EventValueGet(&event, rule->trigger.test.field, &value)) {
+        LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" trigger field is not provided by event", rule->name);
+        return false;
+    }
+
+    for (GList *c = rule->conditions; c != NULL; c = c->next) {
+        ScenarioCondition *cond = (ScenarioCondition *)c->data;
+
+        if (cond->ctrl != SCENARIO_CTRL_SECURITY) {
+            cond->obj = ConditionObjGet(cond);
+            if (cond->obj == NULL) {
+                LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" condition object \"%s\" not found", rule->name, cond->name);
+                return false;
             }
         }
+
+        if (!ConditionValueGet(cond, &value)) {
+            LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" condition field is not provided by \"%s\"", rule->name, cond->name);
+            return false;
+        }
     }
 
+    if (g_list_length(rule->actions) > SCENARIO_ACTIONS_MAX) {
+        LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" has too many actions", rule->name);
+        return false;
+    }
+
+    for (GList *a = rule->actions; a != NULL; a = a->next) {
+        ScenarioAction  *action = (ScenarioAction *)a->data;
+        RpcBatchCmd     cmd;
+
+        if (!ActionCmdGet(action, &cmd)) {
+            LogF(LOG_TYPE_ERROR, "SCENARIO", "Rule \"%s\" has invalid action for \"%s\"", rule->name, action->name);
+            return false;
+        }
+    }
+
+    ScenarioGroup *group = GroupGet(rule->trigger.event, rule->trigger.name);
+
+    group->rules = g_list_append(group->rules, (void *)rule);
+    Scenarios.mask |= EVENT_MASK(rule->trigger.event);
+
     return true;
 }
+
+bool ScenarioRulesStart()
+{
+    if (Scenarios.mask == 0x0) {
+        return true;
+    }
+
+    Scenarios.sub = EventSubscribe("scenario", Scenarios.mask);
+    if (Scenarios.sub == NULL) {
+        return false;
+    }
+
+    return ReactorFdAdd(EventFdGet(Scenarios.sub), &EventsProcess, NULL);
+}
@@ -0,0 +1,148 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stack/breaker.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+
+#include <stdlib.h>
+#include <threads.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef enum {
+    BREAKER_CLOSED,
+    BREAKER_OPEN,
+    BREAKER_HALF_OPEN
+} BreakerState;
+
+typedef struct {
+    unsigned        unit;
+    BreakerState    state;
+    unsigned        failures;
+    unsigned        open_ms;
+    uint64_t        retry_ns;
+} Breaker;
+
+static struct {
+    once_flag   once;
+    mtx_t       mtx;
+    GList       *breakers;
+} Breakers = {
+    .once = ONCE_FLAG_INIT,
+    .breakers = NULL
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void BreakersInit()
+{
+    mtx_init(&Breakers.mtx, mtx_plain);
+}
+
+static Breaker *BreakerGet(unsigned unit)
+{
+    for (GList *b = Breakers.breakers; b != NULL; b = b->next) {
+        Breaker *breaker = (Breaker *)b->data;
+
+        if (breaker->unit == unit) {
+            return breaker;
+        }
+    }
+
+    Breaker *breaker = (Breaker *)calloc(1, sizeof(Breaker));
+
+    breaker->unit = unit;
+    breaker->state = BREAKER_CLOSED;
+    breaker->open_ms = BREAKER_OPEN_MS;
+    Breakers.breakers = g_list_append(Breakers.breakers, (void *)breaker);
+
+    return breaker;
+}
+
+static void BreakerOpen(Breaker *breaker)
+{
+    breaker->state = BREAKER_OPEN;
+    breaker->retry_ns = UtilsMonoNsGet() + (uint64_t)breaker->open_ms * 1000000;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool BreakerAllow(unsigned unit)
+{
+    bool ret = true;
+
+    call_once(&Breakers.once, &BreakersInit);
+
+    mtx_lock(&Breakers.mtx);
+    Breaker *breaker = BreakerGet(unit);
+
+    switch (breaker->state) {
+        case BREAKER_CLOSED:
+            break;
+
+        case BREAKER_OPEN:
+            if (UtilsMonoNsGet() >= breaker->retry_ns) {
+                breaker->state = BREAKER_HALF_OPEN;
+            } else {
+                ret = false;
+            }
+            break;
+
+        case BREAKER_HALF_OPEN:
+            /**
+             * Probe is in flight, others wait for its result
+             */
+            ret = false;
+            break;
+    }
+    mtx_unlock(&Breakers.mtx);
+
+    return ret;
+}
+
+void BreakerResult(unsigned unit, bool result)
+{
+    call_once(&Breakers.once, &BreakersInit);
+
+    mtx_lock(&Breakers.mtx);
+    Breaker *breaker = BreakerGet(unit);
+
+    if (result) {
+        if (breaker->state != BREAKER_CLOSED) {
+            LogF(LOG_TYPE_INFO, "BREAKER", "Unit %u answered, requests are resumed", unit);
+        }
+        breaker->state = BREAKER_CLOSED;
+        breaker->failures = 0;
+        breaker->open_ms = BREAKER_OPEN_MS;
+    } else if (breaker->state == BREAKER_HALF_OPEN) {
+        breaker->open_ms *= 2;
+        if (breaker->open_ms > BREAKER_OPEN_MAX_MS) {
+            breaker->open_ms = BREAKER_OPEN_MAX_MS;
+        }
+        BreakerOpen(breaker);
+    } else if (breaker->state == BREAKER_CLOSED && ++breaker->failures >= BREAKER_FAILURES) {
+        BreakerOpen(breaker);
+        LogF(LOG_TYPE_ERROR, "BREAKER", "Unit %u failed %u requests, requests are cut off", unit, breaker->failures);
+    }
+    mtx_unlock(&Breakers.mtx);
+}
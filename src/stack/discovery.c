@@ -0,0 +1,304 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stack/discovery.h>
+#include <stack/stack.h>
+#include <stack/rpc.h>
+#include <stack/statelog.h>
+#include <stack/replica.h>
+#include <net/web/webserver.h>
+#include <plc/reactor.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <jansson.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    unsigned    unit;
+    uint64_t    seen_ns;
+} DiscoveryPeer;
+
+static struct {
+    bool                enabled;
+    char                group[SHORT_STR_LEN];
+    unsigned            port;
+    unsigned            period_ms;
+    unsigned            missed;
+    bool                announce;
+    unsigned            id;
+    char                name[SHORT_STR_LEN];
+    unsigned            web_port;
+    unsigned            channel;
+    int                 fd;
+    struct sockaddr_in  addr;
+    mtx_t               mtx;
+    GList               *peers;
+} Discovery = {
+    .enabled = false,
+    .group = DISCOVERY_GROUP,
+    .port = DISCOVERY_PORT,
+    .period_ms = DISCOVERY_PERIOD_MS,
+    .missed = DISCOVERY_MISSED,
+    .announce = false,
+    .fd = -1,
+    .peers = NULL
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static DiscoveryPeer *PeerGet(unsigned unit)
+{
+    for (GList *p = Discovery.peers; p != NULL; p = p->next) {
+        DiscoveryPeer *peer = (DiscoveryPeer *)p->data;
+
+        if (peer->unit == unit) {
+            return peer;
+        }
+    }
+
+    DiscoveryPeer *peer = (DiscoveryPeer *)calloc(1, sizeof(DiscoveryPeer));
+
+    peer->unit = unit;
+    Discovery.peers = g_list_append(Discovery.peers, (void *)peer);
+
+    return peer;
+}
+
+static void HeartbeatSend()
+{
+    json_t *root = json_object();
+
+    json_object_set_new(root, "id", json_integer(Discovery.id));
+    json_object_set_new(root, "name", json_string(Discovery.name));
+    json_object_set_new(root, "port", json_integer(Discovery.web_port));
+    json_object_set_new(root, "channel", json_integer(Discovery.channel));
+    json_object_set_new(root, "api", json_string(SERVER_API_VER));
+    json_object_set_new(root, "version", json_integer(StateVersionGet()));
+
+    char *out = json_dumps(root, JSON_COMPACT);
+
+    if (sendto(Discovery.fd, out, strlen(out), 0, (struct sockaddr *)&Discovery.addr, sizeof(Discovery.addr)) < 0) {
+        Log(LOG_TYPE_ERROR, "DISCOVERY", "Failed to send heartbeat");
+    }
+
+    free(out);
+    json_decref(root);
+}
+
+static void HeartbeatProcess(const char *data, const char *ip)
+{
+    json_error_t    error;
+    json_t          *root = json_loads(data, 0, &error);
+
+    if (root == NULL) {
+        return;
+    }
+
+    unsigned    id = json_integer_value(json_object_get(root, "id"));
+    const char  *name = json_string_value(json_object_get(root, "name"));
+    const char  *api = json_string_value(json_object_get(root, "api"));
+
+    if (name == NULL || api == NULL || strcmp(api, SERVER_API_VER) ||
+        id == RPC_DEFAULT_UNIT || strnlen(name, SHORT_STR_LEN) >= SHORT_STR_LEN ||
+        (Discovery.announce && id == Discovery.id)) {
+        json_decref(root);
+        return;
+    }
+
+    bool joined = false;
+
+    mtx_lock(&Discovery.mtx);
+    StackLock();
+
+    StackUnit *unit = StackUnitGet(id);
+
+    /**
+     * Units from configs and units behind sub-masters are not announced,
+     * heartbeat can not take their ID or move them
+     */
+
+    if (unit != NULL && !unit->announced) {
+        StackUnlock();
+        mtx_unlock(&Discovery.mtx);
+        json_decref(root);
+        return;
+    }
+
+    if (unit == NULL) {
+        unit = StackUnitNew(id, name, ip, json_integer_value(json_object_get(root, "port")));
+        StackUnitAdd(unit);
+        LogF(LOG_TYPE_INFO, "DISCOVERY", "Unit \"%s\" joined stack from %s", unit->name, ip);
+        joined = true;
+    } else if (strcmp(unit->ip, ip)) {
+        LogF(LOG_TYPE_INFO, "DISCOVERY", "Unit \"%s\" moved to %s", unit->name, ip);
+        strncpy(unit->ip, ip, SHORT_STR_LEN - 1);
+    }
+
+    unit->channel = json_integer_value(json_object_get(root, "channel"));
+    unit->version = json_integer_value(json_object_get(root, "version"));
+    unit->announced = true;
+    PeerGet(id)->seen_ns = UtilsMonoNsGet();
+
+    if (!unit->active) {
+        unit->active = true;
+        LogF(LOG_TYPE_INFO, "DISCOVERY", "Unit \"%s\" is online", unit->name);
+    }
+
+    StackUnlock();
+    mtx_unlock(&Discovery.mtx);
+    json_decref(root);
+
+    if (joined) {
+        ReplicaUnitAdd(id);
+    }
+}
+
+static void SocketProcess(int fd, void *data)
+{
+    char                buf[BUFFER_LEN_MAX];
+    char                ip[SHORT_STR_LEN];
+    struct sockaddr_in  from;
+    socklen_t           from_len = sizeof(from);
+
+    for (;;) {
+        ssize_t len = recvfrom(fd, buf, BUFFER_LEN_MAX - 1, 0, (struct sockaddr *)&from, &from_len);
+
+        if (len < 0) {
+            break;
+        }
+
+        buf[len] = '\0';
+        inet_ntop(AF_INET, &from.sin_addr, ip, SHORT_STR_LEN);
+        HeartbeatProcess(buf, ip);
+        from_len = sizeof(from);
+    }
+}
+
+static void DiscoveryTask(PeriodicTask *task, void *data)
+{
+    uint64_t timeout_ns = (uint64_t)Discovery.period_ms * Discovery.missed * 1000000;
+
+    if (Discovery.announce) {
+        HeartbeatSend();
+    }
+
+    mtx_lock(&Discovery.mtx);
+    StackLock();
+
+    for (GList *p = Discovery.peers; p != NULL; p = p->next) {
+        DiscoveryPeer   *peer = (DiscoveryPeer *)p->data;
+        StackUnit       *unit = StackUnitGet(peer->unit);
+
+        if (unit != NULL && unit->active && UtilsMonoNsGet() - peer->seen_ns > timeout_ns) {
+            unit->active = false;
+            LogF(LOG_TYPE_INFO, "DISCOVERY", "Unit \"%s\" is offline, %u heartbeats missed",
+                 unit->name, Discovery.missed);
+        }
+    }
+
+    StackUnlock();
+    mtx_unlock(&Discovery.mtx);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+void DiscoverySet(const char *group, unsigned port, unsigned period_ms, unsigned missed)
+{
+    strncpy(Discovery.group, group, SHORT_STR_LEN - 1);
+    Discovery.port = port;
+    Discovery.period_ms = period_ms;
+    Discovery.missed = missed;
+    Discovery.enabled = true;
+}
+
+void DiscoveryUnitSet(unsigned id, const char *name, unsigned port, unsigned channel)
+{
+    Discovery.id = id;
+    strncpy(Discovery.name, name, SHORT_STR_LEN - 1);
+    Discovery.web_port = port;
+    Discovery.channel = channel;
+    Discovery.announce = true;
+}
+
+bool DiscoveryStart()
+{
+    struct sockaddr_in  addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_ANY) };
+    struct ip_mreq      mreq;
+    int                 one = 1;
+
+    if (!Discovery.enabled) {
+        return true;
+    }
+
+    if (mtx_init(&Discovery.mtx, mtx_plain) != thrd_success) {
+        return false;
+    }
+
+    Discovery.addr.sin_family = AF_INET;
+    Discovery.addr.sin_port = htons(Discovery.port);
+    if (inet_pton(AF_INET, Discovery.group, &Discovery.addr.sin_addr) != 1) {
+        LogF(LOG_TYPE_ERROR, "DISCOVERY", "Invalid multicast group \"%s\"", Discovery.group);
+        return false;
+    }
+
+    Discovery.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (Discovery.fd < 0) {
+        return false;
+    }
+
+    setsockopt(Discovery.fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    addr.sin_port = htons(Discovery.port);
+    if (bind(Discovery.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        Log(LOG_TYPE_ERROR, "DISCOVERY", "Failed to bind discovery socket");
+        close(Discovery.fd);
+        return false;
+    }
+
+    mreq.imr_multiaddr = Discovery.addr.sin_addr;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(Discovery.fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        Log(LOG_TYPE_ERROR, "DISCOVERY", "Failed to join multicast group");
+        close(Discovery.fd);
+        return false;
+    }
+
+    fcntl(Discovery.fd, F_SETFL, fcntl(Discovery.fd, F_GETFL) | O_NONBLOCK);
+
+    if (!ReactorFdAdd(Discovery.fd, &SocketProcess, NULL)) {
+        return false;
+    }
+
+    return ReactorTaskAdd("discovery", Discovery.period_ms, &DiscoveryTask, NULL);
+}
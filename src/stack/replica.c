@@ -0,0 +1,470 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stack/replica.h>
+#include <stack/stack.h>
+#include <plc/reactor.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    unsigned        unit;
+    bool            synced;
+    uint64_t        updated_ns;
+    unsigned        writes;
+    unsigned        applied;
+    RpcUnitState    state;
+    bool            busy;
+    uint64_t        version;
+    unsigned        wait;
+    unsigned        sent_writes;
+    uint64_t        sent_ns;
+    uint64_t        retry_ns;
+} Replica;
+
+static struct {
+    mtx_t   mtx;
+    bool    started;
+    GList   *replicas;
+} Replicas = {
+    .started = false,
+    .replicas = NULL
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static Replica *ReplicaGet(unsigned unit)
+{
+    for (GList *r = Replicas.replicas; r != NULL; r = r->next) {
+        Replica *replica = (Replica *)r->data;
+
+        if (replica->unit == unit) {
+            return replica;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get replica which can serve reads: unit is online, its
+ * subscription answered recently and no writes are pending
+ */
+static Replica *FreshGet(unsigned unit)
+{
+    Replica     *replica = ReplicaGet(unit);
+    StackUnit   u;
+
+    if (replica == NULL || !StackUnitCopy(unit, &u) || !u.active || !replica->synced) {
+        return NULL;
+    }
+
+    if (replica->writes != replica->applied) {
+        return NULL;
+    }
+
+    if ((UtilsMonoNsGet() - replica->updated_ns) / 1000000 > REPLICA_STALE_MS) {
+        return NULL;
+    }
+
+    return replica;
+}
+
+static void WatererFree(void *data)
+{
+    RpcWaterer *waterer = (RpcWaterer *)data;
+
+    g_list_free_full(waterer->times, &free);
+    free(waterer);
+}
+
+static void *ItemCopy(const void *src, void *size)
+{
+    void *item = malloc(GPOINTER_TO_UINT(size));
+
+    memcpy(item, src, GPOINTER_TO_UINT(size));
+    return item;
+}
+
+static void *WatererCopy(const void *src, void *data)
+{
+    RpcWaterer *waterer = (RpcWaterer *)ItemCopy(src, GUINT_TO_POINTER(sizeof(RpcWaterer)));
+
+    waterer->times = g_list_copy_deep(waterer->times, (GCopyFunc)&ItemCopy,
+                                      GUINT_TO_POINTER(sizeof(RpcWatererTime)));
+    return waterer;
+}
+
+/**
+ * @brief Append copies of mirrored list to out list, like Rpc*Get do
+ */
+static bool ListGet(unsigned unit, size_t offset, void *(*copy)(const void *, void *), void *data, GList **out)
+{
+    if (!Replicas.started) {
+        return false;
+    }
+
+    mtx_lock(&Replicas.mtx);
+
+    Replica *replica = FreshGet(unit);
+    if (replica == NULL) {
+        mtx_unlock(&Replicas.mtx);
+        return false;
+    }
+
+    GList *list = *(GList **)((char *)&replica->state + offset);
+
+    for (GList *l = list; l != NULL; l = l->next) {
+        *out = g_list_append(*out, copy(l->data, data));
+    }
+
+    mtx_unlock(&Replicas.mtx);
+    return true;
+}
+
+/**
+ * @brief Replace objects of list by changed ones with same name. All
+ * RPC objects start with name field, so name is compared directly.
+ */
+static void ListMerge(GList **list, GList *changes, GDestroyNotify free_func)
+{
+    for (GList *c = changes; c != NULL; c = c->next) {
+        GList *item = g_list_find_custom(*list, c->data, (GCompareFunc)&strcmp);
+
+        if (item != NULL) {
+            free_func(item->data);
+            item->data = c->data;
+        } else {
+            *list = g_list_append(*list, c->data);
+        }
+    }
+
+    g_list_free(changes);
+}
+
+static void StateMerge(Replica *replica, RpcUnitState *state)
+{
+    RpcUnitState *dst = &replica->state;
+
+    if (!state->delta) {
+        RpcUnitStateFree(dst);
+        *dst = *state;
+        return;
+    }
+
+    dst->version = state->version;
+    if (state->security_changed) {
+        dst->security_status = state->security_status;
+        dst->security_alarm = state->security_alarm;
+    }
+
+    ListMerge(&dst->security_sensors, state->security_sensors, &free);
+    ListMerge(&dst->meteo_sensors, state->meteo_sensors, &free);
+    ListMerge(&dst->sockets, state->sockets, &free);
+    ListMerge(&dst->tanks, state->tanks, &free);
+    ListMerge(&dst->waterers, state->waterers, &WatererFree);
+}
+
+static void ReplicaDone(bool result, RpcUnitState *state, void *data);
+
+/**
+ * @brief Send next long-poll request of replica, reply comes to
+ * ReplicaDone, so no thread waits for unit changes
+ */
+static void ReplicaSubscribe(Replica *replica)
+{
+    mtx_lock(&Replicas.mtx);
+    uint64_t version = replica->version;
+    unsigned wait = replica->wait;
+    replica->sent_writes = replica->writes;
+    replica->sent_ns = UtilsMonoNsGet();
+    replica->busy = true;
+    mtx_unlock(&Replicas.mtx);
+
+    if (!RpcUnitChangesAsync(replica->unit, version, wait, &ReplicaDone, (void *)replica)) {
+        ReplicaDone(false, NULL, (void *)replica);
+    }
+}
+
+static void ReplicaDone(bool result, RpcUnitState *state, void *data)
+{
+    Replica     *replica = (Replica *)data;
+    uint64_t    now = UtilsMonoNsGet();
+
+    mtx_lock(&Replicas.mtx);
+
+    if (!result) {
+        if (replica->synced) {
+            replica->synced = false;
+            LogF(LOG_TYPE_ERROR, "REPLICA", "Lost state subscription of Unit %d", replica->unit);
+        }
+
+        replica->version = 0;
+        replica->wait = REPLICA_WAIT_MS;
+        replica->retry_ns = now + (uint64_t)REPLICA_RETRY_MS * 1000000;
+        replica->busy = false;
+        mtx_unlock(&Replicas.mtx);
+        return;
+    }
+
+    bool unchanged = (state->delta && state->version == replica->version);
+    bool fast = ((now - replica->sent_ns) / 1000000 < REPLICA_WAIT_MS / 2);
+    bool waited = (replica->wait > 0);
+
+    StateMerge(replica, state);
+    replica->updated_ns = now;
+    replica->applied = replica->sent_writes;
+    if (!replica->synced) {
+        replica->synced = true;
+        LogF(LOG_TYPE_INFO, "REPLICA", "State of Unit %d is synced", replica->unit);
+    }
+
+    /**
+     * Writes made during long-poll may be not in this reply, so
+     * mirror is fetched once more without waiting
+     */
+
+    replica->version = replica->state.version;
+    replica->wait = (replica->writes != replica->sent_writes) ? 0 : REPLICA_WAIT_MS;
+
+    /**
+     * Unit replies at once without changes when all its workers
+     * are busy, so subscription is repeated later by replica task
+     * instead of spin
+     */
+
+    if (unchanged && waited && fast) {
+        replica->retry_ns = now + (uint64_t)REPLICA_RETRY_MS * 1000000;
+        replica->busy = false;
+        mtx_unlock(&Replicas.mtx);
+        return;
+    }
+
+    mtx_unlock(&Replicas.mtx);
+
+    ReplicaSubscribe(replica);
+}
+
+/**
+ * @brief Restart subscriptions which failed or were postponed
+ */
+static void ReplicaTask(PeriodicTask *task, void *data)
+{
+    GList       *idle = NULL;
+    uint64_t    now = UtilsMonoNsGet();
+
+    mtx_lock(&Replicas.mtx);
+    for (GList *r = Replicas.replicas; r != NULL; r = r->next) {
+        Replica *replica = (Replica *)r->data;
+
+        if (!replica->busy && now >= replica->retry_ns) {
+            replica->busy = true;
+            idle = g_list_append(idle, (void *)replica);
+        }
+    }
+    mtx_unlock(&Replicas.mtx);
+
+    for (GList *r = idle; r != NULL; r = r->next) {
+        ReplicaSubscribe((Replica *)r->data);
+    }
+
+    g_list_free(idle);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool ReplicaStart()
+{
+    if (mtx_init(&Replicas.mtx, mtx_plain) != thrd_success) {
+        return false;
+    }
+
+    GList *units = NULL;
+
+    Replicas.started = true;
+
+    if (!ReactorJobTaskAdd("replica", REPLICA_RETRY_MS, &ReplicaTask, NULL)) {
+        return false;
+    }
+
+    StackLock();
+    for (GList *u = *StackUnitsGet(); u != NULL; u = u->next) {
+        units = g_list_append(units, GUINT_TO_POINTER(((StackUnit *)u->data)->id));
+    }
+    StackUnlock();
+
+    for (GList *u = units; u != NULL; u = u->next) {
+        if (!ReplicaUnitAdd(GPOINTER_TO_UINT(u->data))) {
+            g_list_free(units);
+            return false;
+        }
+    }
+
+    g_list_free(units);
+    return true;
+}
+
+bool ReplicaUnitAdd(unsigned unit)
+{
+    if (!Replicas.started) {
+        return false;
+    }
+
+    /**
+     * Local unit is read directly, so it is not mirrored
+     */
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        return true;
+    }
+
+    Replica *replica = (Replica *)calloc(1, sizeof(Replica));
+
+    replica->unit = unit;
+    replica->wait = REPLICA_WAIT_MS;
+    replica->busy = true;
+
+    mtx_lock(&Replicas.mtx);
+    Replicas.replicas = g_list_append(Replicas.replicas, (void *)replica);
+    mtx_unlock(&Replicas.mtx);
+
+    ReplicaSubscribe(replica);
+
+    return true;
+}
+
+bool ReplicaStateGet(unsigned unit, RpcUnitState *state)
+{
+    memset(state, 0x0, sizeof(RpcUnitState));
+
+    if (!Replicas.started) {
+        return false;
+    }
+
+    mtx_lock(&Replicas.mtx);
+
+    Replica *replica = ReplicaGet(unit);
+    if (replica == NULL || !replica->synced) {
+        mtx_unlock(&Replicas.mtx);
+        return false;
+    }
+
+    *state = replica->state;
+    state->security_sensors = g_list_copy_deep(state->security_sensors, (GCopyFunc)&ItemCopy,
+                                               GUINT_TO_POINTER(sizeof(RpcSecuritySensor)));
+    state->meteo_sensors = g_list_copy_deep(state->meteo_sensors, (GCopyFunc)&ItemCopy,
+                                            GUINT_TO_POINTER(sizeof(RpcMeteoSensor)));
+    state->sockets = g_list_copy_deep(state->sockets, (GCopyFunc)&ItemCopy,
+                                      GUINT_TO_POINTER(sizeof(RpcSocket)));
+    state->tanks = g_list_copy_deep(state->tanks, (GCopyFunc)&ItemCopy,
+                                    GUINT_TO_POINTER(sizeof(RpcTank)));
+    state->waterers = g_list_copy_deep(state->waterers, (GCopyFunc)&WatererCopy, NULL);
+
+    mtx_unlock(&Replicas.mtx);
+    return true;
+}
+
+void ReplicaWriteNotify(unsigned unit)
+{
+    if (!Replicas.started) {
+        return;
+    }
+
+    mtx_lock(&Replicas.mtx);
+
+    Replica *replica = ReplicaGet(unit);
+    if (replica != NULL) {
+        replica->writes++;
+    }
+
+    mtx_unlock(&Replicas.mtx);
+}
+
+bool ReplicaSecurityStatusGet(unsigned unit, bool *status)
+{
+    if (!Replicas.started) {
+        return false;
+    }
+
+    mtx_lock(&Replicas.mtx);
+
+    Replica *replica = FreshGet(unit);
+    if (replica != NULL) {
+        *status = replica->state.security_status;
+    }
+
+    mtx_unlock(&Replicas.mtx);
+    return (replica != NULL);
+}
+
+bool ReplicaSecurityAlarmGet(unsigned unit, bool *alarm)
+{
+    if (!Replicas.started) {
+        return false;
+    }
+
+    mtx_lock(&Replicas.mtx);
+
+    Replica *replica = FreshGet(unit);
+    if (replica != NULL) {
+        *alarm = replica->state.security_alarm;
+    }
+
+    mtx_unlock(&Replicas.mtx);
+    return (replica != NULL);
+}
+
+bool ReplicaSecuritySensorsGet(unsigned unit, GList **sensors)
+{
+    return ListGet(unit, offsetof(RpcUnitState, security_sensors), &ItemCopy,
+                   GUINT_TO_POINTER(sizeof(RpcSecuritySensor)), sensors);
+}
+
+bool ReplicaMeteoSensorsGet(unsigned unit, GList **sensors)
+{
+    return ListGet(unit, offsetof(RpcUnitState, meteo_sensors), &ItemCopy,
+                   GUINT_TO_POINTER(sizeof(RpcMeteoSensor)), sensors);
+}
+
+bool ReplicaSocketsGet(unsigned unit, GList **sockets)
+{
+    return ListGet(unit, offsetof(RpcUnitState, sockets), &ItemCopy,
+                   GUINT_TO_POINTER(sizeof(RpcSocket)), sockets);
+}
+
+bool ReplicaTanksGet(unsigned unit, GList **tanks)
+{
+    return ListGet(unit, offsetof(RpcUnitState, tanks), &ItemCopy,
+                   GUINT_TO_POINTER(sizeof(RpcTank)), tanks);
+}
+
+bool ReplicaWaterersGet(unsigned unit, GList **waterers)
+{
+    return ListGet(unit, offsetof(RpcUnitState, waterers), &WatererCopy, NULL, waterers);
+}
@@ -19,12 +19,462 @@
 #include <net/web/webserver.h>
 #include <utils/utils.h>
 #include <stack/stack.h>
+#include <stack/statelog.h>
+#include <stack/replica.h>
+#include <stack/statecodec.h>
+#include <stack/breaker.h>
+#include <plc/plc.h>
+#include <net/channel.h>
 #include <cam/camera.h>
+#include <utils/jobs.h>
 
 #include <stdlib.h>
 
 #include <jansson.h>
 
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+/**
+ * @brief Get request path with query from URL
+ */
+static const char *UrlPathGet(const char *url)
+{
+    const char *host = strstr(url, "://");
+    const char *path = strchr((host != NULL) ? host + 3 : url, '/');
+
+    return (path != NULL) ? path : "/";
+}
+
+/**
+ * @brief Get unit which request is sent to. Unit behind sub-masters is
+ * reached through first sub-master of its path with route param.
+ *
+ * @param unit Request target unit
+ * @param path Request path with query
+ * @param route Out request path for next hop
+ * @param hop Out next hop unit copy
+ *
+ * @return True if next hop is known
+ */
+static bool RouteGet(const StackUnit *unit, const char *path, char *route, StackUnit *hop)
+{
+    if (unit->hops == 0) {
+        strncpy(route, path, STR_LEN - 1);
+        route[STR_LEN - 1] = '\0';
+        memcpy(hop, unit, sizeof(StackUnit));
+        return true;
+    }
+
+    snprintf(route, STR_LEN, "%s%croute=%u", path, (strchr(path, '?') != NULL) ? '&' : '?', unit->id);
+
+    return StackUnitCopy(unit->path[0], hop);
+}
+
+/**
+ * @brief Run requests in parallel, requests to units with channel are
+ * pipelined into channels, others go by HTTP. Requests to units cut
+ * off by breaker fail at once. Target is taken from units, not from
+ * URL, since units behind different sub-masters may share addresses,
+ * only URL path is sent to the next hop of unit.
+ */
+static void MultiRequest(const unsigned *targets, WebClientReq *reqs, unsigned count, unsigned timeout_ms)
+{
+    char            route[STR_LEN];
+    StackUnit       unit, hop;
+    unsigned        http_count = 0;
+    uint64_t        start = UtilsMonoNsGet();
+
+    if (count == 0) {
+        return;
+    }
+
+    ChannelCall     **calls = (ChannelCall **)calloc(count, sizeof(ChannelCall *));
+    WebClientReq    *http = (WebClientReq *)calloc(count, sizeof(WebClientReq));
+    unsigned        *index = (unsigned *)calloc(count, sizeof(unsigned));
+    bool            *channel = (bool *)calloc(count, sizeof(bool));
+    bool            *breaker = (bool *)calloc(count, sizeof(bool));
+    unsigned        *units = (unsigned *)calloc(count, sizeof(unsigned));
+
+    for (unsigned i = 0; i < count; i++) {
+        reqs[i].result = false;
+        reqs[i].out_len = 0;
+
+        if (!StackUnitCopy(targets[i], &unit) || !BreakerAllow(unit.id)) {
+            continue;
+        }
+        units[i] = unit.id;
+        breaker[i] = true;
+
+        if (!RouteGet(&unit, UrlPathGet(reqs[i].url), route, &hop)) {
+            continue;
+        }
+
+        if (hop.channel != 0) {
+            calls[i] = ChannelCallStart(hop.ip, hop.channel, route, reqs[i].post);
+            channel[i] = true;
+        } else {
+            http[http_count] = reqs[i];
+            snprintf(http[http_count].url, STR_LEN, "http://%s:%d%s", hop.ip, hop.port, route);
+            index[http_count++] = i;
+        }
+    }
+
+    if (http_count > 0) {
+        WebClientMultiRequest(http, http_count, timeout_ms);
+    }
+
+    for (unsigned h = 0; h < http_count; h++) {
+        reqs[index[h]].result = http[h].result;
+        reqs[index[h]].out_len = http[h].out_len;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        uint64_t    elapsed_ms = (UtilsMonoNsGet() - start) / 1000000;
+        unsigned    left_ms = (elapsed_ms < timeout_ms) ? timeout_ms - elapsed_ms : 0;
+        size_t      size = (reqs[i].out_size > 0) ? reqs[i].out_size : BUFFER_LEN_MAX;
+
+        if (channel[i]) {
+            reqs[i].result = ChannelCallWait(calls[i], reqs[i].out, size, &reqs[i].out_len, left_ms);
+        }
+
+        if (breaker[i]) {
+            BreakerResult(units[i], reqs[i].result);
+        }
+    }
+
+    free(units);
+    free(breaker);
+    free(channel);
+    free(index);
+    free(http);
+    free(calls);
+}
+
+/**
+ * @brief Single request with RPC_TIMEOUT_MS deadline
+ */
+static bool Request(unsigned unit, WebRequestType type, const char *url, const char *post, char *out)
+{
+    WebClientReq req = {
+        .type = type,
+        .post = post,
+        .out = out,
+        .out_size = BUFFER_LEN_MAX
+    };
+
+    strncpy(req.url, url, STR_LEN - 1);
+    MultiRequest(&unit, &req, 1, RPC_TIMEOUT_MS);
+
+    return req.result;
+}
+
+static bool WriteRequest(unsigned unit, WebRequestType type, const char *url, const char *post, char *out)
+{
+    bool ret = Request(unit, type, url, post, out);
+
+    /**
+     * Mirror may not have this write until next push from unit,
+     * so reads go to unit directly meanwhile
+     */
+
+    ReplicaWriteNotify(unit);
+    return ret;
+}
+
+typedef struct _RpcAsync RpcAsync;
+
+struct _RpcAsync {
+    unsigned        unit;
+    WebClientReq    req;
+    char            *post;
+    void            (*done)(RpcAsync *async);
+    RpcStateFunc    state_func;
+    RpcRouteFunc    route_func;
+    void            *data;
+};
+
+static void AsyncFree(RpcAsync *async)
+{
+    free(async->req.out);
+    free(async->post);
+    free(async);
+}
+
+/**
+ * @brief Finish async request on job pool, so reactor and web client
+ * threads only move bytes
+ */
+static bool AsyncJob(void *data)
+{
+    RpcAsync    *async = (RpcAsync *)data;
+    bool        ret = async->req.result;
+
+    BreakerResult(async->unit, ret);
+    async->done(async);
+    AsyncFree(async);
+
+    return ret;
+}
+
+static void AsyncFinish(RpcAsync *async)
+{
+    if (!JobRun("rpc_async", JOB_PRIO_NORMAL, &AsyncJob, (void *)async)) {
+        AsyncJob((void *)async);
+    }
+}
+
+static void AsyncChannelDone(bool result, char *payload, size_t len, void *data)
+{
+    RpcAsync *async = (RpcAsync *)data;
+
+    free(async->req.out);
+    async->req.out = payload;
+    async->req.out_len = len;
+    async->req.result = result && len < async->req.out_size;
+
+    AsyncFinish(async);
+}
+
+static void AsyncHttpDone(WebClientReq *req, void *data)
+{
+    AsyncFinish((RpcAsync *)data);
+}
+
+/**
+ * @brief Start request like MultiRequest, but reply is passed to done
+ * function of request instead of waiting for it
+ *
+ * @return False if request was not started, async is freed then
+ */
+static bool AsyncStart(RpcAsync *async, const char *path, unsigned timeout_ms)
+{
+    char        route[STR_LEN];
+    StackUnit   unit, hop;
+    bool        started = false;
+
+    if (async->unit == RPC_DEFAULT_UNIT || !StackUnitCopy(async->unit, &unit) || !BreakerAllow(unit.id)) {
+        AsyncFree(async);
+        return false;
+    }
+
+    async->req.type = (async->post != NULL) ? WEB_REQ_POST : WEB_REQ_GET;
+    async->req.post = async->post;
+    async->req.out_size = RPC_STATE_BUF_LEN;
+    async->req.out = (char *)malloc(RPC_STATE_BUF_LEN);
+
+    if (RouteGet(&unit, path, route, &hop)) {
+        if (hop.channel != 0) {
+            started = ChannelCallAsync(hop.ip, hop.channel, route, async->post, timeout_ms,
+                                       &AsyncChannelDone, (void *)async);
+        } else {
+            snprintf(async->req.url, STR_LEN, "http://%s:%d%s", hop.ip, hop.port, route);
+            started = WebClientAsyncRequest(&async->req, timeout_ms, &AsyncHttpDone, (void *)async);
+        }
+    }
+
+    if (!started) {
+        BreakerResult(unit.id, false);
+        AsyncFree(async);
+    }
+
+    return started;
+}
+
+static json_t *ReplyParse(const WebClientReq *req)
+{
+    json_error_t error;
+
+    if (!req->result) {
+        return NULL;
+    }
+
+    json_t *root = json_loads(req->out, 0, &error);
+    if (root == NULL) {
+        return NULL;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return NULL;
+    }
+
+    return root;
+}
+
+static void SecuritySensorsParse(json_t *root, GList **sensors)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "sensors"), index, value) {
+        RpcSecuritySensor *s = (RpcSecuritySensor *)calloc(1, sizeof(RpcSecuritySensor));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        s->detected = json_boolean_value(json_object_get(value, "detected"));
+        s->type = json_integer_value(json_object_get(value, "type"));
+
+        *sensors = g_list_append(*sensors, s);
+    }
+}
+
+static void AlarmsParse(json_t *root, GList **alarms)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "alarms"), index, value) {
+        RpcAlarm *a = (RpcAlarm *)calloc(1, sizeof(RpcAlarm));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(a->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        a->state = json_integer_value(json_object_get(value, "state"));
+
+        *alarms = g_list_append(*alarms, a);
+    }
+}
+
+static void AlarmRecordsParse(json_t *root, GList **records)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "history"), index, value) {
+        RpcAlarmRecord *r = (RpcAlarmRecord *)calloc(1, sizeof(RpcAlarmRecord));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(r->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        r->action = json_integer_value(json_object_get(value, "action"));
+        r->state = json_integer_value(json_object_get(value, "state"));
+        r->time = json_integer_value(json_object_get(value, "time"));
+
+        *records = g_list_append(*records, r);
+    }
+}
+
+static void MeteoSensorsParse(json_t *root, GList **sensors)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "sensors"), index, value) {
+        RpcMeteoSensor *s = (RpcMeteoSensor *)calloc(1, sizeof(RpcMeteoSensor));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        switch (json_integer_value(json_object_get(value, "type"))) {
+            case RPC_METEO_SENSOR_DS18B20:
+                s->type = RPC_METEO_SENSOR_DS18B20;
+                s->ds18b20.temp = (float)json_real_value(json_object_get(json_object_get(value, "ds18b20"), "temp"));
+                break;
+        }
+
+        *sensors = g_list_append(*sensors, (void *)s);
+    }
+}
+
+static void SocketsParse(json_t *root, GList **sockets)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "sockets"), index, value) {
+        RpcSocket   *s = (RpcSocket *)calloc(1, sizeof(RpcSocket));
+        const char  *group = json_string_value(json_object_get(value, "group"));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        s->status = json_boolean_value(json_object_get(value, "status"));
+
+        if (group != NULL && !strcmp(group, "light")) {
+            s->group = RPC_SOCKET_GROUP_LIGHT;
+        } else if (group != NULL && !strcmp(group, "socket")) {
+            s->group = RPC_SOCKET_GROUP_SOCKET;
+        }
+
+        *sockets = g_list_append(*sockets, (void *)s);
+    }
+}
+
+static void TanksParse(json_t *root, GList **tanks)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(root, "tanks"), index, value) {
+        RpcTank *t = (RpcTank *)calloc(1, sizeof(RpcTank));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(t->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        t->status = json_boolean_value(json_object_get(value, "status"));
+        t->level = json_integer_value(json_object_get(value, "level"));
+        t->pump = json_boolean_value(json_object_get(value, "pump"));
+        t->valve = json_boolean_value(json_object_get(value, "valve"));
+
+        *tanks = g_list_append(*tanks, (void *)t);
+    }
+}
+
+static void WaterersParse(json_t *root, GList **waterers)
+{
+    size_t  index, ext_index;
+    json_t  *value, *ext_value;
+
+    json_array_foreach(json_object_get(root, "waterers"), index, value) {
+        RpcWaterer *t = (RpcWaterer *)calloc(1, sizeof(RpcWaterer));
+
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(t->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        t->status = json_boolean_value(json_object_get(value, "status"));
+        t->valve = json_boolean_value(json_object_get(value, "valve"));
+        t->times = NULL;
+
+        json_array_foreach(json_object_get(value, "times"), ext_index, ext_value) {
+            RpcWatererTime *tm = (RpcWatererTime *)malloc(sizeof(RpcWatererTime));
+
+            tm->day = json_integer_value(json_object_get(ext_value, "day"));
+            tm->hour = json_integer_value(json_object_get(ext_value, "hour"));
+            tm->min = json_integer_value(json_object_get(ext_value, "min"));
+            tm->state = json_integer_value(json_object_get(ext_value, "state"));
+            t->times = g_list_append(t->times, (void *)tm);
+        }
+
+        *waterers = g_list_append(*waterers, (void *)t);
+    }
+}
+
+static WebClientReq *ReqsNew(unsigned count)
+{
+    WebClientReq    *reqs = (WebClientReq *)calloc(count, sizeof(WebClientReq));
+    char            *bufs = (char *)calloc(count, BUFFER_LEN_MAX);
+
+    for (unsigned i = 0; i < count; i++) {
+        reqs[i].type = WEB_REQ_GET;
+        reqs[i].out = bufs + i * BUFFER_LEN_MAX;
+    }
+
+    return reqs;
+}
+
+static void ReqsFree(WebClientReq *reqs, unsigned count)
+{
+    if (count > 0) {
+        free(reqs[0].out);
+    }
+    free(reqs);
+}
+
 /*********************************************************************/
 /*                                                                   */
 /*                          PUBLIC FUNCTIONS                         */
@@ -33,29 +483,569 @@
 
 /*********************************************************************/
 /*                                                                   */
-/*                           STACK MANAGMENT                         */
+/*                           STACK MANAGMENT                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool RpcUnitStatusCheck(unsigned unit)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/", u.ip, u.port);
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    json_decref(root);
+    return true;
+}
+
+void RpcUnitsStatusCheck(RpcUnitCheck *checks, unsigned count, unsigned timeout_ms)
+{
+    unsigned        reqs_count = 0;
+
+    if (count == 0) {
+        return;
+    }
+
+    unsigned        *index = (unsigned *)calloc(count, sizeof(unsigned));
+    unsigned        *units = (unsigned *)calloc(count, sizeof(unsigned));
+    WebClientReq    *reqs = ReqsNew(count);
+
+    for (unsigned i = 0; i < count; i++) {
+        checks[i].online = (checks[i].unit == RPC_DEFAULT_UNIT);
+
+        StackUnit u;
+        if (checks[i].online || !StackUnitCopy(checks[i].unit, &u)) {
+            continue;
+        }
+
+        snprintf(reqs[reqs_count].url, STR_LEN, "http://%s:%d/", u.ip, u.port);
+        units[reqs_count] = checks[i].unit;
+        index[reqs_count++] = i;
+    }
+
+    MultiRequest(units, reqs, reqs_count, timeout_ms);
+
+    for (unsigned r = 0; r < reqs_count; r++) {
+        json_t *root = ReplyParse(&reqs[r]);
+
+        if (root != NULL) {
+            checks[index[r]].online = true;
+            json_decref(root);
+        }
+    }
+
+    ReqsFree(reqs, count);
+    free(units);
+    free(index);
+}
+
+bool RpcStackUnitsGet(unsigned unit, GList **units)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    size_t          index, path_index;
+    json_t          *value, *hop;
+    json_error_t    error;
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        StackLock();
+        for (GList *u = *StackUnitsGet(); u != NULL; u = u->next) {
+            StackUnit       *su = (StackUnit *)u->data;
+            RpcStackUnit    *s = (RpcStackUnit *)calloc(1, sizeof(RpcStackUnit));
+
+            if (su->id == RPC_DEFAULT_UNIT) {
+                free(s);
+                continue;
+            }
+
+            s->id = su->id;
+            strncpy(s->name, su->name, SHORT_STR_LEN - 1);
+            strncpy(s->ip, su->ip, SHORT_STR_LEN - 1);
+            s->port = su->port;
+            s->active = su->active;
+            s->hops = su->hops;
+            memcpy(s->path, su->path, sizeof(s->path));
+
+            *units = g_list_append(*units, (void *)s);
+        }
+        StackUnlock();
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/stack?cmd=units_get", u.ip, u.port, SERVER_API_VER);
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    json_array_foreach(json_object_get(root, "units"), index, value) {
+        RpcStackUnit *s = (RpcStackUnit *)calloc(1, sizeof(RpcStackUnit));
+
+        s->id = json_integer_value(json_object_get(value, "id"));
+        if (json_string_value(json_object_get(value, "name")) != NULL) {
+            strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN - 1);
+        }
+        if (json_string_value(json_object_get(value, "ip")) != NULL) {
+            strncpy(s->ip, json_string_value(json_object_get(value, "ip")), SHORT_STR_LEN - 1);
+        }
+        s->port = json_integer_value(json_object_get(value, "port"));
+        s->active = json_boolean_value(json_object_get(value, "active"));
+
+        json_array_foreach(json_object_get(value, "path"), path_index, hop) {
+            if (s->hops < STACK_PATH_MAX) {
+                s->path[s->hops++] = json_integer_value(hop);
+            }
+        }
+
+        *units = g_list_append(*units, (void *)s);
+    }
+
+    json_decref(root);
+    return true;
+}
+
+bool RpcRouteRequest(unsigned unit, const char *path, const char *post, char *out, size_t out_size, size_t *out_len)
+{
+    WebClientReq req = {
+        .type = (post != NULL) ? WEB_REQ_POST : WEB_REQ_GET,
+        .post = post,
+        .out = out,
+        .out_size = out_size
+    };
+
+    StackUnit u;
+    if (unit == RPC_DEFAULT_UNIT || !StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(req.url, STR_LEN, "http://%s:%d%s", u.ip, u.port, path);
+
+    /**
+     * Routed request may be state subscription, so its deadline covers
+     * longest state waiting
+     */
+
+    MultiRequest(&unit, &req, 1, RPC_TIMEOUT_MS + STATE_WAIT_MAX_MS);
+    *out_len = req.out_len;
+
+    return req.result;
+}
+
+static void RouteAsyncDone(RpcAsync *async)
+{
+    async->route_func(async->req.result, async->req.out, async->req.out_len, async->data);
+}
+
+bool RpcRouteAsync(unsigned unit, const char *path, const char *post, RpcRouteFunc func, void *data)
+{
+    RpcAsync *async = (RpcAsync *)calloc(1, sizeof(RpcAsync));
+
+    async->unit = unit;
+    async->post = (post != NULL) ? strdup(post) : NULL;
+    async->done = &RouteAsyncDone;
+    async->route_func = func;
+    async->data = data;
+
+    return AsyncStart(async, path, RPC_TIMEOUT_MS + STATE_WAIT_MAX_MS);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                         SECURITY FUNCTIONS                        */
+/*                                                                   */
+/*********************************************************************/
+
+void RpcSecurityReconcile(RpcSecurityState *states, unsigned count, unsigned timeout_ms)
+{
+    unsigned        reqs_count = 0;
+
+    if (count == 0) {
+        return;
+    }
+
+    unsigned        *index = (unsigned *)calloc(count, sizeof(unsigned));
+    unsigned        *units = (unsigned *)calloc(count, sizeof(unsigned));
+    WebClientReq    *reqs = ReqsNew(count);
+
+    for (unsigned i = 0; i < count; i++) {
+        states[i].result = false;
+
+        if (states[i].unit == RPC_DEFAULT_UNIT) {
+            states[i].result = SecurityReconcile(states[i].status, states[i].alarm, states[i].version);
+            states[i].status = SecurityStatusGet();
+            states[i].alarm = SecurityAlarmGet();
+            states[i].version = SecurityVersionGet();
+            continue;
+        }
+
+        StackUnit u;
+        if (!StackUnitCopy(states[i].unit, &u)) {
+            continue;
+        }
+
+        snprintf(reqs[reqs_count].url, STR_LEN,
+                 "http://%s:%d/api/%s/security?cmd=reconcile&status=%s&alarm=%s&version=%llu",
+                 u.ip, u.port, SERVER_API_VER,
+                 (states[i].status == true) ? "true" : "false",
+                 (states[i].alarm == true) ? "true" : "false",
+                 (unsigned long long)states[i].version);
+        units[reqs_count] = states[i].unit;
+        index[reqs_count++] = i;
+    }
+
+    MultiRequest(units, reqs, reqs_count, timeout_ms);
+
+    for (unsigned r = 0; r < reqs_count; r++) {
+        RpcSecurityState    *state = &states[index[r]];
+        json_t              *root = ReplyParse(&reqs[r]);
+
+        if (root == NULL) {
+            continue;
+        }
+
+        if (json_boolean_value(json_object_get(root, "applied"))) {
+            ReplicaWriteNotify(state->unit);
+        }
+
+        state->status = json_boolean_value(json_object_get(root, "status"));
+        state->alarm = json_boolean_value(json_object_get(root, "alarm"));
+        state->version = json_integer_value(json_object_get(root, "version"));
+        state->result = true;
+        json_decref(root);
+    }
+
+    ReqsFree(reqs, count);
+    free(units);
+    free(index);
+}
+
+bool RpcSecurityStatusSet(unsigned unit, bool status)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        return SecurityStatusSet(status, true);
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=status_set&status=%s",
+            u.ip, u.port, SERVER_API_VER, (status == true) ? "true" : "false");
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    json_decref(root);
+    return true;
+}
+
+bool RpcSecurityStatusGet(unsigned unit, bool *status)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (status == NULL) {
+        return false;
+    }
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        *status = SecurityStatusGet();
+        return true;
+    }
+
+    if (ReplicaSecurityStatusGet(unit, status)) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=status_get", u.ip, u.port, SERVER_API_VER);
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    *status = json_boolean_value(json_object_get(root, "status"));
+
+    json_decref(root);
+    return true;
+}
+
+bool RpcSecurityAlarmSet(unsigned unit, bool alarm)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        return SecurityAlarmSet(alarm, false);
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=alarm_set&alarm=%s",
+            u.ip, u.port, SERVER_API_VER, (alarm == true) ? "true" : "false");
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    json_decref(root);
+    return true;
+}
+
+bool RpcSecurityAlarmGet(unsigned unit, bool *alarm)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (alarm == NULL) {
+        return false;
+    }
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        *alarm = SecurityAlarmGet();
+        return true;
+    }
+
+    if (ReplicaSecurityAlarmGet(unit, alarm)) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=alarm_get", u.ip, u.port, SERVER_API_VER);
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    *alarm = json_boolean_value(json_object_get(root, "alarm"));
+
+    json_decref(root);
+    return true;
+}
+
+bool RpcSecuritySensorsGet(unsigned unit, GList **sensors)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (sensors == NULL) {
+        return false;
+    }
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        for (GList *c = *SecuritySensorsGet(); c != NULL; c = c->next) {
+            SecuritySensor *sensor = (SecuritySensor *)c->data;
+
+            RpcSecuritySensor *s = (RpcSecuritySensor *)malloc(sizeof(RpcSecuritySensor));
+            strncpy(s->name, sensor->name, SHORT_STR_LEN);
+            s->detected = sensor->detected;
+            switch (sensor->type) {
+                case SECURITY_SENSOR_REED:
+                    s->type = RPC_SECURITY_SENSOR_REED;
+                    break;
+
+                case SECURITY_SENSOR_MICRO_WAVE:
+                    s->type = RPC_SECURITY_SENSOR_MICRO_WAVE;
+                    break;
+
+                case SECURITY_SENSOR_PIR:
+                    s->type = RPC_SECURITY_SENSOR_PIR;
+                    break;
+            }
+
+            *sensors = g_list_append(*sensors, s);
+        }
+        return true;
+    }
+
+    if (ReplicaSecuritySensorsGet(unit, sensors)) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=sensors_get", u.ip, u.port, SERVER_API_VER);
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
+    }
+
+    SecuritySensorsParse(root, sensors);
+
+    json_decref(root);
+    return true;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                           METEO FUNCTIONS                         */
 /*                                                                   */
 /*********************************************************************/
 
-bool RpcUnitStatusCheck(unsigned unit)
+bool RpcMeteoSensorsGet(unsigned unit, GList **sensors)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
+    if (sensors == NULL) {
+        return false;
+    }
+
     if (unit == RPC_DEFAULT_UNIT) {
+        for (GList *c = *MeteoSensorsGet(); c != NULL; c = c->next) {
+            MeteoSensor         *sensor = (MeteoSensor *)c->data;
+            MeteoSensorState    state;
+
+            MeteoSensorStateGet(sensor, &state);
+
+            RpcMeteoSensor *s = (RpcMeteoSensor *)malloc(sizeof(RpcMeteoSensor));
+            strncpy(s->name, sensor->name, SHORT_STR_LEN);
+            switch (sensor->type) {
+                case METEO_SENSOR_DS18B20:
+                    s->type = RPC_METEO_SENSOR_DS18B20;
+                    s->ds18b20.temp = state.temp;
+                    break;
+            }
+
+            *sensors = g_list_append(*sensors, (void *)s);
+        }
         return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    if (ReplicaMeteoSensorsGet(unit, sensors)) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/", u->ip, u->port);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/meteo?cmd=sensors_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -69,36 +1059,42 @@ bool RpcUnitStatusCheck(unsigned unit)
         return false;
     }
 
+    MeteoSensorsParse(root, sensors);
+
     json_decref(root);
     return true;
 }
 
 /*********************************************************************/
 /*                                                                   */
-/*                         SECURITY FUNCTIONS                        */
+/*                         SOCKET  FUNCTIONS                         */
 /*                                                                   */
 /*********************************************************************/
 
-bool RpcSecurityStatusSet(unsigned unit, bool status)
+bool RpcSocketStatusSet(unsigned unit, const char *name, bool status)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
     if (unit == RPC_DEFAULT_UNIT) {
-        return SecurityStatusSet(status, true);
+        Socket *socket = SocketGet(name);
+        if (socket == NULL) {
+            return false;
+        }
+        return SocketStatusSet(socket, status, true);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=status_set&status=%s",
-            u->ip, u->port, SERVER_API_VER, (status == true) ? "true" : "false");
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/socket?cmd=status_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -116,30 +1112,52 @@ bool RpcSecurityStatusSet(unsigned unit, bool status)
     return true;
 }
 
-bool RpcSecurityStatusGet(unsigned unit, bool *status)
+bool RpcSocketsGet(unsigned unit, GList **sockets)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
-    if (status == NULL) {
+    if (sockets == NULL) {
         return false;
     }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        *status = SecurityStatusGet();
+        for (GList *c = *SocketsGet(); c != NULL; c = c->next) {
+            Socket *socket = (Socket *)c->data;
+
+            RpcSocket *s = (RpcSocket *)malloc(sizeof(RpcSocket));
+            strncpy(s->name, socket->name, SHORT_STR_LEN);
+            s->status = SocketStatusGet(socket);
+
+            switch (socket->group) {
+                case SOCKET_GROUP_LIGHT:
+                    s->group = RPC_SOCKET_GROUP_LIGHT;
+                    break;
+
+                case SOCKET_GROUP_SOCKET:
+                    s->group = RPC_SOCKET_GROUP_SOCKET;
+                    break;
+            }
+
+            *sockets = g_list_append(*sockets, (void *)s);
+        }
+        return true;
+    }
+
+    if (ReplicaSocketsGet(unit, sockets)) {
         return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=status_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/socket?cmd=sockets_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -153,32 +1171,42 @@ bool RpcSecurityStatusGet(unsigned unit, bool *status)
         return false;
     }
 
-    *status = json_boolean_value(json_object_get(root, "status"));
+    SocketsParse(root, sockets);
 
     json_decref(root);
     return true;
 }
 
-bool RpcSecurityAlarmSet(unsigned unit, bool alarm)
+/*********************************************************************/
+/*                                                                   */
+/*                           TANK  FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool RpcTankStatusSet(unsigned unit, const char *name, bool status)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
     if (unit == RPC_DEFAULT_UNIT) {
-        return SecurityAlarmSet(alarm, false);
+        Tank *tank = TankGet(name);
+        if (tank == NULL) {
+            return false;
+        }
+        return TankStatusSet(tank, status, true);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=alarm_set&alarm=%s",
-            u->ip, u->port, SERVER_API_VER, (alarm == true) ? "true" : "false");
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=status_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -196,30 +1224,48 @@ bool RpcSecurityAlarmSet(unsigned unit, bool alarm)
     return true;
 }
 
-bool RpcSecurityAlarmGet(unsigned unit, bool *alarm)
+bool RpcTanksGet(unsigned unit, GList **tanks)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
-    if (alarm == NULL) {
+    if (tanks == NULL) {
         return false;
     }
 
-    if (unit == RPC_DEFAULT_UNIT) {
-        *alarm = SecurityAlarmGet();
+    if (unit == RPC_DEFAULT_UNIT) {
+        for (GList *c = *TanksGet(); c != NULL; c = c->next) {
+            Tank        *tank = (Tank *)c->data;
+            TankState   state;
+
+            TankStateGet(tank, &state);
+
+            RpcTank *t = (RpcTank *)malloc(sizeof(RpcTank));
+            strncpy(t->name, tank->name, SHORT_STR_LEN);
+            t->status = state.status;
+            t->level = state.level;
+            t->pump = state.pump;
+            t->valve = state.valve;
+
+            *tanks = g_list_append(*tanks, (void *)t);
+        }
+        return true;
+    }
+
+    if (ReplicaTanksGet(unit, tanks)) {
         return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=alarm_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=tanks_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -233,59 +1279,36 @@ bool RpcSecurityAlarmGet(unsigned unit, bool *alarm)
         return false;
     }
 
-    *alarm = json_boolean_value(json_object_get(root, "alarm"));
+    TanksParse(root, tanks);
 
     json_decref(root);
     return true;
 }
 
-bool RpcSecuritySensorsGet(unsigned unit, GList **sensors)
+bool RpcTankPumpSet(unsigned unit, const char *name, bool status)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
-    size_t          index;
-    json_t          *value;
-
-    if (sensors == NULL) {
-        return false;
-    }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *SecuritySensorsGet(); c != NULL; c = c->next) {
-            SecuritySensor *sensor = (SecuritySensor *)c->data;
-
-            RpcSecuritySensor *s = (RpcSecuritySensor *)malloc(sizeof(RpcSecuritySensor));
-            strncpy(s->name, sensor->name, SHORT_STR_LEN);
-            s->detected = sensor->detected;
-            switch (sensor->type) {
-                case SECURITY_SENSOR_REED:
-                    s->type = RPC_SECURITY_SENSOR_REED;
-                    break;
-
-                case SECURITY_SENSOR_MICRO_WAVE:
-                    s->type = RPC_SECURITY_SENSOR_MICRO_WAVE;
-                    break;
-
-                case SECURITY_SENSOR_PIR:
-                    s->type = RPC_SECURITY_SENSOR_PIR;
-                    break;
-            }
-
-            *sensors = g_list_append(*sensors, s);
+        Tank *tank = TankGet(name);
+        if (tank == NULL) {
+            return false;
         }
-        return true;
+        return TankPumpSet(tank, status);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/security?cmd=sensors_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=pump_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -299,65 +1322,34 @@ bool RpcSecuritySensorsGet(unsigned unit, GList **sensors)
         return false;
     }
 
-    json_array_foreach(json_object_get(root, "sensors"), index, value) {
-        RpcSecuritySensor *s = (RpcSecuritySensor *)malloc(sizeof(RpcSecuritySensor));
-
-        strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN);
-        s->detected = json_boolean_value(json_object_get(value, "detected"));
-        s->type = json_integer_value(json_object_get(value, "type"));
-
-        *sensors = g_list_append(*sensors, s);
-    }
-
     json_decref(root);
     return true;
 }
 
-/*********************************************************************/
-/*                                                                   */
-/*                           METEO FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
-
-bool RpcMeteoSensorsGet(unsigned unit, GList **sensors)
+bool RpcTankValveSet(unsigned unit, const char *name, bool status)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
-    size_t          index;
-    json_t          *value;
-
-    if (sensors == NULL) {
-        return false;
-    }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *MeteoSensorsGet(); c != NULL; c = c->next) {
-            MeteoSensor *sensor = (MeteoSensor *)c->data;
-
-            RpcMeteoSensor *s = (RpcMeteoSensor *)malloc(sizeof(RpcMeteoSensor));
-            strncpy(s->name, sensor->name, SHORT_STR_LEN);
-            switch (sensor->type) {
-                case METEO_SENSOR_DS18B20:
-                    s->type = RPC_METEO_SENSOR_DS18B20;
-                    s->ds18b20.temp = sensor->ds18b20.temp;
-                    break;
-            }
-
-            *sensors = g_list_append(*sensors, (void *)s);
+        Tank *tank = TankGet(name);
+        if (tank == NULL) {
+            return false;
         }
-        return true;
+        return TankValveSet(tank, status);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/meteo?cmd=sensors_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=valve_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -371,54 +1363,83 @@ bool RpcMeteoSensorsGet(unsigned unit, GList **sensors)
         return false;
     }
 
-    json_array_foreach(json_object_get(root, "sensors"), index, value) {
-        RpcMeteoSensor *s = (RpcMeteoSensor *)malloc(sizeof(RpcMeteoSensor));
+    json_decref(root);
+    return true;
+}
 
-        strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN);
-        switch (json_integer_value(json_object_get(value, "pres"))) {
-            case METEO_SENSOR_DS18B20:
-                s->type = RPC_METEO_SENSOR_DS18B20;
-                s->ds18b20.temp = (float)json_real_value(json_object_get(json_object_get(value, "ds18b20"), "temp"));
-                break;
+/*********************************************************************/
+/*                                                                   */
+/*                         CAMERA  FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool RpcCameraPhotoSave(unsigned unit, const char *name, const char *filename)
+{
+    if (unit == RPC_DEFAULT_UNIT) {
+        Camera *cam = CameraGet(name);
+        if (cam == NULL) {
+            return false;
         }
+        return CameraPhotoSave(cam, filename);
+    }
+    return false;
+}
 
-        *sensors = g_list_append(*sensors, (void *)s);
+bool RpcCamerasGet(unsigned unit, GList **cams)
+{
+    if (unit == RPC_DEFAULT_UNIT) {
+        for (GList *c = *CamerasGet(); c != NULL; c = c->next) {
+            Camera *cam = (Camera *)c->data;
+
+            RpcCamera *cm = (RpcCamera *)malloc(sizeof(RpcCamera));
+            strncpy(cm->name, cam->name, SHORT_STR_LEN);
+
+            *cams = g_list_append(*cams, (void *)cm);
+        }
+        return true;
     }
+    return false;
+}
 
-    json_decref(root);
-    return true;
+bool RpcCameraPathGet(unsigned unit, char *path)
+{
+    if (unit == RPC_DEFAULT_UNIT) {
+        strncpy(path, CameraPathGet(), STR_LEN);
+        return true;
+    }
+    return false;
 }
 
 /*********************************************************************/
 /*                                                                   */
-/*                         SOCKET  FUNCTIONS                         */
+/*                           TANK  FUNCTIONS                         */
 /*                                                                   */
 /*********************************************************************/
 
-bool RpcSocketStatusSet(unsigned unit, const char *name, bool status)
+bool RpcWatererStatusSet(unsigned unit, const char *name, bool status)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
     if (unit == RPC_DEFAULT_UNIT) {
-        Socket *socket = SocketGet(name);
-        if (socket == NULL) {
+        Waterer *waterer = WatererGet(name);
+        if (waterer == NULL) {
             return false;
         }
-        return SocketStatusSet(socket, status, true);
+        return WatererStatusSet(waterer, status, true);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/socket?cmd=status_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=status_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -436,50 +1457,58 @@ bool RpcSocketStatusSet(unsigned unit, const char *name, bool status)
     return true;
 }
 
-bool RpcSocketsGet(unsigned unit, GList **sockets)
+bool RpcWaterersGet(unsigned unit, GList **waterers)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
-    size_t          index;
-    json_t          *value;
 
-    if (sockets == NULL) {
+    if (waterers == NULL) {
         return false;
     }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *SocketsGet(); c != NULL; c = c->next) {
-            Socket *socket = (Socket *)c->data;
+        for (GList *c = *WaterersGet(); c != NULL; c = c->next) {
+            Waterer         *waterer = (Waterer *)c->data;
+            WatererState    state;
 
-            RpcSocket *s = (RpcSocket *)malloc(sizeof(RpcSocket));
-            strncpy(s->name, socket->name, SHORT_STR_LEN);
-            s->status = socket->status;
+            WatererStateGet(waterer, &state);
 
-            switch (socket->group) {
-                case SOCKET_GROUP_LIGHT:
-                    s->group = RPC_SOCKET_GROUP_LIGHT;
-                    break;
+            RpcWaterer *t = (RpcWaterer *)malloc(sizeof(RpcWaterer));
+            strncpy(t->name, waterer->name, SHORT_STR_LEN);
+            t->status = state.status;
+            t->valve = state.valve;
+            t->times = NULL;
 
-                case SOCKET_GROUP_SOCKET:
-                    s->group = RPC_SOCKET_GROUP_SOCKET;
-                    break;
+            for (GList *ts = waterer->times; ts != NULL; ts = ts->next) {
+                WateringTime *wt = (WateringTime *)ts->data;
+                
+                RpcWatererTime *tm = (RpcWatererTime *)malloc(sizeof(RpcWatererTime));
+                tm->day = wt->time.dow;
+                tm->hour = wt->time.hour;
+                tm->min = wt->time.min;
+                tm->state = wt->state;
+                t->times = g_list_append(t->times, (void *)tm);
             }
 
-            *sockets = g_list_append(*sockets, (void *)s);
+            *waterers = g_list_append(*waterers, (void *)t);
         }
         return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    if (ReplicaWaterersGet(unit, waterers)) {
+        return true;
+    }
+
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/socket?cmd=sockets_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=waterers_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -493,19 +1522,47 @@ bool RpcSocketsGet(unsigned unit, GList **sockets)
         return false;
     }
 
-    json_array_foreach(json_object_get(root, "sockets"), index, value) {
-        RpcSocket *s = (RpcSocket *)malloc(sizeof(RpcSocket));
+    WaterersParse(root, waterers);
 
-        strncpy(s->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN);
-        s->status = json_boolean_value(json_object_get(value, "status"));
+    json_decref(root);
+    return true;
+}
 
-        if (!strcmp(json_string_value(json_object_get(value, "group")), "light")) {
-            s->group = RPC_SOCKET_GROUP_LIGHT;
-        } else if (!strcmp(json_string_value(json_object_get(value, "group")), "socket")) {
-            s->group = RPC_SOCKET_GROUP_SOCKET;
+bool RpcWatererValveSet(unsigned unit, const char *name, bool status)
+{
+    char            buf[BUFFER_LEN_MAX];
+    char            url[STR_LEN];
+    json_error_t    error;
+
+    if (unit == RPC_DEFAULT_UNIT) {
+        Waterer *waterer = WatererGet(name);
+        if (waterer == NULL) {
+            return false;
         }
+        return WatererValveSet(waterer, status);
+    }
 
-        *sockets = g_list_append(*sockets, (void *)s);
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=valve_set&name=%s&status=%s",
+            u.ip, u.port, SERVER_API_VER, name, (status == true) ? "true" : "false");
+    memset(buf, 0x0, BUFFER_LEN_MAX);
+
+    if (!WriteRequest(unit, WEB_REQ_GET, url, NULL, buf)) {
+        return false;
+    }
+
+    json_t *root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        return false;
+    }
+
+    if (!json_boolean_value(json_object_get(root, "result"))) {
+        json_decref(root);
+        return false;
     }
 
     json_decref(root);
@@ -514,88 +1571,178 @@ bool RpcSocketsGet(unsigned unit, GList **sockets)
 
 /*********************************************************************/
 /*                                                                   */
-/*                           TANK  FUNCTIONS                         */
+/*                            BATCH FUNCTIONS                        */
 /*                                                                   */
 /*********************************************************************/
 
-bool RpcTankStatusSet(unsigned unit, const char *name, bool status)
+static const char *BatchCmds[RPC_BATCH_CMD_MAX] = {
+    [RPC_BATCH_SOCKET_STATUS] = "socket_status",
+    [RPC_BATCH_SECURITY_STATUS] = "security_status",
+    [RPC_BATCH_SECURITY_ALARM] = "security_alarm",
+    [RPC_BATCH_TANK_STATUS] = "tank_status",
+    [RPC_BATCH_TANK_PUMP] = "tank_pump",
+    [RPC_BATCH_TANK_VALVE] = "tank_valve",
+    [RPC_BATCH_WATERER_STATUS] = "waterer_status",
+    [RPC_BATCH_WATERER_VALVE] = "waterer_valve"
+};
+
+static bool BatchActionRun(const RpcBatchAction *action)
+{
+    switch (action->cmd) {
+        case RPC_BATCH_SOCKET_STATUS:
+            return RpcSocketStatusSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        case RPC_BATCH_SECURITY_STATUS:
+            return RpcSecurityStatusSet(RPC_DEFAULT_UNIT, action->status);
+
+        case RPC_BATCH_SECURITY_ALARM:
+            return RpcSecurityAlarmSet(RPC_DEFAULT_UNIT, action->status);
+
+        case RPC_BATCH_TANK_STATUS:
+            return RpcTankStatusSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        case RPC_BATCH_TANK_PUMP:
+            return RpcTankPumpSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        case RPC_BATCH_TANK_VALVE:
+            return RpcTankValveSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        case RPC_BATCH_WATERER_STATUS:
+            return RpcWatererStatusSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        case RPC_BATCH_WATERER_VALVE:
+            return RpcWatererValveSet(RPC_DEFAULT_UNIT, action->name, action->status);
+
+        default:
+            return false;
+    }
+}
+
+const char *RpcBatchCmdName(RpcBatchCmd cmd)
+{
+    if (cmd >= RPC_BATCH_CMD_MAX) {
+        return NULL;
+    }
+
+    return BatchCmds[cmd];
+}
+
+bool RpcBatchRun(unsigned unit, RpcBatchAction *actions, unsigned count)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
+    size_t          index;
+    json_t          *value;
+    bool            ret = true;
+
+    for (unsigned i = 0; i < count; i++) {
+        actions[i].result = false;
+    }
+
+    if (count > RPC_BATCH_MAX) {
+        return false;
+    }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        Tank *tank = TankGet(name);
-        if (tank == NULL) {
-            return false;
+        for (unsigned i = 0; i < count; i++) {
+            actions[i].result = BatchActionRun(&actions[i]);
+            ret = ret && actions[i].result;
         }
-        return TankStatusSet(tank, status, true);
+        return ret;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=status_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
+    json_t *jreq = json_object();
+    json_t *jactions = json_array();
+
+    for (unsigned i = 0; i < count; i++) {
+        json_t *jaction = json_object();
+
+        json_object_set_new(jaction, "cmd", json_string(RpcBatchCmdName(actions[i].cmd)));
+        json_object_set_new(jaction, "name", json_string(actions[i].name));
+        json_object_set_new(jaction, "status", json_boolean(actions[i].status));
+        json_array_append_new(jactions, jaction);
+    }
+
+    json_object_set_new(jreq, "actions", jactions);
+    char *post = json_dumps(jreq, JSON_COMPACT);
+    json_decref(jreq);
+
+    if (post == NULL) {
+        return false;
+    }
+
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/batch?cmd=run", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!WriteRequest(unit, WEB_REQ_POST, url, post, buf)) {
+        free(post);
         return false;
     }
+    free(post);
 
     json_t *root = json_loads(buf, 0, &error);
     if (root == NULL) {
         return false;
     }
 
-    if (!json_boolean_value(json_object_get(root, "result"))) {
+    json_t *jresults = json_object_get(root, "results");
+    if (!json_boolean_value(json_object_get(root, "result")) || json_array_size(jresults) != count) {
         json_decref(root);
         return false;
     }
 
+    json_array_foreach(jresults, index, value) {
+        actions[index].result = json_is_true(value);
+        ret = ret && actions[index].result;
+    }
+
     json_decref(root);
-    return true;
+    return ret;
 }
 
-bool RpcTanksGet(unsigned unit, GList **tanks)
+/*********************************************************************/
+/*                                                                   */
+/*                            ALARM FUNCTIONS                        */
+/*                                                                   */
+/*********************************************************************/
+
+bool RpcAlarmsGet(unsigned unit, GList **alarms)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
-    size_t          index;
-    json_t          *value;
 
-    if (tanks == NULL) {
+    if (alarms == NULL) {
         return false;
     }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *TanksGet(); c != NULL; c = c->next) {
-            Tank *tank = (Tank *)c->data;
+        for (unsigned i = 0; i < PLC_ALARM_MAX; i++) {
+            RpcAlarm *a = (RpcAlarm *)calloc(1, sizeof(RpcAlarm));
 
-            RpcTank *t = (RpcTank *)malloc(sizeof(RpcTank));
-            strncpy(t->name, tank->name, SHORT_STR_LEN);
-            t->status = tank->status;
-            t->level = tank->level;
-            t->pump = tank->pump;
-            t->valve = tank->valve;
+            strncpy(a->name, PlcAlarmNameGet(i), SHORT_STR_LEN - 1);
+            a->state = PlcAlarmStateGet(i);
 
-            *tanks = g_list_append(*tanks, (void *)t);
+            *alarms = g_list_append(*alarms, a);
         }
         return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=tanks_get", u->ip, u->port, SERVER_API_VER);
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/alarm?cmd=state_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -609,46 +1756,48 @@ bool RpcTanksGet(unsigned unit, GList **tanks)
         return false;
     }
 
-    json_array_foreach(json_object_get(root, "tanks"), index, value) {
-        RpcTank *t = (RpcTank *)malloc(sizeof(RpcTank));
-
-        strncpy(t->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN);
-        t->status = json_boolean_value(json_object_get(value, "status"));
-        t->level = json_integer_value(json_object_get(value, "level"));
-        t->pump = json_boolean_value(json_object_get(value, "pump"));
-        t->valve = json_boolean_value(json_object_get(value, "valve"));
-
-        *tanks = g_list_append(*tanks, (void *)t);
-    }
+    AlarmsParse(root, alarms);
 
     json_decref(root);
     return true;
 }
 
-bool RpcTankPumpSet(unsigned unit, const char *name, bool status)
+bool RpcAlarmHistoryGet(unsigned unit, GList **records)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
 
+    if (records == NULL) {
+        return false;
+    }
+
     if (unit == RPC_DEFAULT_UNIT) {
-        Tank *tank = TankGet(name);
-        if (tank == NULL) {
-            return false;
+        PlcAlarmRecord  history[PLC_ALARM_HISTORY_LEN];
+        unsigned        count = PlcAlarmHistoryGet(history, PLC_ALARM_HISTORY_LEN);
+
+        for (unsigned i = 0; i < count; i++) {
+            RpcAlarmRecord *r = (RpcAlarmRecord *)calloc(1, sizeof(RpcAlarmRecord));
+
+            strncpy(r->name, PlcAlarmNameGet(history[i].type), SHORT_STR_LEN - 1);
+            r->action = history[i].action;
+            r->state = history[i].state;
+            r->time = history[i].time;
+
+            *records = g_list_append(*records, r);
         }
-        return TankPumpSet(tank, status);
+        return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=pump_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
+    snprintf(url, STR_LEN, "http://%s:%d/api/%s/alarm?cmd=history_get", u.ip, u.port, SERVER_API_VER);
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -662,34 +1811,53 @@ bool RpcTankPumpSet(unsigned unit, const char *name, bool status)
         return false;
     }
 
+    AlarmRecordsParse(root, records);
+
     json_decref(root);
     return true;
 }
 
-bool RpcTankValveSet(unsigned unit, const char *name, bool status)
+bool RpcAlarmAck(unsigned unit, const char *name, bool *acked)
 {
     char            buf[BUFFER_LEN_MAX];
     char            url[STR_LEN];
     json_error_t    error;
+    PlcAlarmType    type;
+
+    if (acked == NULL) {
+        return false;
+    }
 
     if (unit == RPC_DEFAULT_UNIT) {
-        Tank *tank = TankGet(name);
-        if (tank == NULL) {
+        if (name == NULL) {
+            *acked = false;
+            for (unsigned i = 0; i < PLC_ALARM_MAX; i++) {
+                *acked |= PlcAlarmAck(i);
+            }
+            return true;
+        }
+
+        if (!PlcAlarmTypeGet(name, &type)) {
             return false;
         }
-        return TankValveSet(tank, status);
+
+        *acked = PlcAlarmAck(type);
+        return true;
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
         return false;
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/tank?cmd=valve_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
+    if (name == NULL) {
+        snprintf(url, STR_LEN, "http://%s:%d/api/%s/alarm?cmd=ack", u.ip, u.port, SERVER_API_VER);
+    } else {
+        snprintf(url, STR_LEN, "http://%s:%d/api/%s/alarm?cmd=ack&name=%s", u.ip, u.port, SERVER_API_VER, name);
+    }
     memset(buf, 0x0, BUFFER_LEN_MAX);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    if (!Request(unit, WEB_REQ_GET, url, NULL, buf)) {
         return false;
     }
 
@@ -703,223 +1871,575 @@ bool RpcTankValveSet(unsigned unit, const char *name, bool status)
         return false;
     }
 
+    *acked = json_boolean_value(json_object_get(root, "acked"));
+
     json_decref(root);
     return true;
 }
 
 /*********************************************************************/
 /*                                                                   */
-/*                         CAMERA  FUNCTIONS                         */
+/*                            STATE FUNCTIONS                        */
 /*                                                                   */
 /*********************************************************************/
 
-bool RpcCameraPhotoSave(unsigned unit, const char *name, const char *filename)
+/**
+ * @brief Parse state reply, binary state is asked, units which do not
+ * know it reply JSON
+ */
+static bool StateReplyParse(const WebClientReq *req, RpcUnitState *state)
 {
-    if (unit == RPC_DEFAULT_UNIT) {
-        Camera *cam = CameraGet(name);
-        if (cam == NULL) {
-            return false;
-        }
-        return CameraPhotoSave(cam, filename);
+    if (req->result && StateEncodedCheck((const uint8_t *)req->out, req->out_len)) {
+        return StateDecode((const uint8_t *)req->out, req->out_len, state);
     }
-    return false;
+
+    json_t *root = ReplyParse(req);
+    if (root == NULL) {
+        return false;
+    }
+
+    json_t *jsecurity = json_object_get(root, "security");
+
+    state->version = json_integer_value(json_object_get(root, "version"));
+    state->delta = json_boolean_value(json_object_get(root, "delta"));
+    state->security_changed = (jsecurity != NULL);
+    state->security_status = json_boolean_value(json_object_get(jsecurity, "status"));
+    state->security_alarm = json_boolean_value(json_object_get(jsecurity, "alarm"));
+    SecuritySensorsParse(jsecurity, &state->security_sensors);
+    MeteoSensorsParse(json_object_get(root, "meteo"), &state->meteo_sensors);
+    SocketsParse(json_object_get(root, "socket"), &state->sockets);
+    TanksParse(json_object_get(root, "tank"), &state->tanks);
+    WaterersParse(json_object_get(root, "waterer"), &state->waterers);
+
+    json_decref(root);
+    return true;
 }
 
-bool RpcCamerasGet(unsigned unit, GList **cams)
+static bool UnitStateRequest(unsigned unit, const char *query, unsigned timeout_ms, RpcUnitState *state)
 {
-    if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *CamerasGet(); c != NULL; c = c->next) {
-            Camera *cam = (Camera *)c->data;
+    WebClientReq req = {
+        .type = WEB_REQ_GET,
+        .post = NULL,
+        .out_size = RPC_STATE_BUF_LEN
+    };
 
-            RpcCamera *cm = (RpcCamera *)malloc(sizeof(RpcCamera));
-            strncpy(cm->name, cam->name, SHORT_STR_LEN);
-
-            *cams = g_list_append(*cams, (void *)cm);
-        }
-        return true;
+    StackUnit u;
+    if (!StackUnitCopy(unit, &u)) {
+        return false;
     }
-    return false;
+
+    snprintf(req.url, STR_LEN, "http://%s:%d/api/%s/state?%s&fmt=%s",
+             u.ip, u.port, SERVER_API_VER, query, STATE_CODEC_FORMAT);
+    req.out = (char *)malloc(RPC_STATE_BUF_LEN);
+
+    MultiRequest(&unit, &req, 1, timeout_ms);
+
+    bool ret = StateReplyParse(&req, state);
+
+    free(req.out);
+    return ret;
 }
 
-bool RpcCameraPathGet(unsigned unit, char *path)
+static void StateAsyncDone(RpcAsync *async)
 {
-    if (unit == RPC_DEFAULT_UNIT) {
-        strncpy(path, CameraPathGet(), STR_LEN);
-        return true;
+    RpcUnitState state;
+
+    memset(&state, 0x0, sizeof(RpcUnitState));
+
+    bool ret = StateReplyParse(&async->req, &state);
+    if (!ret) {
+        RpcUnitStateFree(&state);
     }
-    return false;
-}
 
-/*********************************************************************/
-/*                                                                   */
-/*                           TANK  FUNCTIONS                         */
-/*                                                                   */
-/*********************************************************************/
+    async->state_func(ret, &state, async->data);
+}
 
-bool RpcWatererStatusSet(unsigned unit, const char *name, bool status)
+/**
+ * @brief Fill state of big unit, same on every run
+ */
+static void StateBenchFill(RpcUnitState *state)
 {
-    char            buf[BUFFER_LEN_MAX];
-    char            url[STR_LEN];
-    json_error_t    error;
+    memset(state, 0x0, sizeof(RpcUnitState));
 
-    if (unit == RPC_DEFAULT_UNIT) {
-        Waterer *waterer = WatererGet(name);
-        if (waterer == NULL) {
-            return false;
-        }
-        return WatererStatusSet(waterer, status, true);
+    state->version = 1700000000ULL << 16;
+    state->security_changed = true;
+    state->security_status = true;
+
+    for (unsigned i = 0; i < 16; i++) {
+        RpcSecuritySensor *s = (RpcSecuritySensor *)calloc(1, sizeof(RpcSecuritySensor));
+
+        snprintf(s->name, SHORT_STR_LEN, "sensor_%02u", i);
+        s->type = (RpcSecuritySensorType)(i % 3);
+        s->detected = (i % 5 == 0);
+        state->security_sensors = g_list_append(state->security_sensors, (void *)s);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
-        return false;
+    for (unsigned i = 0; i < 8; i++) {
+        RpcMeteoSensor *s = (RpcMeteoSensor *)calloc(1, sizeof(RpcMeteoSensor));
+
+        snprintf(s->name, SHORT_STR_LEN, "meteo_%02u", i);
+        s->type = RPC_METEO_SENSOR_DS18B20;
+        s->ds18b20.temp = 18.5f + (float)i * 0.25f;
+        state->meteo_sensors = g_list_append(state->meteo_sensors, (void *)s);
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=status_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
-    memset(buf, 0x0, BUFFER_LEN_MAX);
+    for (unsigned i = 0; i < 32; i++) {
+        RpcSocket *s = (RpcSocket *)calloc(1, sizeof(RpcSocket));
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
-        return false;
+        snprintf(s->name, SHORT_STR_LEN, "socket_%02u", i);
+        s->group = (i % 2) ? RPC_SOCKET_GROUP_LIGHT : RPC_SOCKET_GROUP_SOCKET;
+        s->status = (i % 3 == 0);
+        state->sockets = g_list_append(state->sockets, (void *)s);
     }
 
-    json_t *root = json_loads(buf, 0, &error);
-    if (root == NULL) {
-        return false;
+    for (unsigned i = 0; i < 8; i++) {
+        RpcTank *t = (RpcTank *)calloc(1, sizeof(RpcTank));
+
+        snprintf(t->name, SHORT_STR_LEN, "tank_%02u", i);
+        t->status = true;
+        t->level = i * 12;
+        t->pump = (i % 2 == 0);
+        state->tanks = g_list_append(state->tanks, (void *)t);
     }
 
-    if (!json_boolean_value(json_object_get(root, "result"))) {
-        json_decref(root);
-        return false;
+    for (unsigned i = 0; i < 8; i++) {
+        RpcWaterer *w = (RpcWaterer *)calloc(1, sizeof(RpcWaterer));
+
+        snprintf(w->name, SHORT_STR_LEN, "waterer_%02u", i);
+        w->status = true;
+        for (unsigned t = 0; t < 4; t++) {
+            RpcWatererTime *tm = (RpcWatererTime *)calloc(1, sizeof(RpcWatererTime));
+
+            tm->day = t;
+            tm->hour = 6 + t * 4;
+            tm->min = 30;
+            tm->state = (t % 2 == 0);
+            w->times = g_list_append(w->times, (void *)tm);
+        }
+        state->waterers = g_list_append(state->waterers, (void *)w);
     }
+}
 
-    json_decref(root);
-    return true;
+/**
+ * @brief Build JSON state in the form of state handler reply
+ */
+static json_t *StateJsonBuild(const RpcUnitState *state)
+{
+    json_t *root = json_object();
+    json_t *jsecurity = json_object();
+    json_t *jmeteo = json_object();
+    json_t *jsocket = json_object();
+    json_t *jtank = json_object();
+    json_t *jwaterer = json_object();
+    json_t *jlist = json_array();
+
+    for (GList *l = state->security_sensors; l != NULL; l = l->next) {
+        RpcSecuritySensor   *s = (RpcSecuritySensor *)l->data;
+        json_t              *jsensor = json_object();
+
+        json_object_set_new(jsensor, "name", json_string(s->name));
+        json_object_set_new(jsensor, "type", json_integer(s->type));
+        json_object_set_new(jsensor, "detected", json_boolean(s->detected));
+        json_array_append_new(jlist, jsensor);
+    }
+    json_object_set_new(jsecurity, "status", json_boolean(state->security_status));
+    json_object_set_new(jsecurity, "alarm", json_boolean(state->security_alarm));
+    json_object_set_new(jsecurity, "sensors", jlist);
+
+    jlist = json_array();
+    for (GList *l = state->meteo_sensors; l != NULL; l = l->next) {
+        RpcMeteoSensor  *s = (RpcMeteoSensor *)l->data;
+        json_t          *jsensor = json_object();
+        json_t          *jds18b20 = json_object();
+
+        json_object_set_new(jsensor, "name", json_string(s->name));
+        json_object_set_new(jsensor, "type", json_integer(s->type));
+        json_object_set_new(jds18b20, "temp", json_real(s->ds18b20.temp));
+        json_object_set_new(jsensor, "ds18b20", jds18b20);
+        json_array_append_new(jlist, jsensor);
+    }
+    json_object_set_new(jmeteo, "sensors", jlist);
+
+    jlist = json_array();
+    for (GList *l = state->sockets; l != NULL; l = l->next) {
+        RpcSocket   *s = (RpcSocket *)l->data;
+        json_t      *jitem = json_object();
+
+        json_object_set_new(jitem, "name", json_string(s->name));
+        json_object_set_new(jitem, "status", json_boolean(s->status));
+        json_object_set_new(jitem, "group", json_string((s->group == RPC_SOCKET_GROUP_LIGHT) ? "light" : "socket"));
+        json_array_append_new(jlist, jitem);
+    }
+    json_object_set_new(jsocket, "sockets", jlist);
+
+    jlist = json_array();
+    for (GList *l = state->tanks; l != NULL; l = l->next) {
+        RpcTank *t = (RpcTank *)l->data;
+        json_t  *jitem = json_object();
+
+        json_object_set_new(jitem, "name", json_string(t->name));
+        json_object_set_new(jitem, "status", json_boolean(t->status));
+        json_object_set_new(jitem, "pump", json_boolean(t->pump));
+        json_object_set_new(jitem, "valve", json_boolean(t->valve));
+        json_object_set_new(jitem, "level", json_integer(t->level));
+        json_array_append_new(jlist, jitem);
+    }
+    json_object_set_new(jtank, "tanks", jlist);
+
+    jlist = json_array();
+    for (GList *l = state->waterers; l != NULL; l = l->next) {
+        RpcWaterer  *w = (RpcWaterer *)l->data;
+        json_t      *jitem = json_object();
+        json_t      *jtimes = json_array();
+
+        for (GList *t = w->times; t != NULL; t = t->next) {
+            RpcWatererTime  *tm = (RpcWatererTime *)t->data;
+            json_t          *jtime = json_object();
+
+            json_object_set_new(jtime, "day", json_integer(tm->day));
+            json_object_set_new(jtime, "hour", json_integer(tm->hour));
+            json_object_set_new(jtime, "min", json_integer(tm->min));
+            json_object_set_new(jtime, "state", json_integer(tm->state));
+            json_array_append_new(jtimes, jtime);
+        }
+
+        json_object_set_new(jitem, "name", json_string(w->name));
+        json_object_set_new(jitem, "status", json_boolean(w->status));
+        json_object_set_new(jitem, "valve", json_boolean(w->valve));
+        json_object_set_new(jitem, "times", jtimes);
+        json_array_append_new(jlist, jitem);
+    }
+    json_object_set_new(jwaterer, "waterers", jlist);
+
+    json_object_set_new(root, "security", jsecurity);
+    json_object_set_new(root, "meteo", jmeteo);
+    json_object_set_new(root, "socket", jsocket);
+    json_object_set_new(root, "tank", jtank);
+    json_object_set_new(root, "waterer", jwaterer);
+    json_object_set_new(root, "version", json_integer(state->version));
+    json_object_set_new(root, "result", json_boolean(true));
+
+    return root;
 }
 
-bool RpcWaterersGet(unsigned unit, GList **waterers)
+/**
+ * @brief Check that decoded state has all objects of source state
+ */
+static bool StateBenchCheck(const RpcUnitState *src, const RpcUnitState *dst)
 {
-    char            buf[BUFFER_LEN_MAX];
-    char            url[STR_LEN];
-    json_error_t    error;
-    size_t          index, ext_index;
-    json_t          *value, *ext_value;
+    return (dst->version == src->version &&
+            g_list_length(dst->security_sensors) == g_list_length(src->security_sensors) &&
+            g_list_length(dst->meteo_sensors) == g_list_length(src->meteo_sensors) &&
+            g_list_length(dst->sockets) == g_list_length(src->sockets) &&
+            g_list_length(dst->tanks) == g_list_length(src->tanks) &&
+            g_list_length(dst->waterers) == g_list_length(src->waterers));
+}
 
-    if (waterers == NULL) {
-        return false;
+static int LatencyCompare(const void *a, const void *b)
+{
+    const uint64_t ns_a = *(const uint64_t *)a;
+    const uint64_t ns_b = *(const uint64_t *)b;
+
+    if (ns_a < ns_b) {
+        return -1;
     }
+    return (ns_a > ns_b) ? 1 : 0;
+}
 
-    if (unit == RPC_DEFAULT_UNIT) {
-        for (GList *c = *WaterersGet(); c != NULL; c = c->next) {
-            Waterer *waterer = (Waterer *)c->data;
+/**
+ * @brief Send same state request count times at once over channel or
+ * HTTP to next hop of unit and parse replies as RpcUnitStateGet does
+ *
+ * @return Count of parsed replies
+ */
+static unsigned TransportBenchRound(const StackUnit *hop, const char *route, bool channel,
+                                    WebClientReq *reqs, unsigned count)
+{
+    ChannelCall     *calls[RPC_BENCH_PARALLEL];
+    RpcUnitState    state;
+    unsigned        parsed = 0;
 
-            RpcWaterer *t = (RpcWaterer *)malloc(sizeof(RpcWaterer));
-            strncpy(t->name, waterer->name, SHORT_STR_LEN);
-            t->status = waterer->status;
-            t->valve = waterer->valve;
-            t->times = NULL;
+    for (unsigned i = 0; i < count; i++) {
+        reqs[i].result = false;
+        reqs[i].out_len = 0;
 
-            for (GList *ts = waterer->times; ts != NULL; ts = ts->next) {
-                WateringTime *wt = (WateringTime *)ts->data;
-                
-                RpcWatererTime *tm = (RpcWatererTime *)malloc(sizeof(RpcWatererTime));
-                tm->day = wt->time.dow;
-                tm->hour = wt->time.hour;
-                tm->min = wt->time.min;
-                tm->state = wt->state;
-                t->times = g_list_append(t->times, (void *)tm);
-            }
+        if (channel) {
+            calls[i] = ChannelCallStart(hop->ip, hop->channel, route, NULL);
+        }
+    }
 
-            *waterers = g_list_append(*waterers, (void *)t);
+    if (channel) {
+        for (unsigned i = 0; i < count; i++) {
+            reqs[i].result = ChannelCallWait(calls[i], reqs[i].out, reqs[i].out_size,
+                                             &reqs[i].out_len, RPC_TIMEOUT_MS);
         }
-        return true;
+    } else {
+        WebClientMultiRequest(reqs, count, RPC_TIMEOUT_MS);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
-        return false;
+    for (unsigned i = 0; i < count; i++) {
+        memset(&state, 0x0, sizeof(RpcUnitState));
+        if (StateReplyParse(&reqs[i], &state)) {
+            parsed++;
+        }
+        RpcUnitStateFree(&state);
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=waterers_get", u->ip, u->port, SERVER_API_VER);
-    memset(buf, 0x0, BUFFER_LEN_MAX);
+    return parsed;
+}
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+/**
+ * @brief Measure one transport and print its latency and throughput
+ *
+ * @param avg_ns Out average latency
+ * @param rate Out calls per second with RPC_BENCH_PARALLEL in flight
+ */
+static bool TransportBench(const char *name, const StackUnit *hop, const char *route, bool channel,
+                           WebClientReq *reqs, uint64_t *avg_ns, double *rate)
+{
+    const unsigned  rounds = RPC_BENCH_CALLS / RPC_BENCH_PARALLEL;
+    uint64_t        *lat = (uint64_t *)calloc(RPC_BENCH_CALLS, sizeof(uint64_t));
+    uint64_t        total = 0;
+    unsigned        failed = 0;
+
+    /**
+     * First call opens connection, it is not measured
+     */
+
+    if (TransportBenchRound(hop, route, channel, reqs, 1) != 1) {
+        LogPrintF(LOG_TYPE_ERROR, "RPC", "%s: unit \"%s\" does not reply state", name, hop->name);
+        free(lat);
         return false;
     }
 
-    json_t *root = json_loads(buf, 0, &error);
-    if (root == NULL) {
-        return false;
+    for (unsigned i = 0; i < RPC_BENCH_CALLS; i++) {
+        uint64_t start = UtilsMonoNsGet();
+
+        failed += 1 - TransportBenchRound(hop, route, channel, reqs, 1);
+        lat[i] = UtilsMonoNsGet() - start;
+        total += lat[i];
     }
 
-    if (!json_boolean_value(json_object_get(root, "result"))) {
-        json_decref(root);
-        return false;
+    qsort(lat, RPC_BENCH_CALLS, sizeof(uint64_t), &LatencyCompare);
+
+    uint64_t start = UtilsMonoNsGet();
+    for (unsigned i = 0; i < rounds; i++) {
+        failed += RPC_BENCH_PARALLEL - TransportBenchRound(hop, route, channel, reqs, RPC_BENCH_PARALLEL);
     }
+    uint64_t ns = UtilsMonoNsGet() - start;
 
-    json_array_foreach(json_object_get(root, "waterers"), index, value) {
-        RpcWaterer *t = (RpcWaterer *)malloc(sizeof(RpcWaterer));
+    *avg_ns = total / RPC_BENCH_CALLS;
+    *rate = (double)rounds * RPC_BENCH_PARALLEL * 1000000000.0 / (double)ns;
 
-        strncpy(t->name, json_string_value(json_object_get(value, "name")), SHORT_STR_LEN);
-        t->status = json_boolean_value(json_object_get(value, "status"));
-        t->valve = json_boolean_value(json_object_get(value, "valve"));
-        t->times = NULL;
+    LogPrintF(LOG_TYPE_INFO, "RPC", "%s: latency avg %.3f ms, p50 %.3f ms, p99 %.3f ms",
+              name, (double)*avg_ns / 1000000.0, (double)lat[RPC_BENCH_CALLS / 2] / 1000000.0,
+              (double)lat[RPC_BENCH_CALLS * 99 / 100] / 1000000.0);
+    LogPrintF(LOG_TYPE_INFO, "RPC", "%s: %.0f calls per second with %u in flight, %u calls failed",
+              name, *rate, RPC_BENCH_PARALLEL, failed);
 
-        json_array_foreach(json_object_get(value, "times"), ext_index, ext_value) {
-            RpcWaterer *t = (RpcWaterer *)malloc(sizeof(RpcWaterer));
+    free(lat);
+    return true;
+}
 
-            RpcWatererTime *tm = (RpcWatererTime *)malloc(sizeof(RpcWatererTime));
-            tm->day = json_integer_value(json_object_get(ext_value, "day"));
-            tm->hour = json_integer_value(json_object_get(ext_value, "hour"));
-            tm->min = json_integer_value(json_object_get(ext_value, "min"));
-            tm->state = json_boolean_value(json_object_get(ext_value, "state"));
-            t->times = g_list_append(t->times, (void *)tm);
-        }
+bool RpcUnitStateGet(unsigned unit, RpcUnitState *state)
+{
+    memset(state, 0x0, sizeof(RpcUnitState));
 
-        *waterers = g_list_append(*waterers, (void *)t);
+    if (unit == RPC_DEFAULT_UNIT) {
+        state->version = StateVersionGet();
+        state->security_changed = true;
+        if (!RpcSecurityStatusGet(unit, &state->security_status) ||
+            !RpcSecurityAlarmGet(unit, &state->security_alarm) ||
+            !RpcSecuritySensorsGet(unit, &state->security_sensors) ||
+            !RpcMeteoSensorsGet(unit, &state->meteo_sensors) ||
+            !RpcSocketsGet(unit, &state->sockets) ||
+            !RpcTanksGet(unit, &state->tanks) ||
+            !RpcWaterersGet(unit, &state->waterers)) {
+            RpcUnitStateFree(state);
+            return false;
+        }
+        return true;
     }
 
-    json_decref(root);
-    return true;
+    return UnitStateRequest(unit, "cmd=state_get", RPC_TIMEOUT_MS, state);
 }
 
-bool RpcWatererValveSet(unsigned unit, const char *name, bool status)
+bool RpcUnitChangesGet(unsigned unit, uint64_t since, unsigned wait_ms, RpcUnitState *state)
 {
-    char            buf[BUFFER_LEN_MAX];
-    char            url[STR_LEN];
-    json_error_t    error;
+    char query[STR_LEN];
+
+    memset(state, 0x0, sizeof(RpcUnitState));
 
     if (unit == RPC_DEFAULT_UNIT) {
-        Waterer *waterer = WatererGet(name);
-        if (waterer == NULL) {
-            return false;
+        if (!StateChangesWait(since, wait_ms)) {
+            state->version = since;
+            state->delta = true;
+            return true;
         }
-        return WatererValveSet(waterer, status);
+        return RpcUnitStateGet(unit, state);
     }
 
-    StackUnit *u = StackUnitGet(unit);
-    if (u == NULL) {
-        return false;
+    snprintf(query, STR_LEN, "cmd=changes_get&since=%llu&wait=%u", (unsigned long long)since, wait_ms);
+
+    return UnitStateRequest(unit, query, RPC_TIMEOUT_MS + wait_ms, state);
+}
+
+bool RpcUnitChangesAsync(unsigned unit, uint64_t since, unsigned wait_ms, RpcStateFunc func, void *data)
+{
+    char path[STR_LEN];
+
+    snprintf(path, STR_LEN, "/api/%s/state?cmd=changes_get&since=%llu&wait=%u&fmt=%s",
+             SERVER_API_VER, (unsigned long long)since, wait_ms, STATE_CODEC_FORMAT);
+
+    RpcAsync *async = (RpcAsync *)calloc(1, sizeof(RpcAsync));
+
+    async->unit = unit;
+    async->done = &StateAsyncDone;
+    async->state_func = func;
+    async->data = data;
+
+    return AsyncStart(async, path, RPC_TIMEOUT_MS + wait_ms);
+}
+
+void RpcUnitStateFree(RpcUnitState *state)
+{
+    for (GList *w = state->waterers; w != NULL; w = w->next) {
+        RpcWaterer *waterer = (RpcWaterer *)w->data;
+        g_list_free_full(waterer->times, &free);
     }
 
-    snprintf(url, STR_LEN, "http://%s:%d/api/%s/waterer?cmd=valve_set&name=%s&status=%s",
-            u->ip, u->port, SERVER_API_VER, name, (status == true) ? "true" : "false");
-    memset(buf, 0x0, BUFFER_LEN_MAX);
+    g_list_free_full(state->security_sensors, &free);
+    g_list_free_full(state->meteo_sensors, &free);
+    g_list_free_full(state->sockets, &free);
+    g_list_free_full(state->tanks, &free);
+    g_list_free_full(state->waterers, &free);
 
-    if (!WebClientRequest(WEB_REQ_GET, url, NULL, buf)) {
+    memset(state, 0x0, sizeof(RpcUnitState));
+}
+
+bool RpcStateBenchmark()
+{
+    RpcUnitState    state, out;
+    WebClientReq    req = { .result = true };
+    uint8_t         *buf = (uint8_t *)malloc(RPC_STATE_BUF_LEN);
+    size_t          bin_len = 0;
+    bool            ret = true;
+
+    StateBenchFill(&state);
+
+    /**
+     * Both formats are measured from Rpc* structs to Rpc* structs, as
+     * unit builds reply and master parses it
+     */
+
+    uint64_t start = UtilsMonoNsGet();
+    for (unsigned i = 0; i < RPC_STATE_BENCH_ROUNDS; i++) {
+        bin_len = StateEncode(&state, buf, RPC_STATE_BUF_LEN);
+    }
+    uint64_t bin_enc_ns = UtilsMonoNsGet() - start;
+
+    start = UtilsMonoNsGet();
+    for (unsigned i = 0; i < RPC_STATE_BENCH_ROUNDS && ret; i++) {
+        memset(&out, 0x0, sizeof(RpcUnitState));
+        ret = StateDecode(buf, bin_len, &out) && StateBenchCheck(&state, &out);
+        RpcUnitStateFree(&out);
+    }
+    uint64_t bin_dec_ns = UtilsMonoNsGet() - start;
+
+    start = UtilsMonoNsGet();
+    for (unsigned i = 0; i < RPC_STATE_BENCH_ROUNDS; i++) {
+        json_t *root = StateJsonBuild(&state);
+
+        free(req.out);
+        req.out = json_dumps(root, JSON_COMPACT);
+        json_decref(root);
+    }
+    uint64_t json_enc_ns = UtilsMonoNsGet() - start;
+
+    req.out_len = strlen(req.out);
+
+    start = UtilsMonoNsGet();
+    for (unsigned i = 0; i < RPC_STATE_BENCH_ROUNDS && ret; i++) {
+        memset(&out, 0x0, sizeof(RpcUnitState));
+        ret = StateReplyParse(&req, &out) && StateBenchCheck(&state, &out);
+        RpcUnitStateFree(&out);
+    }
+    uint64_t json_dec_ns = UtilsMonoNsGet() - start;
+
+    if (bin_len == 0 || !ret) {
+        Log(LOG_TYPE_ERROR, "RPC", "Failed to encode or decode benchmark state");
+        ret = false;
+    } else {
+        LogPrintF(LOG_TYPE_INFO, "RPC", "%u rounds of state with %u objects",
+                  RPC_STATE_BENCH_ROUNDS,
+                  g_list_length(state.security_sensors) + g_list_length(state.meteo_sensors) +
+                  g_list_length(state.sockets) + g_list_length(state.tanks) + g_list_length(state.waterers));
+        LogPrintF(LOG_TYPE_INFO, "RPC", "Binary: %zu bytes, encode %.2f us, decode %.2f us",
+                  bin_len, (double)bin_enc_ns / 1000.0 / RPC_STATE_BENCH_ROUNDS,
+                  (double)bin_dec_ns / 1000.0 / RPC_STATE_BENCH_ROUNDS);
+        LogPrintF(LOG_TYPE_INFO, "RPC", "JSON: %zu bytes, encode %.2f us, decode %.2f us",
+                  req.out_len, (double)json_enc_ns / 1000.0 / RPC_STATE_BENCH_ROUNDS,
+                  (double)json_dec_ns / 1000.0 / RPC_STATE_BENCH_ROUNDS);
+        LogPrintF(LOG_TYPE_INFO, "RPC", "Binary is %.1f%% of JSON size, %.1fx faster to encode, %.1fx faster to decode",
+                  (double)bin_len * 100.0 / (double)req.out_len, (double)json_enc_ns / (double)bin_enc_ns,
+                  (double)json_dec_ns / (double)bin_dec_ns);
+    }
+
+    free(req.out);
+    free(buf);
+    RpcUnitStateFree(&state);
+
+    return ret;
+}
+
+bool RpcTransportBenchmark(unsigned unit)
+{
+    char            path[STR_LEN];
+    char            route[STR_LEN];
+    StackUnit       u, hop;
+    WebClientReq    reqs[RPC_BENCH_PARALLEL];
+    uint64_t        channel_ns = 0, http_ns = 0;
+    double          channel_rate = 0, http_rate = 0;
+
+    if (!StackUnitCopy(unit, &u)) {
+        LogPrintF(LOG_TYPE_ERROR, "RPC", "Stack unit %u is not configured", unit);
         return false;
     }
 
-    json_t *root = json_loads(buf, 0, &error);
-    if (root == NULL) {
+    snprintf(path, STR_LEN, "/api/%s/state?cmd=state_get&fmt=%s", SERVER_API_VER, STATE_CODEC_FORMAT);
+
+    if (!RouteGet(&u, path, route, &hop)) {
+        LogPrintF(LOG_TYPE_ERROR, "RPC", "No route to stack unit \"%s\"", u.name);
         return false;
     }
 
-    if (!json_boolean_value(json_object_get(root, "result"))) {
-        json_decref(root);
+    if (hop.channel == 0) {
+        LogPrintF(LOG_TYPE_ERROR, "RPC", "Stack unit \"%s\" has no channel", hop.name);
         return false;
     }
 
-    json_decref(root);
-    return true;
+    memset(reqs, 0x0, sizeof(reqs));
+    for (unsigned i = 0; i < RPC_BENCH_PARALLEL; i++) {
+        reqs[i].type = WEB_REQ_GET;
+        reqs[i].out_size = RPC_STATE_BUF_LEN;
+        reqs[i].out = (char *)malloc(RPC_STATE_BUF_LEN);
+        snprintf(reqs[i].url, STR_LEN, "http://%s:%d%s", hop.ip, hop.port, route);
+    }
+
+    LogPrintF(LOG_TYPE_INFO, "RPC", "%u state requests to unit \"%s\" by each transport",
+              RPC_BENCH_CALLS * 2, u.name);
+
+    bool ret = TransportBench("Channel", &hop, route, true, reqs, &channel_ns, &channel_rate) &&
+               TransportBench("HTTP", &hop, route, false, reqs, &http_ns, &http_rate);
+
+    if (ret) {
+        LogPrintF(LOG_TYPE_INFO, "RPC", "Channel is %.1fx faster by latency, %.1fx by throughput",
+                  (double)http_ns / (double)channel_ns, channel_rate / http_rate);
+    }
+
+    for (unsigned i = 0; i < RPC_BENCH_PARALLEL; i++) {
+        free(reqs[i].out);
+    }
+
+    return ret;
 }
@@ -11,9 +11,12 @@
 #include <stack/stack.h>
 #include <utils/log.h>
 #include <stack/rpc.h>
+#include <stack/replica.h>
+#include <plc/reactor.h>
 
 #include <threads.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*********************************************************************/
 /*                                                                   */
@@ -22,8 +25,11 @@
 /*********************************************************************/
 
 static struct {
-    GList   *units;
+    once_flag   once;
+    mtx_t       mtx;
+    GList       *units;
 } Stack = {
+    .once = ONCE_FLAG_INIT,
     .units = NULL,
 };
 
@@ -33,12 +39,49 @@ static struct {
 /*                                                                   */
 /*********************************************************************/
 
+static void StackInit()
+{
+    mtx_init(&Stack.mtx, mtx_plain | mtx_recursive);
+}
+
 static void UnitsStatusCheck()
 {
+    StackLock();
+
+    unsigned    count = g_list_length(*StackUnitsGet());
+    unsigned    i = 0;
+
+    if (count == 0) {
+        StackUnlock();
+        return;
+    }
+
+    RpcUnitCheck    *checks = (RpcUnitCheck *)calloc(count, sizeof(RpcUnitCheck));
+
+    /**
+     * Units announced by discovery heartbeats are checked by discovery
+     * and units behind sub-masters are checked by sub-masters. Units
+     * are collected under lock and checked without it.
+     */
+
     for (GList *u = *StackUnitsGet(); u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
 
-        if (RpcUnitStatusCheck(unit->id)) {
+        if (!unit->announced && unit->hops == 0) {
+            checks[i++].unit = unit->id;
+        }
+    }
+    count = i;
+
+    StackUnlock();
+
+    RpcUnitsStatusCheck(checks, count, STACK_TIMEOUT_MS);
+
+    StackLock();
+    for (i = 0; i < count; i++) {
+        StackUnit *unit = StackUnitGet(checks[i].unit);
+
+        if (checks[i].online) {
             if (!unit->active) {
                 unit->active = true;
                 LogF(LOG_TYPE_INFO, "STACK", "Unit \"%s\" is online", unit->name);
@@ -50,119 +93,213 @@ static void UnitsStatusCheck()
             }
         }
     }
+    StackUnlock();
+
+    free(checks);
 }
 
 static void SecurityControllersUpdate()
 {
-    GList   *units = NULL;
-    bool    master_status = false;
-    bool    master_alarm = false;
-    bool    slave_status = false;
-    bool    slave_alarm = false;
-
-    if (!RpcSecurityStatusGet(RPC_DEFAULT_UNIT, &master_status)) {
-        LogF(LOG_TYPE_ERROR, "STACK", "Failed to get Security status from Unit %d", 0);
-        return;
-    }
-
-    if (!RpcSecurityAlarmGet(RPC_DEFAULT_UNIT, &master_alarm)) {
-        LogF(LOG_TYPE_ERROR, "STACK", "Failed to get Security alarm from Unit %d", 0);
+    GList               *units = NULL;
+    RpcSecurityState    master = { .unit = RPC_DEFAULT_UNIT };
+    RpcSecurityState    *newest = &master;
+    bool                tied = false;
+    unsigned            count = 0;
+
+    RpcSecurityReconcile(&master, 1, STACK_TIMEOUT_MS);
+    if (!master.result) {
+        LogF(LOG_TYPE_ERROR, "STACK", "Failed to get Security state from Unit %d", RPC_DEFAULT_UNIT);
         return;
     }
 
     StackActiveUnitsGet(&units);
 
+    RpcSecurityState *states = (RpcSecurityState *)calloc(g_list_length(units) + 1, sizeof(RpcSecurityState));
+
     for (GList *u = units; u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
 
-        if (unit->id == RPC_DEFAULT_UNIT) {
-            continue;
+        if (unit->id != RPC_DEFAULT_UNIT && unit->hops == 0) {
+            states[count] = master;
+            states[count++].unit = unit->id;
         }
+    }
+
+    /**
+     * Every unit gets master state in one request and applies it when
+     * it is newer, unit with newer state keeps it and replies it back.
+     * Newest state wins, so units do not switch alarm back and forth.
+     */
+
+    RpcSecurityReconcile(states, count, STACK_TIMEOUT_MS);
+
+    StackLock();
+    for (unsigned i = 0; i < count; i++) {
+        StackUnit *unit = StackUnitGet(states[i].unit);
 
-        if (!RpcSecurityStatusGet(unit->id, &slave_status)) {
+        if (!states[i].result) {
             if (!unit->error) {
                 unit->error = true;
-                LogF(LOG_TYPE_ERROR, "STACK", "Failed to get Security status from Unit %d", unit->id);
-                continue;
-            }
-        } else {
-            if (unit->error) {
-                unit->error = false;
-                LogF(LOG_TYPE_INFO, "STACK", "Successfully get Security status from Unit %d", unit->id);
+                LogF(LOG_TYPE_ERROR, "STACK", "Failed to reconcile Security state with Unit %d", unit->id);
             }
+            continue;
         }
 
-        if (slave_status != master_status) {
-            if (!RpcSecurityStatusSet(unit->id, master_status)) {
-                if (!unit->error) {
-                    unit->error = true;
-                    LogF(LOG_TYPE_ERROR, "STACK", "Failed to set Security status from Unit %d", unit->id);
-                    continue;
-                }
-            } else {
-                if (unit->error) {
-                    unit->error = false;
-                    LogF(LOG_TYPE_INFO, "STACK", "Successfully set Security status from Unit %d", unit->id);
-                }
-            }
+        if (unit->error) {
+            unit->error = false;
+            LogF(LOG_TYPE_INFO, "STACK", "Successfully reconcile Security state with Unit %d", unit->id);
         }
 
-        if (!RpcSecurityAlarmGet(unit->id, &slave_alarm)) {
-            if (!unit->error) {
-                unit->error = true;
-                LogF(LOG_TYPE_ERROR, "STACK", "Failed to get Security alarm from Unit %d", unit->id);
-                continue;
-            }
-        } else {
-            if (unit->error) {
-                unit->error = false;
-                LogF(LOG_TYPE_INFO, "STACK", "Successfully get Security alarm from Unit %d", unit->id);
-            }
+        /**
+         * Concurrent changes from the same base have equal versions,
+         * unit id breaks the tie, so every cycle picks the same unit
+         */
+
+        if (states[i].version > newest->version ||
+            (states[i].version == newest->version && states[i].unit > newest->unit)) {
+            newest = &states[i];
         }
+    }
+    StackUnlock();
 
-        if (slave_alarm && !master_alarm) {
-            if (!RpcSecurityAlarmSet(RPC_DEFAULT_UNIT, true)) {
-                if (!unit->error) {
-                    unit->error = true;
-                    LogF(LOG_TYPE_ERROR, "STACK", "Failed to set Security alarm to Unit %d", RPC_DEFAULT_UNIT);
-                    continue;
-                }
-            } else {
-                master_alarm = true;
-                if (unit->error) {
-                    unit->error = false;
-                    LogF(LOG_TYPE_INFO, "STACK", "Successfully set Security alarm to Unit %d", RPC_DEFAULT_UNIT);
-                }
-            }
+    for (unsigned i = 0; i <= count; i++) {
+        RpcSecurityState *state = (i < count) ? &states[i] : &master;
+
+        if (state != newest && state->result && state->version == newest->version &&
+            (state->status != newest->status || state->alarm != newest->alarm)) {
+            tied = true;
         }
+    }
 
-        if (!slave_alarm && master_alarm) {
-            if (!RpcSecurityAlarmSet(unit->id, true)) {
-                if (!unit->error) {
-                    unit->error = true;
-                    LogF(LOG_TYPE_ERROR, "STACK", "Failed to set Security alarm to Unit %d", unit->id);
-                    continue;
-                }
-            } else {
-                if (unit->error) {
-                    unit->error = false;
-                    LogF(LOG_TYPE_INFO, "STACK", "Successfully set Security alarm to Unit %d", unit->id);
-                }
-            }
+    /**
+     * Newest unit state is applied to master here and is sent to other
+     * units on next cycle. Units with equal version do not take it, so
+     * state chosen from a tie is applied one version above.
+     */
+
+    if (newest != &master || tied) {
+        RpcSecurityState apply = *newest;
+
+        if (tied) {
+            LogF(LOG_TYPE_INFO, "STACK", "Concurrent Security changes, keep state of Unit %d", newest->unit);
+            apply.version++;
+        } else {
+            LogF(LOG_TYPE_INFO, "STACK", "Apply Security state from Unit %d", newest->unit);
+        }
+
+        apply.unit = RPC_DEFAULT_UNIT;
+        RpcSecurityReconcile(&apply, 1, STACK_TIMEOUT_MS);
+        if (!apply.result) {
+            LogF(LOG_TYPE_ERROR, "STACK", "Failed to set Security state to Unit %d", RPC_DEFAULT_UNIT);
         }
     }
 
+    free(states);
     g_list_free(units);
     units = NULL;
 }
 
-static int StackThread(void *data)
+static RpcStackUnit *ReportedUnitGet(GList *units, unsigned id)
 {
-    for (;;) {
-        UnitsStatusCheck();
-        SecurityControllersUpdate();
-        UtilsSecSleep(3);
+    for (GList *u = units; u != NULL; u = u->next) {
+        RpcStackUnit *unit = (RpcStackUnit *)u->data;
+
+        if (unit->id == id) {
+            return unit;
+        }
     }
+
+    return NULL;
+}
+
+/**
+ * @brief Update units behind sub-master from its units list, it is one
+ * request per sub-master whatever its units count is
+ */
+static void SubmasterUpdate(unsigned sub, bool active)
+{
+    GList   *units = NULL;
+    bool    result = active && RpcStackUnitsGet(sub, &units);
+
+    StackLock();
+    for (GList *u = units; u != NULL; u = u->next) {
+        RpcStackUnit    *reported = (RpcStackUnit *)u->data;
+        StackUnit       *unit = StackUnitGet(reported->id);
+
+        if (unit != NULL || reported->id == RPC_DEFAULT_UNIT) {
+            continue;
+        }
+
+        if (reported->hops + 1 > STACK_PATH_MAX) {
+            LogF(LOG_TYPE_ERROR, "STACK", "Unit \"%s\" is too deep behind Unit %d", reported->name, sub);
+            continue;
+        }
+
+        unit = StackUnitNew(reported->id, reported->name, reported->ip, reported->port);
+        unit->path[0] = sub;
+        memcpy(unit->path + 1, reported->path, reported->hops * sizeof(unsigned));
+        unit->hops = reported->hops + 1;
+        StackUnitAdd(unit);
+        LogF(LOG_TYPE_INFO, "STACK", "Unit \"%s\" joined stack behind Unit %d", unit->name, sub);
+    }
+
+    /**
+     * Units missing in list or behind failed sub-master are offline
+     */
+
+    for (GList *u = *StackUnitsGet(); u != NULL; u = u->next) {
+        StackUnit       *unit = (StackUnit *)u->data;
+        RpcStackUnit    *reported = ReportedUnitGet(units, unit->id);
+        bool            active = result && reported != NULL && reported->active;
+
+        if (unit->hops == 0 || unit->path[0] != sub || unit->active == active) {
+            continue;
+        }
+
+        unit->active = active;
+        LogF(LOG_TYPE_INFO, "STACK", "Unit \"%s\" is %s", unit->name, active ? "online" : "offline");
+    }
+    StackUnlock();
+
+    g_list_free_full(units, &free);
+}
+
+static void SubmastersUpdate()
+{
+    GList *subs = NULL;
+
+    /**
+     * Sub-masters are collected under lock, their units lists are
+     * requested without it
+     */
+
+    StackLock();
+    for (GList *u = *StackUnitsGet(); u != NULL; u = u->next) {
+        StackUnit *unit = (StackUnit *)u->data;
+
+        if (unit->submaster && unit->hops == 0) {
+            StackUnit *sub = (StackUnit *)malloc(sizeof(StackUnit));
+
+            memcpy(sub, unit, sizeof(StackUnit));
+            subs = g_list_append(subs, (void *)sub);
+        }
+    }
+    StackUnlock();
+
+    for (GList *s = subs; s != NULL; s = s->next) {
+        StackUnit *sub = (StackUnit *)s->data;
+
+        SubmasterUpdate(sub->id, sub->active);
+    }
+
+    g_list_free_full(subs, &free);
+}
+
+static void StackTask(PeriodicTask *task, void *data)
+{
+    UnitsStatusCheck();
+    SubmastersUpdate();
+    SecurityControllersUpdate();
 }
 
 /*********************************************************************/
@@ -173,75 +310,108 @@ static int StackThread(void *data)
 
 unsigned StackUnitIdGet(const char *name)
 {
+    unsigned id = 0;
+
+    StackLock();
     for (GList *u = Stack.units; u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
         if (!strcmp(unit->name, name)) {
-            return unit->id;
+            id = unit->id;
+            break;
         }
     }
-    return 0;
+    StackUnlock();
+
+    return id;
 }
 
 StackUnit *StackUnitNew(unsigned id, const char *name, const char *ip, unsigned port)
 {
-    StackUnit *unit = (StackUnit *)malloc(sizeof(StackUnit));
+    StackUnit *unit = (StackUnit *)calloc(1, sizeof(StackUnit));
 
     unit->id = id;
     unit->error = false;
-    strncpy(unit->name, name, SHORT_STR_LEN);
-    strncpy(unit->ip, ip, SHORT_STR_LEN);
+    strncpy(unit->name, name, SHORT_STR_LEN - 1);
+    strncpy(unit->ip, ip, SHORT_STR_LEN - 1);
     unit->active = false;
     unit->port = port;
+    unit->channel = 0;
+    unit->announced = false;
+    unit->version = 0;
+    unit->submaster = false;
+    unit->hops = 0;
 
     return unit;
 }
 
 StackUnit *StackUnitNameGet(const char *name)
 {
+    StackUnit *found = NULL;
+
+    StackLock();
     for (GList *u = Stack.units; u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
         if (!strcmp(unit->name, name)) {
-            return unit;
+            found = unit;
+            break;
         }
     }
-    return NULL;
+    StackUnlock();
+
+    return found;
 }
 
 StackUnit *StackUnitGet(unsigned id)
 {
+    StackUnit *found = NULL;
+
+    StackLock();
     for (GList *u = Stack.units; u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
         if (unit->id == id) {
-            return unit;
+            found = unit;
+            break;
         }
     }
-    return NULL;
+    StackUnlock();
+
+    return found;
+}
+
+bool StackUnitCopy(unsigned id, StackUnit *unit)
+{
+    StackLock();
+    StackUnit *found = StackUnitGet(id);
+    if (found != NULL) {
+        memcpy(unit, found, sizeof(StackUnit));
+    }
+    StackUnlock();
+
+    return (found != NULL);
 }
 
 void StackUnitAdd(StackUnit *unit)
 {
+    StackLock();
     Stack.units = g_list_append(Stack.units, (void *)unit);
+    StackUnlock();
 }
 
 bool StackUnitNameCheck(const char *name)
 {
-    for (GList *u = Stack.units; u != NULL; u = u->next) {
-        StackUnit *unit = (StackUnit *)u->data;
-        if (!strcmp(unit->name, name)) {
-            return true;
-        }
-    }
-    return false;
+    return (StackUnitNameGet(name) != NULL);
 }
 
 void StackActiveUnitsGet(GList **units)
 {
+    StackLock();
     for (GList *u = Stack.units; u != NULL; u = u->next) {
         StackUnit *unit = (StackUnit *)u->data;
         if (unit->active) {
             *units = g_list_append(*units, (void *)unit);
         }
     }
+    StackUnlock();
 }
 
 GList **StackUnitsGet()
@@ -249,18 +419,25 @@ GList **StackUnitsGet()
     return &Stack.units;
 }
 
-bool StackStart()
+void StackLock()
 {
-    thrd_t  stk_th;
+    call_once(&Stack.once, &StackInit);
+    mtx_lock(&Stack.mtx);
+}
 
+void StackUnlock()
+{
+    mtx_unlock(&Stack.mtx);
+}
+
+bool StackStart()
+{
     Log(LOG_TYPE_INFO, "STACK", "Starting Stack monitoring");
 
-    if (thrd_create(&stk_th, &StackThread, NULL) != thrd_success) {
-        return false;
-    }
-    if (thrd_detach(stk_th) != thrd_success) {
+    if (!ReplicaStart()) {
+        Log(LOG_TYPE_ERROR, "STACK", "Failed to start units state replication");
         return false;
     }
 
-    return true;
+    return ReactorJobTaskAdd("stack", STACK_PERIOD_MS, &StackTask, NULL);
 }
@@ -0,0 +1,345 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stack/statecodec.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+#define FLAG_DELTA              0x01
+#define FLAG_SECURITY_CHANGED   0x02
+#define FLAG_SECURITY_STATUS    0x04
+#define FLAG_SECURITY_ALARM     0x08
+
+typedef struct {
+    uint8_t *buf;
+    size_t  size;
+    size_t  len;
+    bool    error;
+} Writer;
+
+typedef struct {
+    const uint8_t   *buf;
+    size_t          len;
+    size_t          pos;
+    bool            error;
+} Reader;
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void ByteWrite(Writer *w, uint8_t byte)
+{
+    if (w->len >= w->size) {
+        w->error = true;
+        return;
+    }
+    w->buf[w->len++] = byte;
+}
+
+static void VarWrite(Writer *w, uint64_t value)
+{
+    while (value >= 0x80) {
+        ByteWrite(w, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    ByteWrite(w, (uint8_t)value);
+}
+
+static void FloatWrite(Writer *w, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    for (unsigned i = 0; i < sizeof(bits); i++) {
+        ByteWrite(w, (uint8_t)(bits >> (i * 8)));
+    }
+}
+
+static void NameWrite(Writer *w, const char *name)
+{
+    size_t len = strnlen(name, SHORT_STR_LEN - 1);
+
+    VarWrite(w, len);
+    for (size_t i = 0; i < len; i++) {
+        ByteWrite(w, (uint8_t)name[i]);
+    }
+}
+
+static uint8_t ByteRead(Reader *r)
+{
+    if (r->pos >= r->len) {
+        r->error = true;
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+static uint64_t VarRead(Reader *r)
+{
+    uint64_t value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = ByteRead(r);
+
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+
+    r->error = true;
+    return 0;
+}
+
+static float FloatRead(Reader *r)
+{
+    uint32_t    bits = 0;
+    float       value;
+
+    for (unsigned i = 0; i < sizeof(bits); i++) {
+        bits |= (uint32_t)ByteRead(r) << (i * 8);
+    }
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static void NameRead(Reader *r, char *name)
+{
+    uint64_t len = VarRead(r);
+
+    if (len >= SHORT_STR_LEN || len > r->len - r->pos) {
+        r->error = true;
+        name[0] = '\0';
+        return;
+    }
+
+    memcpy(name, r->buf + r->pos, len);
+    name[len] = '\0';
+    r->pos += len;
+}
+
+/**
+ * @brief Read items count, every item takes at least one byte, so
+ * broken count can not make huge list
+ */
+static uint64_t CountRead(Reader *r)
+{
+    uint64_t count = VarRead(r);
+
+    if (count > r->len - r->pos) {
+        r->error = true;
+        return 0;
+    }
+
+    return count;
+}
+
+static void WaterersDecode(Reader *r, GList **waterers)
+{
+    uint64_t count = CountRead(r);
+
+    for (uint64_t i = 0; i < count && !r->error; i++) {
+        RpcWaterer *waterer = (RpcWaterer *)calloc(1, sizeof(RpcWaterer));
+
+        NameRead(r, waterer->name);
+        waterer->status = ByteRead(r);
+        waterer->valve = ByteRead(r);
+
+        uint64_t times = CountRead(r);
+
+        for (uint64_t t = 0; t < times && !r->error; t++) {
+            RpcWatererTime *time = (RpcWatererTime *)malloc(sizeof(RpcWatererTime));
+
+            time->day = ByteRead(r);
+            time->hour = ByteRead(r);
+            time->min = ByteRead(r);
+            time->state = ByteRead(r);
+            waterer->times = g_list_append(waterer->times, (void *)time);
+        }
+
+        *waterers = g_list_append(*waterers, (void *)waterer);
+    }
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+size_t StateEncode(const RpcUnitState *state, uint8_t *buf, size_t size)
+{
+    Writer  w = { .buf = buf, .size = size, .len = 0, .error = false };
+    uint8_t flags = 0;
+
+    if (state->delta) {
+        flags |= FLAG_DELTA;
+    }
+    if (state->security_changed) {
+        flags |= FLAG_SECURITY_CHANGED;
+    }
+    if (state->security_status) {
+        flags |= FLAG_SECURITY_STATUS;
+    }
+    if (state->security_alarm) {
+        flags |= FLAG_SECURITY_ALARM;
+    }
+
+    ByteWrite(&w, STATE_CODEC_MAGIC);
+    ByteWrite(&w, STATE_CODEC_VER);
+    ByteWrite(&w, flags);
+    VarWrite(&w, state->version);
+
+    VarWrite(&w, g_list_length(state->security_sensors));
+    for (GList *s = state->security_sensors; s != NULL; s = s->next) {
+        RpcSecuritySensor *sensor = (RpcSecuritySensor *)s->data;
+
+        NameWrite(&w, sensor->name);
+        ByteWrite(&w, sensor->type);
+        ByteWrite(&w, sensor->detected);
+    }
+
+    VarWrite(&w, g_list_length(state->meteo_sensors));
+    for (GList *s = state->meteo_sensors; s != NULL; s = s->next) {
+        RpcMeteoSensor *sensor = (RpcMeteoSensor *)s->data;
+
+        NameWrite(&w, sensor->name);
+        ByteWrite(&w, sensor->type);
+        FloatWrite(&w, sensor->ds18b20.temp);
+    }
+
+    VarWrite(&w, g_list_length(state->sockets));
+    for (GList *s = state->sockets; s != NULL; s = s->next) {
+        RpcSocket *socket = (RpcSocket *)s->data;
+
+        NameWrite(&w, socket->name);
+        ByteWrite(&w, socket->group);
+        ByteWrite(&w, socket->status);
+    }
+
+    VarWrite(&w, g_list_length(state->tanks));
+    for (GList *t = state->tanks; t != NULL; t = t->next) {
+        RpcTank *tank = (RpcTank *)t->data;
+
+        NameWrite(&w, tank->name);
+        ByteWrite(&w, tank->status);
+        VarWrite(&w, tank->level);
+        ByteWrite(&w, tank->pump);
+        ByteWrite(&w, tank->valve);
+    }
+
+    VarWrite(&w, g_list_length(state->waterers));
+    for (GList *wt = state->waterers; wt != NULL; wt = wt->next) {
+        RpcWaterer *waterer = (RpcWaterer *)wt->data;
+
+        NameWrite(&w, waterer->name);
+        ByteWrite(&w, waterer->status);
+        ByteWrite(&w, waterer->valve);
+
+        VarWrite(&w, g_list_length(waterer->times));
+        for (GList *t = waterer->times; t != NULL; t = t->next) {
+            RpcWatererTime *time = (RpcWatererTime *)t->data;
+
+            ByteWrite(&w, time->day);
+            ByteWrite(&w, time->hour);
+            ByteWrite(&w, time->min);
+            ByteWrite(&w, time->state);
+        }
+    }
+
+    return w.error ? 0 : w.len;
+}
+
+bool StateEncodedCheck(const uint8_t *buf, size_t len)
+{
+    return (len >= 2 && buf[0] == STATE_CODEC_MAGIC && buf[1] == STATE_CODEC_VER);
+}
+
+bool StateDecode(const uint8_t *buf, size_t len, RpcUnitState *state)
+{
+    Reader r = { .buf = buf, .len = len, .pos = 0, .error = false };
+
+    memset(state, 0x0, sizeof(RpcUnitState));
+
+    if (!StateEncodedCheck(buf, len)) {
+        return false;
+    }
+    r.pos = 2;
+
+    uint8_t flags = ByteRead(&r);
+
+    state->delta = (flags & FLAG_DELTA) != 0;
+    state->security_changed = (flags & FLAG_SECURITY_CHANGED) != 0;
+    state->security_status = (flags & FLAG_SECURITY_STATUS) != 0;
+    state->security_alarm = (flags & FLAG_SECURITY_ALARM) != 0;
+    state->version = VarRead(&r);
+
+    uint64_t count = CountRead(&r);
+    for (uint64_t i = 0; i < count && !r.error; i++) {
+        RpcSecuritySensor *sensor = (RpcSecuritySensor *)malloc(sizeof(RpcSecuritySensor));
+
+        NameRead(&r, sensor->name);
+        sensor->type = ByteRead(&r);
+        sensor->detected = ByteRead(&r);
+        state->security_sensors = g_list_append(state->security_sensors, (void *)sensor);
+    }
+
+    count = CountRead(&r);
+    for (uint64_t i = 0; i < count && !r.error; i++) {
+        RpcMeteoSensor *sensor = (RpcMeteoSensor *)malloc(sizeof(RpcMeteoSensor));
+
+        NameRead(&r, sensor->name);
+        sensor->type = ByteRead(&r);
+        sensor->ds18b20.temp = FloatRead(&r);
+        state->meteo_sensors = g_list_append(state->meteo_sensors, (void *)sensor);
+    }
+
+    count = CountRead(&r);
+    for (uint64_t i = 0; i < count && !r.error; i++) {
+        RpcSocket *socket = (RpcSocket *)malloc(sizeof(RpcSocket));
+
+        NameRead(&r, socket->name);
+        socket->group = ByteRead(&r);
+        socket->status = ByteRead(&r);
+        state->sockets = g_list_append(state->sockets, (void *)socket);
+    }
+
+    count = CountRead(&r);
+    for (uint64_t i = 0; i < count && !r.error; i++) {
+        RpcTank *tank = (RpcTank *)malloc(sizeof(RpcTank));
+
+        NameRead(&r, tank->name);
+        tank->status = ByteRead(&r);
+        tank->level = VarRead(&r);
+        tank->pump = ByteRead(&r);
+        tank->valve = ByteRead(&r);
+        state->tanks = g_list_append(state->tanks, (void *)tank);
+    }
+
+    WaterersDecode(&r, &state->waterers);
+
+    if (r.error) {
+        RpcUnitStateFree(state);
+        return false;
+    }
+
+    return true;
+}
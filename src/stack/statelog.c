@@ -0,0 +1,287 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+
+#include <stack/statelog.h>
+#include <utils/events.h>
+#include <utils/log.h>
+#include <plc/reactor.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+static const StateSection Sections[EVENT_TYPE_MAX] = {
+    [EVENT_SOCKET_CHANGED] = STATE_SECTION_SOCKET,
+    [EVENT_TANK_LEVEL_CHANGED] = STATE_SECTION_TANK,
+    [EVENT_TANK_STATE_CHANGED] = STATE_SECTION_TANK,
+    [EVENT_WATERER_CHANGED] = STATE_SECTION_WATERER,
+    [EVENT_SENSOR_DETECTED] = STATE_SECTION_SECURITY,
+    [EVENT_SECURITY_CHANGED] = STATE_SECTION_SECURITY,
+    [EVENT_METEO_CHANGED] = STATE_SECTION_METEO
+};
+
+typedef struct {
+    uint64_t        since;
+    uint64_t        deadline_ns;
+    StateNotifyFunc func;
+    void            *data;
+} StateWaiter;
+
+static struct {
+    mtx_t           mtx;
+    cnd_t           changed;
+    uint64_t        version;
+    uint64_t        trimmed;
+    StateChange     log[STATE_LOG_LEN];
+    unsigned long   dropped;
+    EventSubscriber *sub;
+    GList           *waiters;
+} StateLog = {
+    .version = 0,
+    .trimmed = 0,
+    .dropped = 0,
+    .sub = NULL,
+    .waiters = NULL
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void ChangeAdd(StateSection section, const char *name)
+{
+    StateChange *change = &StateLog.log[StateLog.version % STATE_LOG_LEN];
+
+    /**
+     * Slot is reused, so changes up to its old version can not be
+     * listed anymore. Slot of version skipped on events loss keeps
+     * older version, so trimmed version never goes back.
+     */
+
+    if (change->version > StateLog.trimmed) {
+        StateLog.trimmed = change->version;
+    }
+
+    change->version = ++StateLog.version;
+    change->section = section;
+    strncpy(change->name, name, SHORT_STR_LEN - 1);
+    change->name[SHORT_STR_LEN - 1] = '\0';
+}
+
+/**
+ * @brief Call handlers of waiters which version is changed or which
+ * deadline is passed, handlers are called without log lock
+ */
+static void WaitersNotify(uint64_t now)
+{
+    GList *ready = NULL;
+
+    mtx_lock(&StateLog.mtx);
+
+    for (GList *w = StateLog.waiters; w != NULL;) {
+        StateWaiter *waiter = (StateWaiter *)w->data;
+        GList       *next = w->next;
+
+        if (waiter->since != StateLog.version || now >= waiter->deadline_ns) {
+            StateLog.waiters = g_list_delete_link(StateLog.waiters, w);
+            ready = g_list_append(ready, (void *)waiter);
+        }
+        w = next;
+    }
+
+    mtx_unlock(&StateLog.mtx);
+
+    for (GList *w = ready; w != NULL; w = w->next) {
+        StateWaiter *waiter = (StateWaiter *)w->data;
+
+        waiter->func(waiter->data);
+    }
+
+    g_list_free_full(ready, &free);
+}
+
+static void WaitersTask(PeriodicTask *task, void *data)
+{
+    WaitersNotify(UtilsMonoNsGet());
+}
+
+static void EventsProcess(int fd, void *data)
+{
+    Event event;
+
+    EventReset(StateLog.sub);
+
+    while (EventPop(StateLog.sub, &event)) {
+        mtx_lock(&StateLog.mtx);
+        ChangeAdd(Sections[event.type], event.name);
+        mtx_unlock(&StateLog.mtx);
+    }
+
+    unsigned long dropped = EventDroppedGet(StateLog.sub);
+
+    if (dropped != StateLog.dropped) {
+        mtx_lock(&StateLog.mtx);
+        StateLog.dropped = dropped;
+        StateLog.trimmed = ++StateLog.version;
+        mtx_unlock(&StateLog.mtx);
+    }
+
+    /**
+     * Waiters are woken once per events burst, not per change
+     */
+
+    cnd_broadcast(&StateLog.changed);
+    WaitersNotify(0);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool StateLogStart()
+{
+    if (mtx_init(&StateLog.mtx, mtx_plain) != thrd_success) {
+        return false;
+    }
+
+    if (cnd_init(&StateLog.changed) != thrd_success) {
+        return false;
+    }
+
+    /**
+     * Versions start from boot time, so reader which knows version
+     * of previous run always gets full state after unit restart
+     */
+
+    StateLog.version = (uint64_t)time(NULL) << 16;
+    StateLog.trimmed = StateLog.version;
+
+    StateLog.sub = EventSubscribe("statelog", EVENT_MASK_ALL);
+    if (StateLog.sub == NULL) {
+        return false;
+    }
+
+    if (!ReactorTaskAdd("statelog", STATE_NOTIFY_TICK_MS, &WaitersTask, NULL)) {
+        return false;
+    }
+
+    return ReactorFdAdd(EventFdGet(StateLog.sub), &EventsProcess, NULL);
+}
+
+uint64_t StateVersionGet()
+{
+    uint64_t version;
+
+    mtx_lock(&StateLog.mtx);
+    version = StateLog.version;
+    mtx_unlock(&StateLog.mtx);
+
+    return version;
+}
+
+bool StateChangesWait(uint64_t since, unsigned timeout_ms)
+{
+    struct timespec deadline;
+    bool            changed;
+
+    timespec_get(&deadline, TIME_UTC);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    mtx_lock(&StateLog.mtx);
+
+    while (StateLog.version == since) {
+        if (cnd_timedwait(&StateLog.changed, &StateLog.mtx, &deadline) != thrd_success) {
+            break;
+        }
+    }
+
+    changed = (StateLog.version != since);
+    mtx_unlock(&StateLog.mtx);
+
+    return changed;
+}
+
+bool StateChangesNotify(uint64_t since, unsigned timeout_ms, StateNotifyFunc func, void *data)
+{
+    if (StateLog.sub == NULL) {
+        return false;
+    }
+
+    mtx_lock(&StateLog.mtx);
+
+    if (StateLog.version != since) {
+        mtx_unlock(&StateLog.mtx);
+        func(data);
+        return true;
+    }
+
+    StateWaiter *waiter = (StateWaiter *)malloc(sizeof(StateWaiter));
+
+    waiter->since = since;
+    waiter->deadline_ns = UtilsMonoNsGet() + (uint64_t)timeout_ms * 1000000;
+    waiter->func = func;
+    waiter->data = data;
+    StateLog.waiters = g_list_append(StateLog.waiters, (void *)waiter);
+
+    mtx_unlock(&StateLog.mtx);
+    return true;
+}
+
+bool StateChangesGet(uint64_t since, GList **changes)
+{
+    mtx_lock(&StateLog.mtx);
+
+    if (since < StateLog.trimmed || since > StateLog.version) {
+        mtx_unlock(&StateLog.mtx);
+        return false;
+    }
+
+    for (uint64_t v = since + 1; v <= StateLog.version; v++) {
+        const StateChange   *change = &StateLog.log[(v - 1) % STATE_LOG_LEN];
+        bool                found = false;
+
+        for (GList *c = *changes; c != NULL; c = c->next) {
+            StateChange *item = (StateChange *)c->data;
+
+            if (item->section == change->section && !strcmp(item->name, change->name)) {
+                item->version = change->version;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            StateChange *item = (StateChange *)malloc(sizeof(StateChange));
+
+            *item = *change;
+            *changes = g_list_append(*changes, (void *)item);
+        }
+    }
+
+    mtx_unlock(&StateLog.mtx);
+    return true;
+}
@@ -0,0 +1,272 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <utils/log.h>
+#include <scenario/scenario.h>
+#include <scenario/logic.h>
+#include <utils/configs/cfgscenario.h>
+
+#include <stdlib.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+static const char *Events[EVENT_TYPE_MAX] = {
+    [EVENT_SOCKET_CHANGED] = "socket",
+    [EVENT_TANK_LEVEL_CHANGED] = "tank_level",
+    [EVENT_TANK_STATE_CHANGED] = "tank_state",
+    [EVENT_WATERER_CHANGED] = "waterer",
+    [EVENT_SENSOR_DETECTED] = "sensor",
+    [EVENT_SECURITY_CHANGED] = "security",
+    [EVENT_METEO_CHANGED] = "meteo"
+};
+
+static const char *Ctrls[SCENARIO_CTRL_MAX] = {
+    [SCENARIO_CTRL_SOCKET] = "socket",
+    [SCENARIO_CTRL_SECURITY] = "security",
+    [SCENARIO_CTRL_TANK] = "tank",
+    [SCENARIO_CTRL_WATERER] = "waterer",
+    [SCENARIO_CTRL_METEO] = "meteo"
+};
+
+static const char *Fields[SCENARIO_FIELD_MAX] = {
+    [SCENARIO_FIELD_ANY] = "any",
+    [SCENARIO_FIELD_STATUS] = "status",
+    [SCENARIO_FIELD_ALARM] = "alarm",
+    [SCENARIO_FIELD_LEVEL] = "level",
+    [SCENARIO_FIELD_PUMP] = "pump",
+    [SCENARIO_FIELD_VALVE] = "valve",
+    [SCENARIO_FIELD_TEMP] = "temp",
+    [SCENARIO_FIELD_ERROR] = "error"
+};
+
+static const char *Cmps[] = {
+    [SCENARIO_CMP_EQ] = "=",
+    [SCENARIO_CMP_NE] = "<>",
+    [SCENARIO_CMP_LT] = "<",
+    [SCENARIO_CMP_LE] = "<=",
+    [SCENARIO_CMP_GT] = ">",
+    [SCENARIO_CMP_GE] = ">="
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static int NameFind(const char **names, unsigned count, json_t *jname, int def)
+{
+    const char *name = json_string_value(jname);
+
+    if (name == NULL) {
+        return def;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        if (names[i] != NULL && !strcmp(names[i], name)) {
+            return i;
+        }
+    }
+
+    LogF(LOG_TYPE_ERROR, "CONFIGS", "Unknown scenario keyword \"%s\"", name);
+    return -1;
+}
+
+static bool TestRead(json_t *data, ScenarioTest *test, int def_field)
+{
+    int     field = NameFind(Fields, SCENARIO_FIELD_MAX, json_object_get(data, "field"), def_field);
+    int     cmp = NameFind(Cmps, sizeof(Cmps) / sizeof(Cmps[0]), json_object_get(data, "cmp"), SCENARIO_CMP_EQ);
+    json_t  *jvalue = json_object_get(data, "value");
+
+    if (field < 0 || cmp < 0) {
+        return false;
+    }
+
+    test->field = field;
+    test->cmp = cmp;
+
+    if (json_is_boolean(jvalue)) {
+        test->value = json_is_true(jvalue);
+    } else {
+        test->value = json_number_value(jvalue);
+    }
+
+    return true;
+}
+
+static bool ScenariosLoad(json_t *data)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(data, "scenario"), index, value) {
+        Scenario *scenario = (Scenario *)malloc(sizeof(Scenario));
+
+        scenario->unit = json_integer_value(json_object_get(value, "unit"));
+
+        if (!strcmp(json_string_value(json_object_get(value, "type")), "inhome")) {
+            scenario->type = SCENARIO_IN_HOME;
+        } else if (!strcmp(json_string_value(json_object_get(value, "type")), "outhome")) {
+            scenario->type = SCENARIO_OUT_HOME;
+        } else {
+            Log(LOG_TYPE_ERROR, "CONFIGS", "Invalid scenario type");
+            free(scenario);
+            return false;
+        }
+
+        if (!strcmp(json_string_value(json_object_get(value, "ctrl")), "socket")) {
+            json_t *jsocket = json_object_get(value, "socket");
+            strncpy(scenario->socket.name, json_string_value(json_object_get(jsocket, "name")), SHORT_STR_LEN);
+            scenario->socket.status = json_boolean_value(json_object_get(jsocket, "status"));
+            scenario->ctrl = SCENARIO_CTRL_SOCKET;
+        }
+
+        ScenarioAdd(scenario);
+    }
+
+    return true;
+}
+
+static bool RulesLoad(json_t *data)
+{
+    size_t  index;
+    json_t  *value;
+    size_t  sub_index;
+    json_t  *sub_value;
+
+    json_array_foreach(json_object_get(data, "rules"), index, value) {
+        const char      *name = json_string_value(json_object_get(value, "name"));
+        json_t          *jtrigger = json_object_get(value, "trigger");
+        ScenarioRule    *rule = ScenarioRuleNew((name != NULL) ? name : "");
+
+        int event = NameFind(Events, EVENT_TYPE_MAX, json_object_get(jtrigger, "event"), -1);
+        if (event < 0 || !TestRead(jtrigger, &rule->trigger.test, SCENARIO_FIELD_ANY)) {
+            LogF(LOG_TYPE_ERROR, "CONFIGS", "Invalid trigger of rule \"%s\"", rule->name);
+            return false;
+        }
+
+        rule->trigger.event = event;
+        if (json_string_value(json_object_get(jtrigger, "name")) != NULL) {
+            strncpy(rule->trigger.name, json_string_value(json_object_get(jtrigger, "name")), SHORT_STR_LEN - 1);
+        }
+
+        json_array_foreach(json_object_get(value, "conditions"), sub_index, sub_value) {
+            ScenarioCondition *cond = (ScenarioCondition *)calloc(1, sizeof(ScenarioCondition));
+
+            int ctrl = NameFind(Ctrls, SCENARIO_CTRL_MAX, json_object_get(sub_value, "ctrl"), -1);
+            if (ctrl < 0 || !TestRead(sub_value, &cond->test, -1)) {
+                LogF(LOG_TYPE_ERROR, "CONFIGS", "Invalid condition of rule \"%s\"", rule->name);
+                free(cond);
+                return false;
+            }
+
+            cond->ctrl = ctrl;
+            if (json_string_value(json_object_get(sub_value, "name")) != NULL) {
+                strncpy(cond->name, json_string_value(json_object_get(sub_value, "name")), SHORT_STR_LEN - 1);
+            }
+            rule->conditions = g_list_append(rule->conditions, (void *)cond);
+        }
+
+        json_array_foreach(json_object_get(value, "actions"), sub_index, sub_value) {
+            ScenarioAction *action = (ScenarioAction *)calloc(1, sizeof(ScenarioAction));
+
+            int ctrl = NameFind(Ctrls, SCENARIO_CTRL_MAX, json_object_get(sub_value, "ctrl"), -1);
+            int field = NameFind(Fields, SCENARIO_FIELD_MAX, json_object_get(sub_value, "field"), SCENARIO_FIELD_STATUS);
+            if (ctrl < 0 || field < 0) {
+                LogF(LOG_TYPE_ERROR, "CONFIGS", "Invalid action of rule \"%s\"", rule->name);
+                free(action);
+                return false;
+            }
+
+            action->ctrl = ctrl;
+            action->field = field;
+            action->unit = json_integer_value(json_object_get(sub_value, "unit"));
+            action->status = json_boolean_value(json_object_get(sub_value, "status"));
+            if (json_string_value(json_object_get(sub_value, "name")) != NULL) {
+                strncpy(action->name, json_string_value(json_object_get(sub_value, "name")), SHORT_STR_LEN - 1);
+            }
+            rule->actions = g_list_append(rule->actions, (void *)action);
+        }
+
+        if (!ScenarioRuleAdd(rule)) {
+            return false;
+        }
+
+        LogF(LOG_TYPE_INFO, "CONFIGS", "Add scenario rule: \"%s\"", rule->name);
+    }
+
+    return true;
+}
+
+static bool LogicLoad(json_t *data)
+{
+    size_t  index;
+    json_t  *value;
+
+    json_array_foreach(json_object_get(data, "logic"), index, value) {
+        const char  *name = json_string_value(json_object_get(value, "name"));
+        json_t      *jcode = json_object_get(value, "code");
+        unsigned    count = json_array_size(jcode);
+
+        if (name == NULL || name[0] == '\0') {
+            LogF(LOG_TYPE_ERROR, "CONFIGS", "Logic program %zu has no name", index);
+            return false;
+        }
+
+        const char  **lines = (const char **)malloc(sizeof(char *) * (count + 1));
+
+        for (unsigned i = 0; i < count; i++) {
+            lines[i] = json_string_value(json_array_get(jcode, i));
+            if (lines[i] == NULL) {
+                lines[i] = "";
+            }
+        }
+
+        LogicProgram *prog = LogicProgramCompile(name,
+                                                 json_integer_value(json_object_get(value, "period")),
+                                                 lines, count);
+        free(lines);
+
+        if (prog == NULL) {
+            return false;
+        }
+
+        LogicProgramAdd(prog);
+    }
+
+    return true;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool CfgScenarioLoad(json_t *data)
+{
+    if (!ScenariosLoad(data)) {
+        return false;
+    }
+
+    if (!RulesLoad(data)) {
+        return false;
+    }
+
+    if (!LogicLoad(data)) {
+        return false;
+    }
+
+    return true;
+}
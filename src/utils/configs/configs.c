@@ -21,16 +21,18 @@
 #include <utils/configs/cfgsocket.h>
 #include <utils/configs/cfgtank.h>
 #include <utils/configs/cfgwaterer.h>
+#include <utils/configs/cfgscenario.h>
 #include <core/gpio.h>
 #include <core/extenders.h>
 #include <core/lcd.h>
 #include <net/notifier.h>
+#include <net/channel.h>
 #include <net/web/webserver.h>
 #include <net/tgbot/tgbot.h>
 #include <net/tgbot/tgmenu.h>
 #include <db/database.h>
 #include <stack/stack.h>
-#include <scenario/scenario.h>
+#include <stack/discovery.h>
 #include <cam/camera.h>
 #include <plc/plc.h>
 #include <plc/menu.h>
@@ -303,6 +305,26 @@ static bool PlcRead(const char *path)
     WebServerCredsSet(ip, port);
     LogF(LOG_TYPE_INFO, "CONFIGS", "Add Web Server at ip: \"%s\" port: \"%u\"", ip, port);
 
+    const unsigned channel = json_integer_value(json_object_get(server, "channel"));
+    if (channel != 0) {
+        const char *channel_ip = json_string_value(json_object_get(server, "channel_ip"));
+
+        if (channel_ip == NULL) {
+            channel_ip = ip;
+        }
+        ChannelServerSet(channel_ip, channel);
+        LogF(LOG_TYPE_INFO, "CONFIGS", "Add Channel server at ip: \"%s\" port: \"%u\"", channel_ip, channel);
+    }
+
+    json_t *jlog = json_object_get(data, "log");
+    if (jlog != NULL) {
+        const unsigned size = json_integer_value(json_object_get(jlog, "size"));
+        const unsigned days = json_integer_value(json_object_get(jlog, "days"));
+        const unsigned quota = json_integer_value(json_object_get(jlog, "quota"));
+        LogRotateSet(size, days, quota);
+        LogF(LOG_TYPE_INFO, "CONFIGS", "Add Log rotation size: \"%u KB\" days: \"%u\" quota: \"%u KB\"", size, days, quota);
+    }
+
     json_t *notifier = json_object_get(data, "notifier");
 
     json_t *jtg = json_object_get(notifier, "telegram");
@@ -353,10 +375,34 @@ static bool PlcRead(const char *path)
             json_string_value(json_object_get(value, "ip")),
             json_integer_value(json_object_get(value, "port"))
         );
+        unit->channel = json_integer_value(json_object_get(value, "channel"));
+        unit->submaster = json_boolean_value(json_object_get(value, "submaster"));
         StackUnitAdd(unit);
         LogF(LOG_TYPE_INFO, "CONFIGS", "Add Stack unit: \"%s\"", unit->name);
     }
 
+    json_t *jdiscovery = json_object_get(data, "discovery");
+    if (json_boolean_value(json_object_get(jdiscovery, "enabled"))) {
+        const char *group = json_string_value(json_object_get(jdiscovery, "group"));
+        const unsigned dport = json_integer_value(json_object_get(jdiscovery, "port"));
+        const unsigned period = json_integer_value(json_object_get(jdiscovery, "period"));
+        const unsigned missed = json_integer_value(json_object_get(jdiscovery, "missed"));
+
+        DiscoverySet(
+            (group != NULL) ? group : DISCOVERY_GROUP,
+            (dport != 0) ? dport : DISCOVERY_PORT,
+            (period != 0) ? period : DISCOVERY_PERIOD_MS,
+            (missed != 0) ? missed : DISCOVERY_MISSED
+        );
+        LogF(LOG_TYPE_INFO, "CONFIGS", "Add Stack discovery group: \"%s\"", (group != NULL) ? group : DISCOVERY_GROUP);
+
+        const char *name = json_string_value(json_object_get(jdiscovery, "name"));
+        if (name != NULL) {
+            DiscoveryUnitSet(json_integer_value(json_object_get(jdiscovery, "id")), name, port, channel);
+            LogF(LOG_TYPE_INFO, "CONFIGS", "Add Stack discovery heartbeat for unit: \"%s\"", name);
+        }
+    }
+
     /**
      * Cameras configs
      */
@@ -544,8 +590,6 @@ static bool ScenarioRead(const char *path)
 {
     char            full_path[STR_LEN];
     json_error_t    error;
-    size_t          index;
-    json_t          *value;
 
     snprintf(full_path, STR_LEN, "%s%s", path, CONFIGS_SCENARIO_FILE);
 
@@ -554,28 +598,9 @@ static bool ScenarioRead(const char *path)
         return false;
     }
 
-    json_array_foreach(json_object_get(data, "scenario"), index, value) {
-        Scenario *scenario = (Scenario *)malloc(sizeof(Scenario));
-
-        scenario->unit = json_integer_value(json_object_get(value, "unit"));
-
-        if (!strcmp(json_string_value(json_object_get(value, "type")), "inhome")) {
-            scenario->type = SCENARIO_IN_HOME;
-        } else if (!strcmp(json_string_value(json_object_get(value, "type")), "outhome")) {
-            scenario->type = SCENARIO_OUT_HOME;
-        } else {
-            Log(LOG_TYPE_ERROR, "CONFIGS", "Invalid scenario type");
-            return false;
-        }
-
-        if (!strcmp(json_string_value(json_object_get(value, "ctrl")), "socket")) {
-            json_t *jsocket = json_object_get(value, "socket");
-            strncpy(scenario->socket.name, json_string_value(json_object_get(jsocket, "name")), SHORT_STR_LEN);
-            scenario->socket.status = json_boolean_value(json_object_get(jsocket, "status"));
-            scenario->ctrl = SECURITY_CTRL_SOCKET;
-        }
-
-        ScenarioAdd(scenario);
+    if (!CfgScenarioLoad(data)) {
+        json_decref(data);
+        return false;
     }
 
     json_decref(data);
@@ -0,0 +1,278 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <utils/events.h>
+#include <utils/log.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+typedef struct {
+    atomic_size_t   seq;
+    Event           event;
+} EventCell;
+
+/**
+ * Bounded multi-producer queue: publishers never block each other
+ * and never wait for slow subscribers
+ */
+
+struct _EventSubscriber {
+    char            name[SHORT_STR_LEN];
+    unsigned        mask;
+    int             fd;
+    atomic_size_t   head;
+    atomic_size_t   tail;
+    atomic_ulong    dropped;
+    unsigned long   reported;
+    EventCell       cells[EVENT_QUEUE_LEN];
+};
+
+static struct {
+    EventSubscriber *subs[EVENT_SUBSCRIBERS_MAX];
+    atomic_uint     count;
+    mtx_t           mtx;
+    once_flag       once;
+} Events = {
+    .subs = {NULL},
+    .count = 0,
+    .once = ONCE_FLAG_INIT
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void EventsInit()
+{
+    mtx_init(&Events.mtx, mtx_plain);
+}
+
+static bool FdSignal(int fd)
+{
+    uint64_t one = 1;
+
+    return write(fd, &one, sizeof(one)) == sizeof(one);
+}
+
+static bool FdDrain(int fd)
+{
+    uint64_t cnt;
+
+    return read(fd, &cnt, sizeof(cnt)) == sizeof(cnt);
+}
+
+static bool QueuePush(EventSubscriber *sub, const Event *event)
+{
+    EventCell   *cell;
+    size_t      pos = atomic_load_explicit(&sub->head, memory_order_relaxed);
+
+    for (;;) {
+        cell = &sub->cells[pos & (EVENT_QUEUE_LEN - 1)];
+
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&sub->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&sub->head, memory_order_relaxed);
+        }
+    }
+
+    cell->event = *event;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    return true;
+}
+
+static bool QueuePop(EventSubscriber *sub, Event *event)
+{
+    EventCell   *cell;
+    size_t      pos = atomic_load_explicit(&sub->tail, memory_order_relaxed);
+
+    for (;;) {
+        cell = &sub->cells[pos & (EVENT_QUEUE_LEN - 1)];
+
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&sub->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&sub->tail, memory_order_relaxed);
+        }
+    }
+
+    *event = cell->event;
+    atomic_store_explicit(&cell->seq, pos + EVENT_QUEUE_LEN, memory_order_release);
+
+    return true;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+EventSubscriber *EventSubscribe(const char *name, unsigned mask)
+{
+    EventSubscriber *sub = NULL;
+
+    call_once(&Events.once, &EventsInit);
+
+    mtx_lock(&Events.mtx);
+
+    unsigned count = atomic_load(&Events.count);
+
+    if (count == EVENT_SUBSCRIBERS_MAX) {
+        mtx_unlock(&Events.mtx);
+        LogF(LOG_TYPE_ERROR, "EVENTS", "Too many subscribers, \"%s\" rejected", name);
+        return NULL;
+    }
+
+    sub = (EventSubscriber *)malloc(sizeof(EventSubscriber));
+    if (sub == NULL) {
+        mtx_unlock(&Events.mtx);
+        return NULL;
+    }
+
+    sub->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sub->fd < 0) {
+        free(sub);
+        mtx_unlock(&Events.mtx);
+        LogF(LOG_TYPE_ERROR, "EVENTS", "Failed to create eventfd for \"%s\"", name);
+        return NULL;
+    }
+
+    strncpy(sub->name, name, SHORT_STR_LEN - 1);
+    sub->name[SHORT_STR_LEN - 1] = '\0';
+    sub->mask = mask;
+    sub->reported = 0;
+    atomic_init(&sub->head, 0);
+    atomic_init(&sub->tail, 0);
+    atomic_init(&sub->dropped, 0);
+
+    for (size_t i = 0; i < EVENT_QUEUE_LEN; i++) {
+        atomic_init(&sub->cells[i].seq, i);
+    }
+
+    Events.subs[count] = sub;
+    atomic_store_explicit(&Events.count, count + 1, memory_order_release);
+
+    mtx_unlock(&Events.mtx);
+
+    return sub;
+}
+
+bool EventPublish(const Event *event)
+{
+    bool        ret = true;
+    unsigned    count = atomic_load_explicit(&Events.count, memory_order_acquire);
+
+    for (unsigned i = 0; i < count; i++) {
+        EventSubscriber *sub = Events.subs[i];
+
+        if ((sub->mask & EVENT_MASK(event->type)) == 0) {
+            continue;
+        }
+
+        if (!QueuePush(sub, event)) {
+            atomic_fetch_add_explicit(&sub->dropped, 1, memory_order_relaxed);
+            ret = false;
+            continue;
+        }
+
+        FdSignal(sub->fd);
+    }
+
+    return ret;
+}
+
+bool EventPop(EventSubscriber *sub, Event *event)
+{
+    unsigned long dropped = atomic_load_explicit(&sub->dropped, memory_order_relaxed);
+
+    if (dropped != sub->reported) {
+        LogF(LOG_TYPE_WARN, "EVENTS", "Subscriber \"%s\" lost %lu events", sub->name, dropped - sub->reported);
+        sub->reported = dropped;
+    }
+
+    return QueuePop(sub, event);
+}
+
+bool EventWait(EventSubscriber *sub, Event *event, unsigned timeout_ms)
+{
+    uint64_t        deadline = UtilsMonoNsGet() + (uint64_t)timeout_ms * 1000000ULL;
+    struct pollfd   pfd = {
+        .fd = sub->fd,
+        .events = POLLIN
+    };
+
+    for (;;) {
+        if (EventPop(sub, event)) {
+            return true;
+        }
+
+        uint64_t now = UtilsMonoNsGet();
+        if (now >= deadline) {
+            return false;
+        }
+
+        int ret = poll(&pfd, 1, (int)((deadline - now + 999999ULL) / 1000000ULL));
+        if (ret == 0) {
+            return EventPop(sub, event);
+        }
+
+        if (ret > 0) {
+            FdDrain(sub->fd);
+        }
+    }
+}
+
+int EventFdGet(EventSubscriber *sub)
+{
+    return sub->fd;
+}
+
+void EventReset(EventSubscriber *sub)
+{
+    FdDrain(sub->fd);
+}
+
+unsigned long EventDroppedGet(EventSubscriber *sub)
+{
+    return atomic_load_explicit(&sub->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,406 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include <glib-2.0/glib.h>
+
+#include <utils/jobs.h>
+#include <utils/utils.h>
+#include <utils/log.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+struct _Job {
+    char        name[SHORT_STR_LEN];
+    JobPriority prio;
+    JobFunc     func;
+    JobFreeFunc free_func;
+    void        *data;
+    JobState    state;
+    bool        result;
+    uint64_t    queued_ns;
+    atomic_uint refs;
+    mtx_t       mtx;
+    cnd_t       cnd;
+};
+
+typedef struct {
+    GQueue  queues[JOB_PRIO_MAX];
+    mtx_t   mtx;
+} JobsWorker;
+
+static thread_local int JobsWorkerId = -1;
+
+static struct {
+    JobsWorker      workers[JOBS_THREADS];
+    atomic_uint     next;
+    bool            started;
+    unsigned        pending;
+    mtx_t           mtx;
+    cnd_t           cnd;
+    JobsStats       stats;
+    uint64_t        wait_sum_ns;
+    uint64_t        run_sum_ns;
+} Jobs = {
+    .next = 0,
+    .started = false,
+    .pending = 0
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static void JobFree(Job *job)
+{
+    mtx_destroy(&job->mtx);
+    cnd_destroy(&job->cnd);
+    free(job);
+}
+
+static void JobFinish(Job *job, JobState state)
+{
+    mtx_lock(&job->mtx);
+    job->state = state;
+    cnd_broadcast(&job->cnd);
+    mtx_unlock(&job->mtx);
+}
+
+static Job *WorkerTake(unsigned id, bool *stolen)
+{
+    Job *job = NULL;
+
+    /**
+     * Highest priority first: own queue from the head,
+     * other workers queues from the tail
+     */
+
+    for (unsigned prio = 0; prio < JOB_PRIO_MAX; prio++) {
+        for (unsigned i = 0; i < JOBS_THREADS; i++) {
+            unsigned    victim = (id + i) % JOBS_THREADS;
+            JobsWorker  *w = &Jobs.workers[victim];
+
+            mtx_lock(&w->mtx);
+            if (victim == id) {
+                job = (Job *)g_queue_pop_head(&w->queues[prio]);
+            } else {
+                job = (Job *)g_queue_pop_tail(&w->queues[prio]);
+            }
+            mtx_unlock(&w->mtx);
+
+            if (job != NULL) {
+                *stolen = (victim != id);
+                return job;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void JobProcess(Job *job, bool stolen)
+{
+    uint64_t    start = UtilsMonoNsGet();
+    uint64_t    wait = start - job->queued_ns;
+    bool        run = false;
+
+    mtx_lock(&Jobs.mtx);
+    Jobs.pending--;
+    Jobs.stats.queued[job->prio]--;
+    if (stolen) {
+        Jobs.stats.stolen++;
+    }
+    mtx_unlock(&Jobs.mtx);
+
+    mtx_lock(&job->mtx);
+    if (job->state == JOB_STATE_QUEUED) {
+        job->state = JOB_STATE_RUNNING;
+        run = true;
+    }
+    mtx_unlock(&job->mtx);
+
+    if (run) {
+        mtx_lock(&Jobs.mtx);
+        Jobs.stats.running++;
+        mtx_unlock(&Jobs.mtx);
+
+        job->result = job->func(job->data);
+
+        uint64_t elapsed = UtilsMonoNsGet() - start;
+
+        mtx_lock(&Jobs.mtx);
+        Jobs.stats.running--;
+        Jobs.stats.done++;
+        Jobs.wait_sum_ns += wait;
+        Jobs.run_sum_ns += elapsed;
+        if (wait > Jobs.stats.wait_max_ns) {
+            Jobs.stats.wait_max_ns = wait;
+        }
+        if (elapsed > Jobs.stats.run_max_ns) {
+            Jobs.stats.run_max_ns = elapsed;
+        }
+        mtx_unlock(&Jobs.mtx);
+
+        JobFinish(job, JOB_STATE_DONE);
+    }
+
+    JobRelease(job);
+}
+
+static int JobsThread(void *data)
+{
+    unsigned    id = (unsigned)(uintptr_t)data;
+    bool        stolen = false;
+
+    JobsWorkerId = (int)id;
+
+    for (;;) {
+        Job *job = WorkerTake(id, &stolen);
+
+        if (job != NULL) {
+            JobProcess(job, stolen);
+            continue;
+        }
+
+        mtx_lock(&Jobs.mtx);
+        while (Jobs.pending == 0) {
+            cnd_wait(&Jobs.cnd, &Jobs.mtx);
+        }
+        mtx_unlock(&Jobs.mtx);
+    }
+
+    return 0;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+bool JobsStart()
+{
+    thrd_t  th;
+
+    mtx_init(&Jobs.mtx, mtx_plain);
+    cnd_init(&Jobs.cnd);
+    memset(&Jobs.stats, 0x0, sizeof(JobsStats));
+
+    for (unsigned i = 0; i < JOBS_THREADS; i++) {
+        mtx_init(&Jobs.workers[i].mtx, mtx_plain);
+        for (unsigned p = 0; p < JOB_PRIO_MAX; p++) {
+            g_queue_init(&Jobs.workers[i].queues[p]);
+        }
+    }
+
+    for (uintptr_t i = 0; i < JOBS_THREADS; i++) {
+        if (thrd_create(&th, &JobsThread, (void *)i) != thrd_success) {
+            return false;
+        }
+        if (thrd_detach(th) != thrd_success) {
+            return false;
+        }
+    }
+
+    Jobs.started = true;
+
+    LogF(LOG_TYPE_INFO, "JOBS", "Job pool started with %u workers", JOBS_THREADS);
+
+    return true;
+}
+
+Job *JobSubmit(const char *name, JobPriority prio, JobFunc func, JobFreeFunc free_func, void *data)
+{
+    unsigned    id;
+    unsigned    depth = 0;
+    Job         *job;
+
+    if (!Jobs.started) {
+        LogF(LOG_TYPE_ERROR, "JOBS", "Job pool is not started, job \"%s\" rejected", name);
+        return NULL;
+    }
+
+    job = (Job *)malloc(sizeof(Job));
+    if (job == NULL) {
+        return NULL;
+    }
+
+    strncpy(job->name, name, SHORT_STR_LEN - 1);
+    job->name[SHORT_STR_LEN - 1] = '\0';
+    job->prio = prio;
+    job->func = func;
+    job->free_func = free_func;
+    job->data = data;
+    job->state = JOB_STATE_QUEUED;
+    job->result = false;
+    job->queued_ns = UtilsMonoNsGet();
+    mtx_init(&job->mtx, mtx_plain);
+    cnd_init(&job->cnd);
+
+    /**
+     * One reference for the queue and one for the caller
+     */
+
+    atomic_init(&job->refs, 2);
+
+    /**
+     * Workers push to own queue, other threads spread jobs round robin
+     */
+
+    if (JobsWorkerId >= 0) {
+        id = (unsigned)JobsWorkerId;
+    } else {
+        id = atomic_fetch_add(&Jobs.next, 1) % JOBS_THREADS;
+    }
+
+    mtx_lock(&Jobs.workers[id].mtx);
+    g_queue_push_tail(&Jobs.workers[id].queues[prio], (void *)job);
+    mtx_unlock(&Jobs.workers[id].mtx);
+
+    mtx_lock(&Jobs.mtx);
+    Jobs.pending++;
+    Jobs.stats.queued[prio]++;
+    for (unsigned p = 0; p < JOB_PRIO_MAX; p++) {
+        depth += Jobs.stats.queued[p];
+    }
+    if (depth > Jobs.stats.queued_max) {
+        Jobs.stats.queued_max = depth;
+    }
+    cnd_signal(&Jobs.cnd);
+    mtx_unlock(&Jobs.mtx);
+
+    return job;
+}
+
+bool JobRun(const char *name, JobPriority prio, JobFunc func, void *data)
+{
+    Job *job = JobSubmit(name, prio, func, NULL, data);
+
+    if (job == NULL) {
+        return false;
+    }
+
+    JobRelease(job);
+
+    return true;
+}
+
+bool JobAwait(Job *job, bool *result)
+{
+    /**
+     * Worker waiting for a job runs queued jobs meanwhile, so blocking
+     * bodies awaiting nested jobs can not hold all workers
+     */
+
+    while (JobsWorkerId >= 0) {
+        JobState    state = JobStateGet(job);
+        bool        stolen = false;
+
+        if (state != JOB_STATE_QUEUED && state != JOB_STATE_RUNNING) {
+            break;
+        }
+
+        Job *other = WorkerTake((unsigned)JobsWorkerId, &stolen);
+        if (other == NULL) {
+            break;
+        }
+
+        JobProcess(other, stolen);
+    }
+
+    mtx_lock(&job->mtx);
+    while (job->state == JOB_STATE_QUEUED || job->state == JOB_STATE_RUNNING) {
+        cnd_wait(&job->cnd, &job->mtx);
+    }
+    mtx_unlock(&job->mtx);
+
+    if (job->state == JOB_STATE_CANCELLED) {
+        return false;
+    }
+
+    if (result != NULL) {
+        *result = job->result;
+    }
+
+    return true;
+}
+
+bool JobCancel(Job *job)
+{
+    bool ret = false;
+    bool cancelled = false;
+
+    mtx_lock(&job->mtx);
+    if (job->state == JOB_STATE_QUEUED) {
+        job->state = JOB_STATE_CANCELLED;
+        cnd_broadcast(&job->cnd);
+        cancelled = true;
+    }
+    ret = (job->state == JOB_STATE_CANCELLED);
+    mtx_unlock(&job->mtx);
+
+    /**
+     * Body of cancelled job never runs, so its data is freed here
+     */
+
+    if (cancelled) {
+        if (job->free_func != NULL) {
+            job->free_func(job->data);
+        }
+
+        mtx_lock(&Jobs.mtx);
+        Jobs.stats.cancelled++;
+        mtx_unlock(&Jobs.mtx);
+    }
+
+    return ret;
+}
+
+JobState JobStateGet(Job *job)
+{
+    JobState state;
+
+    mtx_lock(&job->mtx);
+    state = job->state;
+    mtx_unlock(&job->mtx);
+
+    return state;
+}
+
+void JobRelease(Job *job)
+{
+    if (atomic_fetch_sub(&job->refs, 1) == 1) {
+        JobFree(job);
+    }
+}
+
+void JobsStatsGet(JobsStats *stats)
+{
+    mtx_lock(&Jobs.mtx);
+
+    *stats = Jobs.stats;
+
+    if (Jobs.stats.done > 0) {
+        stats->wait_avg_ns = Jobs.wait_sum_ns / Jobs.stats.done;
+        stats->run_avg_ns = Jobs.run_sum_ns / Jobs.stats.done;
+    }
+
+    mtx_unlock(&Jobs.mtx);
+}
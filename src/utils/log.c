@@ -13,6 +13,12 @@
 #include <time.h>
 #include <threads.h>
 #include <stdint.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
 
 #include <utils/log.h>
 #include <utils/utils.h>
@@ -24,8 +30,31 @@
 /*                                                                   */
 /*********************************************************************/
 
-static char     log_path[STR_LEN] = {0};
-static mtx_t    log_mtx;
+typedef struct {
+    char    name[EXT_STR_LEN];
+    time_t  mtime;
+    off_t   size;
+} LogArchive;
+
+static struct {
+    char                path[STR_LEN];
+    char                file_name[EXT_STR_LEN];
+    FILE                *file;
+    off_t               size;
+    off_t               size_max;
+    unsigned            days_max;
+    unsigned long long  quota;
+    mtx_t               mtx;
+    cnd_t               cnd;
+} Logger = {
+    .path = {0},
+    .file_name = {0},
+    .file = NULL,
+    .size = 0,
+    .size_max = LOG_ROTATE_SIZE_KB * 1024,
+    .days_max = LOG_ROTATE_DAYS,
+    .quota = LOG_ROTATE_QUOTA_KB * 1024ULL
+};
 
 /*********************************************************************/
 /*                                                                   */
@@ -33,24 +62,375 @@ static mtx_t    log_mtx;
 /*                                                                   */
 /*********************************************************************/
 
+static bool NameEndsWith(const char *name, const char *ext)
+{
+    size_t name_len = strlen(name);
+    size_t ext_len = strlen(ext);
+
+    if (name_len <= ext_len) {
+        return false;
+    }
+
+    return !strcmp(name + name_len - ext_len, ext);
+}
+
+static void LogFileRotate(const char *date)
+{
+    char    part[EXT_STR_LEN];
+    char    archive[EXT_STR_LEN];
+
+    fclose(Logger.file);
+    Logger.file = NULL;
+
+    for (unsigned n = 1; ; n++) {
+        snprintf(part, EXT_STR_LEN, "%s%s.%u" LOG_FILE_EXT, Logger.path, date, n);
+        snprintf(archive, EXT_STR_LEN, "%s%s.%u" LOG_ARCHIVE_EXT, Logger.path, date, n);
+
+        if (access(part, F_OK) != 0 && access(archive, F_OK) != 0) {
+            break;
+        }
+    }
+
+    if (rename(Logger.file_name, part) != 0) {
+        printf("Failed to rotate log file \"%s\"\n", Logger.file_name);
+    }
+
+    /**
+     * File name is kept, next message reopens it and archiver must not
+     * take it in between
+     */
+
+    cnd_signal(&Logger.cnd);
+}
+
+/**
+ * @brief Copy file contents, missing source gives empty copy
+ */
+static bool LogFileCopy(const char *src, const char *dst)
+{
+    char    buf[BUFFER_LEN_MAX];
+    size_t  len;
+    bool    ret = true;
+    FILE    *in = fopen(src, "rb");
+    FILE    *out = fopen(dst, "wb");
+
+    if (out == NULL) {
+        if (in != NULL) {
+            fclose(in);
+        }
+        return false;
+    }
+
+    if (in != NULL) {
+        while ((len = fread(buf, 1, BUFFER_LEN_MAX, in)) > 0) {
+            if (fwrite(buf, 1, len, out) != len) {
+                ret = false;
+                break;
+            }
+        }
+        ret = ret && !ferror(in);
+        fclose(in);
+    }
+
+    return (fclose(out) == 0) && ret;
+}
+
+/**
+ * @brief Compress log file to archive. Stream is fully flushed before the
+ * first line of every minute and flush offsets are saved to index, so
+ * search can inflate archive from the requested minute.
+ */
+static bool LogFileCompress(const char *src)
+{
+    char        dst[EXT_STR_LEN];
+    char        idx[EXT_STR_LEN];
+    char        dst_tmp[EXT_STR_LEN];
+    char        idx_tmp[EXT_STR_LEN];
+    char        buf[BUFFER_LEN_MAX];
+    bool        line_start = true;
+    bool        ret = true;
+    int         minute_last = -1;
+    struct stat st;
+    FILE        *in;
+    FILE        *index = NULL;
+    gzFile      out;
+
+    snprintf(dst, EXT_STR_LEN, "%s.gz", src);
+    snprintf(idx, EXT_STR_LEN, "%s" LOG_INDEX_EXT, dst);
+    snprintf(dst_tmp, EXT_STR_LEN, "%s" LOG_TMP_EXT, dst);
+    snprintf(idx_tmp, EXT_STR_LEN, "%s" LOG_TMP_EXT, idx);
+
+    if (stat(src, &st) != 0) {
+        return false;
+    }
+
+    in = fopen(src, "rb");
+    if (!in) {
+        return false;
+    }
+
+    /**
+     * Archive and index are built in temporary files and replace old
+     * ones only when complete, so failed pass leaves no partial data
+     * to be duplicated by the next one. Older data of archive with same
+     * name is kept, concatenated gzip members are read as one stream.
+     */
+
+    if (!LogFileCopy(dst, dst_tmp)) {
+        unlink(dst_tmp);
+        fclose(in);
+        return false;
+    }
+
+    /**
+     * Index must cover archive from its beginning, archive without
+     * index is left without it
+     */
+
+    if (access(dst, F_OK) != 0) {
+        index = fopen(idx_tmp, "wb");
+    } else if (access(idx, F_OK) == 0 && LogFileCopy(idx, idx_tmp)) {
+        index = fopen(idx_tmp, "ab");
+    }
+
+    out = gzopen(dst_tmp, "ab6");
+    if (out == NULL) {
+        ret = false;
+    }
+
+    while (ret && fgets(buf, BUFFER_LEN_MAX, in) != NULL) {
+        size_t      len = strlen(buf);
+        unsigned    year, month, day, hour, min;
+
+        if (line_start && index != NULL &&
+            sscanf(buf, "[%u.%u.%u][%u:%u", &year, &month, &day, &hour, &min) == 5 &&
+            (int)(hour * 60 + min) > minute_last && gzflush(out, Z_FULL_FLUSH) == Z_OK) {
+            LogIndexMark mark = {
+                .minute = hour * 60 + min,
+                .offset = gzoffset(out)
+            };
+
+            ret = (fwrite(&mark, sizeof(LogIndexMark), 1, index) == 1);
+            minute_last = mark.minute;
+        }
+
+        if (gzwrite(out, buf, len) != (int)len) {
+            ret = false;
+        }
+
+        line_start = (len > 0 && buf[len - 1] == '\n');
+    }
+
+    ret = ret && !ferror(in);
+    fclose(in);
+
+    if (index != NULL && fclose(index) != 0) {
+        ret = false;
+    }
+
+    if (out != NULL && gzclose(out) != Z_OK) {
+        ret = false;
+    }
+
+    /**
+     * Archive goes first: index left from the previous pass still
+     * matches its beginning
+     */
+
+    if (!ret || rename(dst_tmp, dst) != 0) {
+        unlink(dst_tmp);
+        unlink(idx_tmp);
+        return false;
+    }
+
+    if (index != NULL) {
+        rename(idx_tmp, idx);
+    } else {
+        unlink(idx_tmp);
+    }
+
+    utime(dst, &(struct utimbuf){ .actime = st.st_atime, .modtime = st.st_mtime });
+    unlink(src);
+
+    return true;
+}
+
+static void LogFilesCompress(const char *current, const char *today)
+{
+    char            full_path[EXT_STR_LEN];
+    DIR             *dir;
+    struct dirent   *entry;
+
+    dir = opendir(Logger.path);
+    if (dir == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (!NameEndsWith(entry->d_name, LOG_FILE_EXT)) {
+            continue;
+        }
+
+        snprintf(full_path, EXT_STR_LEN, "%s%s", Logger.path, entry->d_name);
+
+        if (!strcmp(full_path, current) || !strcmp(full_path, today)) {
+            continue;
+        }
+
+        if (!LogFileCompress(full_path)) {
+            printf("Failed to compress log file \"%s\"\n", full_path);
+        }
+    }
+
+    closedir(dir);
+}
+
+static int LogArchiveCompare(const void *a, const void *b)
+{
+    const LogArchive *arch_a = (const LogArchive *)a;
+    const LogArchive *arch_b = (const LogArchive *)b;
+
+    if (arch_a->mtime < arch_b->mtime) {
+        return -1;
+    }
+    return (arch_a->mtime > arch_b->mtime) ? 1 : 0;
+}
+
+static void LogFilesPrune()
+{
+    GList               *archives = NULL;
+    unsigned long long  total = 0;
+    time_t              expired = time(NULL) - (time_t)Logger.days_max * 24 * 60 * 60;
+    DIR                 *dir;
+    struct dirent       *entry;
+    struct stat         st;
+
+    dir = opendir(Logger.path);
+    if (dir == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        char full_path[EXT_STR_LEN];
+
+        snprintf(full_path, EXT_STR_LEN, "%s%s", Logger.path, entry->d_name);
+
+        if (stat(full_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        if (!NameEndsWith(entry->d_name, LOG_FILE_EXT) && !NameEndsWith(entry->d_name, LOG_ARCHIVE_EXT)) {
+            continue;
+        }
+
+        total += st.st_size;
+
+        if (NameEndsWith(entry->d_name, LOG_ARCHIVE_EXT)) {
+            LogArchive *arch = (LogArchive *)malloc(sizeof(LogArchive));
+
+            strncpy(arch->name, full_path, EXT_STR_LEN);
+            arch->mtime = st.st_mtime;
+            arch->size = st.st_size;
+
+            archives = g_list_insert_sorted(archives, (void *)arch, &LogArchiveCompare);
+        }
+    }
+
+    closedir(dir);
+
+    /**
+     * Oldest archives go first, so removing from the head both
+     * drops expired files and frees space for quota
+     */
+
+    for (GList *a = archives; a != NULL; a = a->next) {
+        LogArchive *arch = (LogArchive *)a->data;
+
+        bool old = (Logger.days_max != 0 && arch->mtime < expired);
+        bool over = (Logger.quota != 0 && total > Logger.quota);
+
+        if ((old || over) && unlink(arch->name) == 0) {
+            char idx[EXT_STR_LEN];
+
+            snprintf(idx, EXT_STR_LEN, "%s" LOG_INDEX_EXT, arch->name);
+            unlink(idx);
+            total -= arch->size;
+        }
+
+        free(arch);
+    }
+
+    g_list_free(archives);
+}
+
+static int ArchiverThread(void *data)
+{
+    char            current[EXT_STR_LEN];
+    char            today[EXT_STR_LEN];
+    struct timespec ts;
+    PlcTime         time;
+
+    for (;;) {
+        /**
+         * Only numbered parts and files of earlier days are compressed,
+         * last written file and today file can be opened by Log at any time
+         */
+
+        mtx_lock(&Logger.mtx);
+        PlcTimeGet(&time);
+        snprintf(today, EXT_STR_LEN, "%s%d.%d.%d" LOG_FILE_EXT, Logger.path, time.year, time.month, time.day);
+        strncpy(current, Logger.file_name, EXT_STR_LEN);
+        mtx_unlock(&Logger.mtx);
+
+        LogFilesCompress(current, today);
+        LogFilesPrune();
+
+        timespec_get(&ts, TIME_UTC);
+        ts.tv_sec += LOG_ARCHIVE_PERIOD_SEC;
+
+        mtx_lock(&Logger.mtx);
+        cnd_timedwait(&Logger.cnd, &Logger.mtx, &ts);
+        mtx_unlock(&Logger.mtx);
+    }
+
+    return 0;
+}
+
 bool LogSaveToFile(const char *date, const char *msg)
 {
     char    file_name[EXT_STR_LEN];
-    FILE    *file;
 
-    snprintf(file_name, EXT_STR_LEN, "%s%s.log", log_path, date);
- 
-    file = fopen(file_name, "a+");
-    if (!file) {
-        return false;
+    snprintf(file_name, EXT_STR_LEN, "%s%s" LOG_FILE_EXT, Logger.path, date);
+
+    if (Logger.file == NULL || strcmp(file_name, Logger.file_name)) {
+        if (Logger.file != NULL) {
+            fclose(Logger.file);
+            Logger.file = NULL;
+            cnd_signal(&Logger.cnd);
+        }
+
+        Logger.file = fopen(file_name, "a");
+        if (!Logger.file) {
+            return false;
+        }
+
+        fseek(Logger.file, 0, SEEK_END);
+        Logger.size = ftell(Logger.file);
+        strncpy(Logger.file_name, file_name, EXT_STR_LEN);
     }
 
-    if (fprintf(file, "%s", msg) < 0) {
-        fclose(file);
+    if (fputs(msg, Logger.file) < 0 || fflush(Logger.file) != 0) {
+        fclose(Logger.file);
+        Logger.file = NULL;
         return false;
     }
 
-    fclose(file);
+    Logger.size += strlen(msg);
+
+    if (Logger.size_max != 0 && Logger.size >= Logger.size_max) {
+        LogFileRotate(date);
+    }
+
     return true;
 }
 
@@ -93,7 +473,37 @@ GString *LogMakeMsg(const LogType type, const char *module, const char *msg)
 
 void LogPathSet(const char *path)
 {
-    strncpy(log_path, path, STR_LEN);
+    strncpy(Logger.path, path, STR_LEN);
+    mtx_init(&Logger.mtx, mtx_plain);
+    cnd_init(&Logger.cnd);
+}
+
+const char *LogPathGet()
+{
+    return Logger.path;
+}
+
+void LogRotateSet(unsigned size_kb, unsigned days, unsigned quota_kb)
+{
+    mtx_lock(&Logger.mtx);
+    Logger.size_max = (off_t)size_kb * 1024;
+    Logger.days_max = days;
+    Logger.quota = (unsigned long long)quota_kb * 1024;
+    mtx_unlock(&Logger.mtx);
+}
+
+bool LogArchiverStart()
+{
+    thrd_t  arch_th;
+
+    if (thrd_create(&arch_th, &ArchiverThread, NULL) != thrd_success) {
+        return false;
+    }
+    if (thrd_detach(arch_th) != thrd_success) {
+        return false;
+    }
+
+    return true;
 }
 
 bool Log(const LogType type, const char *module, const char *msg)
@@ -104,19 +514,19 @@ bool Log(const LogType type, const char *module, const char *msg)
 
     PlcTimeGet(&time);
 
-    snprintf(date_str, STR_LEN, "%d.%d.%d.log", time.year, time.month, time.day);
+    snprintf(date_str, STR_LEN, "%d.%d.%d", time.year, time.month, time.day);
 
     text = LogMakeMsg(type, module, msg);
     printf("%s", text->str);
 
-    mtx_lock(&log_mtx);
+    mtx_lock(&Logger.mtx);
     if (!LogSaveToFile(date_str, text->str)) {
-        mtx_unlock(&log_mtx);
+        mtx_unlock(&Logger.mtx);
         printf("Failed to save log message to file\n");
         g_string_free(text, true);
         return -1;
     }
-    mtx_unlock(&log_mtx);
+    mtx_unlock(&Logger.mtx);
     g_string_free(text, true);
 
     return true;
@@ -0,0 +1,612 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <threads.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include <utils/logsearch.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE VARIABLES                         */
+/*                                                                   */
+/*********************************************************************/
+
+#define LOG_LINE_HEADER_LEN     128
+
+typedef struct {
+    char        name[EXT_STR_LEN];
+    ino_t       inode;
+    off_t       size;
+    off_t       minutes[LOG_SEARCH_MINUTES];
+} LogIndex;
+
+typedef struct {
+    char                name[EXT_STR_LEN];
+    unsigned long long  date;
+    unsigned            part;
+    bool                archive;
+} LogFile;
+
+typedef struct {
+    const LogQuery      *query;
+    unsigned long long  from;
+    unsigned long long  to;
+    LogSearchCb         cb;
+    void                *data;
+    unsigned            count;
+    bool                stop;
+} LogSearchState;
+
+static struct {
+    GList       *indexes;
+    mtx_t       mtx;
+    once_flag   once;
+} Search = {
+    .indexes = NULL,
+    .once = ONCE_FLAG_INIT
+};
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+static unsigned long long DateKey(unsigned year, unsigned month, unsigned day)
+{
+    return ((unsigned long long)year * 13 + month) * 32 + day;
+}
+
+static unsigned long long TimeKey(const PlcTime *tm)
+{
+    return ((DateKey(tm->year, tm->month, tm->day) * 24 + tm->hour) * 60 + tm->min) * 60 + tm->sec;
+}
+
+static bool LineParse(const char *line, size_t len, PlcTime *tm, LogType *type, char *module)
+{
+    char        header[LOG_LINE_HEADER_LEN];
+    int         pos = 0;
+    char        *end;
+
+    if (len >= LOG_LINE_HEADER_LEN) {
+        len = LOG_LINE_HEADER_LEN - 1;
+    }
+    memcpy(header, line, len);
+    header[len] = '\0';
+
+    if (sscanf(header, "[%u.%u.%u][%u:%u:%u][%n", &tm->year, &tm->month, &tm->day,
+            &tm->hour, &tm->min, &tm->sec, &pos) != 6 || pos == 0) {
+        return false;
+    }
+
+    end = strchr(header + pos, ']');
+    if (end == NULL || (end - (header + pos)) >= SHORT_STR_LEN) {
+        return false;
+    }
+
+    memcpy(module, header + pos, end - (header + pos));
+    module[end - (header + pos)] = '\0';
+
+    if (!strncmp(end, "][INFO]", 7)) {
+        *type = LOG_TYPE_INFO;
+    } else if (!strncmp(end, "][WARN]", 7)) {
+        *type = LOG_TYPE_WARN;
+    } else if (!strncmp(end, "][ERROR]", 8)) {
+        *type = LOG_TYPE_ERROR;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns false when the line is newer than query range, log files
+ * are written in time order so the rest of file can be skipped
+ */
+static bool LineProcess(LogSearchState *state, const char *line, size_t len)
+{
+    PlcTime     tm;
+    LogType     type;
+    char        module[SHORT_STR_LEN];
+
+    if (!LineParse(line, len, &tm, &type, module)) {
+        return true;
+    }
+
+    unsigned long long key = TimeKey(&tm);
+
+    if (key > state->to) {
+        return false;
+    }
+
+    if (key < state->from) {
+        return true;
+    }
+
+    if (state->query->module[0] != '\0' && strcmp(state->query->module, module)) {
+        return true;
+    }
+
+    if (state->query->typed && state->query->type != type) {
+        return true;
+    }
+
+    if (!state->cb(line, len, state->data) || ++state->count >= state->query->limit) {
+        state->stop = true;
+        return false;
+    }
+
+    return true;
+}
+
+static LogIndex *IndexGet(const char *name, const struct stat *st)
+{
+    LogIndex *idx = NULL;
+
+    for (GList *i = Search.indexes; i != NULL; i = i->next) {
+        LogIndex *cur = (LogIndex *)i->data;
+        if (!strcmp(cur->name, name)) {
+            idx = cur;
+            break;
+        }
+    }
+
+    if (idx == NULL) {
+        idx = (LogIndex *)malloc(sizeof(LogIndex));
+        strncpy(idx->name, name, EXT_STR_LEN);
+        idx->size = -1;
+        Search.indexes = g_list_append(Search.indexes, (void *)idx);
+    }
+
+    /**
+     * File was rotated or truncated, index it again
+     */
+
+    if (idx->size < 0 || idx->inode != st->st_ino || idx->size > st->st_size) {
+        idx->inode = st->st_ino;
+        idx->size = 0;
+        for (unsigned m = 0; m < LOG_SEARCH_MINUTES; m++) {
+            idx->minutes[m] = -1;
+        }
+    }
+
+    return idx;
+}
+
+static void IndexUpdate(LogIndex *idx, const char *map, off_t size)
+{
+    PlcTime     tm;
+    LogType     type;
+    char        module[SHORT_STR_LEN];
+    off_t       pos = idx->size;
+
+    while (pos < size) {
+        const char *nl = memchr(map + pos, '\n', size - pos);
+        if (nl == NULL) {
+            break;
+        }
+
+        if (LineParse(map + pos, nl - (map + pos), &tm, &type, module)) {
+            unsigned minute = tm.hour * 60 + tm.min;
+            if (minute < LOG_SEARCH_MINUTES && idx->minutes[minute] < 0) {
+                idx->minutes[minute] = pos;
+            }
+        }
+
+        pos = (nl - map) + 1;
+    }
+
+    idx->size = pos;
+}
+
+static void FileScan(LogSearchState *state, const LogFile *file)
+{
+    struct stat st;
+    off_t       pos = 0;
+    char        *map;
+    int         fd;
+
+    fd = open(file->name, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    LogIndex *idx = IndexGet(file->name, &st);
+    IndexUpdate(idx, map, st.st_size);
+
+    /**
+     * Jump to the first indexed minute of query range
+     */
+
+    const PlcTime *from = &state->query->from;
+    if (file->date == DateKey(from->year, from->month, from->day)) {
+        unsigned minute = from->hour * 60 + from->min;
+
+        pos = idx->size;
+        for (; minute < LOG_SEARCH_MINUTES; minute++) {
+            if (idx->minutes[minute] >= 0) {
+                pos = idx->minutes[minute];
+                break;
+            }
+        }
+    }
+
+    while (pos < idx->size) {
+        const char *line = map + pos;
+        const char *nl = memchr(line, '\n', idx->size - pos);
+        if (nl == NULL) {
+            break;
+        }
+
+        if (!LineProcess(state, line, nl - line)) {
+            break;
+        }
+
+        pos = (nl - map) + 1;
+    }
+
+    munmap(map, st.st_size);
+}
+
+static void GzLinesScan(LogSearchState *state, gzFile in)
+{
+    char buf[BUFFER_LEN_MAX];
+
+    while (gzgets(in, buf, BUFFER_LEN_MAX) != NULL) {
+        size_t len = strlen(buf);
+
+        if (len > 0 && buf[len - 1] == '\n') {
+            len--;
+        }
+
+        if (!LineProcess(state, buf, len)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Find compressed offset of the first indexed minute of query
+ * range in archive index
+ *
+ * @return False if archive has no index
+ */
+static bool IndexMarkGet(const char *name, unsigned minute, off_t *offset, bool *found)
+{
+    char            idx[EXT_STR_LEN];
+    LogIndexMark    mark;
+    FILE            *index;
+
+    snprintf(idx, EXT_STR_LEN, "%s" LOG_INDEX_EXT, name);
+
+    index = fopen(idx, "rb");
+    if (index == NULL) {
+        return false;
+    }
+
+    *found = false;
+    while (fread(&mark, sizeof(LogIndexMark), 1, index) == 1) {
+        if (mark.minute >= minute) {
+            *offset = mark.offset;
+            *found = true;
+            break;
+        }
+    }
+
+    fclose(index);
+    return true;
+}
+
+/**
+ * @brief Inflate raw deflate data from full flush point up to the end of
+ * gzip member, then read the rest of members as usual
+ */
+static void ArchiveMarkScan(LogSearchState *state, int fd, off_t offset)
+{
+    unsigned char   in[BUFFER_LEN_MAX];
+    char            out[BUFFER_LEN_MAX];
+    char            line[BUFFER_LEN_MAX];
+    size_t          line_len = 0;
+    bool            done = false;
+    int             ret = Z_OK;
+    z_stream        strm;
+
+    if (lseek(fd, offset, SEEK_SET) != offset) {
+        return;
+    }
+
+    memset(&strm, 0x0, sizeof(z_stream));
+    if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+        return;
+    }
+
+    while (!done && ret != Z_STREAM_END) {
+        ssize_t len = read(fd, in, BUFFER_LEN_MAX);
+        if (len <= 0) {
+            break;
+        }
+
+        strm.next_in = in;
+        strm.avail_in = len;
+
+        while (!done && strm.avail_in > 0 && ret != Z_STREAM_END) {
+            strm.next_out = (unsigned char *)out;
+            strm.avail_out = BUFFER_LEN_MAX;
+
+            ret = inflate(&strm, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                done = true;
+                break;
+            }
+
+            size_t  size = BUFFER_LEN_MAX - strm.avail_out;
+            char    *pos = out;
+
+            while (!done && size > 0) {
+                char    *nl = memchr(pos, '\n', size);
+                size_t  chunk = (nl != NULL) ? (size_t)(nl - pos) : size;
+                size_t  copy = (line_len + chunk < BUFFER_LEN_MAX) ? chunk : BUFFER_LEN_MAX - 1 - line_len;
+
+                memcpy(line + line_len, pos, copy);
+                line_len += copy;
+
+                if (nl == NULL) {
+                    break;
+                }
+
+                done = !LineProcess(state, line, line_len);
+                line_len = 0;
+                size -= chunk + 1;
+                pos = nl + 1;
+            }
+        }
+    }
+
+    /**
+     * Member ends with 8 bytes trailer, appended members follow it
+     */
+
+    off_t next = offset + (off_t)strm.total_in + 8;
+    inflateEnd(&strm);
+
+    if (done || ret != Z_STREAM_END || lseek(fd, next, SEEK_SET) != next) {
+        return;
+    }
+
+    gzFile rest = gzdopen(dup(fd), "rb");
+    if (rest != NULL) {
+        GzLinesScan(state, rest);
+        gzclose(rest);
+    }
+}
+
+static void ArchiveScan(LogSearchState *state, const LogFile *file)
+{
+    const PlcTime   *from = &state->query->from;
+    gzFile          in;
+
+    /**
+     * Jump to the first indexed minute of query range
+     */
+
+    if (file->date == DateKey(from->year, from->month, from->day)) {
+        off_t   offset = 0;
+        bool    found = false;
+
+        if (IndexMarkGet(file->name, from->hour * 60 + from->min, &offset, &found)) {
+            int fd;
+
+            if (!found) {
+                return;
+            }
+
+            fd = open(file->name, O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+
+            ArchiveMarkScan(state, fd, offset);
+            close(fd);
+            return;
+        }
+    }
+
+    in = gzopen(file->name, "rb");
+    if (in == NULL) {
+        return;
+    }
+
+    GzLinesScan(state, in);
+    gzclose(in);
+}
+
+static bool FileNameParse(const char *name, LogFile *file)
+{
+    unsigned    year, month, day;
+    int         pos = 0;
+    const char  *ext;
+
+    if (sscanf(name, "%u.%u.%u%n", &year, &month, &day, &pos) != 3 || pos == 0) {
+        return false;
+    }
+
+    file->date = DateKey(year, month, day);
+    file->part = UINT_MAX;
+    ext = name + pos;
+
+    if (strcmp(ext, LOG_FILE_EXT) && strcmp(ext, LOG_ARCHIVE_EXT)) {
+        pos = 0;
+        if (sscanf(ext, ".%u%n", &file->part, &pos) != 1 || pos == 0) {
+            return false;
+        }
+        ext += pos;
+    }
+
+    if (!strcmp(ext, LOG_FILE_EXT)) {
+        file->archive = false;
+    } else if (!strcmp(ext, LOG_ARCHIVE_EXT)) {
+        file->archive = true;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static int FileCompare(const void *a, const void *b)
+{
+    const LogFile *file_a = (const LogFile *)a;
+    const LogFile *file_b = (const LogFile *)b;
+
+    if (file_a->date != file_b->date) {
+        return (file_a->date < file_b->date) ? -1 : 1;
+    }
+    if (file_a->part != file_b->part) {
+        return (file_a->part < file_b->part) ? -1 : 1;
+    }
+    return 0;
+}
+
+static void SearchInit()
+{
+    mtx_init(&Search.mtx, mtx_plain);
+}
+
+static void IndexesCleanup()
+{
+    struct stat st;
+    GList       *i = Search.indexes;
+
+    while (i != NULL) {
+        GList *next = i->next;
+        LogIndex *idx = (LogIndex *)i->data;
+
+        if (stat(idx->name, &st) != 0) {
+            Search.indexes = g_list_remove(Search.indexes, idx);
+            free(idx);
+        }
+        i = next;
+    }
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+void LogQueryInit(LogQuery *query)
+{
+    memset(query, 0x0, sizeof(LogQuery));
+
+    query->to.year = 9999;
+    query->to.month = 12;
+    query->to.day = 31;
+    query->to.hour = 23;
+    query->to.min = 59;
+    query->to.sec = 59;
+    query->typed = false;
+    query->limit = LOG_SEARCH_LIMIT;
+}
+
+bool LogSearch(const LogQuery *query, LogSearchCb cb, void *data)
+{
+    const char      *path = LogPathGet();
+    GList           *files = NULL;
+    DIR             *dir;
+    struct dirent   *entry;
+    LogSearchState  state = {
+        .query = query,
+        .from = TimeKey(&query->from),
+        .to = TimeKey(&query->to),
+        .cb = cb,
+        .data = data,
+        .count = 0,
+        .stop = (query->limit == 0)
+    };
+
+    unsigned long long from_date = DateKey(query->from.year, query->from.month, query->from.day);
+    unsigned long long to_date = DateKey(query->to.year, query->to.month, query->to.day);
+
+    dir = opendir(path);
+    if (dir == NULL) {
+        return false;
+    }
+
+    /**
+     * Skip whole files by the date in their names
+     */
+
+    while ((entry = readdir(dir)) != NULL) {
+        LogFile file;
+
+        if (!FileNameParse(entry->d_name, &file)) {
+            continue;
+        }
+
+        if (file.date < from_date || file.date > to_date) {
+            continue;
+        }
+
+        LogFile *f = (LogFile *)malloc(sizeof(LogFile));
+        *f = file;
+        snprintf(f->name, EXT_STR_LEN, "%s%s", path, entry->d_name);
+        files = g_list_insert_sorted(files, (void *)f, &FileCompare);
+    }
+
+    closedir(dir);
+
+    call_once(&Search.once, &SearchInit);
+    mtx_lock(&Search.mtx);
+
+    for (GList *f = files; f != NULL; f = f->next) {
+        LogFile *file = (LogFile *)f->data;
+
+        if (!state.stop) {
+            if (file->archive) {
+                ArchiveScan(&state, file);
+            } else {
+                FileScan(&state, file);
+            }
+        }
+
+        free(file);
+    }
+
+    IndexesCleanup();
+
+    mtx_unlock(&Search.mtx);
+
+    g_list_free(files);
+
+    return true;
+}
@@ -0,0 +1,116 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <string.h>
+#include <errno.h>
+
+#include <utils/periodic.h>
+#include <utils/log.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                         PRIVATE FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+#define NSEC_PER_SEC    1000000000L
+#define NSEC_PER_MSEC   1000000L
+
+static void TimespecAdd(struct timespec *ts, unsigned msec)
+{
+    ts->tv_sec += msec / 1000;
+    ts->tv_nsec += (long)(msec % 1000) * NSEC_PER_MSEC;
+
+    if (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_sec++;
+        ts->tv_nsec -= NSEC_PER_SEC;
+    }
+}
+
+static int64_t TimespecDiff(const struct timespec *a, const struct timespec *b)
+{
+    return (int64_t)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+void PeriodicInit(PeriodicTask *task, const char *name, unsigned period_ms)
+{
+    strncpy(task->name, name, SHORT_STR_LEN - 1);
+    task->name[SHORT_STR_LEN - 1] = '\0';
+    task->period_ms = period_ms;
+    task->runs = 0;
+    task->overruns = 0;
+    task->late_max_ns = 0;
+    task->overrun = false;
+    task->func = NULL;
+    task->data = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &task->deadline);
+}
+
+bool PeriodicNext(PeriodicTask *task)
+{
+    struct timespec now;
+
+    task->runs++;
+    TimespecAdd(&task->deadline, task->period_ms);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t late = TimespecDiff(&now, &task->deadline);
+
+    if (late >= 0) {
+        /**
+         * Work took longer than period: skip missed ticks
+         * instead of running them back to back
+         */
+
+        task->overruns++;
+        if ((uint64_t)late > task->late_max_ns) {
+            task->late_max_ns = late;
+        }
+
+        if (!task->overrun) {
+            task->overrun = true;
+            LogF(LOG_TYPE_WARN, "PERIODIC", "Task \"%s\" overrun by %lld ms (period %u ms)",
+                 task->name, (long long)(late / NSEC_PER_MSEC), task->period_ms);
+        }
+
+        task->deadline = now;
+        return false;
+    }
+
+    if (task->overrun) {
+        task->overrun = false;
+        LogF(LOG_TYPE_INFO, "PERIODIC", "Task \"%s\" is back on schedule, total overruns %lu",
+             task->name, task->overruns);
+    }
+
+    return true;
+}
+
+bool PeriodicWait(PeriodicTask *task)
+{
+    bool ret = PeriodicNext(task);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &task->deadline, NULL) == EINTR);
+
+    return ret;
+}
+
+void PeriodicDelay(PeriodicTask *task, unsigned msec)
+{
+    TimespecAdd(&task->deadline, msec);
+}
@@ -0,0 +1,64 @@
+/*********************************************************************/
+/*                                                                   */
+/* Future City Programmable Logic Controller                         */
+/*                                                                   */
+/* Copyright (C) 2023 Denisov Smart Devices Limited                  */
+/* License: GPLv3                                                    */
+/* Written by Sergey Denisov aka LittleBuster (DenisovS21@gmail.com) */
+/*                                                                   */
+/*********************************************************************/
+
+#include <utils/seqlock.h>
+
+/*********************************************************************/
+/*                                                                   */
+/*                          PUBLIC FUNCTIONS                         */
+/*                                                                   */
+/*********************************************************************/
+
+void SeqLockInit(SeqLock *lock)
+{
+    atomic_init(&lock->seq, 0);
+    mtx_init(&lock->mtx, mtx_plain);
+}
+
+void SeqLockWriteBegin(SeqLock *lock)
+{
+    mtx_lock(&lock->mtx);
+
+    unsigned seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void SeqLockWriteEnd(SeqLock *lock)
+{
+    unsigned seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+
+    mtx_unlock(&lock->mtx);
+}
+
+unsigned SeqLockReadBegin(SeqLock *lock)
+{
+    unsigned seq;
+
+    /**
+     * Odd sequence means that writer is inside
+     */
+
+    while ((seq = atomic_load_explicit(&lock->seq, memory_order_acquire)) & 1) {
+        thrd_yield();
+    }
+
+    return seq;
+}
+
+bool SeqLockReadRetry(SeqLock *lock, unsigned seq)
+{
+    atomic_thread_fence(memory_order_acquire);
+
+    return atomic_load_explicit(&lock->seq, memory_order_relaxed) != seq;
+}
@@ -9,7 +9,9 @@
 /*********************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include <threads.h>
+#include <sys/stat.h>
 
 #include <utils/utils.h>
 
@@ -49,6 +51,39 @@ bool UtilsURIParse(const char *url, GList **params)
     return ret;
 }
 
+void UtilsURIParamDrop(const char *uri, const char *name, char *out)
+{
+    const char  *query = strchr(uri, '?');
+    size_t      len = (query != NULL) ? (size_t)(query - uri) : strlen(uri);
+    size_t      name_len = strlen(name);
+    char        sep = '?';
+
+    if (len >= STR_LEN) {
+        len = STR_LEN - 1;
+    }
+    memcpy(out, uri, len);
+
+    for (const char *p = (query != NULL) ? query + 1 : ""; *p != '\0';) {
+        const char  *end = strchr(p, '&');
+        size_t      param_len = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        bool        drop = (param_len > name_len && !strncmp(p, name, name_len) && p[name_len] == '=');
+
+        if (!drop && len + param_len + 1 < STR_LEN) {
+            out[len++] = sep;
+            memcpy(out + len, p, param_len);
+            len += param_len;
+            sep = '&';
+        }
+
+        p += param_len;
+        if (*p == '&') {
+            p++;
+        }
+    }
+
+    out[len] = '\0';
+}
+
 void UtilsSecSleep(unsigned sec)
 {
     thrd_sleep(&(struct timespec){ .tv_sec = sec }, NULL);
@@ -56,18 +91,70 @@ void UtilsSecSleep(unsigned sec)
 
 void UtilsMsecSleep(unsigned msec)
 {
-    thrd_sleep(&(struct timespec){ .tv_nsec = msec * 1000000 }, NULL);
+    thrd_sleep(&(struct timespec){
+        .tv_sec = msec / 1000,
+        .tv_nsec = (long)(msec % 1000) * 1000000
+    }, NULL);
+}
+
+bool UtilsLinuxTimeGet(time_t sec, struct tm *tm)
+{
+    if (localtime_r(&sec, tm) == NULL) {
+        return false;
+    }
+
+    tm->tm_year += 1900;
+    tm->tm_mon += 1;
+
+    return true;
+}
+
+bool UtilsTimeZoneUpdate()
+{
+    static time_t   tz_mtime = 0;
+    static ino_t    tz_ino = 0;
+    struct stat     st;
+    char            tz[STR_LEN] = ":" UTILS_TIME_ZONE_FILE;
+    const char      *env = getenv("TZ");
+
+    /**
+     * Zone file is usually a symlink, switching zone points it to
+     * another file with other inode
+     */
+
+    if (stat(UTILS_TIME_ZONE_FILE, &st) != 0) {
+        return false;
+    }
+
+    if (st.st_mtime == tz_mtime && st.st_ino == tz_ino) {
+        return false;
+    }
+
+    tz_mtime = st.st_mtime;
+    tz_ino = st.st_ino;
+
+    if (env != NULL) {
+        strncpy(tz, env, STR_LEN - 1);
+    }
+
+    /**
+     * glibc skips reloading if TZ value is the same as on previous call,
+     * so TZ is switched to fixed zone and back to force reading the file
+     */
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    setenv("TZ", tz, 1);
+    tzset();
+
+    return true;
 }
 
-struct tm *UtilsLinuxTimeGet()
+uint64_t UtilsMonoNsGet()
 {
-    long int    s_time;
-    struct tm   *cur_time;
+    struct timespec ts;
 
-    s_time = time(NULL);
-    cur_time = localtime(&s_time);
-    cur_time->tm_year += 1900;
-    cur_time->tm_mon += 1;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return cur_time;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }